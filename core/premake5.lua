@@ -73,6 +73,7 @@ project "microwave"
         "source/MW/Data/Internal/Assets.h",
         "source/MW/Graphics/AnimationClip.cpp",
         "source/MW/Graphics/AnimationClip.ixx",
+        "source/MW/Graphics/AnimationTrack.cpp",
         "source/MW/Graphics/AnimationTrack.ixx",
         "source/MW/Graphics/Buffer.cpp",
         "source/MW/Graphics/Buffer.ixx",
@@ -107,17 +108,25 @@ project "microwave"
         "source/MW/Graphics/Shader.ixx",
         "source/MW/Graphics/ShaderInfo.cpp",
         "source/MW/Graphics/ShaderInfo.ixx",
+        "source/MW/Graphics/Skinning.cpp",
+        "source/MW/Graphics/Skinning.ixx",
         "source/MW/Graphics/Texture.cpp",
         "source/MW/Graphics/Texture.ixx",
+        "source/MW/Graphics/TextureData.cpp",
+        "source/MW/Graphics/TextureData.ixx",
         "source/MW/Graphics/Types.ixx",
         "source/MW/Graphics/Internal/FreeType2.h",
         "source/MW/Graphics/Internal/HWBuffer.ixx",
         "source/MW/Graphics/Internal/HWRenderTarget.ixx",
         "source/MW/Graphics/Internal/HWRenderTexture.ixx",
         "source/MW/Graphics/Internal/HWContext.ixx",
+        "source/MW/Graphics/Internal/HWContextNull.cpp",
+        "source/MW/Graphics/Internal/HWContextNull.ixx",
         "source/MW/Graphics/Internal/HWShader.ixx",
         "source/MW/Graphics/Internal/HWSurface.ixx",
         "source/MW/Graphics/Internal/HWTexture.ixx",
+        "source/MW/IO/BinaryArtifact.cpp",
+        "source/MW/IO/BinaryArtifact.ixx",
         "source/MW/IO/File.cpp",
         "source/MW/IO/File.ixx",
         "source/MW/IO/FileStream.ixx",
@@ -126,6 +135,7 @@ project "microwave"
         "source/MW/IO/Stream.ixx",
         "source/MW/IO/Terminal.ixx",
         "source/MW/Math/AABox.ixx",
+        "source/MW/Math/Batch.ixx",
         "source/MW/Math/Constants.ixx",
         "source/MW/Math/Functions.ixx",
         "source/MW/Math/IntRect.ixx",
@@ -140,6 +150,7 @@ project "microwave"
         "source/MW/Math/Plane.ixx",
         "source/MW/Math/Quat.ixx",
         "source/MW/Math/Ray.ixx",
+        "source/MW/Math/Simd.ixx",
         "source/MW/Math/Sphere.ixx",
         "source/MW/Math/Transform.ixx",
         "source/MW/Math/Triangle.ixx",
@@ -187,8 +198,12 @@ project "microwave"
         "source/MW/SceneGraph/Internal/Bullet.h",
         "source/MW/SceneGraph/Internal/Bullet.ixx",
         "source/MW/SceneGraph/Internal/CapsuleShape.ixx",
+        "source/MW/SceneGraph/Internal/CollisionShapes.cpp",
+        "source/MW/SceneGraph/Internal/CollisionShapes.ixx",
         "source/MW/SceneGraph/Axis.ixx",
         "source/MW/SceneGraph/Coroutine.ixx",
+        "source/MW/SceneGraph/Culling.cpp",
+        "source/MW/SceneGraph/Culling.ixx",
         "source/MW/SceneGraph/Events.ixx",
         "source/MW/SceneGraph/LayerMask.ixx",
         "source/MW/SceneGraph/Node.cpp",
@@ -201,6 +216,8 @@ project "microwave"
         "source/MW/SceneGraph/SceneGraph.ixx",
         "source/MW/SceneGraph/SceneRenderer.cpp",
         "source/MW/SceneGraph/SceneRenderer.ixx",
+        "source/MW/SceneGraph/TransformStore.cpp",
+        "source/MW/SceneGraph/TransformStore.ixx",
         "source/MW/System/App.cpp",
         "source/MW/System/App.ixx",
         "source/MW/System/ApplicationDispatcher.ixx",
@@ -217,7 +234,12 @@ project "microwave"
         "source/MW/System/GC.ixx",
         "source/MW/System/IAwaitable.ixx",
         "source/MW/System/IAwaiter.ixx",
+        "source/MW/System/JobSystem.cpp",
+        "source/MW/System/JobSystem.ixx",
         "source/MW/System/Json.ixx",
+        "source/MW/System/JsonWriter.cpp",
+        "source/MW/System/JsonWriter.ixx",
+        "source/MW/System/MPSCQueue.ixx",
         "source/MW/System/Object.cpp",
         "source/MW/System/Object.ixx",
         "source/MW/System/Path.ixx",
@@ -232,6 +254,7 @@ project "microwave"
         "source/MW/System/UUID.ixx",
         "source/MW/System/Window.cpp",
         "source/MW/System/Window.ixx",
+        "source/MW/System/WorkStealingDeque.ixx",
         "source/MW/System/Internal/Platform.h",
         "source/MW/System/Internal/PlatformHeaders.h",
         "source/MW/Tools/DynamicLibrary.cpp",
@@ -406,6 +429,7 @@ project "microwave"
         defines {
             "NOMINMAX",
             "AL_ALEXT_PROTOTYPES",
+            "BT_THREADSAFE=1",
             "WIN32",
             "_DEBUG"
         }
@@ -415,6 +439,7 @@ project "microwave"
         defines {
             "NOMINMAX",
             "AL_ALEXT_PROTOTYPES",
+            "BT_THREADSAFE=1",
             "WIN32",
             "NDEBUG"
         }
@@ -17,7 +17,9 @@ import Microwave.IO.MemoryStream;
 import Microwave.IO.Terminal;
 import Microwave.Math;
 import Microwave.System.Exception;
+import Microwave.System.JobSystem;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.Utilities.Util;
 import <MW/Data/Internal/Assets.h>;
 import <MW/System/Debug.h>;
@@ -28,6 +30,34 @@ namespace fs = std::filesystem;
 namespace mw {
 inline namespace data {
 
+// a dirty source file, waiting for its dependencies to be imported
+struct PendingImport
+{
+    path sourcePath;
+    gptr<AssetMetadata> meta;
+    gptr<AssetImporter> importer;
+    std::vector<std::size_t> dependents;
+    int dependencies = 0; // unfinished imports this one waits for
+    bool finished = false;
+    std::chrono::steady_clock::duration time{};
+};
+
+// sorted, so the manifest doesn't change between refreshes unless an asset does
+static void SortArtifacts(std::vector<AssetArtifact>& artifacts)
+{
+    std::sort(artifacts.begin(), artifacts.end(),
+        [](const AssetArtifact& a, const AssetArtifact& b)
+        {
+            auto pathA = a.sourcePath.generic_string();
+            auto pathB = b.sourcePath.generic_string();
+
+            if (pathA != pathB)
+                return pathA < pathB;
+
+            return a.uuid.ToString() < b.uuid.ToString();
+        });
+}
+
 AssetDatabase::AssetDatabase(const gptr<AssetLibrary>& assetLibrary)
     : assetLibrary(assetLibrary)
 {
@@ -69,6 +99,35 @@ const gptr<AssetLibrary>& AssetDatabase::GetAssetLibrary() const {
     return assetLibrary;
 }
 
+void AssetDatabase::SetArtifactFormat(ArtifactFormat format)
+{
+    artifactFormat = format;
+
+    for (auto& [ext, importer] : importers)
+        importer->SetArtifactFormat(format);
+}
+
+ArtifactFormat AssetDatabase::GetArtifactFormat() const {
+    return artifactFormat;
+}
+
+void AssetDatabase::SetImportJobs(int jobs) {
+    importJobs = std::max(jobs, 0);
+}
+
+int AssetDatabase::GetImportJobs() const {
+    return importJobs;
+}
+
+void AssetDatabase::SetImportOptions(std::span<const std::string> args)
+{
+    for (std::size_t i = 0; i + 1 < args.size(); ++i)
+    {
+        if (args[i] == "--jobs")
+            SetImportJobs(std::atoi(args[i + 1].c_str()));
+    }
+}
+
 void AssetDatabase::SetDirty(const path& sourceFile)
 {
     path p = sourceFile;
@@ -81,12 +140,16 @@ void AssetDatabase::SetDirty(const path& sourceFile)
 
 void AssetDatabase::Refresh(bool force)
 {
+    auto start = std::chrono::steady_clock::now();
+
     ExtractInternalAssets();
     LoadCatalog();
     UpdateMetadata();
-    ImportFiles(force);
+    auto importTimes = ImportFiles(force);
     RemoveOrphanedImports();
     SaveCatalog();
+
+    ReportImportTimes(std::move(importTimes), std::chrono::steady_clock::now() - start);
 }
 
 void AssetDatabase::ExtractInternalAssets()
@@ -150,8 +213,9 @@ void AssetDatabase::SaveCatalog()
     }
 
     path catalogPath = dataDir / "catalog.json";
-    json obj = catalog;
-    File::WriteAllText(catalogPath, obj.dump(2));
+    JsonWriter writer(File::Open(catalogPath, OpenMode::Out | OpenMode::Binary), 2);
+    writer.Write(catalog);
+    writer.Flush();
 }
 
 // update in-memory metadata object cache and delete extra *.meta files from disk
@@ -300,42 +364,264 @@ void AssetDatabase::UpdateMetadata()
     }
 }
 
-void AssetDatabase::ImportFiles(bool force)
+// Files are imported in waves. Each wave holds every file whose
+// dependencies were imported by earlier waves, and its files are imported
+// concurrently on the JobSystem, except for those whose importer isn't
+// thread safe, which are imported here while the workers are busy. Meta
+// files are written, and assets released, on this thread between waves.
+std::vector<AssetDatabase::ImportTime> AssetDatabase::ImportFiles(bool force)
 {
     EnsureDirectoryExists(sourceDir);
     EnsureDirectoryExists(dataDir);
 
+    std::vector<PendingImport> imports;
+
     for (auto& [sourcePath, meta] : metadata)
     {
         if (meta->dirty || force)
         {
-            writeln("Importing File: ", sourcePath);
+            auto& imp = imports.emplace_back();
+            imp.sourcePath = sourcePath;
+            imp.meta = meta;
+            imp.importer = GetImporter(sourcePath);
+            meta->sourcePath = sourcePath;
+        }
+    }
 
-            auto fullSourcePath = sourceDir / sourcePath;
-            auto fullMetaPath = fullSourcePath + ".meta";
+    // metadata is unordered, so sort to import in the same order every time
+    std::sort(imports.begin(), imports.end(),
+        [](const PendingImport& a, const PendingImport& b) {
+            return a.sourcePath.generic_string() < b.sourcePath.generic_string();
+        });
 
-            meta->sourcePath = sourcePath;
-            
-            auto fileStream = File::Open(fullSourcePath, OpenMode::In | OpenMode::Binary);
-            auto importer = GetImporter(sourcePath);
-            importer->ImportFile(*meta, fileStream, dataDir);
+    std::unordered_map<path, std::size_t> importIndices;
+    std::unordered_multimap<path, std::size_t> importsByFilename;
+
+    for (std::size_t i = 0; i < imports.size(); ++i)
+    {
+        importIndices[imports[i].sourcePath] = i;
+        importsByFilename.emplace(imports[i].sourcePath.filename(), i);
+    }
+
+    // 'second' isn't started until 'first' has finished
+    auto AddDependency = [&](std::size_t first, std::size_t second)
+    {
+        imports[first].dependents.push_back(second);
+        ++imports[second].dependencies;
+    };
+
+    // Files that share an artifact UUID, like a source file copied along
+    // with its meta file, would write the same artifact. Each one waits for
+    // the previous writer, so writes to an artifact happen one at a time.
+    std::unordered_map<UUID, std::size_t> artifactWriters;
+
+    for (std::size_t i = 0; i < imports.size(); ++i)
+    {
+        auto& imp = imports[i];
+
+        for (path dep : imp.importer->GetDependencies(*imp.meta))
+        {
+            dep.make_preferred();
+
+            // a bare file name matches a file of that name in any directory,
+            // the same way AssetLibrary::FindAssetUUID() finds it
+            if (!dep.has_parent_path())
+            {
+                auto [first, last] = importsByFilename.equal_range(dep);
+                for (auto it = first; it != last; ++it)
+                {
+                    if (it->second != i)
+                        AddDependency(it->second, i);
+                }
+
+                continue;
+            }
+
+            auto it = importIndices.find(dep);
+            if (it != importIndices.end() && it->second != i)
+                AddDependency(it->second, i);
+        }
+
+        for (auto& art : imp.meta->artifacts)
+        {
+            auto [it, inserted] = artifactWriters.try_emplace(art.uuid, i);
+            if (!inserted && it->second != i)
+            {
+                AddDependency(it->second, i);
+                it->second = i;
+            }
+        }
+    }
+
+    std::unique_ptr<JobSystem> ownJobSystem;
+
+    if (importJobs > 1 && !imports.empty())
+        ownJobSystem = std::make_unique<JobSystem>(importJobs);
+
+    JobSystem& jobSystem = ownJobSystem ? *ownJobSystem : JobSystem::GetInstance();
+    bool concurrent = importJobs != 1;
+
+    auto Import = [&](PendingImport& imp)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        auto fileStream = File::Open(sourceDir / imp.sourcePath, OpenMode::In | OpenMode::Binary);
+        imp.importer->ImportFile(*imp.meta, fileStream, dataDir);
+
+        imp.time = std::chrono::steady_clock::now() - start;
+        imp.finished = true;
+    };
+
+    std::vector<std::size_t> wave;
+
+    for (std::size_t i = 0; i < imports.size(); ++i)
+    {
+        if (imports[i].dependencies == 0)
+            wave.push_back(i);
+    }
+
+    std::size_t importedCount = 0;
+
+    while (!wave.empty())
+    {
+        std::vector<JobHandle> jobs;
+        std::exception_ptr error;
+
+        for (auto i : wave)
+        {
+            auto& imp = imports[i];
+            if (concurrent && imp.importer->IsThreadSafe())
+            {
+                writeln("Importing File: ", imp.sourcePath);
+                jobs.push_back(jobSystem.ScheduleBackground([&Import, p = &imp]{ Import(*p); }));
+            }
+        }
+
+        for (auto i : wave)
+        {
+            auto& imp = imports[i];
+            if (!error && (!concurrent || !imp.importer->IsThreadSafe()))
+            {
+                writeln("Importing File: ", imp.sourcePath);
+
+                try {
+                    Import(imp);
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        for (auto& job : jobs)
+        {
+            try {
+                jobSystem.Wait(job);
+            }
+            catch (...) {
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+
+        // keep the files that did import, even if another one failed
+        for (auto i : wave)
+        {
+            auto& imp = imports[i];
+            if (!imp.finished)
+                continue;
 
             // save meta file
             json obj;
-            to_json(obj, *meta);
+            to_json(obj, *imp.meta);
 
+            auto fullMetaPath = sourceDir / imp.sourcePath + ".meta";
             File::WriteAllText(fullMetaPath, obj.dump(2));
-            meta->dirty = false;
+            imp.meta->dirty = false;
 
-            for(auto& art : meta->artifacts)
+            for (auto& art : imp.meta->artifacts)
                 assetLibrary->ReleaseAsset(art.uuid);
         }
+
+        if (error)
+            std::rethrow_exception(error);
+
+        std::vector<std::size_t> nextWave;
+
+        for (auto i : wave)
+        {
+            for (auto dependent : imports[i].dependents)
+            {
+                if (--imports[dependent].dependencies == 0)
+                    nextWave.push_back(dependent);
+            }
+        }
+
+        std::sort(nextWave.begin(), nextWave.end());
+
+        importedCount += wave.size();
+        wave = std::move(nextWave);
+    }
+
+    if (importedCount != imports.size())
+    {
+        auto it = std::find_if(imports.begin(), imports.end(),
+            [](const PendingImport& imp) { return !imp.finished; });
+
+        throw Exception({ "circular import dependency: ", it->sourcePath });
+    }
+
+    std::vector<ImportTime> importTimes;
+
+    for (auto& imp : imports)
+    {
+        auto it = std::find_if(importTimes.begin(), importTimes.end(),
+            [&](const ImportTime& t) { return t.importer == imp.importer; });
+
+        if (it == importTimes.end())
+        {
+            importTimes.push_back({ imp.importer });
+            it = std::prev(importTimes.end());
+        }
+
+        it->fileCount += 1;
+        it->time += imp.time;
     }
 
     ExportManifest();
     assetLibrary->Refresh();
 
     ResolveReferences();
+
+    return importTimes;
+}
+
+// Time spent in each importer, summed over its files. Files are imported
+// concurrently, so these can add up to more than the whole refresh.
+void AssetDatabase::ReportImportTimes(
+    std::vector<ImportTime> times,
+    std::chrono::steady_clock::duration total)
+{
+    if (times.empty())
+        return;
+
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    std::sort(times.begin(), times.end(),
+        [](const ImportTime& a, const ImportTime& b) { return a.time > b.time; });
+
+    writeln("Refreshed assets in ", std::format("{:.1f}", Milliseconds(total).count()), " ms");
+
+    for (auto& t : times)
+    {
+        std::string fileTypes;
+
+        for (auto& ext : t.importer->GetSupportedFileTypes())
+            fileTypes += (fileTypes.empty() ? "" : " ") + ext;
+
+        writeln("    ", fileTypes, ": ", t.fileCount, t.fileCount == 1 ? " file, " : " files, ",
+            std::format("{:.1f}", Milliseconds(t.time).count()), " ms");
+    }
 }
 
 void AssetDatabase::ResolveReferences()
@@ -383,8 +669,11 @@ void AssetDatabase::ExportManifest()
         }
     }
 
-    json obj = manifest;
-    File::WriteAllText(dataDir / "manifest.json", obj.dump(2));
+    SortArtifacts(manifest.artifacts);
+
+    JsonWriter writer(File::Open(dataDir / "manifest.json", OpenMode::Out | OpenMode::Binary), 2);
+    writer.Write(manifest);
+    writer.Flush();
 }
 
 void AssetDatabase::RemoveOrphanedImports()
@@ -504,6 +793,7 @@ void AssetDatabase::Deploy(const path& dest)
         }
     }
 
+    SortArtifacts(manifest.artifacts);
     json obj = manifest;
 
     auto manifestPath = dest / "manifest.json";
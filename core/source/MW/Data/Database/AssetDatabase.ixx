@@ -27,6 +27,15 @@ class AssetDatabase : public Object
     gmap<std::string, gptr<AssetMetadata>> metadata; // by relative path
     std::unordered_map<path, AssetRecord> catalog;
     gptr<AssetLibrary> assetLibrary;
+    ArtifactFormat artifactFormat = ArtifactFormat::Json;
+    int importJobs = 0;
+
+    struct ImportTime
+    {
+        gptr<AssetImporter> importer;
+        int fileCount = 0;
+        std::chrono::steady_clock::duration time{};
+    };
 
 public:
     AssetDatabase(const gptr<AssetLibrary>& assetLibrary);
@@ -36,6 +45,19 @@ public:
     const path& GetDataDir() const;
     const gptr<AssetLibrary>& GetAssetLibrary() const;
 
+    // only affects files imported after the change - use Refresh(true) to reimport everything
+    void SetArtifactFormat(ArtifactFormat format);
+    ArtifactFormat GetArtifactFormat() const;
+
+    // Number of files imported at once by Refresh(). Zero shares the global
+    // JobSystem's workers, and one imports everything on the calling thread.
+    void SetImportJobs(int jobs);
+    int GetImportJobs() const;
+
+    // applies the import options in command line arguments, like App::GetArgs():
+    // '--jobs N' sets how many files are imported at once
+    void SetImportOptions(std::span<const std::string> args);
+
     void SetDirty(const path& sourceFile);
     void Refresh(bool force = false);
     void Deploy(const path& dest);
@@ -58,7 +80,8 @@ private:
     void LoadCatalog();
     void SaveCatalog();
     void UpdateMetadata();
-    void ImportFiles(bool force);
+    std::vector<ImportTime> ImportFiles(bool force);
+    void ReportImportTimes(std::vector<ImportTime> times, std::chrono::steady_clock::duration total);
     void ResolveReferences();
     void ExportManifest();
     void RemoveOrphanedImports();
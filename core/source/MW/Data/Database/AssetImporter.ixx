@@ -22,11 +22,31 @@ inline namespace data {
 
 class AssetImporter
 {
+protected:
+    ArtifactFormat artifactFormat = ArtifactFormat::Json;
 public:
     virtual ~AssetImporter() {}
 
+    void SetArtifactFormat(ArtifactFormat format) {
+        artifactFormat = format;
+    }
+
     virtual std::span<std::string> GetSupportedFileTypes() = 0;
 
+    // Source files, relative to the source directory, whose imports must
+    // finish before this one starts. Files are imported concurrently, so any
+    // file ImportFile() reads besides its own source should be listed here.
+    // A bare file name stands for every file with that name.
+    virtual std::vector<path> GetDependencies(const AssetMetadata& meta) {
+        return {};
+    }
+
+    // false if ImportFile() has to run on the thread that called Refresh(),
+    // e.g. because it creates scene objects
+    virtual bool IsThreadSafe() const {
+        return true;
+    }
+
     // should generate artifact files and update metadata
     virtual void ImportFile(
         AssetMetadata& meta,
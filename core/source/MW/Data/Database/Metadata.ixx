@@ -9,6 +9,15 @@ import std;
 export namespace mw {
 inline namespace data {
 
+// how importers write the artifacts of objects like meshes and clips.
+// Both formats can be loaded, so imports don't have to be redone after
+// switching.
+enum class ArtifactFormat
+{
+    Json,   // readable and diffable, for editing
+    Binary  // BinaryArtifact container, for fast loading
+};
+
 struct ArtifactMetadata
 {
     UUID uuid;
@@ -8,9 +8,13 @@ import Microwave.Data.Database.Metadata;
 import Microwave.Data.Library.AssetLibrary;
 import Microwave.Data.Internal.FBXModelConverter;
 import Microwave.Graphics.AnimationClip;
+import Microwave.Graphics.AnimationTrack;
 import Microwave.Graphics.Material;
 import Microwave.Graphics.Mesh;
+import Microwave.IO.BinaryArtifact;
 import Microwave.IO.File;
+import Microwave.IO.FileStream;
+import Microwave.IO.Terminal;
 import Microwave.SceneGraph.Node;
 import Microwave.SceneGraph.Components.Animator;
 import Microwave.SceneGraph.Components.BoxCollider;
@@ -19,7 +23,9 @@ import Microwave.SceneGraph.Components.MeshCollider;
 import Microwave.SceneGraph.Components.MeshRenderer;
 import Microwave.SceneGraph.Components.RigidBody;
 import Microwave.SceneGraph.Components.SphereCollider;
+import Microwave.SceneGraph.Internal.CollisionShapes;
 import Microwave.System.Exception;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import Microwave.Utilities.Util;
@@ -33,6 +39,7 @@ struct ModelImporter::ParserState
 {
     gptr<Node> rootNode;
     gmap<std::string, gptr<Mesh>> meshes;
+    gvector<std::pair<gptr<Node>, gptr<Mesh>>> colliderMeshes;
     gmap<std::string, MaterialInfo> materials;
     gvector<gptr<AnimationClip>> clips;
     gvector<gptr<MeshRenderer>> meshRenderers;
@@ -43,6 +50,36 @@ std::span<std::string> ModelImporter::GetSupportedFileTypes() {
     return types;
 }
 
+// Bindings only hold file names, which Resolve() looks up once every file
+// is imported. Importing the bound files first keeps a model from being
+// imported alongside the textures it's about to reference. The bindings
+// are saved in the settings, so this only knows them once the model has
+// been imported before.
+std::vector<path> ModelImporter::GetDependencies(const AssetMetadata& meta)
+{
+    ModelSettings settings = meta.settings;
+    std::vector<path> ret;
+
+    auto AddBinding = [&](const AssetBinding& binding)
+    {
+        if (!binding.filename.empty() &&
+            std::find(ret.begin(), ret.end(), binding.filename) == ret.end())
+        {
+            ret.push_back(binding.filename);
+        }
+    };
+
+    for (auto& [uuid, matSettings] : settings.materialSettings)
+    {
+        AddBinding(matSettings.shaderBinding);
+
+        for (auto& [uniform, binding] : matSettings.textureBindings)
+            AddBinding(binding);
+    }
+
+    return ret;
+}
+
 void ModelImporter::ImportFile(
     AssetMetadata& meta,
     const gptr<Stream>& stream,
@@ -55,6 +92,9 @@ void ModelImporter::ImportFile(
 
     gptr<Model> model = FBXModelConverter::Convert(stream, settings);
 
+    if (settings.compressAnimation)
+        CompressClips(model, settings.animationTolerance);
+
     ParserState state;
     ParseModel(model, state);
     
@@ -102,6 +142,29 @@ void ModelImporter::ImportFile(
         artifacts[art.sourcePath] = art;
         objects[art.sourcePath] = mesh;
     }
+
+    // Collision meshes are keyed by the path of their node, since their
+    // names aren't unique. Nodes with the same path are told apart by the
+    // order they're in.
+    for (auto& [node, mesh] : state.colliderMeshes)
+    {
+        std::string key = node->GetFullPath().generic_string();
+        if (key.empty())
+            key = node->GetName();
+
+        ArtifactMetadata art;
+        art.uuid = mesh->GetUUID();
+        art.sourcePath = meta.sourcePath / key + ".collision";
+        art.assetType = AssetType::Mesh;
+
+        for (int i = 1; artifacts.contains(art.sourcePath); ++i)
+            art.sourcePath = meta.sourcePath / key + "." + std::to_string(i) + ".collision";
+
+        RetainOldUUID(art, mesh);
+
+        artifacts[art.sourcePath] = art;
+        objects[art.sourcePath] = mesh;
+    }
     
     settings.materialSettings.clear();
 
@@ -137,11 +200,29 @@ void ModelImporter::ImportFile(
 
     for (auto& [sourcePath, art] : artifacts)
     {
-        json obj;
-        objects[sourcePath]->ToJson(obj);
-
+        auto& obj = objects[sourcePath];
         path destFilePath = dataDir / art.uuid.ToString();
-        File::WriteAllText(destFilePath, obj.dump(2));
+
+        // materials stay JSON, since Resolve() rewrites their bindings
+        if (artifactFormat == ArtifactFormat::Binary && art.assetType != AssetType::Material)
+        {
+            BinaryArtifactWriter writer;
+
+            if (auto mesh = gpcast<Mesh>(obj))
+                mesh->WriteArtifact(writer);
+            else if (auto clip = gpcast<AnimationClip>(obj))
+                clip->WriteArtifact(writer);
+            else
+                obj->ToJson(writer.header);
+
+            writer.Save(destFilePath);
+        }
+        else
+        {
+            JsonWriter writer(File::Open(destFilePath, OpenMode::Out | OpenMode::Binary), 2);
+            obj->WriteJson(writer);
+            writer.Flush();
+        }
         
         meta.artifacts.push_back(std::move(art));
     }
@@ -230,6 +311,27 @@ bool ModelImporter::Resolve(
     return resolvedReference;
 }
 
+void ModelImporter::CompressClips(const gptr<Model>& model, const AnimationTolerance& tolerance)
+{
+    for (auto& clip : model->clips)
+    {
+        AnimationCompressionStats stats;
+
+        for (auto& [path, track] : clip->tracks)
+            stats += track->Compress(tolerance);
+
+        if (stats.compressedSize == 0)
+            continue;
+
+        writeln("Compressed Clip: ", clip->name,
+            " (", stats.originalSize, " -> ", stats.compressedSize, " bytes, ",
+            (float)stats.originalSize / stats.compressedSize, "x, max error: ",
+            stats.maxPositionError, " pos, ",
+            stats.maxRotationError, " rad, ",
+            stats.maxScaleError, " scale)");
+    }
+}
+
 void ModelImporter::ParseModel(const gptr<Model>& model, ParserState& state)
 {
     state.rootNode = ParseModelNode(model->rootNode, state);
@@ -412,23 +514,38 @@ gptr<Node> ModelImporter::ParseModelNode(const gptr<ModelNode>& modelNode, Parse
             col->SetRadius(modelNode->collider->radius);
             col->SetHeight(modelNode->collider->height);
         }
-        else if (colliderType == ModelColliderType::Convex)
+        else if (colliderType == ModelColliderType::Convex ||
+                 colliderType == ModelColliderType::Mesh)
         {
             Assert(modelNode->collider->mesh);
             gptr<Mesh> mesh = gpnew<Mesh>();
             mesh->SetName(modelNode->collider->mesh->name);
             mesh->vertices = std::move(modelNode->collider->mesh->vertices);
-            auto& elem = modelNode->collider->mesh->elements[0];
-            MeshElement meshElem;
-            meshElem.drawMode = elem.drawMode;
-            meshElem.indices = std::move(elem.indices);
-            mesh->elements.push_back(meshElem);
+
+            for (auto& elem : modelNode->collider->mesh->elements)
+            {
+                MeshElement meshElem;
+                meshElem.drawMode = elem.drawMode;
+                meshElem.indices = std::move(elem.indices);
+                mesh->elements.push_back(meshElem);
+            }
+
             mesh->RecalcBounds();
 
+            // bake the collision data here, instead of each time it's loaded
+            bool convex = (colliderType == ModelColliderType::Convex);
+            mesh->collisionHull = ReduceHull(mesh->vertices);
+
+            if (!convex)
+                mesh->collisionTree = BuildTriangleTree(*mesh);
+
+            state.colliderMeshes.emplace_back(node, mesh);
+
             auto col = node->AddComponent<MeshCollider>();
             col->SetName(modelNode->collider->name);
             col->SetPivot(node->GetChild(modelNode->collider->pivotID));
-            col->SetMesh(mesh);
+            col->SetMesh(mesh, true);
+            col->SetConvex(convex);
         }
 
         auto body = node->AddComponent<RigidBody>();
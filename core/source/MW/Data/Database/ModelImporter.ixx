@@ -7,6 +7,7 @@ import Microwave.Data.Database.AssetDatabase;
 import Microwave.Data.Database.AssetImporter;
 import Microwave.Data.Database.Metadata;
 import Microwave.Data.Library.AssetSettings;
+import Microwave.Graphics.AnimationTrack;
 import Microwave.Graphics.Material;
 import Microwave.Graphics.Model;
 import Microwave.IO.File;
@@ -36,6 +37,9 @@ public:
 
     virtual std::span<std::string> GetSupportedFileTypes() override;
 
+    // the textures and shaders the model's materials are bound to
+    virtual std::vector<path> GetDependencies(const AssetMetadata& meta) override;
+
     virtual void ImportFile(
         AssetMetadata& meta,
         const gptr<Stream>& stream,
@@ -47,6 +51,7 @@ public:
         const path& sourceDir,
         const path& dataDir) override;
 
+    void CompressClips(const gptr<Model>& model, const AnimationTolerance& tolerance);
     void ParseModel(const gptr<Model>& model, ParserState& state);
     gptr<Node> ParseModelNode(const gptr<ModelNode>& modelNode, ParserState& state);
 };
@@ -8,8 +8,10 @@ import Microwave.Data.Database.AssetImporter;
 import Microwave.Data.Library.AssetSettings;
 import Microwave.Graphics.Image;
 import Microwave.Graphics.Texture;
+import Microwave.Graphics.TextureData;
 import Microwave.IO.File;
 import Microwave.IO.Stream;
+import Microwave.System.Exception;
 import Microwave.System.Json;
 import Microwave.System.Path;
 import Microwave.System.Pointers;
@@ -24,6 +26,25 @@ inline namespace data {
 
 class TextureImporter : public AssetImporter
 {
+    // Guesses the type of a texture that hasn't been given one from the
+    // common suffixes for normal maps, like "brick_n.png" or "brickNormal.png".
+    static TextureType GuessTextureType(const path& sourcePath)
+    {
+        static const char* suffixes[] = { "_n", "_nrm", "_norm", "normal", "normalmap" };
+
+        auto stem = sourcePath.stem().string();
+        std::transform(stem.begin(), stem.end(), stem.begin(),
+            [](unsigned char c) { return (char)std::tolower(c); });
+
+        for (auto suffix : suffixes)
+        {
+            if (stem.ends_with(suffix))
+                return TextureType::NormalMap;
+        }
+
+        return TextureType::Color;
+    }
+
 public:
     virtual std::span<std::string> GetSupportedFileTypes() override {
         static std::string types[] = { ".exr", ".jpg", ".png", ".tga" };
@@ -35,16 +56,28 @@ public:
         const gptr<Stream>& stream,
         const path& dataDir) override
     {
-        TextureSettings settings = meta.settings;
-        
-        //Image img(sourceFilePath);
-        //std::vector<std::byte> output;
-        //img.Save(settings.fileFormat, output);
-        //File::WriteAllBytes(destFilePath, output);
-
-        // hack this for now until Image properly handles saving all types
+        // sRGB defaults from the type, so the type has to be known first
+        json settingsJson = meta.settings.IsObject() ? meta.settings : json::object();
+        if (!settingsJson.GetObject().contains("type"))
+            settingsJson["type"] = GuessTextureType(meta.sourcePath);
+
+        TextureSettings settings = settingsJson;
         settings.fileFormat = Image::GetFormatForFile(meta.sourcePath);
 
+        std::vector<std::byte> fileData(stream->GetLength());
+        if ((std::size_t)stream->Read(fileData) != fileData.size())
+            throw Exception("failed to read texture file");
+
+        // the artifact holds the texture as it's uploaded, so loading
+        // it doesn't need to decode the image or generate mip levels
+        Image image(settings.fileFormat, fileData);
+
+        TextureBuildSettings buildSettings;
+        buildSettings.sRGB = settings.sRGB;
+        buildSettings.compress = settings.compress;
+        buildSettings.target = settings.compressionTarget;
+        TextureData data = TextureData::Build(image, buildSettings);
+
         ArtifactMetadata art;
         art.sourcePath = meta.sourcePath; 
         art.uuid = !meta.artifacts.empty() ? meta.artifacts[0].uuid : UUID::New();
@@ -57,12 +90,9 @@ public:
             path::remove(artifactFilePath);
 
         gptr<Stream> output = File::Open(artifactFilePath, OpenMode::Out | OpenMode::Binary);
-        stream->CopyTo(output);
+        data.Save(output);
         output = nullptr;
 
-        //auto opt = path::copy_options::overwrite_existing;
-        //path::copy(sourceFilePath, artifactFilePath, opt);
-
         meta.artifacts.clear();
         meta.artifacts.push_back(std::move(art));
 
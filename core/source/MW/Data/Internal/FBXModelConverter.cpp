@@ -392,6 +392,10 @@ public:
                 {
                     collider->type = ModelColliderType::Convex;
                 }
+                else if (*colliderType == "Mesh")
+                {
+                    collider->type = ModelColliderType::Mesh;
+                }
 
                 auto bodyType = props.TryGet<std::string>("ColliderBodyType");
                 if (bodyType)
@@ -475,6 +479,11 @@ public:
         for (Vec3& v : mesh->vertices)
             v = Vec4(v, 1) * vxf;
 
+        // keep the triangles for concave colliders, after the lines used for gizmos
+        ModelMeshElement triangles;
+        triangles.drawMode = DrawMode::Triangles;
+        triangles.indices = element.indices;
+
         // convert triangles to lines
         std::set<std::uint64_t> edges;
         Assert(element.indices.size() % 3 == 0);
@@ -504,6 +513,8 @@ public:
             element.indices.push_back((int)b);
         }
 
+        mesh->elements.push_back(std::move(triangles));
+
         auto removedAttrib = fbxNode->RemoveNodeAttribute(fbxMesh);
         Assert(removedAttrib); // if null, remove failed
         fbxMesh->Destroy();
@@ -10,6 +10,7 @@ import Microwave.Data.Library.AssetType;
 import Microwave.Data.Library.AssetSettings;
 import Microwave.IO.File;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Path;
 import Microwave.System.UUID;
 import std;
@@ -49,6 +50,10 @@ void to_json(json& obj, const AssetManifest& manifest) {
     obj["artifacts"] = manifest.artifacts;
 }
 
+void to_json(JsonWriter& writer, const AssetManifest& manifest) {
+    writer.BeginObject().Property("artifacts", manifest.artifacts).EndObject();
+}
+
 void from_json(const json& obj, AssetManifest& manifest) {
     manifest.artifacts = obj.value("artifacts", manifest.artifacts);
 }
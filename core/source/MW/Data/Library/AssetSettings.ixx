@@ -5,10 +5,12 @@
 export module Microwave.Data.Library.AssetSettings;
 import Microwave.Audio.AudioClip;
 import Microwave.Graphics.AnimationClip;
+import Microwave.Graphics.AnimationTrack;
 import Microwave.Graphics.Font;
 import Microwave.Graphics.Image;
 import Microwave.Graphics.Material;
 import Microwave.Graphics.Texture;
+import Microwave.Graphics.TextureData;
 import Microwave.Graphics.GraphicsTypes;
 import Microwave.Math;
 import Microwave.System.Path;
@@ -20,11 +22,24 @@ import std;
 export namespace mw {
 inline namespace data {
 
+// What a texture's pixels hold. Only colors are sRGB encoded. Normal maps
+// and other data are stored as is, and filtered as they're stored.
+enum class TextureType
+{
+    Color,
+    NormalMap,
+    Data
+};
+
 struct TextureSettings
 {
     ImageFileFormat fileFormat = ImageFileFormat::PNG;
     TextureWrapMode wrapMode = TextureWrapMode::Repeat;
     TextureFilterMode filterMode = TextureFilterMode::Bilinear;
+    TextureType type = TextureType::Color;
+    bool sRGB = true; // defaults to whether 'type' is Color
+    bool compress = true;
+    TextureCompressionTarget compressionTarget = TextureCompressionTarget::Default;
 };
 
 struct AudioClipSettings
@@ -59,6 +74,8 @@ struct ModelSettings
     bool keepRootTransform = false;
     std::vector<ClipSpec> clipSpecs;
     std::unordered_map<UUID, MaterialSettings> materialSettings;
+    bool compressAnimation = false;
+    AnimationTolerance animationTolerance;
 };
 
 struct FontSettings
@@ -70,16 +87,60 @@ struct FontSettings
     int margin = 2;
 };
 
+void to_json(json& obj, const TextureType& type) {
+    static std::array<const char*, 3> types{
+        "Color",
+        "NormalMap",
+        "Data"
+    };
+    obj = types[(int)type];
+}
+
+void from_json(const json& obj, TextureType& type) {
+    static std::unordered_map<std::string, TextureType> types{
+        { "Color", TextureType::Color },
+        { "NormalMap", TextureType::NormalMap },
+        { "Data", TextureType::Data }
+    };
+    type = types[obj.get<std::string>()];
+}
+
+void to_json(json& obj, const TextureCompressionTarget& target) {
+    static std::array<const char*, 3> targets{
+        "Default",
+        "BC",
+        "ETC2"
+    };
+    obj = targets[(int)target];
+}
+
+void from_json(const json& obj, TextureCompressionTarget& target) {
+    static std::unordered_map<std::string, TextureCompressionTarget> targets{
+        { "Default", TextureCompressionTarget::Default },
+        { "BC", TextureCompressionTarget::BC },
+        { "ETC2", TextureCompressionTarget::ETC2 }
+    };
+    target = targets[obj.get<std::string>()];
+}
+
 void to_json(json& obj, const TextureSettings& settings) {
     obj["fileFormat"] = settings.fileFormat;
     obj["wrapMode"] = settings.wrapMode;
     obj["filterMode"] = settings.filterMode;
+    obj["type"] = settings.type;
+    obj["sRGB"] = settings.sRGB;
+    obj["compress"] = settings.compress;
+    obj["compressionTarget"] = settings.compressionTarget;
 }
 
 void from_json(const json& obj, TextureSettings& settings) {
     settings.fileFormat = obj.value("fileFormat", settings.fileFormat);
     settings.wrapMode = obj.value("wrapMode", settings.wrapMode);
     settings.filterMode = obj.value("filterMode", settings.filterMode);
+    settings.type = obj.value("type", settings.type);
+    settings.sRGB = obj.value("sRGB", settings.type == TextureType::Color);
+    settings.compress = obj.value("compress", settings.compress);
+    settings.compressionTarget = obj.value("compressionTarget", settings.compressionTarget);
 }
 
 void to_json(json& obj, const AudioClipSettings& settings) {
@@ -106,6 +167,18 @@ void from_json(const json& obj, ClipSpec& spec) {
     spec.wrapMode = obj.value("wrapMode", spec.wrapMode);
 }
 
+void to_json(json& obj, const AnimationTolerance& tolerance) {
+    obj["position"] = tolerance.position;
+    obj["rotation"] = tolerance.rotation;
+    obj["scale"] = tolerance.scale;
+}
+
+void from_json(const json& obj, AnimationTolerance& tolerance) {
+    tolerance.position = obj.value("position", tolerance.position);
+    tolerance.rotation = obj.value("rotation", tolerance.rotation);
+    tolerance.scale = obj.value("scale", tolerance.scale);
+}
+
 void to_json(json& obj, const AssetBinding& binding) {
     obj["filename"] = binding.filename;
     obj["uuid"] = binding.uuid;
@@ -131,6 +204,8 @@ void to_json(json& obj, const ModelSettings& settings) {
     obj["keepRootTransform"] = settings.keepRootTransform;
     obj["clipSpecs"] = settings.clipSpecs;
     obj["materialSettings"] = settings.materialSettings;
+    obj["compressAnimation"] = settings.compressAnimation;
+    obj["animationTolerance"] = settings.animationTolerance;
 }
 
 void from_json(const json& obj, ModelSettings& settings) {
@@ -138,6 +213,8 @@ void from_json(const json& obj, ModelSettings& settings) {
     settings.keepRootTransform = obj.value("keepRootTransform", settings.keepRootTransform);
     settings.clipSpecs = obj.value("clipSpecs", settings.clipSpecs);
     settings.materialSettings = obj.value("materialSettings", settings.materialSettings);
+    settings.compressAnimation = obj.value("compressAnimation", settings.compressAnimation);
+    settings.animationTolerance = obj.value("animationTolerance", settings.animationTolerance);
 }
 
 void to_json(json& obj, const FontMode& mode) {
@@ -6,6 +6,9 @@ export module Microwave.Data.Library.ObjectLoader;
 import Microwave.Data.Library.AssetLoader;
 import Microwave.Data.Library.AssetManifest;
 import Microwave.Data.Library.AssetSettings;
+import Microwave.Graphics.AnimationClip;
+import Microwave.Graphics.Mesh;
+import Microwave.IO.BinaryArtifact;
 import Microwave.IO.MemoryStream;
 import Microwave.IO.File;
 import Microwave.System.Executor;
@@ -27,14 +30,38 @@ public:
         const gptr<Executor>& executor
     ) const override
     {
-        json val = co_await executor->Invoke(
-            [fp = filePath]{
-                auto text = File::ReadAllText(fp);
-                return json::parse(text);
-            });
-
         ObjectLinker linker;
-        auto obj = Object::CreateFromJson(val, &linker);
+        gptr<Object> obj;
+
+        if (BinaryArtifact::IsBinaryArtifact(filePath))
+        {
+            auto binary = co_await executor->Invoke(
+                [fp = filePath]{
+                    return gpnew<BinaryArtifact>(fp);
+                });
+
+            // everything is copied out of the streams, so don't leave
+            // the file mapped until the artifact is collected
+            try {
+                obj = CreateFromArtifact(*binary, &linker);
+            }
+            catch (...) {
+                binary->Close();
+                throw;
+            }
+
+            binary->Close();
+        }
+        else
+        {
+            json val = co_await executor->Invoke(
+                [fp = filePath]{
+                    auto text = File::ReadAllText(fp);
+                    return json::parse(text);
+                });
+
+            obj = Object::CreateFromJson(val, &linker);
+        }
         
         if(obj) {
             obj->SetUUID(artifact.uuid);
@@ -42,6 +69,28 @@ public:
         }
         co_return obj;
     }
+
+    // types without a binary layout store their JSON in the artifact's header
+    static gptr<Object> CreateFromArtifact(const BinaryArtifact& artifact, ObjectLinker* linker)
+    {
+        auto& header = artifact.GetHeader();
+        auto typeName = header.value("objectType", std::string());
+
+        if (typeName == Type::Get<Mesh>().name())
+        {
+            auto mesh = gpnew<Mesh>();
+            mesh->ReadArtifact(artifact, linker);
+            return mesh;
+        }
+        else if (typeName == Type::Get<AnimationClip>().name())
+        {
+            auto clip = gpnew<AnimationClip>();
+            clip->ReadArtifact(artifact, linker);
+            return clip;
+        }
+
+        return Object::CreateFromJson(header, linker);
+    }
 };
 
 } // data
@@ -5,7 +5,9 @@
 module Microwave.Graphics.AnimationClip;
 import Microwave.SceneGraph.Components.Animator;
 import Microwave.SceneGraph.Node;
+import Microwave.System.Exception;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import std;
@@ -25,6 +27,20 @@ void AnimationClip::ToJson(json& obj) const
     obj["wrapMode"] = wrapMode;
 }
 
+void AnimationClip::WriteJson(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WriteObjectJson(writer);
+    writer.Key("tracks").BeginObject();
+
+    for (auto& [path, track] : tracks)
+        writer.Property(path, *track);
+
+    writer.EndObject();
+    writer.Property("wrapMode", wrapMode);
+    writer.EndObject();
+}
+
 void AnimationClip::FromJson(const json& obj, ObjectLinker* linker)
 {
     Object::FromJson(obj, linker);
@@ -36,10 +52,133 @@ void AnimationClip::FromJson(const json& obj, ObjectLinker* linker)
     {
         auto track = gpnew<AnimationTrack>();
         from_json(trackObj, *track);
-        tracks[key] = track;
+        tracks[std::string(key)] = track;
 
-        if(!track->frames.empty())
-            length = std::max(length, track->frames.back().time);
+        length = std::max(length, track->GetLength());
+    }
+
+    wrapMode = obj.value("wrapMode", wrapMode);
+}
+
+static json WriteChannel(
+    const AnimationChannel& channel,
+    std::vector<float>& times,
+    std::vector<std::uint16_t>& values)
+{
+    json obj;
+    obj["first"] = times.size();
+    obj["count"] = channel.times.size();
+    obj["constant"] = channel.constant;
+    obj["rangeMin"] = channel.rangeMin;
+    obj["rangeSize"] = channel.rangeSize;
+
+    times.insert(times.end(), channel.times.begin(), channel.times.end());
+    values.insert(values.end(), channel.values.begin(), channel.values.end());
+    return obj;
+}
+
+static void ReadChannel(
+    const json& obj,
+    AnimationChannel& channel,
+    std::span<const float> times,
+    std::span<const std::uint16_t> values)
+{
+    auto first = obj.value("first", std::size_t());
+    auto count = obj.value("count", std::size_t());
+
+    if (first > times.size() || count > times.size() - first || (first + count) * 3 > values.size())
+        throw Exception("animation clip artifact has an invalid channel");
+
+    channel.times.assign(times.begin() + first, times.begin() + first + count);
+    channel.values.assign(values.begin() + first * 3, values.begin() + (first + count) * 3);
+    channel.constant = obj.value("constant", channel.constant);
+    channel.rangeMin = obj.value("rangeMin", channel.rangeMin);
+    channel.rangeSize = obj.value("rangeSize", channel.rangeSize);
+}
+
+void AnimationClip::WriteArtifact(BinaryArtifactWriter& writer) const
+{
+    static_assert(std::is_trivially_copyable_v<Keyframe>);
+
+    json& obj = writer.header;
+    Object::ToJson(obj);
+
+    std::vector<Keyframe> frames;
+    std::vector<float> channelTimes;
+    std::vector<std::uint16_t> channelValues;
+    json trackObjs = json::array();
+
+    for (auto& [path, track] : tracks)
+    {
+        json t;
+        t["path"] = path;
+
+        if (track->compressed)
+        {
+            // channels index into the shared time and value streams,
+            // with three values per key
+            t["length"] = track->length;
+            t["position"] = WriteChannel(track->position, channelTimes, channelValues);
+            t["rotation"] = WriteChannel(track->rotation, channelTimes, channelValues);
+            t["scale"] = WriteChannel(track->scale, channelTimes, channelValues);
+        }
+        else
+        {
+            t["first"] = frames.size();
+            t["count"] = track->frames.size();
+            frames.insert(frames.end(), track->frames.begin(), track->frames.end());
+        }
+
+        trackObjs.push_back(std::move(t));
+    }
+
+    obj["tracks"] = std::move(trackObjs);
+    obj["keyframes"] = writer.AddStream(frames);
+
+    if (!channelTimes.empty())
+    {
+        obj["channelTimes"] = writer.AddStream(channelTimes);
+        obj["channelValues"] = writer.AddStream(channelValues);
+    }
+
+    obj["wrapMode"] = wrapMode;
+}
+
+void AnimationClip::ReadArtifact(const BinaryArtifact& artifact, ObjectLinker* linker)
+{
+    const json& obj = artifact.GetHeader();
+    Object::FromJson(obj, linker);
+
+    auto frames = artifact.GetStreamAs<Keyframe>(obj.value("keyframes", -1));
+    auto channelTimes = artifact.GetStreamAs<float>(obj.value("channelTimes", -1));
+    auto channelValues = artifact.GetStreamAs<std::uint16_t>(obj.value("channelValues", -1));
+
+    ClearTracks();
+
+    for (auto& t : obj["tracks"])
+    {
+        auto track = gpnew<AnimationTrack>();
+
+        if (t.find("position") != t.end())
+        {
+            track->compressed = true;
+            track->length = t.value("length", 0.0f);
+            ReadChannel(t["position"], track->position, channelTimes, channelValues);
+            ReadChannel(t["rotation"], track->rotation, channelTimes, channelValues);
+            ReadChannel(t["scale"], track->scale, channelTimes, channelValues);
+        }
+        else
+        {
+            auto first = t.value("first", std::size_t());
+            auto count = t.value("count", std::size_t());
+
+            if (first > frames.size() || count > frames.size() - first)
+                throw Exception("animation clip artifact has an invalid track");
+
+            track->frames.assign(frames.begin() + first, frames.begin() + first + count);
+        }
+
+        AddTrack(t.value("path", std::string()), track);
     }
 
     wrapMode = obj.value("wrapMode", wrapMode);
@@ -48,9 +187,7 @@ void AnimationClip::FromJson(const json& obj, ObjectLinker* linker)
 void AnimationClip::AddTrack(const std::string& path, const gptr<AnimationTrack>& track)
 {
     tracks[path] = track;
-
-    if (!track->frames.empty())
-        length = std::max(length, track->frames.back().time);
+    length = std::max(length, track->GetLength());
 }
 
 void AnimationClip::ClearTracks()
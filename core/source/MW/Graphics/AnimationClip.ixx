@@ -4,9 +4,11 @@
 
 export module Microwave.Graphics.AnimationClip;
 import Microwave.Graphics.AnimationTrack;
+import Microwave.IO.BinaryArtifact;
 import Microwave.Math;
 import Microwave.SceneGraph.Node;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import std;
@@ -40,6 +42,11 @@ public:
 
     virtual void ToJson(json& obj) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
+    virtual void WriteJson(JsonWriter& writer) const override;
+
+    // keyframes of all tracks are stored in a single stream
+    void WriteArtifact(BinaryArtifactWriter& writer) const;
+    void ReadArtifact(const BinaryArtifact& artifact, ObjectLinker* linker);
 };
 
 void to_json(json& obj, const AnimationWrapMode& wrapMode)
@@ -0,0 +1,241 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Microwave.Graphics.AnimationTrack;
+import std;
+
+namespace mw {
+inline namespace gfx {
+
+static float VectorError(const Vec3& a, const Vec3& b) {
+    return (a - b).Length();
+}
+
+// angle between two rotations, in radians
+static float RotationError(const Quat& a, const Quat& b)
+{
+    // rotation from 'a' to 'b'. atan2 stays accurate for small angles,
+    // where acos of the dot product would be dominated by rounding
+    Vec3 v = b.v * a.w - a.v * b.w - Vec3(
+        a.v.y * b.v.z - a.v.z * b.v.y,
+        a.v.z * b.v.x - a.v.x * b.v.z,
+        a.v.x * b.v.y - a.v.y * b.v.x);
+
+    return 2.0f * std::atan2(v.Length(), std::abs(a.Dot(b)));
+}
+
+static void QuantizeVector(const Vec3& value, const Vec3& rangeMin, const Vec3& rangeSize, std::uint16_t* out)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        float t = rangeSize[i] > 0 ? (value[i] - rangeMin[i]) / rangeSize[i] : 0.0f;
+        out[i] = (std::uint16_t)std::lround(std::clamp(t, 0.0f, 1.0f) * 65535.0f);
+    }
+}
+
+static void QuantizeRotation(const Quat& rotation, std::uint16_t* out)
+{
+    Quat q = rotation.Normalized();
+    float c[4] = { q.v.x, q.v.y, q.v.z, q.w };
+
+    int largest = 0;
+    for (int i = 1; i < 4; ++i)
+    {
+        if (std::abs(c[i]) > std::abs(c[largest]))
+            largest = i;
+    }
+
+    // q and -q are the same rotation, so the largest component can
+    // always be positive and rebuilt from the other three
+    float sign = c[largest] < 0 ? -1.0f : 1.0f;
+
+    for (int i = 0, j = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+
+        // the smaller components are within +/- 1/sqrt(2)
+        float t = (c[i] * sign + 0.70710678f) / 1.41421356f;
+        out[j++] = (std::uint16_t)std::lround(std::clamp(t, 0.0f, 1.0f) * 32767.0f);
+    }
+
+    out[0] |= (std::uint16_t)((largest & 1) << 15);
+    out[1] |= (std::uint16_t)((largest >> 1) << 15);
+}
+
+// Picks the keys to keep, so that interpolating between kept keys is
+// within 'tolerance' of every dropped one. 'error(a, b, i, t)' measures
+// key 'i' against keys 'a' and 'b' interpolated by 't'.
+template<class F>
+static std::vector<std::size_t> ReduceKeys(const std::vector<Keyframe>& frames, float tolerance, F&& error)
+{
+    std::vector<std::size_t> kept{ 0 };
+    std::size_t start = 0;
+
+    for (std::size_t end = 2; end < frames.size(); ++end)
+    {
+        float span = frames[end].time - frames[start].time;
+
+        for (std::size_t i = start + 1; i < end; ++i)
+        {
+            float t = (frames[i].time - frames[start].time) / span;
+
+            if (error(start, end, i, t) > tolerance)
+            {
+                start = end - 1;
+                kept.push_back(start);
+                break;
+            }
+        }
+    }
+
+    if (frames.size() > 1)
+        kept.push_back(frames.size() - 1);
+
+    return kept;
+}
+
+static AnimationChannel CompressVectors(
+    const std::vector<Keyframe>& frames,
+    Vec3 Transform::* member,
+    float tolerance)
+{
+    AnimationChannel channel;
+
+    const Vec3& first = frames[0].value.*member;
+
+    bool constant = std::all_of(frames.begin(), frames.end(),
+        [&](const Keyframe& k) { return VectorError(k.value.*member, first) <= tolerance; });
+
+    if (constant)
+    {
+        channel.constant = Vec4(first.x, first.y, first.z, 0.0f);
+        return channel;
+    }
+
+    Vec3 vmin = first;
+    Vec3 vmax = first;
+
+    for (auto& k : frames)
+    {
+        const Vec3& v = k.value.*member;
+        vmin = Vec3(std::min(vmin.x, v.x), std::min(vmin.y, v.y), std::min(vmin.z, v.z));
+        vmax = Vec3(std::max(vmax.x, v.x), std::max(vmax.y, v.y), std::max(vmax.z, v.z));
+    }
+
+    channel.rangeMin = vmin;
+    channel.rangeSize = vmax - vmin;
+
+    // measure against quantized values, so the tolerance covers both
+    std::vector<std::uint16_t> quantized(frames.size() * 3);
+    for (std::size_t i = 0; i < frames.size(); ++i)
+        QuantizeVector(frames[i].value.*member, vmin, channel.rangeSize, &quantized[i * 3]);
+
+    channel.values = std::move(quantized);
+
+    auto kept = ReduceKeys(frames, tolerance,
+        [&](std::size_t a, std::size_t b, std::size_t i, float t) {
+            Vec3 value = Vec3::Lerp(channel.GetVector(a), channel.GetVector(b), t);
+            return VectorError(value, frames[i].value.*member);
+        });
+
+    std::vector<std::uint16_t> values;
+    values.reserve(kept.size() * 3);
+    channel.times.reserve(kept.size());
+
+    for (auto i : kept)
+    {
+        channel.times.push_back(frames[i].time);
+        values.insert(values.end(), &channel.values[i * 3], &channel.values[i * 3] + 3);
+    }
+
+    channel.values = std::move(values);
+    return channel;
+}
+
+static AnimationChannel CompressRotations(const std::vector<Keyframe>& frames, float tolerance)
+{
+    AnimationChannel channel;
+
+    const Quat& first = frames[0].value.rotation;
+
+    bool constant = std::all_of(frames.begin(), frames.end(),
+        [&](const Keyframe& k) { return RotationError(k.value.rotation, first) <= tolerance; });
+
+    if (constant)
+    {
+        Quat q = first.Normalized();
+        channel.constant = Vec4(q.v.x, q.v.y, q.v.z, q.w);
+        return channel;
+    }
+
+    channel.values.resize(frames.size() * 3);
+    for (std::size_t i = 0; i < frames.size(); ++i)
+        QuantizeRotation(frames[i].value.rotation, &channel.values[i * 3]);
+
+    auto kept = ReduceKeys(frames, tolerance,
+        [&](std::size_t a, std::size_t b, std::size_t i, float t) {
+            Quat value = Quat::Slerp(channel.GetRotation(a), channel.GetRotation(b), t);
+            return RotationError(value, frames[i].value.rotation);
+        });
+
+    std::vector<std::uint16_t> values;
+    values.reserve(kept.size() * 3);
+    channel.times.reserve(kept.size());
+
+    for (auto i : kept)
+    {
+        channel.times.push_back(frames[i].time);
+        values.insert(values.end(), &channel.values[i * 3], &channel.values[i * 3] + 3);
+    }
+
+    channel.values = std::move(values);
+    return channel;
+}
+
+AnimationCompressionStats& AnimationCompressionStats::operator+=(const AnimationCompressionStats& other)
+{
+    originalSize += other.originalSize;
+    compressedSize += other.compressedSize;
+    maxPositionError = std::max(maxPositionError, other.maxPositionError);
+    maxRotationError = std::max(maxRotationError, other.maxRotationError);
+    maxScaleError = std::max(maxScaleError, other.maxScaleError);
+    return *this;
+}
+
+AnimationCompressionStats AnimationTrack::Compress(const AnimationTolerance& tolerance)
+{
+    AnimationCompressionStats stats;
+
+    if (compressed || frames.empty())
+        return stats;
+
+    position = CompressVectors(frames, &Transform::position, tolerance.position);
+    rotation = CompressRotations(frames, tolerance.rotation);
+    scale = CompressVectors(frames, &Transform::scale, tolerance.scale);
+    length = frames.back().time;
+    compressed = true;
+
+    stats.originalSize = frames.size() * sizeof(Keyframe);
+    stats.compressedSize = sizeof(AnimationChannel) * 3
+        + position.GetSize() + rotation.GetSize() + scale.GetSize();
+
+    TrackCursor cursor;
+
+    for (auto& k : frames)
+    {
+        Transform value = Evaluate(k.time, cursor);
+        stats.maxPositionError = std::max(stats.maxPositionError, VectorError(value.position, k.value.position));
+        stats.maxRotationError = std::max(stats.maxRotationError, RotationError(value.rotation, k.value.rotation));
+        stats.maxScaleError = std::max(stats.maxScaleError, VectorError(value.scale, k.value.scale));
+    }
+
+    frames.clear();
+    frames.shrink_to_fit();
+
+    return stats;
+}
+
+} // gfx
+} // mw
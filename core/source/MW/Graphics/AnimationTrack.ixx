@@ -5,6 +5,7 @@
 export module Microwave.Graphics.AnimationTrack;
 import Microwave.System.Exception;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.Math;
 import <MW/System/Debug.h>;
 import std;
@@ -19,35 +20,137 @@ public:
     Transform value;
 };
 
+// largest error AnimationTrack::Compress may introduce at a keyframe
+struct AnimationTolerance
+{
+    float position = 0.001f;    // distance
+    float rotation = 0.001f;    // radians
+    float scale = 0.001f;
+};
+
+// size and accuracy of a compressed track
+struct AnimationCompressionStats
+{
+    std::size_t originalSize = 0;
+    std::size_t compressedSize = 0;
+    float maxPositionError = 0;
+    float maxRotationError = 0;
+    float maxScaleError = 0;
+
+    AnimationCompressionStats& operator+=(const AnimationCompressionStats& other);
+};
+
+// One channel of a compressed track, with three 16 bit values per key.
+// Positions and scales are quantized over the range of the channel.
+// Rotations keep the three smallest quaternion components, with the
+// index of the largest one in the high bits of the first two values.
+struct AnimationChannel
+{
+    std::vector<float> times;           // empty if the channel is constant
+    std::vector<std::uint16_t> values;
+    Vec4 constant;                      // xyz, or a quaternion as xyzw
+    Vec3 rangeMin;
+    Vec3 rangeSize;
+
+    bool IsConstant() const {
+        return times.empty();
+    }
+
+    std::size_t GetSize() const {
+        return times.size() * sizeof(float) + values.size() * sizeof(std::uint16_t);
+    }
+
+    Vec3 GetVector(std::size_t key) const
+    {
+        auto q = &values[key * 3];
+        return rangeMin + rangeSize.Multiply(Vec3(q[0], q[1], q[2]) * (1.0f / 65535.0f));
+    }
+
+    Quat GetRotation(std::size_t key) const
+    {
+        constexpr float scale = 1.41421356f / 32767.0f;
+        constexpr float offset = -0.70710678f;
+
+        auto q = &values[key * 3];
+        int largest = (q[0] >> 15) | ((q[1] >> 15) << 1);
+
+        float small[3] = {
+            (q[0] & 0x7FFF) * scale + offset,
+            (q[1] & 0x7FFF) * scale + offset,
+            (q[2] & 0x7FFF) * scale + offset,
+        };
+
+        float sumSq = small[0] * small[0] + small[1] * small[1] + small[2] * small[2];
+        float c[4];
+
+        for (int i = 0, j = 0; i < 4; ++i)
+            c[i] = (i == largest) ? std::sqrt(std::max(0.0f, 1.0f - sumSq)) : small[j++];
+
+        return Quat(c[0], c[1], c[2], c[3]);
+    }
+};
+
+// where Evaluate last found keyframes, for each channel
+struct TrackCursor
+{
+    std::size_t position = 0;
+    std::size_t rotation = 0;
+    std::size_t scale = 0;
+};
+
 class AnimationTrack
 {
 public:
     std::vector<Keyframe> frames;
 
-    Transform Evaluate(float time)
+    // set by Compress, which leaves 'frames' empty
+    bool compressed = false;
+    float length = 0;
+    AnimationChannel position;
+    AnimationChannel rotation;
+    AnimationChannel scale;
+
+    Transform Evaluate(float time) const
     {
+        TrackCursor cursor;
+        return Evaluate(time, cursor);
+    }
+
+    // Same as Evaluate(time), but starts searching for the keyframes at
+    // 'cursor' and updates it. Passing the same cursor back each frame
+    // makes forward playback find its keyframes in constant time.
+    Transform Evaluate(float time, TrackCursor& cursor) const
+    {
+        if (compressed)
+        {
+            Transform ret;
+            ret.position = EvaluateVector(position, time, cursor.position);
+            ret.rotation = EvaluateRotation(rotation, time, cursor.rotation);
+            ret.scale = EvaluateVector(scale, time, cursor.scale);
+            return ret;
+        }
+
         if (frames.empty())
             return {};
 
         if (frames.size() == 1)
             return frames.begin()->value;
 
-        auto it = std::lower_bound(
-            frames.begin(), frames.end(), time,
-            [](const Keyframe& k, float t) { return k.time < t; });
+        auto& key = cursor.position;
+        key = FindKey(frames.size(), time, key, [this](std::size_t i) { return frames[i].time; });
 
-        if (it == frames.begin())
+        if (key == 0)
         {
-            return it->value;
+            return frames[0].value;
         }
-        else if (it == frames.end())
+        else if (key == frames.size())
         {
-            return (it - 1)->value;
+            return frames.back().value;
         }
         else
         {
-            const auto& a = *(it - 1);
-            const auto& b = *it;
+            const auto& a = frames[key - 1];
+            const auto& b = frames[key];
             
             Assert((b.time - a.time) >= std::numeric_limits<float>::epsilon());
             auto t = (time - a.time) / (b.time - a.time);
@@ -60,9 +163,111 @@ public:
         }
     }
 
-    float GetLength() const {
+    float GetLength() const
+    {
+        if (compressed)
+            return length;
+
         return frames.empty() ? 0 : frames.back().time;
     }
+
+    // Replaces the keyframes with quantized channels. Channels that don't
+    // change are stored as a single value, and keys that can be
+    // interpolated from their neighbours within 'tolerance' are dropped.
+    AnimationCompressionStats Compress(const AnimationTolerance& tolerance);
+
+private:
+    // index of the first key at or after 'time', like lower_bound
+    template<class F>
+    static std::size_t FindKey(std::size_t count, float time, std::size_t hint, F&& timeAt)
+    {
+        constexpr std::size_t MaxSteps = 4;
+
+        auto i = std::min(hint, count);
+
+        if (i == 0 || timeAt(i - 1) < time)
+        {
+            for (std::size_t step = 0; step < MaxSteps; ++step)
+            {
+                if (i == count || timeAt(i) >= time)
+                    return i;
+
+                ++i;
+            }
+        }
+
+        // time went backwards or jumped ahead
+        std::size_t lo = 0, hi = count;
+
+        while (lo < hi)
+        {
+            auto mid = lo + (hi - lo) / 2;
+
+            if (timeAt(mid) < time)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return lo;
+    }
+
+    // finds the keys around 'time', returning false if 'time' is outside
+    // them and 'a' should be used on its own
+    static bool FindKeys(
+        const AnimationChannel& channel, float time, std::size_t& cursor,
+        std::size_t& a, std::size_t& b, float& t)
+    {
+        auto& times = channel.times;
+        auto count = times.size();
+
+        if (count == 1)
+        {
+            a = 0;
+            return false;
+        }
+
+        cursor = FindKey(count, time, cursor, [&times](std::size_t i) { return times[i]; });
+
+        if (cursor == 0 || cursor == count)
+        {
+            a = cursor == 0 ? 0 : count - 1;
+            return false;
+        }
+
+        a = cursor - 1;
+        b = cursor;
+        t = (time - times[a]) / (times[b] - times[a]);
+        return true;
+    }
+
+    static Vec3 EvaluateVector(const AnimationChannel& channel, float time, std::size_t& cursor)
+    {
+        if (channel.IsConstant())
+            return Vec3(channel.constant.x, channel.constant.y, channel.constant.z);
+
+        std::size_t a, b;
+        float t;
+
+        if (!FindKeys(channel, time, cursor, a, b, t))
+            return channel.GetVector(a);
+
+        return Vec3::Lerp(channel.GetVector(a), channel.GetVector(b), t);
+    }
+
+    static Quat EvaluateRotation(const AnimationChannel& channel, float time, std::size_t& cursor)
+    {
+        if (channel.IsConstant())
+            return Quat(channel.constant.x, channel.constant.y, channel.constant.z, channel.constant.w);
+
+        std::size_t a, b;
+        float t;
+
+        if (!FindKeys(channel, time, cursor, a, b, t))
+            return channel.GetRotation(a);
+
+        return Quat::Slerp(channel.GetRotation(a), channel.GetRotation(b), t);
+    }
 };
 
 void to_json(json& obj, const Keyframe& keyframe)
@@ -71,20 +276,98 @@ void to_json(json& obj, const Keyframe& keyframe)
     obj["value"] = keyframe.value;
 }
 
+void to_json(JsonWriter& writer, const Keyframe& keyframe) {
+    writer.BeginObject().Property("time", keyframe.time).Property("value", keyframe.value).EndObject();
+}
+
 void from_json(const json& obj, Keyframe& keyframe)
 {
     keyframe.time = obj.value("time", keyframe.time);
     keyframe.value = obj.value("value", keyframe.value);
 }
 
+void to_json(json& obj, const AnimationChannel& channel)
+{
+    obj["times"] = channel.times;
+    obj["values"] = channel.values;
+    obj["constant"] = channel.constant;
+    obj["rangeMin"] = channel.rangeMin;
+    obj["rangeSize"] = channel.rangeSize;
+}
+
+void to_json(JsonWriter& writer, const AnimationChannel& channel)
+{
+    writer.BeginObject()
+        .Property("times", channel.times)
+        .Property("values", channel.values)
+        .Property("constant", channel.constant)
+        .Property("rangeMin", channel.rangeMin)
+        .Property("rangeSize", channel.rangeSize)
+        .EndObject();
+}
+
+void from_json(const json& obj, AnimationChannel& channel)
+{
+    channel.times = obj.value("times", std::vector<float>());
+    channel.values = obj.value("values", std::vector<std::uint16_t>());
+    channel.constant = obj.value("constant", channel.constant);
+    channel.rangeMin = obj.value("rangeMin", channel.rangeMin);
+    channel.rangeSize = obj.value("rangeSize", channel.rangeSize);
+
+    if (channel.values.size() != channel.times.size() * 3)
+        throw Exception("animation channel has the wrong number of values");
+}
+
 void to_json(json& obj, const AnimationTrack& track)
 {
-    obj["frames"] = track.frames;
+    if (track.compressed)
+    {
+        obj["length"] = track.length;
+        obj["position"] = track.position;
+        obj["rotation"] = track.rotation;
+        obj["scale"] = track.scale;
+    }
+    else
+    {
+        obj["frames"] = track.frames;
+    }
+}
+
+void to_json(JsonWriter& writer, const AnimationTrack& track)
+{
+    writer.BeginObject();
+
+    if (track.compressed)
+    {
+        writer.Property("length", track.length)
+            .Property("position", track.position)
+            .Property("rotation", track.rotation)
+            .Property("scale", track.scale);
+    }
+    else
+    {
+        writer.Property("frames", track.frames);
+    }
+
+    writer.EndObject();
 }
 
 void from_json(const json& obj, AnimationTrack& track)
 {
-    track.frames = obj.value("frames", std::vector<Keyframe>());
+    track.compressed = obj.find("position") != obj.end();
+
+    if (track.compressed)
+    {
+        track.frames.clear();
+        track.length = obj.value("length", 0.0f);
+        track.position = obj.value("position", AnimationChannel());
+        track.rotation = obj.value("rotation", AnimationChannel());
+        track.scale = obj.value("scale", AnimationChannel());
+    }
+    else
+    {
+        track.frames = obj.value("frames", std::vector<Keyframe>());
+    }
 }
 
 }
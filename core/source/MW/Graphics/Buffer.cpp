@@ -21,6 +21,7 @@ Buffer::Buffer(BufferType type, BufferUsage usage, BufferCPUAccess cpuAccess, st
         throw Exception("no active graphics context");
 
     buffer = graphics->context->CreateBuffer(type, usage, cpuAccess, size);
+    graphics->InvalidateBindings();
 }
 
 Buffer::Buffer(BufferType type, BufferUsage usage, BufferCPUAccess cpuAccess, const std::span<std::byte>& data)
@@ -34,6 +35,7 @@ Buffer::Buffer(BufferType type, BufferUsage usage, BufferCPUAccess cpuAccess, co
         throw Exception("no active graphics context");
 
     buffer = graphics->context->CreateBuffer(type, usage, cpuAccess, data);
+    graphics->InvalidateBindings();
 }
 
 void Buffer::UpdateSubData(std::size_t offset, const std::span<std::byte>& data)
@@ -49,6 +51,10 @@ void Buffer::UpdateSubData(std::size_t offset, const std::span<std::byte>& data)
         std::span<std::byte> mapping = buffer->Map(BufferMapAccess::WriteNoSync);
         std::copy(data.begin(), data.end(), mapping.begin() + offset);
         buffer->Unmap();
+
+        // mapping may rebind the buffer
+        if (auto& graphics = GraphicsContext::GetCurrent())
+            graphics->InvalidateBindings();
     }
 }
 
@@ -24,5 +24,7 @@ export import Microwave.Graphics.RenderTarget;
 export import Microwave.Graphics.RenderTexture;
 export import Microwave.Graphics.Shader;
 export import Microwave.Graphics.ShaderInfo;
+export import Microwave.Graphics.Skinning;
 export import Microwave.Graphics.Texture;
+export import Microwave.Graphics.TextureData;
 export import Microwave.Graphics.Types;
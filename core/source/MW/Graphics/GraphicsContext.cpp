@@ -7,6 +7,7 @@ module;
 
 module Microwave.Graphics.GraphicsContext;
 import Microwave.Graphics.Internal.HWContextD3D11;
+import Microwave.Graphics.Internal.HWContextNull;
 import Microwave.Graphics.Internal.HWContextOpenGL;
 import Microwave.Graphics;
 import Microwave.System.Dispatcher;
@@ -29,7 +30,7 @@ void GraphicsContext::SetCurrent(const gptr<GraphicsContext>& current)
         currentContext->context->SetActive(true);
 }
 
-gptr<GraphicsContext> GraphicsContext::GetCurrent() {
+const gptr<GraphicsContext>& GraphicsContext::GetCurrent() {
     return currentContext;
 }
 
@@ -41,8 +42,14 @@ GraphicsContext::GraphicsContext(GraphicsDriverType type)
         context = gpnew<HWContextD3D11>();
 #elif PLATFORM_IOS || PLATFORM_ANDROID || PLATFORM_MACOS
         context = gpnew<HWContextOpenGL>();
+#else
+        context = gpnew<HWContextNull>();
 #endif
     }
+    else if(type == GraphicsDriverType::None)
+    {
+        context = gpnew<HWContextNull>();
+    }
     else if(type == GraphicsDriverType::Direct3D11)
     {
 #if PLATFORM_WINDOWS
@@ -91,6 +98,7 @@ void GraphicsContext::SetViewport(const IntRect& rect)
 {
     viewportRect = rect;
     context->SetViewport(rect);
+    ++stats.stateChanges;
 }
 
 bool GraphicsContext::IsBlendingEnabled() const {
@@ -101,6 +109,10 @@ void GraphicsContext::SetBlendingEnabled(bool enabled) {
     if (blendingEnabled != enabled) {
         blendingEnabled = enabled;
         context->SetBlendingEnabled(enabled);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -112,6 +124,10 @@ void GraphicsContext::SetScissorTestEnabled(bool enabled) {
     if (scissorTestEnabled != enabled) {
         scissorTestEnabled = enabled;
         context->SetScissorTestEnabled(enabled);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -124,6 +140,10 @@ void GraphicsContext::SetScissorRect(const IntRect& rect)
     if (scissorRect != rect) {
         scissorRect = rect;
         context->SetScissorRect(rect);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -135,6 +155,10 @@ void GraphicsContext::SetClearColor(const Color& color) {
     if(clearColor != color) {
         clearColor = color;
         context->SetClearColor(color);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -150,6 +174,10 @@ void GraphicsContext::SetColorMask(bool red, bool green, bool blue, bool alpha)
         colorMask[2] = blue;
         colorMask[3] = alpha;
         context->SetColorMask(red, green, blue, alpha);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -165,6 +193,10 @@ void GraphicsContext::SetBlendFactors(BlendFactor source, BlendFactor dest)
         srcAlphaFactor = source;
         dstAlphaFactor = dest;
         context->SetBlendFactors(source, dest, source, dest);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -182,6 +214,10 @@ void GraphicsContext::SetBlendFactors(
         srcAlphaFactor = sourceAlpha;
         dstAlphaFactor = destAlpha;
         context->SetBlendFactors(sourceColor, destColor, sourceAlpha, destAlpha);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -208,6 +244,10 @@ void GraphicsContext::SetBlendOperations(BlendOperation blendOp)
         colorBlendOperation = blendOp;
         alphaBlendOperation = blendOp;
         context->SetBlendOperations(blendOp, blendOp);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -219,6 +259,10 @@ void GraphicsContext::SetBlendOperations(
         colorBlendOperation = colorBlendOp;
         alphaBlendOperation = alphaBlendOp;
         context->SetBlendOperations(colorBlendOp, alphaBlendOp);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -239,6 +283,10 @@ void GraphicsContext::SetBlendColor(Color color)
     if (blendColor != color) {
         blendColor = color;
         context->SetBlendColor(color);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -251,6 +299,10 @@ void GraphicsContext::SetCullMode(CullMode mode)
     if (cullMode != mode) {
         cullMode = mode;
         context->SetCullMode(mode);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -258,9 +310,16 @@ DepthTest GraphicsContext::GetDepthTest() const {
     return depthTest;
 }
 
-void GraphicsContext::SetDepthTest(DepthTest test) {
-    depthTest = test;
-    context->SetDepthTest(test);
+void GraphicsContext::SetDepthTest(DepthTest test)
+{
+    if (depthTest != test) {
+        depthTest = test;
+        context->SetDepthTest(test);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
+    }
 }
 
 bool GraphicsContext::IsDepthWriteEnabled() const {
@@ -271,6 +330,10 @@ void GraphicsContext::SetDepthWriteEnabled(bool enabled) {
     if(depthWriteEnabled != enabled) {
         depthWriteEnabled = enabled;
         context->SetDepthWriteEnabled(enabled);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -282,6 +345,10 @@ void GraphicsContext::SetSwapInterval(int interval) {
     if (swapInterval != interval) {
         swapInterval = interval;
         context->SetSwapInterval(interval);
+        ++stats.stateChanges;
+    }
+    else {
+        ++stats.redundantChanges;
     }
 }
 
@@ -317,16 +384,129 @@ void GraphicsContext::Flush() {
     context->Flush();
 }
 
-void GraphicsContext::Flip() {
+void GraphicsContext::Flip()
+{
     context->Flip(renderTarget->GetHWRenderTarget());
+
+    // resources may be released between frames
+    InvalidateBindings();
 }
 
 void GraphicsContext::DrawArray(int start, int count, DrawMode mode) {
     context->DrawArray(start, count, mode);
+    ++stats.drawCalls;
 }
 
 void GraphicsContext::DrawIndexed(int start, int count, DrawMode mode) {
     context->DrawIndexed(start, count, mode);
+    ++stats.drawCalls;
+}
+
+void GraphicsContext::SetShader(const gptr<HWShader>& shader)
+{
+    if (boundShader == shader.get()) {
+        ++stats.redundantChanges;
+        return;
+    }
+
+    shader->Bind();
+    ++stats.shaderChanges;
+
+    // vertex inputs, textures, and uniform buffers are per-shader
+    boundShader = shader.get();
+    boundIndexBuffer = nullptr;
+    boundVertexBuffers.assign(shader->info->attributes.size(), {});
+    boundTextures.assign(shader->info->uniforms.size(), nullptr);
+}
+
+void GraphicsContext::ClearShader(const gptr<HWShader>& shader)
+{
+    shader->Unbind();
+
+    if (boundShader == shader.get())
+        InvalidateBindings();
+}
+
+void GraphicsContext::SetVertexBuffer(
+    const gptr<HWShader>& shader, int id,
+    const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride)
+{
+    if (id < 0)
+        return;
+
+    if (boundShader == shader.get())
+    {
+        auto& binding = boundVertexBuffers[id];
+        auto hwBuffer = buffer ? buffer->GetHWBuffer().get() : nullptr;
+
+        if (binding.buffer == hwBuffer &&
+            binding.offset == offset &&
+            binding.stride == stride)
+        {
+            ++stats.redundantChanges;
+            return;
+        }
+
+        binding = { hwBuffer, offset, stride };
+    }
+
+    shader->SetVertexBuffer(id, buffer, offset, stride);
+    ++stats.bufferChanges;
+}
+
+void GraphicsContext::SetIndexBuffer(const gptr<HWShader>& shader, const gptr<Buffer>& buffer)
+{
+    if (boundShader == shader.get())
+    {
+        auto hwBuffer = buffer ? buffer->GetHWBuffer().get() : nullptr;
+
+        if (boundIndexBuffer == hwBuffer) {
+            ++stats.redundantChanges;
+            return;
+        }
+
+        boundIndexBuffer = hwBuffer;
+    }
+
+    shader->SetIndexBuffer(buffer);
+    ++stats.bufferChanges;
+}
+
+void GraphicsContext::SetTexture(const gptr<HWShader>& shader, int id, const gptr<Texture>& texture)
+{
+    if (id < 0)
+        return;
+
+    if (boundShader == shader.get())
+    {
+        auto hwTexture = texture ? texture->GetHWTexture().get() : nullptr;
+
+        if (boundTextures[id] == hwTexture) {
+            ++stats.redundantChanges;
+            return;
+        }
+
+        boundTextures[id] = hwTexture;
+    }
+
+    shader->SetUniform(id, texture);
+    ++stats.textureChanges;
+}
+
+void GraphicsContext::InvalidateBindings()
+{
+    boundShader = nullptr;
+    boundIndexBuffer = nullptr;
+    boundVertexBuffers.clear();
+    boundTextures.clear();
+}
+
+const GraphicsStats& GraphicsContext::GetStats() const {
+    return stats;
+}
+
+void GraphicsContext::ResetStats() {
+    stats = {};
 }
 
 Mat4 GraphicsContext::GetOrthoMatrix(
@@ -13,6 +13,7 @@ import Microwave.Graphics.Color;
 import Microwave.Graphics.Internal.HWBuffer;
 import Microwave.Graphics.Internal.HWContext;
 import Microwave.Graphics.Internal.HWRenderTexture;
+import Microwave.Graphics.Internal.HWShader;
 import Microwave.Graphics.Internal.HWTexture;
 import Microwave.Math;
 import Microwave.System.Object;
@@ -22,9 +23,37 @@ import std;
 export namespace mw {
 inline namespace gfx {
 
+// work submitted to the driver since the last ResetStats()
+struct GraphicsStats
+{
+    std::uint32_t drawCalls = 0;
+    std::uint32_t shaderChanges = 0;
+    std::uint32_t bufferChanges = 0;
+    std::uint32_t textureChanges = 0;
+    std::uint32_t stateChanges = 0;
+    std::uint32_t redundantChanges = 0; // skipped, since they were already set
+};
+
 class GraphicsContext : public Object
 {
     thread_local static gptr<GraphicsContext> currentContext;
+
+    struct VertexBinding
+    {
+        HWBuffer* buffer = nullptr;
+        std::size_t offset = 0;
+        std::size_t stride = 0;
+    };
+
+    // Bindings of the active shader. These are raw pointers, so they're
+    // forgotten whenever a resource is created, in case it reuses the
+    // address of one that was destroyed.
+    HWShader* boundShader = nullptr;
+    HWBuffer* boundIndexBuffer = nullptr;
+    std::vector<VertexBinding> boundVertexBuffers;
+    std::vector<HWTexture*> boundTextures;
+
+    GraphicsStats stats;
 public:
     gptr<HWContext> context;
     gptr<RenderTarget> renderTarget;
@@ -47,7 +76,7 @@ public:
     int swapInterval = 1;
 
     static void SetCurrent(const gptr<GraphicsContext>& current);
-    static gptr<GraphicsContext> GetCurrent();
+    static const gptr<GraphicsContext>& GetCurrent();
 
     GraphicsContext(GraphicsDriverType type = GraphicsDriverType::Default);
     ~GraphicsContext();
@@ -113,6 +142,19 @@ public:
     void DrawArray(int start, int count, DrawMode mode);
     void DrawIndexed(int start, int count, DrawMode mode);
 
+    // Shader and resource bindings, skipping the ones that are already set.
+    // Anything that changes the driver's bindings behind the context's back,
+    // like creating or uploading to a resource, must call InvalidateBindings().
+    void SetShader(const gptr<HWShader>& shader);
+    void ClearShader(const gptr<HWShader>& shader);
+    void SetVertexBuffer(const gptr<HWShader>& shader, int id, const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride);
+    void SetIndexBuffer(const gptr<HWShader>& shader, const gptr<Buffer>& buffer);
+    void SetTexture(const gptr<HWShader>& shader, int id, const gptr<Texture>& texture);
+    void InvalidateBindings();
+
+    const GraphicsStats& GetStats() const;
+    void ResetStats();
+
     Mat4 GetOrthoMatrix(
         float left, float right,
         float bottom, float top,
@@ -2,12 +2,36 @@
 *  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
 *--------------------------------------------------------------*/
 
+module;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#  include <emmintrin.h>
+#  define MW_IMAGE_SSE2 1
+#endif
+
+// SSSE3 isn't part of the x64 baseline, so its kernels are always built on
+// x86 and picked at runtime. GCC and Clang need the target attribute to
+// compile them when the rest of the file targets plain SSE2.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#  include <tmmintrin.h>
+#  if defined(_MSC_VER)
+#    include <intrin.h>
+#  endif
+#  if defined(__GNUC__) || defined(__clang__)
+#    define MW_IMAGE_TARGET_SSSE3 __attribute__((target("ssse3")))
+#  else
+#    define MW_IMAGE_TARGET_SSSE3
+#  endif
+#  define MW_IMAGE_SSSE3 1
+#endif
+
 module Microwave.Graphics.Image;
 import Microwave.Graphics.GraphicsTypes;
 import Microwave.IO.File;
 import Microwave.IO.FileStream;
 import Microwave.Math;
 import Microwave.System.Exception;
+import Microwave.System.JobSystem;
 import Microwave.System.Pointers;
 import Microwave.Utilities.Util;
 import <png.h>;
@@ -989,277 +1013,342 @@ std::byte* Image::GetPixel(std::uint32_t x, std::uint32_t y) {
     return data.get() + (y * size.x + x) * GetBytesPerPixel(format);
 }
 
-std::byte ConvertToGrayscale(std::byte r, std::byte g, std::byte b)
-{
-    std::uint32_t rfrac = (std::uint32_t)r * 2990000;
-    std::uint32_t gfrac = (std::uint32_t)g * 5870000;
-    std::uint32_t bfrac = (std::uint32_t)b * 1140000;
-    std::uint32_t lum = ((rfrac + gfrac + bfrac) + 5000000) / 10000000;
-    return (std::byte)std::min(std::max(lum, 0U), 255U);
-}
+// pixels converted by a single job
+constexpr std::size_t ConvertChunkSize = 1 << 16;
 
-void ConvertPixel_Alpha8ToAlpha8(std::byte*& src, std::byte*& dst) {
-    *dst++ = *src++;
-}
+// pixels held in the float buffer when adjusting colors
+constexpr std::size_t ConvertBlockSize = 256;
+
+typedef void(*ConvertRowFunc)(const std::byte* src, std::byte* dst, std::size_t count);
 
-void ConvertPixel_Alpha8ToRGB24(std::byte*& src, std::byte*& dst) {
-    std::byte alpha = *src++;
-    *dst++ = alpha;
-    *dst++ = alpha;
-    *dst++ = alpha;
+static float SRGBToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
 }
 
-void ConvertPixel_Alpha8ToRGBA32(std::byte*& src, std::byte*& dst) {
-    std::byte alpha = *src++;
-    *dst++ = alpha;
-    *dst++ = alpha;
-    *dst++ = alpha;
-    *dst++ = (std::byte)255;
+static float LinearToSRGB(float c) {
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
 }
 
-void ConvertPixel_Alpha8ToRGBAFloat(std::byte*& src, std::byte*& dst)
+// byte channel values as floats, so expanding them is a lookup
+struct ByteTables
 {
-    float alpha = math::Clamp01((float)*src++ / 255.0f);
-    
-    std::byte* pAlphaBytes = (std::byte*)&alpha;
-    for (int i = 0; i != 4; ++i)
+    float unorm[256];
+    float srgb[256];
+
+    ByteTables()
     {
-        *dst++ = pAlphaBytes[0];
-        *dst++ = pAlphaBytes[1];
-        *dst++ = pAlphaBytes[2];
-        *dst++ = pAlphaBytes[3];
+        for (int i = 0; i != 256; ++i)
+        {
+            unorm[i] = math::Clamp01((float)i / 255.0f);
+            srgb[i] = SRGBToLinear(unorm[i]);
+        }
     }
-}
+};
 
-void ConvertPixel_RGB24ToAlpha8(std::byte*& src, std::byte*& dst)
+static const ByteTables& GetByteTables()
 {
-    std::byte r = *src++;
-    std::byte g = *src++;
-    std::byte b = *src++;
-    *dst++ = ConvertToGrayscale(r, g, b);
+    static const ByteTables tables;
+    return tables;
 }
 
-void ConvertPixel_RGB24ToRGB24(std::byte*& src, std::byte*& dst)
+static std::uint8_t ToByte(float value)
 {
-    *dst++ = *src++;
-    *dst++ = *src++;
-    *dst++ = *src++;
+    // written so NaN goes to zero
+    float v = value * 255.0f;
+    v = v > 0.0f ? std::min(v, 255.0f) : 0.0f;
+    return (std::uint8_t)(v + 0.5f);
 }
 
-void ConvertPixel_RGB24ToRGBA32(std::byte*& src, std::byte*& dst)
+static std::uint8_t ConvertToGrayscale(std::uint32_t r, std::uint32_t g, std::uint32_t b)
 {
-    *dst++ = *src++;
-    *dst++ = *src++;
-    *dst++ = *src++;
-    *dst++ = (std::byte)255;
+    std::uint32_t rfrac = r * 2990000;
+    std::uint32_t gfrac = g * 5870000;
+    std::uint32_t bfrac = b * 1140000;
+    std::uint32_t lum = ((rfrac + gfrac + bfrac) + 5000000) / 10000000;
+    return (std::uint8_t)std::min(lum, 255U);
 }
 
-void ConvertPixel_RGB24ToRGBAFloat(std::byte*& src, std::byte*& dst)
+template<std::size_t BytesPerPixel>
+static void CopyRow(const std::byte* src, std::byte* dst, std::size_t count) {
+    std::memcpy(dst, src, count * BytesPerPixel);
+}
+
+static void ConvertRow_Alpha8ToRGB24(const std::byte* src, std::byte* dst, std::size_t count)
 {
-    float rgba[4];
-    rgba[0] = math::Clamp01((float)*src++ / 255.0f);
-    rgba[1] = math::Clamp01((float)*src++ / 255.0f);
-    rgba[2] = math::Clamp01((float)*src++ / 255.0f);
-    rgba[3] = 1.0f;
+    for (std::size_t i = 0; i != count; ++i, dst += 3)
+        dst[0] = dst[1] = dst[2] = src[i];
+}
 
-    for (int i = 0; i != 4; ++i)
+static void ConvertRow_Alpha8ToRGBA32(const std::byte* src, std::byte* dst, std::size_t count)
+{
+    for (std::size_t i = 0; i != count; ++i)
     {
-        std::byte* pChan = (std::byte*)&rgba[i];
-        *dst++ = pChan[0];
-        *dst++ = pChan[1];
-        *dst++ = pChan[2];
-        *dst++ = pChan[3];
+        std::uint32_t pixel = (std::uint32_t)src[i] * 0x00010101u | 0xFF000000u;
+        std::memcpy(dst + i * 4, &pixel, 4);
     }
 }
 
-void ConvertPixel_RGBA32ToAlpha8(std::byte*& src, std::byte*& dst)
+static void ConvertRow_Alpha8ToRGBAFloat(const std::byte* src, std::byte* dst, std::size_t count)
 {
-    std::byte r = *src++;
-    std::byte g = *src++;
-    std::byte b = *src++;
-    src++;
-    *dst++ = ConvertToGrayscale(r, g, b);
+    auto& unorm = GetByteTables().unorm;
+    float* out = (float*)dst;
+
+    for (std::size_t i = 0; i != count; ++i, out += 4)
+        out[0] = out[1] = out[2] = out[3] = unorm[(std::uint8_t)src[i]];
 }
 
-void ConvertPixel_RGBA32ToRGB24(std::byte*& src, std::byte*& dst)
+static void ConvertRow_RGB24ToAlpha8(const std::byte* src, std::byte* dst, std::size_t count)
 {
-    *dst++ = *src++;
-    *dst++ = *src++;
-    *dst++ = *src++;
-    src++;
+    auto in = (const std::uint8_t*)src;
+
+    for (std::size_t i = 0; i != count; ++i, in += 3)
+        dst[i] = (std::byte)ConvertToGrayscale(in[0], in[1], in[2]);
 }
 
-void ConvertPixel_RGBA32ToRGBA32(std::byte*& src, std::byte*& dst)
+#if MW_IMAGE_SSSE3
+
+static bool DetectSSSE3()
 {
-    *dst++ = *src++;
-    *dst++ = *src++;
-    *dst++ = *src++;
-    *dst++ = *src++;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3") != 0;
+#endif
 }
 
-void ConvertPixel_RGBA32ToRGBAFloat(std::byte*& src, std::byte*& dst)
+static const bool HasSSSE3 = DetectSSSE3();
+
+// returns the number of pixels converted, leaving the rest to the caller
+MW_IMAGE_TARGET_SSSE3
+static std::size_t ConvertRow_RGB24ToRGBA32_SSSE3(const std::uint8_t* in, std::byte* dst, std::size_t count)
 {
-    float rgba[4];
-    rgba[0] = math::Clamp01((float)*src++ / 255.0f);
-    rgba[1] = math::Clamp01((float)*src++ / 255.0f);
-    rgba[2] = math::Clamp01((float)*src++ / 255.0f);
-    rgba[3] = math::Clamp01((float)*src++ / 255.0f);
+    // four pixels at a time - each load reads 16 bytes for the 12 used,
+    // so it stops while there are still two pixels past the last one
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xFF000000u);
+
+    std::size_t i = 0;
 
-    for (int i = 0; i != 4; ++i)
+    for (; i + 6 <= count; i += 4)
     {
-        std::byte* pChan = (std::byte*)&rgba[i];
-        *dst++ = pChan[0];
-        *dst++ = pChan[1];
-        *dst++ = pChan[2];
-        *dst++ = pChan[3];
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(in + i * 3));
+        pixels = _mm_or_si128(_mm_shuffle_epi8(pixels, spread), alpha);
+        _mm_storeu_si128((__m128i*)(dst + i * 4), pixels);
     }
+
+    return i;
 }
 
-void ConvertPixel_RGBAFloatToAlpha8(std::byte*& src, std::byte*& dst)
+#endif
+
+static void ConvertRow_RGB24ToRGBA32(const std::byte* src, std::byte* dst, std::size_t count)
 {
-    float rgba[4];
-    for (int i = 0; i != 4; ++i) {
-        std::byte* pVal = (std::byte*)&rgba[i];
-        *pVal++ = *src++;
-        *pVal++ = *src++;
-        *pVal++ = *src++;
-        *pVal++ = *src++;
-    }
+    auto in = (const std::uint8_t*)src;
+    std::size_t i = 0;
+
+#if MW_IMAGE_SSSE3
+    if (HasSSSE3)
+        i = ConvertRow_RGB24ToRGBA32_SSSE3(in, dst, count);
+#endif
 
-    std::byte r = (std::byte)math::Clamp(math::RoundToInt(rgba[0] * 255.0f), 0, 255);
-    std::byte g = (std::byte)math::Clamp(math::RoundToInt(rgba[1] * 255.0f), 0, 255);
-    std::byte b = (std::byte)math::Clamp(math::RoundToInt(rgba[2] * 255.0f), 0, 255);
-    *dst++ = ConvertToGrayscale(r, g, b);
+    for (; i != count; ++i)
+    {
+        const std::uint8_t* p = in + i * 3;
+        std::uint32_t pixel = p[0] | (p[1] << 8) | (p[2] << 16) | 0xFF000000u;
+        std::memcpy(dst + i * 4, &pixel, 4);
+    }
 }
 
-void ConvertPixel_RGBAFloatToRGB24(std::byte*& src, std::byte*& dst)
+static void ConvertRow_RGB24ToRGBAFloat(const std::byte* src, std::byte* dst, std::size_t count)
 {
-    float rgba[4];
-    for (int i = 0; i != 4; ++i) {
-        std::byte* pVal = (std::byte*)&rgba[i];
-        *pVal++ = *src++;
-        *pVal++ = *src++;
-        *pVal++ = *src++;
-        *pVal++ = *src++;
-    }
+    auto& unorm = GetByteTables().unorm;
+    auto in = (const std::uint8_t*)src;
+    float* out = (float*)dst;
 
-    *dst++ = (std::byte)math::Clamp(math::RoundToInt(rgba[0] * 255.0f), 0, 255);
-    *dst++ = (std::byte)math::Clamp(math::RoundToInt(rgba[1] * 255.0f), 0, 255);
-    *dst++ = (std::byte)math::Clamp(math::RoundToInt(rgba[2] * 255.0f), 0, 255);
+    for (std::size_t i = 0; i != count; ++i, in += 3, out += 4)
+    {
+        out[0] = unorm[in[0]];
+        out[1] = unorm[in[1]];
+        out[2] = unorm[in[2]];
+        out[3] = 1.0f;
+    }
 }
 
-void ConvertPixel_RGBAFloatToRGBA32(std::byte*& src, std::byte*& dst)
+static void ConvertRow_RGBA32ToAlpha8(const std::byte* src, std::byte* dst, std::size_t count)
 {
-    float rgba[4];
-    for (int i = 0; i != 4; ++i) {
-        std::byte* pVal = (std::byte*)&rgba[i];
-        *pVal++ = *src++;
-        *pVal++ = *src++;
-        *pVal++ = *src++;
-        *pVal++ = *src++;
-    }
+    auto in = (const std::uint8_t*)src;
 
-    *dst++ = (std::byte)math::Clamp(math::RoundToInt(rgba[0] * 255.0f), 0, 255);
-    *dst++ = (std::byte)math::Clamp(math::RoundToInt(rgba[1] * 255.0f), 0, 255);
-    *dst++ = (std::byte)math::Clamp(math::RoundToInt(rgba[2] * 255.0f), 0, 255);
-    *dst++ = (std::byte)255;
+    for (std::size_t i = 0; i != count; ++i, in += 4)
+        dst[i] = (std::byte)ConvertToGrayscale(in[0], in[1], in[2]);
 }
 
-void ConvertPixel_RGBAFloatToRGBAFloat(std::byte*& src, std::byte*& dst)
+static void ConvertRow_RGBA32ToRGB24(const std::byte* src, std::byte* dst, std::size_t count)
 {
-    for (int i = 0; i != 4; ++i) {
-        *dst++ = *src++;
-        *dst++ = *src++;
-        *dst++ = *src++;
-        *dst++ = *src++;
+    for (std::size_t i = 0; i != count; ++i, src += 4, dst += 3)
+    {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
     }
 }
 
-typedef void(*ConvertPixelFunc)(std::byte*& src, std::byte*& dst);
-typedef void(*ConvertImageFunc)(std::byte* srcBegin, std::byte* srcEnd, std::byte* dstBegin);
+static void ConvertRow_RGBA32ToRGBAFloat(const std::byte* src, std::byte* dst, std::size_t count)
+{
+    auto& unorm = GetByteTables().unorm;
+    auto in = (const std::uint8_t*)src;
+    float* out = (float*)dst;
+
+    for (std::size_t i = 0; i != count * 4; ++i)
+        out[i] = unorm[in[i]];
+}
 
-template<ConvertPixelFunc fun>
-void ConvertPixels(
-    std::byte* srcBegin,
-    std::byte* srcEnd,
-    std::byte* dstBegin)
+static void ConvertRow_RGBAFloatToAlpha8(const std::byte* src, std::byte* dst, std::size_t count)
 {
-    while (srcBegin != srcEnd)
-        fun(srcBegin, dstBegin);
+    const float* in = (const float*)src;
+
+    for (std::size_t i = 0; i != count; ++i, in += 4)
+        dst[i] = (std::byte)ConvertToGrayscale(ToByte(in[0]), ToByte(in[1]), ToByte(in[2]));
 }
 
-ConvertImageFunc GetConvertFunc(
-    PixelDataFormat srcFormat,
-    PixelDataFormat dstFormat)
+static void ConvertRow_RGBAFloatToRGB24(const std::byte* src, std::byte* dst, std::size_t count)
 {
-    if (srcFormat == PixelDataFormat::Alpha8)
+    const float* in = (const float*)src;
+
+    for (std::size_t i = 0; i != count; ++i, in += 4, dst += 3)
     {
-        if (dstFormat == PixelDataFormat::Alpha8 || dstFormat == PixelDataFormat::Unspecified) {
-            return ConvertPixels<ConvertPixel_Alpha8ToAlpha8>;
-        }
-        else if (dstFormat == PixelDataFormat::RGB24) {
-            return ConvertPixels<ConvertPixel_Alpha8ToRGB24>;
-        }
-        else if (dstFormat == PixelDataFormat::RGBA32) {
-            return ConvertPixels<ConvertPixel_Alpha8ToRGBA32>;
-        }
-        else if (dstFormat == PixelDataFormat::RGBAFloat) {
-            return ConvertPixels< ConvertPixel_Alpha8ToRGBAFloat>;
-        }
+        dst[0] = (std::byte)ToByte(in[0]);
+        dst[1] = (std::byte)ToByte(in[1]);
+        dst[2] = (std::byte)ToByte(in[2]);
     }
-    else if (srcFormat == PixelDataFormat::RGB24)
+}
+
+static void ConvertRow_RGBAFloatToRGBA32(const std::byte* src, std::byte* dst, std::size_t count)
+{
+    const float* in = (const float*)src;
+    std::size_t i = 0;
+
+#if MW_IMAGE_SSE2
+    // same rounding as ToByte, four pixels at a time
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    auto quantize = [&](const float* p) {
+        __m128 v = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(p), scale), zero), scale);
+        return _mm_cvttps_epi32(_mm_add_ps(v, half));
+    };
+
+    for (; i + 4 <= count; i += 4)
     {
-        if (dstFormat == PixelDataFormat::Alpha8) {
-            return ConvertPixels<ConvertPixel_RGB24ToAlpha8>;
-        }
-        else if (dstFormat == PixelDataFormat::RGB24 || dstFormat == PixelDataFormat::Unspecified) {
-            return ConvertPixels<ConvertPixel_RGB24ToRGB24>;
-        }
-        else if (dstFormat == PixelDataFormat::RGBA32) {
-            return ConvertPixels<ConvertPixel_RGB24ToRGBA32>;
-        }
-        else if (dstFormat == PixelDataFormat::RGBAFloat) {
-            return ConvertPixels<ConvertPixel_RGB24ToRGBAFloat>;
-        }
+        const float* p = in + i * 4;
+        __m128i lo = _mm_packs_epi32(quantize(p), quantize(p + 4));
+        __m128i hi = _mm_packs_epi32(quantize(p + 8), quantize(p + 12));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
     }
-    else if (srcFormat == PixelDataFormat::RGBA32)
+#endif
+
+    // 'i' counts pixels, so the tail only covers what the loop above didn't
+    for (; i != count; ++i)
     {
-        if (dstFormat == PixelDataFormat::Alpha8) {
-            return ConvertPixels<ConvertPixel_RGBA32ToAlpha8>;
-        }
-        else if (dstFormat == PixelDataFormat::RGB24) {
-            return ConvertPixels<ConvertPixel_RGBA32ToRGB24>;
-        }
-        else if (dstFormat == PixelDataFormat::RGBA32 || dstFormat == PixelDataFormat::Unspecified) {
-            return ConvertPixels<ConvertPixel_RGBA32ToRGBA32>;
-        }
-        else if (dstFormat == PixelDataFormat::RGBAFloat) {
-            return ConvertPixels<ConvertPixel_RGBA32ToRGBAFloat>;
-        }
+        for (std::size_t c = 0; c != 4; ++c)
+            dst[i * 4 + c] = (std::byte)ToByte(in[i * 4 + c]);
     }
-    else if (srcFormat == PixelDataFormat::RGBAFloat)
+}
+
+static ConvertRowFunc GetConvertFunc(PixelDataFormat srcFormat, PixelDataFormat dstFormat)
+{
+    static const ConvertRowFunc funcs[4][4] = {
+        { CopyRow<1>, ConvertRow_Alpha8ToRGB24, ConvertRow_Alpha8ToRGBA32, ConvertRow_Alpha8ToRGBAFloat },
+        { ConvertRow_RGB24ToAlpha8, CopyRow<3>, ConvertRow_RGB24ToRGBA32, ConvertRow_RGB24ToRGBAFloat },
+        { ConvertRow_RGBA32ToAlpha8, ConvertRow_RGBA32ToRGB24, CopyRow<4>, ConvertRow_RGBA32ToRGBAFloat },
+        { ConvertRow_RGBAFloatToAlpha8, ConvertRow_RGBAFloatToRGB24, ConvertRow_RGBAFloatToRGBA32, CopyRow<16> },
+    };
+
+    if (dstFormat == PixelDataFormat::Unspecified)
+        dstFormat = srcFormat;
+
+    int src = (int)srcFormat - (int)PixelDataFormat::Alpha8;
+    int dst = (int)dstFormat - (int)PixelDataFormat::Alpha8;
+
+    if (src < 0 || src >= 4 || dst < 0 || dst >= 4)
+        throw Exception("Invalid source or destination format");
+
+    return funcs[src][dst];
+}
+
+// Adjustments need the channel values, so pixels are expanded to floats
+// a block at a time, adjusted, and then converted to the final format
+static void ConvertAdjusted(
+    const std::byte* src, PixelDataFormat srcFormat,
+    std::byte* dst, PixelDataFormat dstFormat,
+    std::size_t count, PixelConversion conversion)
+{
+    auto toFloat = GetConvertFunc(srcFormat, PixelDataFormat::RGBAFloat);
+    auto fromFloat = GetConvertFunc(PixelDataFormat::RGBAFloat, dstFormat);
+    auto srcStride = GetBytesPerPixel(srcFormat);
+    auto dstStride = GetBytesPerPixel(dstFormat);
+
+    bool decode = (conversion & PixelConversion::SRGBToLinear) != 0;
+    bool premultiply = (conversion & PixelConversion::PremultiplyAlpha) != 0;
+    bool encode = (conversion & PixelConversion::LinearToSRGB) != 0;
+
+    // byte channels came from the table, so they can be decoded by lookup
+    bool decodeBytes = decode && srcFormat != PixelDataFormat::RGBAFloat;
+    auto& srgb = GetByteTables().srgb;
+
+    alignas(16) float block[ConvertBlockSize * 4];
+
+    for (std::size_t first = 0; first < count; first += ConvertBlockSize)
     {
-        if (dstFormat == PixelDataFormat::Alpha8) {
-            return ConvertPixels<ConvertPixel_RGBAFloatToAlpha8>;
-        }
-        else if (dstFormat == PixelDataFormat::RGB24) {
-            return ConvertPixels<ConvertPixel_RGBAFloatToRGB24>;
-        }
-        else if (dstFormat == PixelDataFormat::RGBA32) {
-            return ConvertPixels<ConvertPixel_RGBAFloatToRGBA32>;
-        }
-        else if (dstFormat == PixelDataFormat::RGBAFloat || dstFormat == PixelDataFormat::Unspecified) {
-            return ConvertPixels<ConvertPixel_RGBAFloatToRGBAFloat>;
+        std::size_t n = std::min(ConvertBlockSize, count - first);
+        toFloat(src + first * srcStride, (std::byte*)block, n);
+
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            float* p = block + i * 4;
+
+            for (int c = 0; c != 3; ++c)
+            {
+                if (decodeBytes)
+                    p[c] = srgb[(int)(p[c] * 255.0f + 0.5f)];
+                else if (decode)
+                    p[c] = SRGBToLinear(p[c]);
+
+                if (premultiply)
+                    p[c] *= p[3];
+
+                if (encode)
+                    p[c] = LinearToSRGB(p[c]);
+            }
         }
+
+        fromFloat((const std::byte*)block, dst + first * dstStride, n);
     }
+}
 
-    throw Exception("Invalid source or destination format");
+void Image::ConvertPixels(
+    const std::byte* src, PixelDataFormat srcFormat,
+    std::byte* dst, PixelDataFormat dstFormat,
+    std::size_t count, PixelConversion conversion)
+{
+    if ((conversion & PixelConversion::SRGBToLinear) != 0 &&
+        (conversion & PixelConversion::LinearToSRGB) != 0)
+    {
+        throw Exception("cannot convert to and from sRGB at once");
+    }
+
+    if (conversion == PixelConversion::None)
+        GetConvertFunc(srcFormat, dstFormat)(src, dst, count);
+    else
+        ConvertAdjusted(src, srcFormat, dst, dstFormat == PixelDataFormat::Unspecified ? srcFormat : dstFormat, count, conversion);
 }
 
 void Image::Blit(
     std::byte* src, IVec2 srcSize, IntRect srcRect, PixelDataFormat srcFormat,
     std::byte* dst, IVec2 dstSize, IVec2 dstPos, PixelDataFormat dstFormat,
-    bool flipVertically)
+    bool flipVertically, PixelConversion conversion)
 {
     if (srcFormat == PixelDataFormat::Unspecified)
         throw Exception("'srcFormat' cannot be 'Unspecified'");
@@ -1293,26 +1382,38 @@ void Image::Blit(
     clampedSrcRect.h = copyHeight;
     clampedDstRect.h = copyHeight;
 
-    int srcChannels = GetBytesPerPixel(srcFormat);
-    int dstChannels = GetBytesPerPixel(dstFormat);
-    auto convertFunc = GetConvertFunc(srcFormat, dstFormat);
+    if (dstFormat == PixelDataFormat::Unspecified)
+        dstFormat = srcFormat;
 
-    for (int y = 0; y != copyHeight; ++y)
+    // validates the formats and conversion before any jobs are started
+    ConvertPixels(src, srcFormat, dst, dstFormat, 0, conversion);
+
+    std::size_t srcChannels = GetBytesPerPixel(srcFormat);
+    std::size_t dstChannels = GetBytesPerPixel(dstFormat);
+
+    auto blitRows = [&](std::size_t first, std::size_t last)
     {
-        auto srcX = clampedSrcRect.x;
-        auto srcY = clampedSrcRect.y + y;
-        auto dstX = clampedDstRect.x;
-        auto dstY = clampedDstRect.y + y;
+        for (int y = (int)first; y != (int)last; ++y)
+        {
+            auto srcX = clampedSrcRect.x;
+            auto srcY = clampedSrcRect.y + y;
+            auto dstX = clampedDstRect.x;
+            auto dstY = clampedDstRect.y + y;
 
-        if (flipVertically) {
-            dstY = dstPos.y + (srcRect.h - 1 - y);
+            if (flipVertically) {
+                dstY = dstPos.y + (srcRect.h - 1 - y);
+            }
+
+            std::byte* srcBegin = &src[((std::size_t)srcY * srcSize.x + srcX) * srcChannels];
+            std::byte* dstBegin = &dst[((std::size_t)dstY * dstSize.x + dstX) * dstChannels];
+            ConvertPixels(srcBegin, srcFormat, dstBegin, dstFormat, copyWidth, conversion);
         }
+    };
 
-        std::byte* srcBegin = &src[(srcY * srcSize.x + srcX) * srcChannels];
-        std::byte* srcEnd = srcBegin + copyWidth * srcChannels;
-        std::byte* dstBegin = &dst[(dstY * dstSize.x + dstX) * dstChannels];
-        convertFunc(srcBegin, srcEnd, dstBegin);
-    }
+    if ((std::size_t)copyWidth * copyHeight < ConvertChunkSize)
+        blitRows(0, copyHeight);
+    else
+        JobSystem::GetInstance().ParallelFor(copyHeight, std::max<std::size_t>(1, ConvertChunkSize / copyWidth), blitRows);
 }
 
 void Image::FlipVertical(
@@ -1351,7 +1452,7 @@ void Image::FlipVertical(
     }
 }
 
-Image Image::Clone(PixelDataFormat targetFormat)
+Image Image::Clone(PixelDataFormat targetFormat, PixelConversion conversion)
 {
     if (format == PixelDataFormat::Unspecified)
         throw Exception("source Image format cannot be 'Unspecified'");
@@ -1359,20 +1460,34 @@ Image Image::Clone(PixelDataFormat targetFormat)
     if (!data)
         throw Exception("source Image cannot be empty");
 
-    auto oldByteCount = size.x * size.y * GetBytesPerPixel(format);
-    auto newByteCount = size.x * size.y * GetBytesPerPixel(targetFormat);
+    if (targetFormat == PixelDataFormat::Unspecified)
+        targetFormat = format;
+
+    std::size_t pixelCount = (std::size_t)size.x * size.y;
+    std::size_t srcStride = GetBytesPerPixel(format);
+    std::size_t dstStride = GetBytesPerPixel(targetFormat);
 
     Image ret;
     ret.size = size;
     ret.format = targetFormat;
-    ret.data = std::make_unique<std::byte[]>(newByteCount);
+    ret.data = std::make_unique<std::byte[]>(pixelCount * dstStride);
 
-    std::byte* srcBegin = data.get();
-    std::byte* srcEnd   = data.get() + oldByteCount;
-    std::byte* dstBegin = ret.data.get();
-    
-    auto convertFunc = GetConvertFunc(format, targetFormat);
-    convertFunc(srcBegin, srcEnd, dstBegin);
+    const std::byte* src = data.get();
+    std::byte* dst = ret.data.get();
+
+    auto convert = [&](std::size_t first, std::size_t last) {
+        ConvertPixels(src + first * srcStride, format, dst + first * dstStride, targetFormat, last - first, conversion);
+    };
+
+    if (pixelCount < ConvertChunkSize)
+    {
+        convert(0, pixelCount);
+    }
+    else
+    {
+        ConvertPixels(src, format, dst, targetFormat, 0, conversion);
+        JobSystem::GetInstance().ParallelFor(pixelCount, ConvertChunkSize, convert);
+    }
 
     return ret;
 }
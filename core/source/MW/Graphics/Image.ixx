@@ -3,6 +3,7 @@
 *--------------------------------------------------------------*/
 
 export module Microwave.Graphics.Image;
+export import Microwave.Utilities.EnumFlags;
 import Microwave.Graphics.GraphicsTypes;
 import Microwave.IO.FileStream;
 import Microwave.Math;
@@ -22,6 +23,18 @@ enum class ImageFileFormat
     EXR
 };
 
+// Adjustments made to color channels while pixels are converted. Alpha is
+// never adjusted. Decoding happens first and encoding last, so alpha is
+// premultiplied in linear space when both are requested.
+enum class PixelConversion
+{
+    None = 0,
+    SRGBToLinear = 1 << 0,
+    PremultiplyAlpha = 1 << 1,
+    LinearToSRGB = 1 << 2,
+};
+constexpr void EnableEnumFlags(PixelConversion);
+
 struct ImageInfo
 {
     PixelDataFormat format = PixelDataFormat::Unspecified;
@@ -86,12 +99,22 @@ public:
     std::byte* GetPixel(std::uint32_t x, std::uint32_t y);
 
     // 'format' of 'Unspecified' uses original format
-    Image Clone(PixelDataFormat format = PixelDataFormat::Unspecified);
+    Image Clone(
+        PixelDataFormat format = PixelDataFormat::Unspecified,
+        PixelConversion conversion = PixelConversion::None);
 
     static void Blit(
         std::byte* src, IVec2 srcSize, IntRect srcRect, PixelDataFormat srcFormat,
         std::byte* dst, IVec2 dstSize, IVec2 dstPos, PixelDataFormat dstFormat,
-        bool flipVertically = false);
+        bool flipVertically = false,
+        PixelConversion conversion = PixelConversion::None);
+
+    // converts a run of 'count' pixels on the calling thread
+    static void ConvertPixels(
+        const std::byte* src, PixelDataFormat srcFormat,
+        std::byte* dst, PixelDataFormat dstFormat,
+        std::size_t count,
+        PixelConversion conversion = PixelConversion::None);
 
     static void FlipVertical(
         std::byte* buffer, IVec2 size, PixelDataFormat format);
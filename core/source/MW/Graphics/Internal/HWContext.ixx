@@ -6,6 +6,7 @@ export module Microwave.Graphics.Internal.HWContext;
 import Microwave.Graphics.Color;
 import Microwave.Graphics.GraphicsTypes;
 import Microwave.Graphics.ShaderInfo;
+import Microwave.Graphics.TextureData;
 import Microwave.Graphics.Internal.HWBuffer;
 import Microwave.Graphics.Internal.HWRenderTarget;
 import Microwave.Graphics.Internal.HWRenderTexture;
@@ -62,6 +63,8 @@ public:
     virtual gptr<HWBuffer> CreateBuffer(BufferType type, BufferUsage usage, BufferCPUAccess cpuAccess, const std::span<std::byte>& data) = 0;
     virtual gptr<HWSurface> CreateSurface(const gptr<Window>& window) = 0;
     virtual gptr<HWTexture> CreateTexture(const IVec2& size, PixelDataFormat format, bool dynamic, const std::span<std::byte>& data) = 0;
+    virtual gptr<HWTexture> CreateTexture(const TextureData& data) = 0;
+    virtual bool IsCompressionSupported(TextureCompression compression) const = 0;
     virtual gptr<HWTexture> GetDefaultTexture() = 0;
 };
 
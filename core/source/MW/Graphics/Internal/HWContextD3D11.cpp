@@ -341,6 +341,19 @@ gptr<HWTexture> HWContextD3D11::CreateTexture(
         self(this), size, format, dynamic, data);
 }
 
+gptr<HWTexture> HWContextD3D11::CreateTexture(const TextureData& data) {
+    return gpnew<HWTextureD3D11>(self(this), data);
+}
+
+bool HWContextD3D11::IsCompressionSupported(TextureCompression compression) const
+{
+    // BC1-BC3 are supported at every feature level, BC7 from 11_0, and ETC2 at none
+    return compression == TextureCompression::None
+        || compression == TextureCompression::BC1
+        || compression == TextureCompression::BC3
+        || (compression == TextureCompression::BC7 && mFeatureLevel >= D3D_FEATURE_LEVEL_11_0);
+}
+
 gptr<HWTexture> HWContextD3D11::GetDefaultTexture()
 {
     if (!defaultTexture)
@@ -14,6 +14,7 @@ import Microwave.Graphics.Internal.HWRenderTextureD3D11;
 import Microwave.Graphics.Internal.HWSurfaceD3D11;
 import Microwave.Graphics.RenderTarget;
 import Microwave.Graphics.GraphicsTypes;
+import Microwave.Graphics.TextureData;
 import Microwave.System.Pointers;
 import Microwave.System.Internal.WindowWindows;
 
@@ -128,6 +129,12 @@ public:
         const IVec2& size, PixelDataFormat format, bool dynamic,
         const std::span<std::byte>& data) override;
 
+    virtual gptr<HWTexture> CreateTexture(
+        const TextureData& data) override;
+
+    virtual bool IsCompressionSupported(
+        TextureCompression compression) const override;
+
     virtual gptr<HWTexture> GetDefaultTexture() override;
 
     void UpdateDeviceStates();
@@ -0,0 +1,277 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Microwave.Graphics.Internal.HWContextNull;
+import Microwave.System.Exception;
+import std;
+
+namespace mw {
+inline namespace gfx {
+
+Vec2 HWContextNull::GetDepthRangeNDC() const {
+    return Vec2(0.0f, 1.0f);
+}
+
+void HWContextNull::SetClearColor(const Color& color) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetCullMode(CullMode mode) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetScissorTestEnabled(bool enabled) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetScissorRect(const IntRect& rect) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetDepthTest(DepthTest test) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetDepthWriteEnabled(bool enabled) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetBlendingEnabled(bool enabled) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetBlendOperations(
+    BlendOperation colorBlendOp, BlendOperation alphaBlendOp)
+{
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetBlendFactors(
+    BlendFactor sourceColor, BlendFactor destColor,
+    BlendFactor sourceAlpha, BlendFactor destAlpha)
+{
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetColorMask(bool red, bool green, bool blue, bool alpha) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetBlendColor(Color color) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetViewport(const IntRect& rect) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetRenderTarget(const gptr<HWRenderTarget>& target) {
+    ++calls.stateChanges;
+}
+
+void HWContextNull::SetSwapInterval(int interval) {
+}
+
+void HWContextNull::Clear(const gptr<HWRenderTarget>& target, bool depth, bool color) {
+    ++calls.clears;
+}
+
+void HWContextNull::DrawArray(int start, int count, DrawMode mode)
+{
+    ++calls.draws;
+    calls.vertices += count;
+}
+
+void HWContextNull::DrawIndexed(int start, int count, DrawMode mode)
+{
+    ++calls.draws;
+    calls.vertices += count;
+}
+
+void HWContextNull::Flip(const gptr<HWRenderTarget>& target) {
+    ++calls.flips;
+}
+
+Mat4 HWContextNull::GetOrthoMatrix(
+    float left, float right,
+    float bottom, float top,
+    float znear, float zfar)
+{
+    return Mat4::OrthoD3D(left, right, bottom, top, znear, zfar);
+}
+
+Mat4 HWContextNull::GetPerspectiveMatrix(
+    float fovY, float aspect,
+    float znear, float zfar)
+{
+    return Mat4::PerspectiveD3D(fovY, aspect, znear, zfar);
+}
+
+ShaderLanguage HWContextNull::GetShaderLanguage() const {
+    return ShaderLanguage::HLSL;
+}
+
+gptr<HWShader> HWContextNull::CreateShader(const gptr<ShaderInfo>& info) {
+    return gpnew<HWShaderNull>(self(this), info);
+}
+
+gptr<HWRenderTexture> HWContextNull::CreateRenderTexture(const gptr<HWTexture>& tex)
+{
+    auto nullTex = gpcast<HWTextureNull>(tex);
+    if (!nullTex)
+        throw Exception("texture was not created by this context");
+
+    return gpnew<HWRenderTextureNull>(nullTex);
+}
+
+gptr<HWBuffer> HWContextNull::CreateBuffer(
+    BufferType type, BufferUsage usage,
+    BufferCPUAccess cpuAccess, std::size_t size)
+{
+    return gpnew<HWBufferNull>(size);
+}
+
+gptr<HWBuffer> HWContextNull::CreateBuffer(
+    BufferType type, BufferUsage usage,
+    BufferCPUAccess cpuAccess, const std::span<std::byte>& data)
+{
+    auto buffer = gpnew<HWBufferNull>(data.size());
+
+    auto mapping = buffer->Map(BufferMapAccess::WriteDiscard);
+    std::copy(data.begin(), data.end(), mapping.begin());
+    buffer->Unmap();
+
+    return buffer;
+}
+
+gptr<HWSurface> HWContextNull::CreateSurface(const gptr<Window>& window) {
+    return gpnew<HWSurfaceNull>(window);
+}
+
+gptr<HWTexture> HWContextNull::CreateTexture(
+    const IVec2& size, PixelDataFormat format, bool dynamic,
+    const std::span<std::byte>& data)
+{
+    return gpnew<HWTextureNull>(size);
+}
+
+gptr<HWTexture> HWContextNull::CreateTexture(const TextureData& data) {
+    return gpnew<HWTextureNull>(data.GetSize());
+}
+
+bool HWContextNull::IsCompressionSupported(TextureCompression compression) const {
+    return true;
+}
+
+gptr<HWTexture> HWContextNull::GetDefaultTexture()
+{
+    if (!defaultTexture)
+        defaultTexture = gpnew<HWTextureNull>(IVec2(1, 1));
+
+    return defaultTexture;
+}
+
+std::span<std::byte> HWBufferNull::Map(BufferMapAccess access)
+{
+    if (mapped)
+        throw Exception("buffer is already mapped");
+
+    mapped = true;
+    return std::span<std::byte>(data);
+}
+
+bool HWBufferNull::IsMapped() const {
+    return mapped;
+}
+
+void HWBufferNull::Unmap() {
+    mapped = false;
+}
+
+std::size_t HWBufferNull::GetSize() const {
+    return data.size();
+}
+
+IVec2 HWRenderTextureNull::GetSize() {
+    return tex->size;
+}
+
+gptr<HWTexture> HWRenderTextureNull::GetTexture() {
+    return tex;
+}
+
+void HWSurfaceNull::UpdateSize() {
+    size = window->GetSize();
+}
+
+IVec2 HWSurfaceNull::GetSize() const {
+    return size;
+}
+
+HWShaderNull::HWShaderNull(const gptr<HWContextNull>& context, const gptr<ShaderInfo>& info)
+    : HWShader(info), context(context)
+{
+    // every declared uniform is considered active
+    for (int i = 0; i < (int)info->uniforms.size(); ++i)
+    {
+        info->uniforms[i].slot = i;
+        info->uniformIDs[info->uniforms[i].name] = i;
+    }
+
+    for (int i = 0; i < (int)info->attributes.size(); ++i)
+        info->attributes[i].slot = i;
+}
+
+void HWShaderNull::Bind() {
+    ++context->calls.shaderBinds;
+}
+
+void HWShaderNull::SetVertexBuffer(int id, const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride)
+{
+    if (id >= 0)
+        ++context->calls.vertexBufferBinds;
+}
+
+void HWShaderNull::SetIndexBuffer(const gptr<Buffer>& buffer) {
+    ++context->calls.indexBufferBinds;
+}
+
+void HWShaderNull::SetUniform(int id, float value) {
+    if (id >= 0) ++context->calls.uniformWrites;
+}
+
+void HWShaderNull::SetUniform(int id, const Vec2& value) {
+    if (id >= 0) ++context->calls.uniformWrites;
+}
+
+void HWShaderNull::SetUniform(int id, const Vec3& value) {
+    if (id >= 0) ++context->calls.uniformWrites;
+}
+
+void HWShaderNull::SetUniform(int id, const Vec4& value) {
+    if (id >= 0) ++context->calls.uniformWrites;
+}
+
+void HWShaderNull::SetUniform(int id, const Mat2& value) {
+    if (id >= 0) ++context->calls.uniformWrites;
+}
+
+void HWShaderNull::SetUniform(int id, const Mat3& value) {
+    if (id >= 0) ++context->calls.uniformWrites;
+}
+
+void HWShaderNull::SetUniform(int id, const Mat4& value) {
+    if (id >= 0) ++context->calls.uniformWrites;
+}
+
+void HWShaderNull::SetUniform(int id, const Color& value) {
+    if (id >= 0) ++context->calls.uniformWrites;
+}
+
+void HWShaderNull::SetUniform(int id, const gptr<Texture>& texture) {
+    if (id >= 0) ++context->calls.textureBinds;
+}
+
+} // gfx
+} // mw
@@ -0,0 +1,170 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.Graphics.Internal.HWContextNull;
+import Microwave.Graphics.Buffer;
+import Microwave.Graphics.Color;
+import Microwave.Graphics.GraphicsTypes;
+import Microwave.Graphics.ShaderInfo;
+import Microwave.Graphics.Texture;
+import Microwave.Graphics.TextureData;
+import Microwave.Graphics.Internal.HWBuffer;
+import Microwave.Graphics.Internal.HWContext;
+import Microwave.Graphics.Internal.HWRenderTarget;
+import Microwave.Graphics.Internal.HWRenderTexture;
+import Microwave.Graphics.Internal.HWShader;
+import Microwave.Graphics.Internal.HWSurface;
+import Microwave.Graphics.Internal.HWTexture;
+import Microwave.Math;
+import Microwave.System.Pointers;
+import Microwave.System.Window;
+import std;
+
+export namespace mw {
+inline namespace gfx {
+
+// calls received by a HWContextNull and the resources it created
+struct HWCallCounts
+{
+    std::uint64_t draws = 0;
+    std::uint64_t vertices = 0;
+    std::uint64_t stateChanges = 0;
+    std::uint64_t shaderBinds = 0;
+    std::uint64_t vertexBufferBinds = 0;
+    std::uint64_t indexBufferBinds = 0;
+    std::uint64_t textureBinds = 0;
+    std::uint64_t uniformWrites = 0;
+    std::uint64_t clears = 0;
+    std::uint64_t flips = 0;
+};
+
+// A driver that doesn't render anything, and only counts what it's asked
+// to do. Used when no graphics driver is available, like on a headless
+// build machine, or to measure the work a frame submits.
+class HWContextNull : public HWContext
+{
+public:
+    HWCallCounts calls;
+
+    HWContextNull() = default;
+    virtual ~HWContextNull() = default;
+
+    virtual void SetActive(bool active) override {}
+
+    virtual Vec2 GetDepthRangeNDC() const override;
+    virtual void SetClearColor(const Color& color) override;
+    virtual void SetCullMode(CullMode mode) override;
+    virtual void SetScissorTestEnabled(bool enabled) override;
+    virtual void SetScissorRect(const IntRect& rect) override;
+    virtual void SetDepthTest(DepthTest test) override;
+    virtual void SetDepthWriteEnabled(bool enabled) override;
+    virtual void SetBlendingEnabled(bool enabled) override;
+    virtual void SetBlendOperations(
+        BlendOperation colorBlendOp, BlendOperation alphaBlendOp) override;
+    virtual void SetBlendFactors(
+        BlendFactor sourceColor, BlendFactor destColor,
+        BlendFactor sourceAlpha, BlendFactor destAlpha) override;
+    virtual void SetColorMask(bool red, bool green, bool blue, bool alpha) override;
+    virtual void SetBlendColor(Color color) override;
+    virtual void SetViewport(const IntRect& rect) override;
+    virtual void SetRenderTarget(const gptr<HWRenderTarget>& target) override;
+    virtual void SetSwapInterval(int interval) override;
+    virtual void Clear(const gptr<HWRenderTarget>& target, bool depth, bool color) override;
+    virtual void DrawArray(int start, int count, DrawMode mode) override;
+    virtual void DrawIndexed(int start, int count, DrawMode mode) override;
+    virtual void Flush() override {}
+    virtual void Flip(const gptr<HWRenderTarget>& target) override;
+    virtual Mat4 GetOrthoMatrix(float left, float right, float bottom, float top, float znear, float zfar) override;
+    virtual Mat4 GetPerspectiveMatrix(float fovY, float aspect, float znear, float zfar) override;
+
+    virtual ShaderLanguage GetShaderLanguage() const override;
+
+    virtual gptr<HWShader> CreateShader(const gptr<ShaderInfo>& info) override;
+    virtual gptr<HWRenderTexture> CreateRenderTexture(const gptr<HWTexture>& tex) override;
+    virtual gptr<HWBuffer> CreateBuffer(BufferType type, BufferUsage usage, BufferCPUAccess cpuAccess, std::size_t size) override;
+    virtual gptr<HWBuffer> CreateBuffer(BufferType type, BufferUsage usage, BufferCPUAccess cpuAccess, const std::span<std::byte>& data) override;
+    virtual gptr<HWSurface> CreateSurface(const gptr<Window>& window) override;
+    virtual gptr<HWTexture> CreateTexture(const IVec2& size, PixelDataFormat format, bool dynamic, const std::span<std::byte>& data) override;
+    virtual gptr<HWTexture> CreateTexture(const TextureData& data) override;
+    virtual bool IsCompressionSupported(TextureCompression compression) const override;
+    virtual gptr<HWTexture> GetDefaultTexture() override;
+
+private:
+    gptr<HWTexture> defaultTexture;
+};
+
+class HWBufferNull : public HWBuffer
+{
+    std::vector<std::byte> data;
+    bool mapped = false;
+public:
+    HWBufferNull(std::size_t size) : data(size) {}
+
+    virtual std::span<std::byte> Map(BufferMapAccess access) override;
+    virtual bool IsMapped() const override;
+    virtual void Unmap() override;
+    virtual std::size_t GetSize() const override;
+};
+
+class HWTextureNull : public HWTexture
+{
+public:
+    IVec2 size;
+
+    HWTextureNull(const IVec2& size) : size(size) {}
+
+    virtual void SetPixels(const std::span<std::byte>& data, const IntRect& rect) override {}
+    virtual void SetWrapMode(TextureWrapMode mode) override {}
+    virtual void SetFilterMode(TextureFilterMode mode) override {}
+    virtual void SetAnisoLevel(float level) override {}
+};
+
+class HWRenderTextureNull : public HWRenderTexture
+{
+public:
+    gptr<HWTextureNull> tex;
+
+    HWRenderTextureNull(const gptr<HWTextureNull>& tex) : tex(tex) {}
+
+    virtual IVec2 GetSize() override;
+    virtual gptr<HWTexture> GetTexture() override;
+};
+
+class HWSurfaceNull : public HWSurface
+{
+public:
+    gptr<Window> window;
+    IVec2 size;
+
+    HWSurfaceNull(const gptr<Window>& window) : window(window) {
+        UpdateSize();
+    }
+
+    virtual void UpdateSize() override;
+    virtual IVec2 GetSize() const override;
+};
+
+class HWShaderNull : public HWShader
+{
+    gptr<HWContextNull> context;
+public:
+    HWShaderNull(const gptr<HWContextNull>& context, const gptr<ShaderInfo>& info);
+
+    virtual void Bind() override;
+    virtual void Unbind() override {}
+    virtual void SetVertexBuffer(int id, const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride) override;
+    virtual void SetIndexBuffer(const gptr<Buffer>& buffer) override;
+    virtual void SetUniform(int id, float value) override;
+    virtual void SetUniform(int id, const Vec2& value) override;
+    virtual void SetUniform(int id, const Vec3& value) override;
+    virtual void SetUniform(int id, const Vec4& value) override;
+    virtual void SetUniform(int id, const Mat2& value) override;
+    virtual void SetUniform(int id, const Mat3& value) override;
+    virtual void SetUniform(int id, const Mat4& value) override;
+    virtual void SetUniform(int id, const Color& value) override;
+    virtual void SetUniform(int id, const gptr<Texture>& texture) override;
+};
+
+} // gfx
+} // mw
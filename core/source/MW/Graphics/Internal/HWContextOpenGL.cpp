@@ -342,6 +342,78 @@ gptr<HWTexture> HWContextOpenGL::CreateTexture(
         self(this), size, format, dynamic, data);
 }
 
+gptr<HWTexture> HWContextOpenGL::CreateTexture(const TextureData& data) {
+    return gpnew<HWTextureOpenGL>(self(this), data);
+}
+
+// ETC2 is core in OpenGL ES 3.0 and OpenGL 4.3. Mobile drivers usually
+// create an ES 3 context even when 2.0 is asked for, so the version the
+// driver reports is checked rather than the one requested.
+static bool IsETC2Supported()
+{
+    static const bool supported = []
+    {
+        auto version = (const char*)gl::GetString(gl::VERSION);
+        int major = 0, minor = 0;
+
+        if (!version)
+            return false;
+
+#if PLATFORM_IOS || PLATFORM_ANDROID
+        return std::sscanf(version, "OpenGL ES %d.%d", &major, &minor) == 2 && major >= 3;
+#else
+        return std::sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 4 || (major == 4 && minor >= 3));
+#endif
+    }();
+
+    return supported;
+}
+
+// BC7 is core in OpenGL 4.2, and rarely available on mobile drivers
+static bool IsBPTCSupported()
+{
+#if PLATFORM_IOS || PLATFORM_ANDROID
+    return false;
+#else
+    static const bool supported = []
+    {
+        auto version = (const char*)gl::GetString(gl::VERSION);
+        int major = 0, minor = 0;
+
+        if (!version)
+            return false;
+
+        return std::sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 4 || (major == 4 && minor >= 2));
+    }();
+
+    return supported;
+#endif
+}
+
+bool HWContextOpenGL::IsCompressionSupported(TextureCompression compression) const
+{
+    switch (compression)
+    {
+    case TextureCompression::None:
+        return true;
+
+    // S3TC is available on all desktop drivers, but not on mobile ones
+    case TextureCompression::BC1:
+    case TextureCompression::BC3:
+        return !(PLATFORM_IOS || PLATFORM_ANDROID);
+
+    case TextureCompression::ETC2_RGB:
+    case TextureCompression::ETC2_RGBA:
+        return IsETC2Supported();
+
+    case TextureCompression::BC7:
+        return IsBPTCSupported();
+
+    default:
+        return false;
+    }
+}
+
 gptr<HWTexture> HWContextOpenGL::GetDefaultTexture()
 {
     if (!defaultTexture)
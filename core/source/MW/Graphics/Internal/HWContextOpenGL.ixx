@@ -7,6 +7,7 @@ module;
 
 export module Microwave.Graphics.Internal.HWContextOpenGL;
 import Microwave.Graphics.GraphicsTypes;
+import Microwave.Graphics.TextureData;
 import Microwave.Graphics.Internal.HWBufferOpenGL;
 import Microwave.Graphics.Internal.HWContext;
 import Microwave.Graphics.Internal.HWDriverContext;
@@ -99,6 +100,12 @@ public:
         const IVec2& size, PixelDataFormat format, bool dynamic,
         const std::span<std::byte>& data) override;
 
+    virtual gptr<HWTexture> CreateTexture(
+        const TextureData& data) override;
+
+    virtual bool IsCompressionSupported(
+        TextureCompression compression) const override;
+
     virtual gptr<HWTexture> GetDefaultTexture() override;
 };
 
@@ -31,6 +31,12 @@ std::unordered_map<PixelDataFormat, DXGI_FORMAT> textureFormats = {
     { PixelDataFormat::RGBAFloat, DXGI_FORMAT_R32G32B32A32_FLOAT }
 };
 
+std::unordered_map<TextureCompression, DXGI_FORMAT> compressedFormats = {
+    { TextureCompression::BC1, DXGI_FORMAT_BC1_UNORM },
+    { TextureCompression::BC3, DXGI_FORMAT_BC3_UNORM },
+    { TextureCompression::BC7, DXGI_FORMAT_BC7_UNORM }
+};
+
 std::unordered_map<PixelDataFormat, int> textureComponents = {
     { PixelDataFormat::Alpha8, 1 },
     { PixelDataFormat::RGB24, 4 },
@@ -79,6 +85,77 @@ HWTextureD3D11::HWTextureD3D11(
     buffer->Unmap();
 }
 
+HWTextureD3D11::HWTextureD3D11(
+    const gptr<HWContextD3D11>& context,
+    const TextureData& data)
+    : context(context)
+    , size(data.GetSize())
+    , format(data.format)
+{
+    internalFormat = (format == PixelDataFormat::RGB24) ? PixelDataFormat::RGBA32 : format;
+
+    auto blockSize = GetBlockSize(data.compression);
+    auto levelCount = data.levels.size();
+
+    std::vector<std::vector<std::byte>> expanded;
+    expanded.reserve(levelCount);
+
+    std::vector<D3D11_SUBRESOURCE_DATA> subResData(levelCount);
+
+    for (std::size_t i = 0; i < levelCount; ++i)
+    {
+        auto& level = data.levels[i];
+        const std::byte* pixels = level.data.data();
+
+        if (!blockSize && internalFormat != format)
+        {
+            std::size_t count = (std::size_t)level.size.x * level.size.y;
+            auto& temp = expanded.emplace_back(count * GetBytesPerPixel(internalFormat));
+            Image::ConvertPixels(pixels, format, temp.data(), internalFormat, count);
+            pixels = temp.data();
+        }
+
+        subResData[i].pSysMem = pixels;
+        subResData[i].SysMemPitch = blockSize
+            ? (UINT)(((level.size.x + 3) / 4) * blockSize)
+            : (UINT)(level.size.x * GetBytesPerPixel(internalFormat));
+        subResData[i].SysMemSlicePitch = 0;
+    }
+
+    D3D11_TEXTURE2D_DESC textureDesc;
+    textureDesc.Width = size.x;
+    textureDesc.Height = size.y;
+    textureDesc.MipLevels = (UINT)levelCount;
+    textureDesc.ArraySize = 1;
+    textureDesc.Format = blockSize ? compressedFormats[data.compression] : textureFormats[format];
+    textureDesc.SampleDesc.Count = 1;
+    textureDesc.SampleDesc.Quality = 0;
+    textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+    textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    textureDesc.CPUAccessFlags = 0;
+    textureDesc.MiscFlags = 0;
+
+    HRESULT res = context->device->CreateTexture2D(
+        &textureDesc, subResData.data(), &texture);
+
+    if (FAILED(res))
+        throw Exception("texture creation failed");
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC shaderResViewDesc;
+    shaderResViewDesc.Format = textureDesc.Format;
+    shaderResViewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+    shaderResViewDesc.Texture2D.MostDetailedMip = 0;
+    shaderResViewDesc.Texture2D.MipLevels = (UINT)levelCount;
+
+    res = context->device->CreateShaderResourceView(
+        texture.Get(), &shaderResViewDesc, &resourceView);
+
+    if (FAILED(res))
+        throw Exception("texture creation failed");
+
+    UpdateSamplerState();
+}
+
 HWTextureD3D11::~HWTextureD3D11()
 {
     samplerState = nullptr;
@@ -9,6 +9,7 @@ export module Microwave.Graphics.Internal.HWTextureD3D11;
 import Microwave.Graphics.GraphicsContext;
 import Microwave.Graphics.Internal.HWBuffer;
 import Microwave.Graphics.Internal.HWTexture;
+import Microwave.Graphics.TextureData;
 import Microwave.Math;
 import Microwave.System.Pointers;
 import std;
@@ -50,6 +51,11 @@ public:
         bool dynamic,
         const gptr<HWBuffer>& buffer);
 
+    // uploads every level of 'data', which must be a full mip chain
+    HWTextureD3D11(
+        const gptr<HWContextD3D11>& context,
+        const TextureData& data);
+
     virtual ~HWTextureD3D11();
 
     virtual void SetPixels(const std::span<std::byte>& data, const IntRect& rect) override;
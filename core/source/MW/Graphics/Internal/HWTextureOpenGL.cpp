@@ -52,6 +52,14 @@ std::unordered_map<PixelDataFormat, int> textureComponents = {
     { PixelDataFormat::RGBAFloat, 4 }
 };
 
+std::unordered_map<TextureCompression, gl::Enum> compressedFormats = {
+    { TextureCompression::BC1, gl::COMPRESSED_RGBA_S3TC_DXT1 },
+    { TextureCompression::BC3, gl::COMPRESSED_RGBA_S3TC_DXT5 },
+    { TextureCompression::ETC2_RGB, gl::COMPRESSED_RGB8_ETC2 },
+    { TextureCompression::ETC2_RGBA, gl::COMPRESSED_RGBA8_ETC2_EAC },
+    { TextureCompression::BC7, gl::COMPRESSED_RGBA_BPTC_UNORM }
+};
+
 std::unordered_map<TextureFilterMode, int> minFilters = {
     { TextureFilterMode::Point, gl::NEAREST_MIPMAP_NEAREST },
     { TextureFilterMode::Bilinear, gl::LINEAR_MIPMAP_NEAREST },
@@ -112,6 +120,54 @@ HWTextureOpenGL::HWTextureOpenGL(
     gl::BindTexture(gl::TEXTURE_2D, 0);
 }
 
+HWTextureOpenGL::HWTextureOpenGL(
+    const gptr<HWContextOpenGL>& context,
+    TextureData data)
+    : context(context)
+    , size(data.GetSize())
+    , format(data.format)
+{
+    // OpenGL's rows go from bottom to top
+    if (!data.FlipVertical())
+    {
+        data = data.Decompress();
+        data.FlipVertical();
+    }
+
+    format = data.format;
+
+    gl::GenTextures(1, &textureID);
+    gl::BindTexture(gl::TEXTURE_2D, textureID);
+
+    for (int i = 0; i < (int)data.levels.size(); ++i)
+    {
+        auto& level = data.levels[i];
+
+        if (data.compression != TextureCompression::None)
+        {
+            gl::CompressedTexImage2D(gl::TEXTURE_2D, i, compressedFormats[data.compression],
+                level.size.x, level.size.y, 0, (gl::Sizei)level.data.size(), level.data.data());
+        }
+        else
+        {
+            auto fmt = textureFormats[format];
+            auto typ = componentTypes[format];
+            gl::TexImage2D(gl::TEXTURE_2D, i, fmt, level.size.x, level.size.y, 0, fmt, typ, level.data.data());
+        }
+    }
+
+    int minFilter = minFilters[TextureFilterMode::Bilinear];
+    int magFilter = magFilters[TextureFilterMode::Bilinear];
+    gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MIN_FILTER, minFilter);
+    gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_MAG_FILTER, magFilter);
+
+    auto mode = wrapModes[TextureWrapMode::Repeat];
+    gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_WRAP_S, mode);
+    gl::TexParameteri(gl::TEXTURE_2D, gl::TEXTURE_WRAP_T, mode);
+
+    gl::BindTexture(gl::TEXTURE_2D, 0);
+}
+
 HWTextureOpenGL::~HWTextureOpenGL()
 {
     if (gl::IsTexture(textureID))
@@ -10,6 +10,7 @@ import Microwave.Graphics.GraphicsTypes;
 import Microwave.Graphics.Internal.HWBuffer;
 import Microwave.Graphics.Internal.HWTexture;
 import Microwave.Graphics.Internal.OpenGLAPI;
+import Microwave.Graphics.TextureData;
 import Microwave.Math;
 import Microwave.System.Pointers;
 import Microwave.System.Task;
@@ -37,6 +38,11 @@ public:
         bool dynamic,
         const std::span<std::byte>& data);
 
+    // uploads every level of 'data', which must be a full mip chain
+    HWTextureOpenGL(
+        const gptr<HWContextOpenGL>& context,
+        TextureData data);
+
     virtual ~HWTextureOpenGL();
 
     virtual void SetPixels(const std::span<std::byte>& data, const IntRect& rect) override;
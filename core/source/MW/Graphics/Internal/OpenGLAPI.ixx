@@ -103,6 +103,7 @@ typedef GLdouble Double;
 typedef GLclampd Clampd;
 typedef GLvoid Void;
 
+constexpr Enum VERSION = GL_VERSION;
 constexpr Enum TEXTURE_2D = GL_TEXTURE_2D;
 constexpr Enum UNPACK_SKIP_ROWS = GL_UNPACK_SKIP_ROWS;
 constexpr Enum UNPACK_SKIP_PIXELS = GL_UNPACK_SKIP_PIXELS;
@@ -111,6 +112,11 @@ constexpr Enum TEXTURE_WRAP_S = GL_TEXTURE_WRAP_S;
 constexpr Enum TEXTURE_WRAP_T = GL_TEXTURE_WRAP_T;
 constexpr Enum TEXTURE_MIN_FILTER = GL_TEXTURE_MIN_FILTER;
 constexpr Enum TEXTURE_MAG_FILTER = GL_TEXTURE_MAG_FILTER;
+constexpr Enum COMPRESSED_RGBA_S3TC_DXT1 = 0x83F1; // EXT_texture_compression_s3tc
+constexpr Enum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3; // EXT_texture_compression_s3tc
+constexpr Enum COMPRESSED_RGB8_ETC2 = 0x9274; // OpenGL ES 3.0, OpenGL 4.3
+constexpr Enum COMPRESSED_RGBA8_ETC2_EAC = 0x9278; // OpenGL ES 3.0, OpenGL 4.3
+constexpr Enum COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C; // OpenGL 4.2
 constexpr Enum TEXTURE_MAX_ANISOTROPY = GL_TEXTURE_MAX_ANISOTROPY_EXT;
 constexpr Enum MAX_TEXTURE_MAX_ANISOTROPY = GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT;
 constexpr Enum CLAMP_TO_EDGE = GL_CLAMP_TO_EDGE;
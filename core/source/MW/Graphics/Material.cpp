@@ -32,14 +32,10 @@ void Material::SetActive(const MaterialPropertyBlock* extra)
 
     shader->Bind();
 
-    for (auto& [name, prop] : properties->properties)
-        prop->Apply(shader);
+    properties->Apply(shader);
 
     if (extra)
-    {
-        for (auto& [name, prop] : extra->properties)
-            prop->Apply(shader);
-    }
+        extra->Apply(shader);
 
     graphics->SetBlendOperations(colorBlendOperation, alphaBlendOperation);
     graphics->SetBlendFactors(
@@ -8,6 +8,7 @@ import Microwave.Graphics.GraphicsTypes;
 import Microwave.Graphics.MaterialPropertyBlock;
 import Microwave.Graphics.RenderQueue;
 import Microwave.Graphics.Shader;
+import Microwave.Graphics.ShaderInfo;
 import Microwave.Graphics.Texture;
 import Microwave.Math;
 import Microwave.System.Json;
@@ -59,16 +60,16 @@ public:
 
     Material(){}
 
-    void SetUniform(const std::string& name, float value);
-    void SetUniform(const std::string& name, const Vec2& value);
-    void SetUniform(const std::string& name, const Vec3& value);
-    void SetUniform(const std::string& name, const Vec4& value);
-    void SetUniform(const std::string& name, const Mat2& value);
-    void SetUniform(const std::string& name, const Mat3& value);
-    void SetUniform(const std::string& name, const Mat4& value);
-    void SetUniform(const std::string& name, const Color& value);
-    void SetUniform(const std::string& name, const gptr<Texture>& value);
-    gptr<Texture> GetTexture(const std::string& name);
+    void SetUniform(UniformName name, float value);
+    void SetUniform(UniformName name, const Vec2& value);
+    void SetUniform(UniformName name, const Vec3& value);
+    void SetUniform(UniformName name, const Vec4& value);
+    void SetUniform(UniformName name, const Mat2& value);
+    void SetUniform(UniformName name, const Mat3& value);
+    void SetUniform(UniformName name, const Mat4& value);
+    void SetUniform(UniformName name, const Color& value);
+    void SetUniform(UniformName name, const gptr<Texture>& value);
+    gptr<Texture> GetTexture(UniformName name);
 
     void SetBlendFactors(BlendFactor src, BlendFactor dest);
 
@@ -78,43 +79,43 @@ public:
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 };
 
-void Material::SetUniform(const std::string& name, float value) {
+void Material::SetUniform(UniformName name, float value) {
     properties->SetUniform(name, value);
 }
 
-void Material::SetUniform(const std::string& name, const Vec2& value) {
+void Material::SetUniform(UniformName name, const Vec2& value) {
     properties->SetUniform(name, value);
 }
 
-void Material::SetUniform(const std::string& name, const Vec3& value) {
+void Material::SetUniform(UniformName name, const Vec3& value) {
     properties->SetUniform(name, value);
 }
 
-void Material::SetUniform(const std::string& name, const Vec4& value) {
+void Material::SetUniform(UniformName name, const Vec4& value) {
     properties->SetUniform(name, value);
 }
 
-void Material::SetUniform(const std::string& name, const Mat2& value) {
+void Material::SetUniform(UniformName name, const Mat2& value) {
     properties->SetUniform(name, value);
 }
 
-void Material::SetUniform(const std::string& name, const Mat3& value) {
+void Material::SetUniform(UniformName name, const Mat3& value) {
     properties->SetUniform(name, value);
 }
 
-void Material::SetUniform(const std::string& name, const Mat4& value) {
+void Material::SetUniform(UniformName name, const Mat4& value) {
     properties->SetUniform(name, value);
 }
 
-void Material::SetUniform(const std::string& name, const Color& value) {
+void Material::SetUniform(UniformName name, const Color& value) {
     properties->SetUniform(name, value);
 }
 
-void Material::SetUniform(const std::string& name, const gptr<Texture>& value) {
+void Material::SetUniform(UniformName name, const gptr<Texture>& value) {
     properties->SetUniform(name, value);
 }
 
-gptr<Texture> Material::GetTexture(const std::string& name) {
+gptr<Texture> Material::GetTexture(UniformName name) {
     return properties->GetTexture(name);
 }
 
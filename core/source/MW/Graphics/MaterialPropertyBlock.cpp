@@ -11,167 +11,239 @@ import <MW/System/Debug.h>;
 namespace mw {
 inline namespace gfx {
 
-template<class T> struct ShaderVarLangType { const static ShaderVarType type = ShaderVarType::Unknown; };
-template<> struct ShaderVarLangType<float> { const static ShaderVarType type = ShaderVarType::Float; };
-template<> struct ShaderVarLangType<Vec2> { const static ShaderVarType type = ShaderVarType::Float2; };
-template<> struct ShaderVarLangType<Vec3> { const static ShaderVarType type = ShaderVarType::Float3; };
-template<> struct ShaderVarLangType<Vec4> { const static ShaderVarType type = ShaderVarType::Float4; };
-template<> struct ShaderVarLangType<Mat2> { const static ShaderVarType type = ShaderVarType::Float2x2; };
-template<> struct ShaderVarLangType<Mat3> { const static ShaderVarType type = ShaderVarType::Float3x3; };
-template<> struct ShaderVarLangType<Mat4> { const static ShaderVarType type = ShaderVarType::Float4x4; };
-template<> struct ShaderVarLangType<Color> { const static ShaderVarType type = ShaderVarType::Float4; };
-template<> struct ShaderVarLangType<gptr<Texture>> { const static ShaderVarType type = ShaderVarType::Sampler2D; };
-
-template<class T>
-class MaterialPropertyT : public MaterialProperty
-{
-public:
-    typedef T value_type;
-    constexpr static ShaderVarType var_type = ShaderVarLangType<T>::type;
+// property types as they were saved when each property was its own Object
+constexpr std::pair<ShaderVarType, const char*> PropertyTypeNames[] = {
+    { ShaderVarType::Float, "MaterialPropertyFloat" },
+    { ShaderVarType::Float2, "MaterialPropertyFloat2" },
+    { ShaderVarType::Float3, "MaterialPropertyFloat3" },
+    { ShaderVarType::Float4, "MaterialPropertyFloat4" },
+    { ShaderVarType::Float2x2, "MaterialPropertyFloat2x2" },
+    { ShaderVarType::Float3x3, "MaterialPropertyFloat3x3" },
+    { ShaderVarType::Float4x4, "MaterialPropertyFloat4x4" },
+    { ShaderVarType::Sampler2D, "MaterialPropertyTexture" },
+};
 
-    T value = {};
+constexpr const char* ColorPropertyTypeName = "MaterialPropertyColor";
 
-    virtual ShaderVarType GetUniformType() const override {
-        return ShaderVarLangType<T>::type;
+static std::size_t GetValueCount(ShaderVarType type)
+{
+    switch (type)
+    {
+    case ShaderVarType::Float: return 1;
+    case ShaderVarType::Float2: return 2;
+    case ShaderVarType::Float3: return 3;
+    case ShaderVarType::Float4: return 4;
+    case ShaderVarType::Float2x2: return sizeof(Mat2) / sizeof(float);
+    case ShaderVarType::Float3x3: return sizeof(Mat3) / sizeof(float);
+    case ShaderVarType::Float4x4: return sizeof(Mat4) / sizeof(float);
+    default: return 0;
     }
+}
 
-    virtual void Apply(const gptr<Shader>& shader) override {
-        shader->SetUniform(name, value);
-    }
+template<class T>
+static T ReadValue(const float* data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
 
-    virtual void ToJson(json& obj) const override {
-        Object::ToJson(obj);
-        obj["value"] = value;
+MaterialPropertyBlock::Property* MaterialPropertyBlock::Find(UniformName name)
+{
+    // blocks only have a few properties, so this beats a map
+    for (auto& prop : properties)
+    {
+        if (prop.hash == name.hash && prop.name == name.str)
+            return &prop;
     }
 
-    virtual void FromJson(const json& obj, ObjectLinker* linker) override {
-        Object::FromJson(obj, linker);
-        value = obj.value("value", value);
-    }
-};
+    return nullptr;
+}
 
-class MaterialPropertyFloat : public MaterialPropertyT<float>{
-    inline static Type::Pin<MaterialPropertyFloat> pin;
-};
-class MaterialPropertyFloat2 : public MaterialPropertyT<Vec2> {
-    inline static Type::Pin<MaterialPropertyFloat2> pin;
-};
-class MaterialPropertyFloat3 : public MaterialPropertyT<Vec3> {
-    inline static Type::Pin<MaterialPropertyFloat3> pin;
-};
-class MaterialPropertyFloat4 : public MaterialPropertyT<Vec4> {
-    inline static Type::Pin<MaterialPropertyFloat4> pin;
-};
-class MaterialPropertyFloat2x2 : public MaterialPropertyT<Mat2> {
-    inline static Type::Pin<MaterialPropertyFloat2x2> pin;
-};
-class MaterialPropertyFloat3x3 : public MaterialPropertyT<Mat3> {
-    inline static Type::Pin<MaterialPropertyFloat3x3> pin;
-};
-class MaterialPropertyFloat4x4 : public MaterialPropertyT<Mat4> {
-    inline static Type::Pin<MaterialPropertyFloat4x4> pin;
-};
-class MaterialPropertyColor : public MaterialPropertyT<Vec4> {
-    inline static Type::Pin<MaterialPropertyColor> pin;
-};
+const MaterialPropertyBlock::Property* MaterialPropertyBlock::Find(UniformName name) const {
+    return const_cast<MaterialPropertyBlock*>(this)->Find(name);
+}
 
-class MaterialPropertyTexture : public MaterialProperty
+void MaterialPropertyBlock::Remove(std::size_t index)
 {
-    inline static Type::Pin<MaterialPropertyTexture> pin;
-public:
-    typedef gptr<Texture> value_type;
-    constexpr static ShaderVarType var_type = ShaderVarLangType<gptr<Texture>>::type;
+    Property removed = std::move(properties[index]);
+    properties.erase(properties.begin() + index);
 
-    gptr<Texture> value = {};
+    bool isTexture = (removed.type == ShaderVarType::Sampler2D);
+    std::size_t count = isTexture ? 1 : GetValueCount(removed.type);
 
-    virtual ShaderVarType GetUniformType() const override {
-        return ShaderVarLangType<gptr<Texture>>::type;
-    }
+    if (isTexture)
+        textures.erase(textures.begin() + removed.offset);
+    else
+        values.erase(values.begin() + removed.offset, values.begin() + removed.offset + count);
 
-    virtual void Apply(const gptr<Shader>& shader) override {
-        shader->SetUniform(name, value);
+    for (auto& prop : properties)
+    {
+        if ((prop.type == ShaderVarType::Sampler2D) == isTexture && prop.offset > removed.offset)
+            prop.offset -= (std::uint32_t)count;
     }
 
-    virtual void ToJson(json& obj) const override {
-        Object::ToJson(obj);
-        ObjectLinker::SaveAsset(obj, "value", value);
-    }
+    slotShader = nullptr;
+}
 
-    virtual void FromJson(const json& obj, ObjectLinker* linker) override {
-        Object::FromJson(obj, linker);
-        ObjectLinker::RestoreAsset(linker, self(this), value, obj, "value");
+std::uint32_t MaterialPropertyBlock::Reserve(UniformName name, ShaderVarType type, bool isColor)
+{
+    if (auto prop = Find(name))
+    {
+        if (prop->type == type) {
+            prop->isColor = isColor;
+            return prop->offset;
+        }
+
+        Remove(prop - properties.data());
     }
-};
 
-template<class PTy>
-void SetUniformImpl(MaterialPropertyBlock& block, const std::string& name, const typename PTy::value_type& value)
-{
-    gptr<PTy> prop;
+    Property prop;
+    prop.name = name.str;
+    prop.hash = name.hash;
+    prop.type = type;
+    prop.isColor = isColor;
 
-    auto it = block.properties.find(name);
-    if (it == block.properties.end() || it->second->GetUniformType() != ShaderVarLangType<typename PTy::value_type>::type)
+    if (type == ShaderVarType::Sampler2D)
     {
-        prop = gpnew<PTy>();
-        prop->SetName(name);
-        block.properties[name] = prop;
+        prop.offset = (std::uint32_t)textures.size();
+        textures.emplace_back();
     }
     else
     {
-        prop = gpcast<PTy>(it->second);
+        prop.offset = (std::uint32_t)values.size();
+        values.resize(values.size() + GetValueCount(type));
     }
 
-    Assert(prop);
-    prop->value = value;
+    properties.push_back(std::move(prop));
+    slotShader = nullptr;
+
+    return properties.back().offset;
+}
+
+void MaterialPropertyBlock::SetValue(
+    UniformName name, ShaderVarType type, bool isColor,
+    const float* data, std::size_t count)
+{
+    Assert(GetValueCount(type) == count);
+    auto offset = Reserve(name, type, isColor);
+    std::copy(data, data + count, values.begin() + offset);
+}
+
+const std::vector<MaterialPropertyBlock::Property>& MaterialPropertyBlock::GetProperties() const {
+    return properties;
+}
+
+bool MaterialPropertyBlock::IsEmpty() const {
+    return properties.empty();
+}
+
+void MaterialPropertyBlock::Clear()
+{
+    properties.clear();
+    values.clear();
+    textures.clear();
+    slotShader = nullptr;
 }
 
-void MaterialPropertyBlock::SetUniform(const std::string& name, float value) {
-    SetUniformImpl<MaterialPropertyFloat>(*this, name, value);
+void MaterialPropertyBlock::SetUniform(UniformName name, float value) {
+    SetValue(name, ShaderVarType::Float, false, &value, 1);
 }
 
-void MaterialPropertyBlock::SetUniform(const std::string& name, const Vec2& value) {
-    SetUniformImpl<MaterialPropertyFloat2>(*this, name, value);
+void MaterialPropertyBlock::SetUniform(UniformName name, const Vec2& value) {
+    SetValue(name, ShaderVarType::Float2, false, (const float*)&value, 2);
 }
 
-void MaterialPropertyBlock::SetUniform(const std::string& name, const Vec3& value) {
-    SetUniformImpl<MaterialPropertyFloat3>(*this, name, value);
+void MaterialPropertyBlock::SetUniform(UniformName name, const Vec3& value) {
+    SetValue(name, ShaderVarType::Float3, false, (const float*)&value, 3);
 }
 
-void MaterialPropertyBlock::SetUniform(const std::string& name, const Vec4& value) {
-    SetUniformImpl<MaterialPropertyFloat4>(*this, name, value);
+void MaterialPropertyBlock::SetUniform(UniformName name, const Vec4& value) {
+    SetValue(name, ShaderVarType::Float4, false, (const float*)&value, 4);
 }
 
-void MaterialPropertyBlock::SetUniform(const std::string& name, const Mat2& value) {
-    SetUniformImpl<MaterialPropertyFloat2x2>(*this, name, value);
+void MaterialPropertyBlock::SetUniform(UniformName name, const Mat2& value) {
+    SetValue(name, ShaderVarType::Float2x2, false, (const float*)&value, sizeof(Mat2) / sizeof(float));
 }
 
-void MaterialPropertyBlock::SetUniform(const std::string& name, const Mat3& value) {
-    SetUniformImpl<MaterialPropertyFloat3x3>(*this, name, value);
+void MaterialPropertyBlock::SetUniform(UniformName name, const Mat3& value) {
+    SetValue(name, ShaderVarType::Float3x3, false, (const float*)&value, sizeof(Mat3) / sizeof(float));
 }
 
-void MaterialPropertyBlock::SetUniform(const std::string& name, const Mat4& value) {
-    SetUniformImpl<MaterialPropertyFloat4x4>(*this, name, value);
+void MaterialPropertyBlock::SetUniform(UniformName name, const Mat4& value) {
+    SetValue(name, ShaderVarType::Float4x4, false, (const float*)&value, sizeof(Mat4) / sizeof(float));
 }
 
-void MaterialPropertyBlock::SetUniform(const std::string& name, const Color& value) {
-    SetUniformImpl<MaterialPropertyColor>(*this, name, (Vec4&)value);
+void MaterialPropertyBlock::SetUniform(UniformName name, const Color& value) {
+    SetValue(name, ShaderVarType::Float4, true, (const float*)&value, 4);
 }
 
-void MaterialPropertyBlock::SetUniform(const std::string& name, const gptr<Texture>& value) {
-    SetUniformImpl<MaterialPropertyTexture>(*this, name, value);
+void MaterialPropertyBlock::SetUniform(UniformName name, const gptr<Texture>& value) {
+    textures[Reserve(name, ShaderVarType::Sampler2D, false)] = value;
 }
 
-gptr<Texture> MaterialPropertyBlock::GetTexture(const std::string& name)
+gptr<Texture> MaterialPropertyBlock::GetTexture(UniformName name) const
 {
     gptr<Texture> ret;
 
-    auto it = properties.find(name);
-    if (it != properties.end() && it->second->GetUniformType() == ShaderVarType::Sampler2D)
+    auto prop = Find(name);
+    if (prop && prop->type == ShaderVarType::Sampler2D)
+        ret = textures[prop->offset];
+
+    return ret;
+}
+
+void MaterialPropertyBlock::Apply(const gptr<Shader>& shader) const
+{
+    if (slotShader != shader)
     {
-        auto prop = (MaterialPropertyTexture*)it->second.get();
-        ret = prop->value;
+        slots.resize(properties.size());
+
+        for (std::size_t i = 0; i < properties.size(); ++i)
+            slots[i] = shader->GetUniformID(properties[i].name);
+
+        slotShader = shader;
     }
 
-    return ret;
+    for (std::size_t i = 0; i < properties.size(); ++i)
+    {
+        int slot = slots[i];
+        if (slot < 0)
+            continue;
+
+        auto& prop = properties[i];
+        const float* data = values.data() + prop.offset;
+
+        switch (prop.type)
+        {
+        case ShaderVarType::Float:
+            shader->SetUniform(slot, data[0]);
+            break;
+        case ShaderVarType::Float2:
+            shader->SetUniform(slot, ReadValue<Vec2>(data));
+            break;
+        case ShaderVarType::Float3:
+            shader->SetUniform(slot, ReadValue<Vec3>(data));
+            break;
+        case ShaderVarType::Float4:
+            shader->SetUniform(slot, ReadValue<Vec4>(data));
+            break;
+        case ShaderVarType::Float2x2:
+            shader->SetUniform(slot, ReadValue<Mat2>(data));
+            break;
+        case ShaderVarType::Float3x3:
+            shader->SetUniform(slot, ReadValue<Mat3>(data));
+            break;
+        case ShaderVarType::Float4x4:
+            shader->SetUniform(slot, ReadValue<Mat4>(data));
+            break;
+        case ShaderVarType::Sampler2D:
+            shader->SetUniform(slot, textures[prop.offset]);
+            break;
+        default:
+            break;
+        }
+    }
 }
 
 void MaterialPropertyBlock::ToJson(json& obj) const
@@ -180,8 +252,34 @@ void MaterialPropertyBlock::ToJson(json& obj) const
 
     auto props = json::object();
 
-    for (auto& [key, val] : properties)
-        val->ToJson(props[key]);
+    for (auto& prop : properties)
+    {
+        auto& p = props[prop.name];
+        const float* data = values.data() + prop.offset;
+
+        auto typeName = std::find_if(
+            std::begin(PropertyTypeNames), std::end(PropertyTypeNames),
+            [&](auto& entry) { return entry.first == prop.type; });
+
+        p["objectType"] = prop.isColor ? ColorPropertyTypeName : typeName->second;
+        p["name"] = prop.name;
+
+        switch (prop.type)
+        {
+        case ShaderVarType::Float: p["value"] = data[0]; break;
+        case ShaderVarType::Float2: p["value"] = ReadValue<Vec2>(data); break;
+        case ShaderVarType::Float3: p["value"] = ReadValue<Vec3>(data); break;
+        case ShaderVarType::Float4: p["value"] = ReadValue<Vec4>(data); break;
+        case ShaderVarType::Float2x2: p["value"] = ReadValue<Mat2>(data); break;
+        case ShaderVarType::Float3x3: p["value"] = ReadValue<Mat3>(data); break;
+        case ShaderVarType::Float4x4: p["value"] = ReadValue<Mat4>(data); break;
+        case ShaderVarType::Sampler2D:
+            ObjectLinker::SaveAsset(p, "value", textures[prop.offset]);
+            break;
+        default:
+            break;
+        }
+    }
 
     obj["properties"] = std::move(props);
 }
@@ -189,9 +287,56 @@ void MaterialPropertyBlock::ToJson(json& obj) const
 void MaterialPropertyBlock::FromJson(const json& obj, ObjectLinker* linker)
 {
     Object::FromJson(obj, linker);
+    Clear();
 
-    for (auto& [key, value] : obj["properties"].items())
-        properties[key] = Object::CreateFromJson<MaterialProperty>(value, linker);
+    auto& props = obj["properties"];
+
+    for (auto& [key, value] : props.items())
+    {
+        auto typeName = value.value("objectType", std::string());
+
+        if (typeName == ColorPropertyTypeName)
+        {
+            auto color = value.value("value", Vec4());
+            SetValue(key, ShaderVarType::Float4, true, (const float*)&color, 4);
+            continue;
+        }
+
+        auto it = std::find_if(
+            std::begin(PropertyTypeNames), std::end(PropertyTypeNames),
+            [&](auto& entry) { return typeName == entry.second; });
+
+        if (it == std::end(PropertyTypeNames))
+            throw Exception("unknown material property type: " + typeName);
+
+        switch (it->first)
+        {
+        case ShaderVarType::Float: SetUniform(key, value.value("value", 0.0f)); break;
+        case ShaderVarType::Float2: SetUniform(key, value.value("value", Vec2())); break;
+        case ShaderVarType::Float3: SetUniform(key, value.value("value", Vec3())); break;
+        case ShaderVarType::Float4: SetUniform(key, value.value("value", Vec4())); break;
+        case ShaderVarType::Float2x2: SetUniform(key, value.value("value", Mat2())); break;
+        case ShaderVarType::Float3x3: SetUniform(key, value.value("value", Mat3())); break;
+        case ShaderVarType::Float4x4: SetUniform(key, value.value("value", Mat4())); break;
+        case ShaderVarType::Sampler2D:
+        {
+            // Linked by name, since later properties may still move the
+            // texture, and so can anything that runs before linking.
+            Reserve(key, ShaderVarType::Sampler2D, false);
+
+            ObjectLinker::RestoreAssetWith<Texture>(linker, self(this),
+                [this, name = std::string(key)](const gptr<Texture>& tex) {
+                    auto prop = Find(name);
+                    if (prop && prop->type == ShaderVarType::Sampler2D)
+                        textures[prop->offset] = tex;
+                },
+                value, "value");
+            break;
+        }
+        default:
+            break;
+        }
+    }
 }
 
 } // gfx
@@ -17,35 +17,59 @@ import std;
 export namespace mw {
 inline namespace gfx {
 
-class MaterialProperty : public Object
-{
-public:
-    virtual ShaderVarType GetUniformType() const = 0;
-    virtual void Apply(const gptr<Shader>& shader) = 0;
-    virtual void ToJson(json& obj) const = 0;
-    virtual void FromJson(const json& obj, ObjectLinker* linker) = 0;
-};
-
+// Uniform values, packed into a single array of floats, plus an array of
+// textures. The uniform IDs of the properties are looked up once for each
+// shader the block is applied to, so applying it again to the same shader
+// is just a loop over the properties.
 class MaterialPropertyBlock : public Object
 {
     inline static Type::Pin<MaterialPropertyBlock> pin;
 public:
+    struct Property
+    {
+        std::string name;
+        std::uint32_t hash = 0;
+        ShaderVarType type = ShaderVarType::Unknown;
+        bool isColor = false;       // stored as Float4, but saved as a Color
+        std::uint32_t offset = 0;   // into 'values', or into 'textures' for Sampler2D
+    };
+
+private:
+    std::vector<Property> properties;
+    std::vector<float> values;
+    gvector<gptr<Texture>> textures;
 
+    // IDs of 'properties' in the shader they were last applied to
+    mutable gptr<Shader> slotShader;
+    mutable std::vector<int> slots;
+
+    Property* Find(UniformName name);
+    const Property* Find(UniformName name) const;
+    void Remove(std::size_t index);
+    std::uint32_t Reserve(UniformName name, ShaderVarType type, bool isColor);
+    void SetValue(UniformName name, ShaderVarType type, bool isColor, const float* data, std::size_t count);
+
+public:
     MaterialPropertyBlock(){}
 
-    gmap<std::string, gptr<MaterialProperty>> properties;
+    const std::vector<Property>& GetProperties() const;
+    bool IsEmpty() const;
+    void Clear();
+
+    void SetUniform(UniformName name, float value);
+    void SetUniform(UniformName name, const Vec2& value);
+    void SetUniform(UniformName name, const Vec3& value);
+    void SetUniform(UniformName name, const Vec4& value);
+    void SetUniform(UniformName name, const Mat2& value);
+    void SetUniform(UniformName name, const Mat3& value);
+    void SetUniform(UniformName name, const Mat4& value);
+    void SetUniform(UniformName name, const Color& value);
+    void SetUniform(UniformName name, const gptr<Texture>& value);
 
-    void SetUniform(const std::string& name, float value);
-    void SetUniform(const std::string& name, const Vec2& value);
-    void SetUniform(const std::string& name, const Vec3& value);
-    void SetUniform(const std::string& name, const Vec4& value);
-    void SetUniform(const std::string& name, const Mat2& value);
-    void SetUniform(const std::string& name, const Mat3& value);
-    void SetUniform(const std::string& name, const Mat4& value);
-    void SetUniform(const std::string& name, const Color& value);
-    void SetUniform(const std::string& name, const gptr<Texture>& value);
+    gptr<Texture> GetTexture(UniformName name) const;
 
-    gptr<Texture> GetTexture(const std::string& name);
+    // sets every property on 'shader', which must be bound
+    void Apply(const gptr<Shader>& shader) const;
 
     virtual void ToJson(json& obj) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
@@ -8,6 +8,7 @@ import Microwave.Graphics.GraphicsTypes;
 import Microwave.Graphics.Internal.HWBuffer;
 import Microwave.System.Exception;
 import std;
+import <MW/System/Debug.h>;
 
 namespace mw {
 inline namespace gfx {
@@ -26,6 +27,25 @@ void Mesh::ToJson(json& obj) const
     obj["boneWeights"] = boneWeights;
     obj["bsphere"] = bsphere;
     obj["bbox"] = bbox;
+    obj["collisionHull"] = collisionHull;
+}
+
+void Mesh::WriteJson(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WriteObjectJson(writer);
+    writer.Property("vertices", vertices);
+    writer.Property("normals", normals);
+    writer.Property("texcoords", texcoords);
+    writer.Property("elements", elements);
+    writer.Property("skinType", skinType);
+    writer.Property("bones", bones);
+    writer.Property("boneIndices", boneIndices);
+    writer.Property("boneWeights", boneWeights);
+    writer.Property("bsphere", bsphere);
+    writer.Property("bbox", bbox);
+    writer.Property("collisionHull", collisionHull);
+    writer.EndObject();
 }
 
 void Mesh::FromJson(const json& obj, ObjectLinker* linker)
@@ -42,6 +62,7 @@ void Mesh::FromJson(const json& obj, ObjectLinker* linker)
     boneWeights = obj.value("boneWeights", boneWeights);
     bsphere = obj.value("bsphere", bsphere);
     bbox = obj.value("bbox", bbox);
+    collisionHull = obj.value("collisionHull", collisionHull);
 
     UpdateBuffers();
 }
@@ -79,91 +100,158 @@ void Mesh::RecalcBounds()
     }
 }
 
-void Mesh::UpdateBuffers()
+void Mesh::WriteArtifact(BinaryArtifactWriter& writer) const
 {
-    auto graphics = GraphicsContext::GetCurrent();
-    bool dynamicBuffers = skinType != SkinType::None;
+    json& obj = writer.header;
+    Object::ToJson(obj);
 
-    BufferUsage usage{};
-    BufferCPUAccess cpuAccess{};
+    obj["vertices"] = writer.AddStream(vertices);
+    obj["normals"] = writer.AddStream(normals);
+    obj["texcoords"] = writer.AddStream(texcoords);
+    obj["skinType"] = skinType;
+    obj["boneIndices"] = writer.AddStream(boneIndices);
+    obj["boneWeights"] = writer.AddStream(boneWeights);
+    obj["bsphere"] = bsphere;
+    obj["bbox"] = bbox;
+    obj["collisionHull"] = writer.AddStream(collisionHull);
+    obj["collisionTree"] = writer.AddStream(collisionTree);
 
-    if(skinType != SkinType::None) {
-        usage = BufferUsage::Dynamic;
-        cpuAccess = BufferCPUAccess::WriteOnly;
-    }
-    else {
-        usage = BufferUsage::Static;
-        cpuAccess = BufferCPUAccess::None;
-    }
+    json elems = json::array();
 
-    if (!vertices.empty())
-    {
-        vertexBuffer = gpnew<Buffer>(
-            BufferType::Vertex, usage, cpuAccess,
-            std::as_writable_bytes(std::span(vertices)));
-    }
-    else
+    for (auto& elem : elements)
     {
-        vertexBuffer = nullptr;
+        json e;
+        e["drawMode"] = elem.drawMode;
+        e["indices"] = writer.AddStream(elem.indices);
+        elems.push_back(std::move(e));
     }
 
-    if (!normals.empty())
-    {
-        normalBuffer = gpnew<Buffer>(
-            BufferType::Vertex, usage, cpuAccess,
-            std::as_writable_bytes(std::span(normals)));
-    }
-    else
-    {
-        normalBuffer = nullptr;
-    }
+    obj["elements"] = std::move(elems);
 
-    if (!texcoords.empty())
-    {
-        texcoordBuffer = gpnew<Buffer>(
-            BufferType::Vertex, BufferUsage::Static, BufferCPUAccess::None,
-            std::as_writable_bytes(std::span(texcoords)));
-    }
-    else
-    {
-        texcoordBuffer = nullptr;
-    }
+    // bind matrices go in a stream, three per bone
+    json boneObjs = json::array();
+    std::vector<Mat4> boneMatrices;
+    boneMatrices.reserve(bones.size() * 3);
 
-    if (!boneIndices.empty())
+    for (auto& bone : bones)
     {
-        boneIndexBuffer = gpnew<Buffer>(
-            BufferType::Vertex, BufferUsage::Static, BufferCPUAccess::None,
-            std::as_writable_bytes(std::span(boneIndices)));
-    }
-    else
-    {
-        boneIndexBuffer = nullptr;
+        json b;
+        b["linkNodePath"] = bone.linkNodePath;
+        b["linkMode"] = bone.linkMode;
+        boneObjs.push_back(std::move(b));
+
+        boneMatrices.push_back(bone.boneBindMatrix);
+        boneMatrices.push_back(bone.meshBindMatrix);
+        boneMatrices.push_back(bone.invBoneBindMatrix);
     }
 
-    if (!boneWeights.empty())
+    obj["bones"] = std::move(boneObjs);
+    obj["boneMatrices"] = writer.AddStream(boneMatrices);
+}
+
+void Mesh::ReadArtifact(const BinaryArtifact& artifact, ObjectLinker* linker)
+{
+    const json& obj = artifact.GetHeader();
+    Object::FromJson(obj, linker);
+
+    artifact.ReadStream(obj.value("vertices", -1), vertices);
+    artifact.ReadStream(obj.value("normals", -1), normals);
+    artifact.ReadStream(obj.value("texcoords", -1), texcoords);
+    skinType = obj.value("skinType", skinType);
+    artifact.ReadStream(obj.value("boneIndices", -1), boneIndices);
+    artifact.ReadStream(obj.value("boneWeights", -1), boneWeights);
+    bsphere = obj.value("bsphere", bsphere);
+    bbox = obj.value("bbox", bbox);
+    artifact.ReadStream(obj.value("collisionHull", -1), collisionHull);
+    artifact.ReadStream(obj.value("collisionTree", -1), collisionTree);
+
+    elements.clear();
+    std::vector<std::span<std::byte>> indexData;
+
+    for (auto& e : obj["elements"])
     {
-        boneWeightBuffer = gpnew<Buffer>(
-            BufferType::Vertex, BufferUsage::Static, BufferCPUAccess::None,
-            std::as_writable_bytes(std::span(boneWeights)));
+        int stream = e.value("indices", -1);
+
+        MeshElement elem;
+        elem.drawMode = e.value("drawMode", elem.drawMode);
+        artifact.ReadStream(stream, elem.indices);
+        elements.push_back(std::move(elem));
+
+        indexData.push_back(artifact.GetStream(stream));
     }
-    else
+
+    auto boneMatrices = artifact.GetStreamAs<Mat4>(obj.value("boneMatrices", -1));
+
+    const json& boneObjs = obj["bones"];
+    if (boneMatrices.size() != boneObjs.size() * 3)
+        throw Exception("mesh artifact has the wrong number of bone matrices");
+
+    bones.clear();
+    bones.reserve(boneObjs.size());
+
+    for (std::size_t i = 0; i < boneObjs.size(); ++i)
     {
-        boneWeightBuffer = nullptr;
+        auto& b = boneObjs[i];
+
+        Bone bone;
+        bone.linkNodePath = b.value("linkNodePath", bone.linkNodePath);
+        bone.linkMode = b.value("linkMode", bone.linkMode);
+        bone.boneBindMatrix = boneMatrices[i * 3 + 0];
+        bone.meshBindMatrix = boneMatrices[i * 3 + 1];
+        bone.invBoneBindMatrix = boneMatrices[i * 3 + 2];
+        bones.push_back(std::move(bone));
     }
 
+    CreateBuffers(
+        artifact.GetStream(obj.value("vertices", -1)),
+        artifact.GetStream(obj.value("normals", -1)),
+        artifact.GetStream(obj.value("texcoords", -1)),
+        artifact.GetStream(obj.value("boneIndices", -1)),
+        artifact.GetStream(obj.value("boneWeights", -1)),
+        indexData);
+}
+
+void Mesh::UpdateBuffers()
+{
+    std::vector<std::span<std::byte>> indexData;
+    indexData.reserve(elements.size());
+
     for (auto& elem : elements)
-    {
-        if (!elem.indices.empty())
-        {
-            elem.indexBuffer = gpnew<Buffer>(
-                BufferType::Index, BufferUsage::Static, BufferCPUAccess::None,
-                std::as_writable_bytes(std::span(elem.indices)));
-        }
-        else
-        {
-            elem.indexBuffer = nullptr;
-        }
-    }
+        indexData.push_back(std::as_writable_bytes(std::span(elem.indices)));
+
+    CreateBuffers(
+        std::as_writable_bytes(std::span(vertices)),
+        std::as_writable_bytes(std::span(normals)),
+        std::as_writable_bytes(std::span(texcoords)),
+        std::as_writable_bytes(std::span(boneIndices)),
+        std::as_writable_bytes(std::span(boneWeights)),
+        indexData);
+}
+
+void Mesh::CreateBuffers(
+    std::span<std::byte> vertexData,
+    std::span<std::byte> normalData,
+    std::span<std::byte> texcoordData,
+    std::span<std::byte> boneIndexData,
+    std::span<std::byte> boneWeightData,
+    std::span<const std::span<std::byte>> indexData)
+{
+    Assert(indexData.size() == elements.size());
+
+    // skinned meshes keep the bind pose here - each MeshRenderer
+    // deforms it into buffers of its own
+    auto MakeBuffer = [](BufferType type, BufferUsage usage, BufferCPUAccess cpuAccess, std::span<std::byte> data) {
+        return data.empty() ? gptr<Buffer>() : gpnew<Buffer>(type, usage, cpuAccess, data);
+    };
+
+    vertexBuffer = MakeBuffer(BufferType::Vertex, BufferUsage::Static, BufferCPUAccess::None, vertexData);
+    normalBuffer = MakeBuffer(BufferType::Vertex, BufferUsage::Static, BufferCPUAccess::None, normalData);
+    texcoordBuffer = MakeBuffer(BufferType::Vertex, BufferUsage::Static, BufferCPUAccess::None, texcoordData);
+    boneIndexBuffer = MakeBuffer(BufferType::Vertex, BufferUsage::Static, BufferCPUAccess::None, boneIndexData);
+    boneWeightBuffer = MakeBuffer(BufferType::Vertex, BufferUsage::Static, BufferCPUAccess::None, boneWeightData);
+
+    for (std::size_t i = 0; i < elements.size(); ++i)
+        elements[i].indexBuffer = MakeBuffer(BufferType::Index, BufferUsage::Static, BufferCPUAccess::None, indexData[i]);
 }
 
 void to_json(json& obj, const BoneLinkMode& linkMode)
@@ -214,6 +302,14 @@ void to_json(json& obj, const MeshElement& elem)
     obj["indices"] = elem.indices;
 }
 
+void to_json(JsonWriter& writer, const MeshElement& elem)
+{
+    writer.BeginObject();
+    writer.Property("drawMode", elem.drawMode);
+    writer.Property("indices", elem.indices);
+    writer.EndObject();
+}
+
 void from_json(const json& obj, MeshElement& elem)
 {
     elem.drawMode = obj.value("drawMode", elem.drawMode);
@@ -7,8 +7,10 @@ import Microwave.Graphics.Color;
 import Microwave.Graphics.Buffer;
 import Microwave.Graphics.Material;
 import Microwave.Graphics.GraphicsTypes;
+import Microwave.IO.BinaryArtifact;
 import Microwave.Math;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Path;
 import Microwave.System.Pointers;
@@ -29,7 +31,7 @@ enum class SkinType : int
     None,
     Rigid,
     Linear,
-    DualQuaternion, // not supported
+    DualQuaternion,
     Blend           // not supported
 };
 
@@ -74,13 +76,36 @@ public:
     Sphere bsphere;
     AABox bbox;
 
+    // Collision data baked at import for meshes used by a MeshCollider, so
+    // it doesn't have to be built when a scene loads. 'collisionHull' is a
+    // reduced convex hull, and 'collisionTree' a triangle tree in the format
+    // written by Microwave.SceneGraph.Internal.CollisionShapes. The tree is
+    // only kept in binary artifacts.
+    std::vector<Vec3> collisionHull;
+    std::vector<std::byte> collisionTree;
+
     virtual void ToJson(json& obj) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
+    virtual void WriteJson(JsonWriter& writer) const override;
+
+    // vertex, index and bone data is stored in raw streams, and the
+    // buffers are created straight from the artifact's streams
+    void WriteArtifact(BinaryArtifactWriter& writer) const;
+    void ReadArtifact(const BinaryArtifact& artifact, ObjectLinker* linker);
 
     void RecalcBounds();
     void UpdateBuffers();
 
     Mesh(){}
+
+private:
+    void CreateBuffers(
+        std::span<std::byte> vertexData,
+        std::span<std::byte> normalData,
+        std::span<std::byte> texcoordData,
+        std::span<std::byte> boneIndexData,
+        std::span<std::byte> boneWeightData,
+        std::span<const std::span<std::byte>> indexData);
 };
 
 void to_json(json& obj, const BoneLinkMode& linkMode);
@@ -90,6 +115,7 @@ void to_json(json& obj, const Bone& bone);
 void from_json(const json& obj, Bone& bone);
 
 void to_json(json& obj, const MeshElement& elem);
+void to_json(JsonWriter& writer, const MeshElement& elem);
 void from_json(const json& obj, MeshElement& elem);
 
 void to_json(json& obj, const SkinType& skinType);
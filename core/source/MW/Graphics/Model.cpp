@@ -351,7 +351,8 @@ void to_json(json& obj, const ModelColliderType& type)
         { ModelColliderType::Sphere, "Sphere" },
         { ModelColliderType::Box, "Box" },
         { ModelColliderType::Capsule, "Capsule" },
-        { ModelColliderType::Convex, "Convex" }
+        { ModelColliderType::Convex, "Convex" },
+        { ModelColliderType::Mesh, "Mesh" }
     };
     obj = typeNames[type];
 }
@@ -363,7 +364,8 @@ void from_json(const json& obj, ModelColliderType& type)
         { "Sphere", ModelColliderType::Sphere },
         { "Box", ModelColliderType::Box },
         { "Capsule", ModelColliderType::Capsule },
-        { "Convex", ModelColliderType::Convex }
+        { "Convex", ModelColliderType::Convex },
+        { "Mesh", ModelColliderType::Mesh }
     };
     type = types[obj.get<std::string>("None")];
 }
@@ -507,7 +509,7 @@ void from_json(const json& obj, ModelAnimationClip& clip)
         {
             auto track = gpnew<AnimationTrack>();
             from_json(trackObj, *track);
-            clip.tracks[key] = track;
+            clip.tracks[std::string(key)] = track;
         }
     }
 }
@@ -78,7 +78,8 @@ enum class ModelColliderType
     Sphere,  // radius
     Box,     // length, width, height
     Capsule, // radius, height
-    Convex   // mesh
+    Convex,  // mesh
+    Mesh     // mesh (triangles, for static bodies)
 };
 
 enum class ModelRigidBodyType
@@ -23,6 +23,7 @@ RenderTexture::RenderTexture(const IVec2& size)
         throw Exception("no active graphics context");
 
     renderTexture = graphics->context->CreateRenderTexture(GetHWTexture());
+    graphics->InvalidateBindings();
 }
 
 gptr<HWRenderTarget> RenderTexture::GetHWRenderTarget() {
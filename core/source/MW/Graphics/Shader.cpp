@@ -21,6 +21,8 @@ Shader::Shader(const std::string& source)
 
     auto info = gpnew<ShaderInfo>(source, graphics->context->GetShaderLanguage());
     shader = graphics->context->CreateShader(info);
+    graphics->InvalidateBindings();
+    BuildUniformHashes();
 }
 
 Shader::Shader(const gptr<ShaderInfo>& info)
@@ -30,6 +32,22 @@ Shader::Shader(const gptr<ShaderInfo>& info)
         throw Exception("no active graphics context");
 
     shader = graphics->context->CreateShader(info);
+    graphics->InvalidateBindings();
+    BuildUniformHashes();
+}
+
+void Shader::BuildUniformHashes()
+{
+    uniformHashes.clear();
+
+    for (auto& [name, id] : shader->info->uniformIDs)
+        uniformHashes.push_back({ UniformName::Hash(name), id, name });
+
+    // Names that collide end up next to each other, and GetUniformID()
+    // tells them apart by comparing names, so a collision costs an extra
+    // string compare instead of binding the wrong uniform.
+    std::sort(uniformHashes.begin(), uniformHashes.end(),
+        [](auto& a, auto& b) { return a.hash < b.hash; });
 }
 
 int Shader::GetAttributeID(const std::string& name)
@@ -59,21 +77,28 @@ int Shader::GetAttributeID(Semantic semantic, int index)
     return -1;
 }
 
-int Shader::GetUniformID(const std::string& name)
+int Shader::GetUniformID(UniformName name)
 {
-    auto it = shader->info->uniformIDs.find(name);
-    if(it == shader->info->uniformIDs.end())
-        return -1;
+    auto it = std::lower_bound(
+        uniformHashes.begin(), uniformHashes.end(), name.hash,
+        [](auto& entry, std::uint32_t hash) { return entry.hash < hash; });
 
-    return it->second;
+    // a matching hash alone could be a different name
+    for (; it != uniformHashes.end() && it->hash == name.hash; ++it)
+    {
+        if (it->name == name.str)
+            return it->id;
+    }
+
+    return -1;
 }
 
 bool Shader::HasAttribute(const std::string& name) {
     return shader->info->attribIDs.count(name) != 0;
 }
 
-bool Shader::HasUniform(const std::string& name) {
-    return shader->info->uniformIDs.count(name) != 0;
+bool Shader::HasUniform(UniformName name) {
+    return GetUniformID(name) != -1;
 }
 
 int Shader::GetAttributeCount() const {
@@ -97,7 +122,7 @@ ShaderVarType Shader::GetAttributeType(int id) {
     return shader->info->attributes[id].type;
 }
 
-ShaderVarType Shader::GetUniformType(const std::string& name) {
+ShaderVarType Shader::GetUniformType(UniformName name) {
     int id = GetUniformID(name);
     if(id == -1)
         return ShaderVarType::Void;
@@ -109,12 +134,20 @@ ShaderVarType Shader::GetUniformType(int id) {
     return shader->info->uniforms[id].type;
 }
 
-void Shader::Bind() {
-    shader->Bind();
+void Shader::Bind()
+{
+    if (auto& graphics = GraphicsContext::GetCurrent())
+        graphics->SetShader(shader);
+    else
+        shader->Bind();
 }
 
-void Shader::Unbind() {
-    shader->Unbind();
+void Shader::Unbind()
+{
+    if (auto& graphics = GraphicsContext::GetCurrent())
+        graphics->ClearShader(shader);
+    else
+        shader->Unbind();
 }
 
 void Shader::SetVertexBuffer(const VertexMapping& vm)
@@ -125,51 +158,103 @@ void Shader::SetVertexBuffer(const VertexMapping& vm)
 }
 
 void Shader::SetVertexBuffer(Semantic semantic, int semanticIndex, const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride) {
-    shader->SetVertexBuffer(GetAttributeID(semantic, semanticIndex), buffer, offset, stride);
+    SetVertexBuffer(GetAttributeID(semantic, semanticIndex), buffer, offset, stride);
 }
 
 void Shader::SetVertexBuffer(const std::string& name, const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride) {
-    shader->SetVertexBuffer(GetAttributeID(name), buffer, offset, stride);
+    SetVertexBuffer(GetAttributeID(name), buffer, offset, stride);
 }
 
-void Shader::SetIndexBuffer(const gptr<Buffer>& buffer) {
-    shader->SetIndexBuffer(buffer);
+void Shader::SetVertexBuffer(int id, const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride)
+{
+    if (auto& graphics = GraphicsContext::GetCurrent())
+        graphics->SetVertexBuffer(shader, id, buffer, offset, stride);
+    else
+        shader->SetVertexBuffer(id, buffer, offset, stride);
 }
 
-void Shader::SetUniform(const std::string& name, float value) {
+void Shader::SetIndexBuffer(const gptr<Buffer>& buffer)
+{
+    if (auto& graphics = GraphicsContext::GetCurrent())
+        graphics->SetIndexBuffer(shader, buffer);
+    else
+        shader->SetIndexBuffer(buffer);
+}
+
+void Shader::SetUniform(UniformName name, float value) {
     shader->SetUniform(GetUniformID(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, const Vec2& value) {
+void Shader::SetUniform(UniformName name, const Vec2& value) {
     shader->SetUniform(GetUniformID(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, const Vec3& value) {
+void Shader::SetUniform(UniformName name, const Vec3& value) {
     shader->SetUniform(GetUniformID(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, const Vec4& value) {
+void Shader::SetUniform(UniformName name, const Vec4& value) {
     shader->SetUniform(GetUniformID(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, const Mat2& value) {
+void Shader::SetUniform(UniformName name, const Mat2& value) {
     shader->SetUniform(GetUniformID(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, const Mat3& value) {
+void Shader::SetUniform(UniformName name, const Mat3& value) {
     shader->SetUniform(GetUniformID(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, const Mat4& value) {
+void Shader::SetUniform(UniformName name, const Mat4& value) {
     shader->SetUniform(GetUniformID(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, const Color& value) {
+void Shader::SetUniform(UniformName name, const Color& value) {
     shader->SetUniform(GetUniformID(name), value);
 }
 
-void Shader::SetUniform(const std::string& name, const gptr<Texture>& texture) {
-    shader->SetUniform(GetUniformID(name), texture);
+void Shader::SetUniform(UniformName name, const gptr<Texture>& texture) {
+    SetUniform(GetUniformID(name), texture);
+}
+
+void Shader::SetUniform(int id, float value) {
+    shader->SetUniform(id, value);
+}
+
+void Shader::SetUniform(int id, const Vec2& value) {
+    shader->SetUniform(id, value);
+}
+
+void Shader::SetUniform(int id, const Vec3& value) {
+    shader->SetUniform(id, value);
+}
+
+void Shader::SetUniform(int id, const Vec4& value) {
+    shader->SetUniform(id, value);
+}
+
+void Shader::SetUniform(int id, const Mat2& value) {
+    shader->SetUniform(id, value);
+}
+
+void Shader::SetUniform(int id, const Mat3& value) {
+    shader->SetUniform(id, value);
+}
+
+void Shader::SetUniform(int id, const Mat4& value) {
+    shader->SetUniform(id, value);
+}
+
+void Shader::SetUniform(int id, const Color& value) {
+    shader->SetUniform(id, value);
+}
+
+void Shader::SetUniform(int id, const gptr<Texture>& texture)
+{
+    if (auto& graphics = GraphicsContext::GetCurrent())
+        graphics->SetTexture(shader, id, texture);
+    else
+        shader->SetUniform(id, texture);
 }
 
 } // gfx
@@ -68,6 +68,18 @@ class Shader : public Object
 {
 protected:
     gptr<HWShader> shader;
+
+    struct UniformHash
+    {
+        std::uint32_t hash;
+        int id;
+        std::string_view name; // points into the shader's info
+    };
+
+    // uniform IDs sorted by name hash
+    std::vector<UniformHash> uniformHashes;
+
+    void BuildUniformHashes();
 public:
     Shader(const std::string& source);
     Shader(const gptr<ShaderInfo>& info);
@@ -75,10 +87,10 @@ public:
 
     int GetAttributeID(const std::string& name);
     int GetAttributeID(Semantic semantic, int index);
-    int GetUniformID(const std::string& name);
+    int GetUniformID(UniformName name);
 
     bool HasAttribute(const std::string& name);
-    bool HasUniform(const std::string& name);
+    bool HasUniform(UniformName name);
 
     int GetAttributeCount() const;
     int GetUniformCount() const;
@@ -86,7 +98,7 @@ public:
     ShaderVarType GetAttributeType(const std::string& name);
     ShaderVarType GetAttributeType(int id);
 
-    ShaderVarType GetUniformType(const std::string& name);
+    ShaderVarType GetUniformType(UniformName name);
     ShaderVarType GetUniformType(int id);
     
     void Bind();
@@ -95,17 +107,29 @@ public:
     void SetVertexBuffer(const VertexMapping& vm);
     void SetVertexBuffer(Semantic semantic, int semanticIndex, const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride);
     void SetVertexBuffer(const std::string& name, const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride);
+    void SetVertexBuffer(int id, const gptr<Buffer>& buffer, std::size_t offset, std::size_t stride);
     void SetIndexBuffer(const gptr<Buffer>& buffer);
 
-    void SetUniform(const std::string& name, float value);
-    void SetUniform(const std::string& name, const Vec2& value);
-    void SetUniform(const std::string& name, const Vec3& value);
-    void SetUniform(const std::string& name, const Vec4& value);
-    void SetUniform(const std::string& name, const Mat2& value);
-    void SetUniform(const std::string& name, const Mat3& value);
-    void SetUniform(const std::string& name, const Mat4& value);
-    void SetUniform(const std::string& name, const Color& value);
-    void SetUniform(const std::string& name, const gptr<Texture>& texture);
+    void SetUniform(UniformName name, float value);
+    void SetUniform(UniformName name, const Vec2& value);
+    void SetUniform(UniformName name, const Vec3& value);
+    void SetUniform(UniformName name, const Vec4& value);
+    void SetUniform(UniformName name, const Mat2& value);
+    void SetUniform(UniformName name, const Mat3& value);
+    void SetUniform(UniformName name, const Mat4& value);
+    void SetUniform(UniformName name, const Color& value);
+    void SetUniform(UniformName name, const gptr<Texture>& texture);
+
+    // by ID from GetUniformID(), to avoid looking names up for every draw
+    void SetUniform(int id, float value);
+    void SetUniform(int id, const Vec2& value);
+    void SetUniform(int id, const Vec3& value);
+    void SetUniform(int id, const Vec4& value);
+    void SetUniform(int id, const Mat2& value);
+    void SetUniform(int id, const Mat3& value);
+    void SetUniform(int id, const Mat4& value);
+    void SetUniform(int id, const Color& value);
+    void SetUniform(int id, const gptr<Texture>& texture);
 };
 
 } // gfx
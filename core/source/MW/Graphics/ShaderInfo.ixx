@@ -46,6 +46,47 @@ enum class ShaderVarType : int
     Struct,
 };
 
+// Hashed uniform name, for finding uniforms without comparing strings.
+// Names are hashed at compile time when one is a constant expression, like
+// the ones in UniformNames. 'str' refers to the string it was made from, and
+// is only valid for as long as that string is.
+struct UniformName
+{
+    std::uint32_t hash = 0;
+    std::string_view str;
+
+    constexpr UniformName() = default;
+    constexpr UniformName(const char* name) : UniformName(std::string_view(name)) {}
+    constexpr UniformName(const std::string& name) : UniformName(std::string_view(name)) {}
+    constexpr UniformName(std::string_view name) : hash(Hash(name)), str(name) {}
+
+    // 32-bit FNV-1a
+    static constexpr std::uint32_t Hash(std::string_view name)
+    {
+        std::uint32_t h = 2166136261u;
+
+        for (char c : name)
+        {
+            h ^= (std::uint8_t)c;
+            h *= 16777619u;
+        }
+
+        return h;
+    }
+};
+
+// uniforms set by the engine (see Material for the rest)
+struct UniformNames
+{
+    constexpr static const UniformName MtxModel = "uMtxModel";
+    constexpr static const UniformName MtxMVP = "uMtxMVP";
+    constexpr static const UniformName MtxNormal = "uMtxNormal";
+    constexpr static const UniformName CameraPos = "uCameraPos";
+    constexpr static const UniformName AmbientColor = "uAmbientColor";
+    constexpr static const UniformName LightPos = "uLightPos";
+    constexpr static const UniformName LightColor = "uLightColor";
+};
+
 struct ShaderUniform
 {
     std::string name;
@@ -0,0 +1,226 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Microwave.Graphics.Skinning;
+import Microwave.Math.Simd;
+import std;
+
+namespace mw {
+inline namespace gfx {
+
+constexpr int MaxInfluences = 4;
+
+DualQuatBone::DualQuatBone(const Mat4& m)
+{
+    scale = Vec3(m.m11, m.m12, m.m13).Length();
+    float invScale = scale > 0 ? 1.0f / scale : 0.0f;
+
+    Mat3 rotation(
+        m.m11 * invScale, m.m12 * invScale, m.m13 * invScale,
+        m.m21 * invScale, m.m22 * invScale, m.m23 * invScale,
+        m.m31 * invScale, m.m32 * invScale, m.m33 * invScale);
+
+    real = Quat::FromMatrix(rotation).Normalized();
+
+    // the translation 't' is stored as t * real / 2, where 't' is a pure
+    // quaternion and '*' is the Hamilton product - Quat's operator*
+    // multiplies in the opposite order
+    dual = real * Quat(m.m41, m.m42, m.m43, 0.0f) * 0.5f;
+}
+
+// Additive bones are applied one after another, so their order matters,
+// and the weights can't be blended up front
+static void SkinAdditive(
+    const Mesh& mesh,
+    std::span<const Mat4> bones,
+    std::size_t first, std::size_t last,
+    std::span<Vec3> positions,
+    std::span<Vec3> normals)
+{
+    bool hasNormals = !normals.empty();
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        Mat4 deformation = Mat4::Identity();
+
+        for (int b = 0; b < MaxInfluences; ++b)
+        {
+            float weight = mesh.boneWeights[i][b];
+            if (weight == 0.0f)
+                continue;
+
+            Mat4 influence = bones[mesh.boneIndices[i][b]] * weight;
+
+            float invWeight = 1.0f - weight;
+            influence.m11 += invWeight;
+            influence.m22 += invWeight;
+            influence.m33 += invWeight;
+            influence.m44 += invWeight;
+
+            deformation = influence * deformation;
+        }
+
+        positions[i] = Vec4(mesh.vertices[i], 1.0f) * deformation;
+
+        if (hasNormals)
+            normals[i] = Vec4(mesh.normals[i], 0.0f) * deformation;
+    }
+}
+
+void SkinLinear(
+    const Mesh& mesh,
+    std::span<const Mat4> bones,
+    std::size_t first, std::size_t last,
+    std::span<Vec3> positions,
+    std::span<Vec3> normals)
+{
+    BoneLinkMode mode = mesh.bones.empty() ? BoneLinkMode::Normalize : mesh.bones[0].linkMode;
+
+    if (mode == BoneLinkMode::Additive) {
+        SkinAdditive(mesh, bones, first, last, positions, normals);
+        return;
+    }
+
+    bool hasNormals = !normals.empty();
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        const IVec4& indices = mesh.boneIndices[i];
+        const Vec4& weights = mesh.boneWeights[i];
+        const Vec3& vertex = mesh.vertices[i];
+        Vec3 normal = hasNormals ? mesh.normals[i] : Vec3();
+
+        // Only the first three columns of a bone matrix are used, so each
+        // row is blended as a whole and the last lane is ignored. Unused
+        // influences have no weight and are skipped.
+        float totalWeight = 0;
+
+        simd::float4 r0 = simd::Zero();
+        simd::float4 r1 = simd::Zero();
+        simd::float4 r2 = simd::Zero();
+        simd::float4 r3 = simd::Zero();
+
+        for (int b = 0; b < MaxInfluences; ++b)
+        {
+            float weight = weights[b];
+            if (weight == 0.0f)
+                continue;
+
+            simd::Rows bone(&bones[indices[b]].m11);
+            simd::float4 w = simd::Splat(weight);
+
+            r0 = simd::MulAdd(bone.r0, w, r0);
+            r1 = simd::MulAdd(bone.r1, w, r1);
+            r2 = simd::MulAdd(bone.r2, w, r2);
+            r3 = simd::MulAdd(bone.r3, w, r3);
+            totalWeight += weight;
+        }
+
+        // unweighted vertices stay where they are
+        if (totalWeight <= 0.0f)
+        {
+            positions[i] = vertex;
+
+            if (hasNormals)
+                normals[i] = normal;
+
+            continue;
+        }
+
+        // Normalize scales the blended result back to a total weight of
+        // one. TotalOne leaves the missing weight to the bind pose.
+        float scale = 1.0f;
+        float rest = 0.0f;
+
+        if (mode == BoneLinkMode::Normalize)
+            scale = 1.0f / totalWeight;
+        else
+            rest = 1.0f - totalWeight;
+
+        simd::Rows blended(r0, r1, r2, r3);
+        simd::float4 s = simd::Splat(scale);
+        simd::float4 r = simd::Splat(rest);
+
+        alignas(16) float out[4];
+
+        simd::float4 p = blended.TransformPoint(vertex.x, vertex.y, vertex.z);
+        simd::Store(out, simd::MulAdd(p, s, simd::Mul(simd::Set(vertex.x, vertex.y, vertex.z, 0.0f), r)));
+        positions[i] = Vec3(out[0], out[1], out[2]);
+
+        if (hasNormals)
+        {
+            simd::float4 n = blended.TransformVector(normal.x, normal.y, normal.z);
+            simd::Store(out, simd::MulAdd(n, s, simd::Mul(simd::Set(normal.x, normal.y, normal.z, 0.0f), r)));
+            normals[i] = Vec3(out[0], out[1], out[2]);
+        }
+    }
+}
+
+void SkinDualQuaternion(
+    const Mesh& mesh,
+    std::span<const DualQuatBone> bones,
+    std::size_t first, std::size_t last,
+    std::span<Vec3> positions,
+    std::span<Vec3> normals)
+{
+    bool hasNormals = !normals.empty();
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        const IVec4& indices = mesh.boneIndices[i];
+        const Vec4& weights = mesh.boneWeights[i];
+
+        Quat real(0, 0, 0, 0);
+        Quat dual(0, 0, 0, 0);
+        float scale = 0;
+        float totalWeight = 0;
+        const Quat* pivot = nullptr;
+
+        for (int b = 0; b < MaxInfluences; ++b)
+        {
+            float weight = weights[b];
+            if (weight == 0.0f)
+                continue;
+
+            auto& bone = bones[indices[b]];
+
+            // q and -q are the same rotation, so blend each bone from the
+            // same side as the first one, or the blend takes the long way
+            if (!pivot)
+                pivot = &bone.real;
+
+            float w = pivot->Dot(bone.real) < 0 ? -weight : weight;
+            real += bone.real * w;
+            dual += bone.dual * w;
+            scale += bone.scale * weight;
+            totalWeight += weight;
+        }
+
+        if (totalWeight <= 0.0f)
+        {
+            positions[i] = mesh.vertices[i];
+
+            if (hasNormals)
+                normals[i] = mesh.normals[i];
+
+            continue;
+        }
+
+        float len = real.Length();
+        real /= len;
+        dual /= len;
+        scale /= totalWeight;
+
+        // translation = 2 * dual * conjugate(real), as a Hamilton product
+        Vec3 translation = (real.Conjugate() * dual).v * 2.0f;
+
+        positions[i] = (mesh.vertices[i] * scale) * real + translation;
+
+        if (hasNormals)
+            normals[i] = mesh.normals[i] * real;
+    }
+}
+
+} // gfx
+} // mw
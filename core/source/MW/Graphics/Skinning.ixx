@@ -0,0 +1,50 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.Graphics.Skinning;
+import Microwave.Graphics.Mesh;
+import Microwave.Math;
+import std;
+
+export namespace mw {
+inline namespace gfx {
+
+// A bone pose for dual quaternion skinning. Rotation and translation are
+// blended as one rigid transform, so joints keep their volume where
+// blending matrices would collapse them. Bones are assumed to be scaled
+// uniformly, and the scale is blended separately.
+struct DualQuatBone
+{
+    Quat real;
+    Quat dual;
+    float scale = 1.0f;
+
+    DualQuatBone() = default;
+    explicit DualQuatBone(const Mat4& matrix);
+};
+
+// The skinning functions below deform vertices [first, last) of 'mesh'
+// and write them to the same indices of 'positions' and 'normals'. There
+// is one bone transform per bone of the mesh, taking vertices from the
+// bind pose to their current position in mesh space.
+//
+// Only the mesh is read, so disjoint ranges can be skinned in parallel.
+
+// blends bone matrices, following the link mode of the mesh's bones
+void SkinLinear(
+    const Mesh& mesh,
+    std::span<const Mat4> bones,
+    std::size_t first, std::size_t last,
+    std::span<Vec3> positions,
+    std::span<Vec3> normals);
+
+void SkinDualQuaternion(
+    const Mesh& mesh,
+    std::span<const DualQuatBone> bones,
+    std::size_t first, std::size_t last,
+    std::span<Vec3> positions,
+    std::span<Vec3> normals);
+
+} // gfx
+} // mw
@@ -8,7 +8,9 @@ module;
 module Microwave.Graphics.Texture;
 import Microwave.Graphics.GraphicsContext;
 import Microwave.Graphics.Image;
+import Microwave.Graphics.Internal.HWContext;
 import Microwave.Graphics.Internal.HWTexture;
+import Microwave.Graphics.TextureData;
 import Microwave.IO.Terminal;
 import Microwave.System.Exception;
 import Microwave.System.ThreadPool;
@@ -18,6 +20,22 @@ import std;
 namespace mw {
 inline namespace gfx {
 
+// updating a texture may change the driver's texture bindings
+static void InvalidateTextureBindings()
+{
+    if (auto& graphics = GraphicsContext::GetCurrent())
+        graphics->InvalidateBindings();
+}
+
+// decompresses 'data' when it's in a format the driver can't sample
+static gptr<TextureData> PrepareTextureData(const gptr<HWContext>& context, TextureData data)
+{
+    if (!context->IsCompressionSupported(data.compression))
+        data = data.Decompress();
+
+    return gpnew<TextureData>(std::move(data));
+}
+
 Texture::Texture(
     const path& filePath,
     ImageFileFormat fileFormat,
@@ -27,9 +45,15 @@ Texture::Texture(
     , fileFormat(fileFormat)
     , dynamic(dynamic)
 {
-    ImageInfo info = Image::GetInfo(filePath, fileFormat);
-    format = info.format;
-    size = info.size;
+    // imported textures are stored with their mip levels already built
+    auto info = TextureData::GetInfo(filePath);
+    prebuilt = info.has_value();
+
+    if (!prebuilt)
+        info = Image::GetInfo(filePath, fileFormat);
+
+    format = info->format;
+    size = info->size;
 
     if (!deferLoading) {
         LoadFile();
@@ -56,6 +80,7 @@ Texture::Texture(
     tex->SetWrapMode(wrapMode);
     tex->SetFilterMode(filterMode);
     tex->SetAnisoLevel(anisoLevel);
+    graphics->InvalidateBindings();
 
     loadState = LoadState::Loaded;
 }
@@ -80,6 +105,7 @@ Texture::Texture(
     tex->SetWrapMode(wrapMode);
     tex->SetFilterMode(filterMode);
     tex->SetAnisoLevel(anisoLevel);
+    graphics->InvalidateBindings();
 
     loadState = LoadState::Loaded;
 }
@@ -125,13 +151,17 @@ void Texture::SetPixels(const std::span<std::byte>& data, const IntRect& rect)
 
     Assert(tex);
     tex->SetPixels(data, rect);
+    InvalidateTextureBindings();
 }
 
 void Texture::SetWrapMode(TextureWrapMode mode)
 {
     if (wrapMode != mode) {
         wrapMode = mode;
-        if(tex) tex->SetWrapMode(mode);
+        if (tex) {
+            tex->SetWrapMode(mode);
+            InvalidateTextureBindings();
+        }
     }
 }
 
@@ -143,7 +173,10 @@ void Texture::SetFilterMode(TextureFilterMode mode)
 {
     if (filterMode != mode) {
         filterMode = mode;
-        if(tex) tex->SetFilterMode(mode);
+        if (tex) {
+            tex->SetFilterMode(mode);
+            InvalidateTextureBindings();
+        }
     }
 }
 
@@ -155,7 +188,10 @@ void Texture::SetAnisoLevel(float aniso)
 {
     if (anisoLevel != aniso) {
         anisoLevel = aniso;
-        if(tex) tex->SetAnisoLevel(aniso);
+        if (tex) {
+            tex->SetAnisoLevel(aniso);
+            InvalidateTextureBindings();
+        }
     }
 }
 
@@ -176,12 +212,21 @@ void Texture::LoadFile()
     if (!graphics)
         throw Exception("no active graphics context");
 
-    auto img = gpnew<Image>(filePath, fileFormat);
+    if (prebuilt)
+    {
+        auto data = PrepareTextureData(graphics->context, TextureData::Load(filePath));
+        tex = graphics->context->CreateTexture(*data);
+    }
+    else
+    {
+        auto img = gpnew<Image>(filePath, fileFormat);
+        tex = graphics->context->CreateTexture(size, format, dynamic, img->GetData());
+    }
 
-    tex = graphics->context->CreateTexture(size, format, dynamic, img->GetData());
     tex->SetWrapMode(wrapMode);
     tex->SetFilterMode(filterMode);
     tex->SetAnisoLevel(anisoLevel);
+    graphics->InvalidateBindings();
 
     loadState = LoadState::Loaded;
 }
@@ -205,17 +250,35 @@ Task<void> Texture::LoadFileAsync()
 
         Assert(!filePath.empty());
 
-        gptr<Image> img = co_await ThreadPool::InvokeAsync(
-            [=](){
-                return gpnew<Image>(filePath, fileFormat);
-            });
+        gptr<Image> img;
+        gptr<TextureData> data;
+
+        if (prebuilt)
+        {
+            data = co_await ThreadPool::InvokeAsync(
+                [=, context = graphics->context](){
+                    return PrepareTextureData(context, TextureData::Load(filePath));
+                });
+        }
+        else
+        {
+            img = co_await ThreadPool::InvokeAsync(
+                [=](){
+                    return gpnew<Image>(filePath, fileFormat);
+                });
+        }
 
         if (loadState == LoadState::Loading)
         {
-            tex = graphics->context->CreateTexture(size, format, dynamic, img->GetData());
+            if (data)
+                tex = graphics->context->CreateTexture(*data);
+            else
+                tex = graphics->context->CreateTexture(size, format, dynamic, img->GetData());
+
             tex->SetWrapMode(wrapMode);
             tex->SetFilterMode(filterMode);
             tex->SetAnisoLevel(anisoLevel);
+            graphics->InvalidateBindings();
             loadState = LoadState::Loaded;
         }
     }
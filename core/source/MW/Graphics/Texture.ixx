@@ -34,6 +34,7 @@ class Texture : public Object
     PixelDataFormat format{};
     IVec2 size = IVec2::Zero();
     bool dynamic{};
+    bool prebuilt{};
 
     TextureWrapMode wrapMode = TextureWrapMode::Clamp;
     TextureFilterMode filterMode = TextureFilterMode::Bilinear;
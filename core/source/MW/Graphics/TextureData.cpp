@@ -0,0 +1,1639 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module;
+#include <MW/System/Internal/Platform.h>
+
+module Microwave.Graphics.TextureData;
+import Microwave.IO.File;
+import Microwave.IO.FileStream;
+import Microwave.System.Exception;
+import Microwave.System.JobSystem;
+import std;
+
+namespace mw {
+inline namespace gfx {
+
+// pixels converted by a single job
+constexpr std::size_t ConvertChunkSize = 1 << 16;
+
+// rows filtered by a single job
+constexpr std::size_t FilterRowsPerJob = 32;
+
+// rows of blocks compressed or decompressed by a single job
+constexpr std::size_t BlockRowsPerJob = 8;
+
+constexpr char TextureFileMagic[4] = { 'M', 'W', 'T', 'X' };
+constexpr std::uint32_t TextureFileVersion = 1;
+
+struct TextureFileHeader
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t format;
+    std::uint32_t compression;
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint32_t levelCount;
+};
+
+// precedes the data of each level
+struct TextureLevelHeader
+{
+    std::uint32_t width;
+    std::uint32_t height;
+    std::uint64_t byteCount;
+};
+
+std::size_t GetBlockSize(TextureCompression compression)
+{
+    switch (compression)
+    {
+    case TextureCompression::BC1:       return 8;
+    case TextureCompression::BC3:       return 16;
+    case TextureCompression::ETC2_RGB:  return 8;
+    case TextureCompression::ETC2_RGBA: return 16;
+    case TextureCompression::BC7:       return 16;
+    default:                            return 0;
+    }
+}
+
+static std::size_t GetLevelByteCount(IVec2 size, PixelDataFormat format, TextureCompression compression)
+{
+    if (auto blockSize = GetBlockSize(compression))
+        return (std::size_t)((size.x + 3) / 4) * ((size.y + 3) / 4) * blockSize;
+
+    return (std::size_t)size.x * size.y * GetBytesPerPixel(format);
+}
+
+static void ConvertPixels(
+    const std::byte* src, PixelDataFormat srcFormat,
+    std::byte* dst, PixelDataFormat dstFormat,
+    std::size_t count, PixelConversion conversion)
+{
+    auto srcStride = GetBytesPerPixel(srcFormat);
+    auto dstStride = GetBytesPerPixel(dstFormat);
+
+    JobSystem::GetInstance().ParallelFor(count, ConvertChunkSize,
+        [&](std::size_t first, std::size_t last) {
+            Image::ConvertPixels(
+                src + first * srcStride, srcFormat,
+                dst + first * dstStride, dstFormat,
+                last - first, conversion);
+        });
+}
+
+// The source pixels a destination pixel covers when 'srcSize' pixels are
+// filtered down to 'dstSize'. Pixels partly covered at either end are
+// weighted by how much of them is covered, so odd sizes are filtered
+// without dropping or favoring a row. Halving a size covers at most 3
+// source pixels, which can straddle 4.
+struct FilterTap
+{
+    int first = 0;
+    int count = 0;
+    float weights[4] = {};
+};
+
+static std::vector<FilterTap> GetFilterTaps(int srcSize, int dstSize)
+{
+    std::vector<FilterTap> taps(dstSize);
+    float scale = (float)srcSize / dstSize;
+
+    for (int i = 0; i < dstSize; ++i)
+    {
+        float begin = i * scale;
+        float end = begin + scale;
+
+        auto& tap = taps[i];
+        tap.first = (int)begin;
+        tap.count = std::min({ (int)std::ceil(end), srcSize, tap.first + 4 }) - tap.first;
+
+        for (int j = 0; j < tap.count; ++j)
+        {
+            float lo = std::max(begin, (float)(tap.first + j));
+            float hi = std::min(end, (float)(tap.first + j + 1));
+            tap.weights[j] = (hi - lo) / scale;
+        }
+    }
+
+    return taps;
+}
+
+// box filters RGBA float pixels, one axis at a time
+static std::vector<float> Downsample(const std::vector<float>& src, IVec2 srcSize, IVec2 dstSize)
+{
+    auto tapsX = GetFilterTaps(srcSize.x, dstSize.x);
+    auto tapsY = GetFilterTaps(srcSize.y, dstSize.y);
+
+    std::vector<float> rows((std::size_t)dstSize.x * srcSize.y * 4);
+    std::vector<float> dst((std::size_t)dstSize.x * dstSize.y * 4);
+    auto& jobs = JobSystem::GetInstance();
+
+    jobs.ParallelFor(srcSize.y, FilterRowsPerJob, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t y = first; y < last; ++y)
+        {
+            const float* in = &src[y * srcSize.x * 4];
+            float* out = &rows[y * dstSize.x * 4];
+
+            for (auto& tap : tapsX)
+            {
+                float sum[4] = {};
+
+                for (int j = 0; j < tap.count; ++j)
+                {
+                    const float* p = in + (tap.first + j) * 4;
+                    for (int c = 0; c < 4; ++c)
+                        sum[c] += p[c] * tap.weights[j];
+                }
+
+                std::copy_n(sum, 4, out);
+                out += 4;
+            }
+        }
+    });
+
+    std::size_t stride = (std::size_t)dstSize.x * 4;
+
+    jobs.ParallelFor(dstSize.y, FilterRowsPerJob, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t y = first; y < last; ++y)
+        {
+            auto& tap = tapsY[y];
+            float* out = &dst[y * stride];
+
+            for (int j = 0; j < tap.count; ++j)
+            {
+                const float* in = &rows[(tap.first + j) * stride];
+                for (std::size_t i = 0; i < stride; ++i)
+                    out[i] += in[i] * tap.weights[j];
+            }
+        }
+    });
+
+    return dst;
+}
+
+static std::uint16_t To565(const float* color)
+{
+    int r = std::clamp((int)std::lround(color[0] * (31.0f / 255.0f)), 0, 31);
+    int g = std::clamp((int)std::lround(color[1] * (63.0f / 255.0f)), 0, 63);
+    int b = std::clamp((int)std::lround(color[2] * (31.0f / 255.0f)), 0, 31);
+    return (std::uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void From565(std::uint16_t value, int* color)
+{
+    int r = (value >> 11) & 31;
+    int g = (value >> 5) & 63;
+    int b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// colors in the order of BC1's 2-bit indices
+static void GetColorPalette(std::uint16_t c0, std::uint16_t c1, bool fourColors, int (*palette)[4])
+{
+    From565(c0, palette[0]);
+    From565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+
+    for (int c = 0; c < 3; ++c)
+    {
+        if (fourColors)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+}
+
+// values in the order of BC3's 3-bit alpha indices
+static void GetAlphaPalette(int a0, int a1, int* palette)
+{
+    palette[0] = a0;
+    palette[1] = a1;
+
+    if (a0 > a1)
+    {
+        for (int i = 2; i < 8; ++i)
+            palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    }
+    else
+    {
+        for (int i = 2; i < 6; ++i)
+            palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+// Fits a line through the block's colors along their principal axis, and
+// uses the ends of it, pulled in slightly, as the endpoints. Always uses
+// the four color mode, so the result is also valid as BC3's color block.
+static void EncodeColorBlock(const std::uint8_t (*pixels)[4], std::uint8_t* out)
+{
+    float mean[3] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 3; ++c)
+            mean[c] += pixels[i][c] / 16.0f;
+
+    float cov[6] = {};
+    float lo[3] = { 255, 255, 255 };
+    float hi[3] = { 0, 0, 0 };
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float d[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            d[c] = pixels[i][c] - mean[c];
+            lo[c] = std::min(lo[c], (float)pixels[i][c]);
+            hi[c] = std::max(hi[c], (float)pixels[i][c]);
+        }
+
+        cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+    }
+
+    // power iteration, starting from the diagonal of the bounding box
+    float axis[3] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] };
+
+    for (int it = 0; it < 8; ++it)
+    {
+        float next[3] = {
+            cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+            cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+            cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2]
+        };
+
+        float scale = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+        if (!(scale > 0))
+            break;
+
+        for (int c = 0; c < 3; ++c)
+            axis[c] = next[c] / scale;
+    }
+
+    float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float tmin = 0, tmax = 0;
+
+    if (length > 0)
+    {
+        for (int c = 0; c < 3; ++c)
+            axis[c] /= length;
+
+        tmin = std::numeric_limits<float>::max();
+        tmax = -tmin;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = (pixels[i][0] - mean[0]) * axis[0]
+                    + (pixels[i][1] - mean[1]) * axis[1]
+                    + (pixels[i][2] - mean[2]) * axis[2];
+            tmin = std::min(tmin, t);
+            tmax = std::max(tmax, t);
+        }
+
+        float inset = (tmax - tmin) / 16.0f;
+        tmin += inset;
+        tmax -= inset;
+    }
+
+    float e0[3], e1[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        e0[c] = mean[c] + axis[c] * tmax;
+        e1[c] = mean[c] + axis[c] * tmin;
+    }
+
+    std::uint16_t c0 = To565(e0);
+    std::uint16_t c1 = To565(e1);
+
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    std::uint32_t indices = 0;
+
+    if (c0 != c1)
+    {
+        int palette[4][4];
+        GetColorPalette(c0, c1, true, palette);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            int bestDist = std::numeric_limits<int>::max();
+
+            for (int p = 0; p < 4; ++p)
+            {
+                int dr = pixels[i][0] - palette[p][0];
+                int dg = pixels[i][1] - palette[p][1];
+                int db = pixels[i][2] - palette[p][2];
+                int dist = dr * dr + dg * dg + db * db;
+
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+
+            indices |= (std::uint32_t)best << (i * 2);
+        }
+    }
+
+    out[0] = (std::uint8_t)c0;
+    out[1] = (std::uint8_t)(c0 >> 8);
+    out[2] = (std::uint8_t)c1;
+    out[3] = (std::uint8_t)(c1 >> 8);
+
+    for (int i = 0; i < 4; ++i)
+        out[4 + i] = (std::uint8_t)(indices >> (i * 8));
+}
+
+// uses the block's alpha range, with six values between
+static void EncodeAlphaBlock(const std::uint8_t (*pixels)[4], std::uint8_t* out)
+{
+    int a0 = 0;
+    int a1 = 255;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        a0 = std::max(a0, (int)pixels[i][3]);
+        a1 = std::min(a1, (int)pixels[i][3]);
+    }
+
+    std::uint64_t indices = 0;
+
+    if (a0 != a1)
+    {
+        int palette[8];
+        GetAlphaPalette(a0, a1, palette);
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            for (int p = 1; p < 8; ++p)
+            {
+                if (std::abs(pixels[i][3] - palette[p]) < std::abs(pixels[i][3] - palette[best]))
+                    best = p;
+            }
+
+            indices |= (std::uint64_t)best << (i * 3);
+        }
+    }
+
+    out[0] = (std::uint8_t)a0;
+    out[1] = (std::uint8_t)a1;
+
+    for (int i = 0; i < 6; ++i)
+        out[2 + i] = (std::uint8_t)(indices >> (i * 8));
+}
+
+static void DecodeColorBlock(const std::uint8_t* in, bool alwaysFourColors, std::uint8_t (*pixels)[4])
+{
+    std::uint16_t c0 = (std::uint16_t)(in[0] | (in[1] << 8));
+    std::uint16_t c1 = (std::uint16_t)(in[2] | (in[3] << 8));
+
+    int palette[4][4];
+    GetColorPalette(c0, c1, alwaysFourColors || c0 > c1, palette);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int index = (in[4 + i / 4] >> ((i % 4) * 2)) & 3;
+        for (int c = 0; c < 4; ++c)
+            pixels[i][c] = (std::uint8_t)palette[index][c];
+    }
+}
+
+static void DecodeAlphaBlock(const std::uint8_t* in, std::uint8_t (*pixels)[4])
+{
+    int palette[8];
+    GetAlphaPalette(in[0], in[1], palette);
+
+    std::uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+        indices |= (std::uint64_t)in[2 + i] << (i * 8);
+
+    for (int i = 0; i < 16; ++i)
+        pixels[i][3] = (std::uint8_t)palette[(indices >> (i * 3)) & 7];
+}
+
+// ETC1 modifier tables, in the order of the 2-bit pixel indices' magnitudes
+static constexpr int EtcModifiers[8][2] = {
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 },
+    { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+// EAC modifier tables, indexed by the 3-bit pixel indices
+static constexpr int EacModifiers[16][8] = {
+    { -3, -6,  -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5,  -8, -13, 1, 4, 7, 12 },
+    { -2, -4,  -6, -13, 1, 3, 5, 12 },
+    { -3, -6,  -8, -12, 2, 5, 7, 11 },
+    { -3, -7,  -9, -11, 2, 6, 8, 10 },
+    { -4, -7,  -8, -11, 3, 6, 7, 10 },
+    { -3, -5,  -8, -11, 2, 4, 7, 10 },
+    { -2, -6,  -8, -10, 1, 5, 7,  9 },
+    { -2, -5,  -8, -10, 1, 4, 7,  9 },
+    { -2, -4,  -8, -10, 1, 3, 7,  9 },
+    { -2, -5,  -7, -10, 1, 4, 6,  9 },
+    { -3, -4,  -7, -10, 2, 3, 6,  9 },
+    { -1, -2,  -3, -10, 0, 1, 2,  9 },
+    { -4, -6,  -8,  -9, 3, 5, 7,  8 },
+    { -3, -5,  -7,  -9, 2, 4, 6,  8 }
+};
+
+// ETC blocks are big endian, with pixels numbered down each column
+static std::uint64_t ReadBigEndian64(const std::uint8_t* in)
+{
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; ++i)
+        value = (value << 8) | in[i];
+
+    return value;
+}
+
+static void WriteBigEndian64(std::uint64_t value, std::uint8_t* out)
+{
+    for (int i = 7; i >= 0; --i, value >>= 8)
+        out[i] = (std::uint8_t)value;
+}
+
+static int EtcPixelIndex(int i) {
+    return (i % 4) * 4 + i / 4;
+}
+
+// the color of a pixel given its subblock's base color and modifier table
+static int EtcModify(int base, int table, int index)
+{
+    int mod = EtcModifiers[table][index & 1];
+    return std::clamp((index & 2) ? base - mod : base + mod, 0, 255);
+}
+
+// Picks the modifier table and pixel indices with the least error for the
+// pixels of one subblock. Returns the error, and ORs the indices into 'bits'.
+static int EncodeEtcSubblock(
+    const std::uint8_t (*pixels)[4], const bool* inSubblock,
+    const int* base, int& table, std::uint32_t& bits)
+{
+    int bestError = std::numeric_limits<int>::max();
+    std::uint32_t bestBits = 0;
+
+    for (int t = 0; t < 8; ++t)
+    {
+        int error = 0;
+        std::uint32_t tableBits = 0;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            if (!inSubblock[i])
+                continue;
+
+            int best = 0;
+            int bestDist = std::numeric_limits<int>::max();
+
+            for (int index = 0; index < 4; ++index)
+            {
+                int dist = 0;
+                for (int c = 0; c < 3; ++c)
+                {
+                    int d = EtcModify(base[c], t, index) - pixels[i][c];
+                    dist += d * d;
+                }
+
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = index;
+                }
+            }
+
+            int p = EtcPixelIndex(i);
+            tableBits |= (std::uint32_t)(best >> 1) << (16 + p);
+            tableBits |= (std::uint32_t)(best & 1) << p;
+            error += bestDist;
+        }
+
+        if (error < bestError) {
+            bestError = error;
+            bestBits = tableBits;
+            table = t;
+        }
+    }
+
+    bits |= bestBits;
+    return bestError;
+}
+
+// Encodes the block in ETC1's individual or differential mode, which ETC2
+// decoders read the same way, using the average color of each half of the
+// block as its base. Both ways of splitting the block are tried. Deltas are
+// kept within -3..3, so FlipEtcBlock() can always swap the halves.
+static void EncodeEtcBlock(const std::uint8_t (*pixels)[4], std::uint8_t* out)
+{
+    std::uint64_t best = 0;
+    int bestError = std::numeric_limits<int>::max();
+
+    for (int flip = 0; flip < 2; ++flip)
+    {
+        bool inFirst[16], inSecond[16];
+        float avg[2][3] = {};
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int x = i % 4, y = i / 4;
+            inFirst[i] = (flip ? y : x) < 2;
+            inSecond[i] = !inFirst[i];
+
+            for (int c = 0; c < 3; ++c)
+                avg[inFirst[i] ? 0 : 1][c] += pixels[i][c] / 8.0f;
+        }
+
+        for (int differential = 0; differential < 2; ++differential)
+        {
+            int q[2][3], base[2][3];
+
+            for (int c = 0; c < 3; ++c)
+            {
+                if (differential)
+                {
+                    q[0][c] = std::clamp((int)std::lround(avg[0][c] * 31.0f / 255.0f), 0, 31);
+                    int second = (int)std::lround(avg[1][c] * 31.0f / 255.0f);
+                    int delta = std::clamp(second - q[0][c], std::max(-3, -q[0][c]), std::min(3, 31 - q[0][c]));
+                    q[1][c] = delta;
+                    base[0][c] = (q[0][c] << 3) | (q[0][c] >> 2);
+                    int c2 = q[0][c] + delta;
+                    base[1][c] = (c2 << 3) | (c2 >> 2);
+                }
+                else
+                {
+                    for (int s = 0; s < 2; ++s)
+                    {
+                        q[s][c] = std::clamp((int)std::lround(avg[s][c] * 15.0f / 255.0f), 0, 15);
+                        base[s][c] = (q[s][c] << 4) | q[s][c];
+                    }
+                }
+            }
+
+            int table[2] = {};
+            std::uint32_t indexBits = 0;
+            int error = EncodeEtcSubblock(pixels, inFirst, base[0], table[0], indexBits)
+                      + EncodeEtcSubblock(pixels, inSecond, base[1], table[1], indexBits);
+
+            if (error >= bestError)
+                continue;
+
+            std::uint64_t block = 0;
+
+            for (int c = 0; c < 3; ++c)
+            {
+                int shift = 56 - c * 8;
+                if (differential)
+                    block |= ((std::uint64_t)q[0][c] << (shift + 3)) | ((std::uint64_t)(q[1][c] & 7) << shift);
+                else
+                    block |= ((std::uint64_t)q[0][c] << (shift + 4)) | ((std::uint64_t)q[1][c] << shift);
+            }
+
+            block |= (std::uint64_t)table[0] << 37;
+            block |= (std::uint64_t)table[1] << 34;
+            block |= (std::uint64_t)differential << 33;
+            block |= (std::uint64_t)flip << 32;
+            block |= indexBits;
+
+            best = block;
+            bestError = error;
+        }
+    }
+
+    WriteBigEndian64(best, out);
+}
+
+// The base colors of a block in individual or differential mode. Returns
+// false for ETC2's T, H and planar modes, which EncodeEtcBlock() never
+// produces.
+static bool GetEtcBaseColors(std::uint64_t block, int (*base)[3])
+{
+    bool differential = (block >> 33) & 1;
+
+    for (int c = 0; c < 3; ++c)
+    {
+        int shift = 56 - c * 8;
+
+        if (differential)
+        {
+            int c1 = (int)(block >> (shift + 3)) & 31;
+            int delta = (int)(block >> shift) & 7;
+            int c2 = c1 + (delta >= 4 ? delta - 8 : delta);
+
+            if (c2 < 0 || c2 > 31)
+                return false;
+
+            base[0][c] = (c1 << 3) | (c1 >> 2);
+            base[1][c] = (c2 << 3) | (c2 >> 2);
+        }
+        else
+        {
+            int c1 = (int)(block >> (shift + 4)) & 15;
+            int c2 = (int)(block >> shift) & 15;
+            base[0][c] = (c1 << 4) | c1;
+            base[1][c] = (c2 << 4) | c2;
+        }
+    }
+
+    return true;
+}
+
+static void DecodeEtcBlock(const std::uint8_t* in, std::uint8_t (*pixels)[4])
+{
+    std::uint64_t block = ReadBigEndian64(in);
+
+    int base[2][3];
+    if (!GetEtcBaseColors(block, base))
+        throw Exception("ETC2 T, H and planar blocks are not supported");
+
+    int table[2] = { (int)(block >> 37) & 7, (int)(block >> 34) & 7 };
+    bool flip = (block >> 32) & 1;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int x = i % 4, y = i / 4;
+        int s = (flip ? y : x) < 2 ? 0 : 1;
+        int p = EtcPixelIndex(i);
+        int index = (int)(((block >> (16 + p)) & 1) << 1 | ((block >> p) & 1));
+
+        for (int c = 0; c < 3; ++c)
+            pixels[i][c] = (std::uint8_t)EtcModify(base[s][c], table[s], index);
+
+        pixels[i][3] = 255;
+    }
+}
+
+// Tries every table with the multiplier that makes it span the block's
+// alpha range, and the base that centers it.
+static void EncodeEacBlock(const std::uint8_t (*pixels)[4], std::uint8_t* out)
+{
+    int lo = 255, hi = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        lo = std::min(lo, (int)pixels[i][3]);
+        hi = std::max(hi, (int)pixels[i][3]);
+    }
+
+    std::uint64_t best = 0;
+    int bestError = std::numeric_limits<int>::max();
+
+    for (int t = 0; t < 16 && bestError > 0; ++t)
+    {
+        auto& mods = EacModifiers[t];
+        int span = mods[7] - mods[3];
+        int mul = std::clamp((hi - lo + span - 1) / span, 1, 15);
+        int base = std::clamp((int)std::lround((lo + hi) / 2.0f - mul * (mods[3] + mods[7]) / 2.0f), 0, 255);
+
+        int error = 0;
+        std::uint64_t indices = 0;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int bestIndex = 0;
+            int bestDist = std::numeric_limits<int>::max();
+
+            for (int index = 0; index < 8; ++index)
+            {
+                int value = std::clamp(base + mods[index] * mul, 0, 255);
+                int dist = std::abs(value - pixels[i][3]);
+
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    bestIndex = index;
+                }
+            }
+
+            indices |= (std::uint64_t)bestIndex << (45 - EtcPixelIndex(i) * 3);
+            error += bestDist * bestDist;
+        }
+
+        if (error < bestError)
+        {
+            bestError = error;
+            best = ((std::uint64_t)base << 56) | ((std::uint64_t)mul << 52) | ((std::uint64_t)t << 48) | indices;
+        }
+    }
+
+    WriteBigEndian64(best, out);
+}
+
+static void DecodeEacBlock(const std::uint8_t* in, std::uint8_t (*pixels)[4])
+{
+    std::uint64_t block = ReadBigEndian64(in);
+    int base = (int)(block >> 56);
+    int mul = (int)(block >> 52) & 15;
+    auto& mods = EacModifiers[(block >> 48) & 15];
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int index = (int)(block >> (45 - EtcPixelIndex(i) * 3)) & 7;
+        pixels[i][3] = (std::uint8_t)std::clamp(base + mods[index] * mul, 0, 255);
+    }
+}
+
+// whether FlipEtcBlock() can flip the block, which it can't when it would
+// have to swap the halves of a differential block with a delta of -4
+static bool CanFlipEtcBlock(const std::uint8_t* in)
+{
+    std::uint64_t block = ReadBigEndian64(in);
+    int base[2][3];
+
+    if (!GetEtcBaseColors(block, base))
+        return false;
+
+    if (((block >> 32) & 1) && ((block >> 33) & 1))
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            if (((block >> (56 - c * 8)) & 7) == 4)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// reverses the first 'rows' rows of pixels in an ETC block
+static void FlipEtcBlock(std::uint8_t* inout, int rows)
+{
+    std::uint64_t block = ReadBigEndian64(inout);
+    std::uint64_t flipped = block & ~(std::uint64_t)0xFFFFFFFF;
+
+    for (int x = 0; x < 4; ++x)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            int from = x * 4 + y;
+            int to = y < rows ? x * 4 + rows - 1 - y : from;
+            flipped |= ((block >> from) & 1) << to;
+            flipped |= ((block >> (16 + from)) & 1) << (16 + to);
+        }
+    }
+
+    // the halves of a block split top and bottom trade places
+    if (rows == 4 && ((block >> 32) & 1))
+    {
+        bool differential = (block >> 33) & 1;
+
+        for (int c = 0; c < 3; ++c)
+        {
+            int shift = 56 - c * 8;
+            std::uint64_t colors;
+
+            if (differential)
+            {
+                int c1 = (int)(block >> (shift + 3)) & 31;
+                int delta = (int)(block >> shift) & 7;
+                delta = delta >= 4 ? delta - 8 : delta;
+                colors = ((std::uint64_t)(c1 + delta) << 3) | (std::uint64_t)(-delta & 7);
+            }
+            else
+            {
+                int c1 = (int)(block >> (shift + 4)) & 15;
+                int c2 = (int)(block >> shift) & 15;
+                colors = ((std::uint64_t)c2 << 4) | (std::uint64_t)c1;
+            }
+
+            flipped = (flipped & ~((std::uint64_t)0xFF << shift)) | (colors << shift);
+        }
+
+        std::uint64_t table1 = (block >> 37) & 7;
+        std::uint64_t table2 = (block >> 34) & 7;
+        flipped &= ~((std::uint64_t)0x3F << 34);
+        flipped |= (table2 << 37) | (table1 << 34);
+    }
+
+    WriteBigEndian64(flipped, inout);
+}
+
+// reverses the first 'rows' rows of pixels in an EAC block
+static void FlipEacBlock(std::uint8_t* inout, int rows)
+{
+    std::uint64_t block = ReadBigEndian64(inout);
+    std::uint64_t flipped = block & ~(((std::uint64_t)1 << 48) - 1);
+
+    for (int x = 0; x < 4; ++x)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            int from = x * 4 + y;
+            int to = y < rows ? x * 4 + rows - 1 - y : from;
+            flipped |= ((block >> (45 - from * 3)) & 7) << (45 - to * 3);
+        }
+    }
+
+    WriteBigEndian64(flipped, inout);
+}
+
+// BC7 interpolation weights for 4-bit indices, out of 64
+static constexpr int Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// A BC7 block in mode 6, which has a single subset with RGBA endpoints and
+// a 4-bit index per pixel. Endpoint channels are stored in 7 bits, plus a
+// low bit shared by all four channels of each endpoint.
+struct Bc7Mode6Block
+{
+    int endpoints[2][4];
+    int indices[16];
+};
+
+static void GetBc7Palette(const Bc7Mode6Block& block, int (*palette)[4])
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            palette[i][c] = ((64 - Bc7Weights[i]) * block.endpoints[0][c]
+                                 + Bc7Weights[i] * block.endpoints[1][c] + 32) >> 6;
+        }
+    }
+}
+
+// returns false, without changing 'block', if 'in' isn't in mode 6
+static bool ReadBc7Block(const std::uint8_t* in, Bc7Mode6Block& block)
+{
+    // the mode is the position of the lowest set bit
+    if ((in[0] & 0x7F) != 0x40)
+        return false;
+
+    std::uint64_t bits[2] = {};
+    for (int i = 0; i < 16; ++i)
+        bits[i / 8] |= (std::uint64_t)in[i] << ((i % 8) * 8);
+
+    int pos = 7;
+
+    auto read = [&](int count)
+    {
+        int value = 0;
+        for (int i = 0; i < count; ++i, ++pos)
+            value |= (int)((bits[pos / 64] >> (pos % 64)) & 1) << i;
+        return value;
+    };
+
+    for (int c = 0; c < 4; ++c)
+    {
+        block.endpoints[0][c] = read(7) << 1;
+        block.endpoints[1][c] = read(7) << 1;
+    }
+
+    int lowBits[2] = { read(1), read(1) };
+
+    for (int e = 0; e < 2; ++e)
+        for (int c = 0; c < 4; ++c)
+            block.endpoints[e][c] |= lowBits[e];
+
+    // pixel 0's index is stored without its top bit, which is always clear
+    block.indices[0] = read(3);
+
+    for (int i = 1; i < 16; ++i)
+        block.indices[i] = read(4);
+
+    return true;
+}
+
+static void WriteBc7Block(Bc7Mode6Block block, std::uint8_t* out)
+{
+    // swap the endpoints if pixel 0's index doesn't fit in 3 bits
+    if (block.indices[0] & 8)
+    {
+        std::swap(block.endpoints[0], block.endpoints[1]);
+
+        for (int& index : block.indices)
+            index = 15 - index;
+    }
+
+    std::uint64_t bits[2] = {};
+    int pos = 0;
+
+    auto write = [&](int value, int count)
+    {
+        for (int i = 0; i < count; ++i, ++pos)
+            bits[pos / 64] |= (std::uint64_t)((value >> i) & 1) << (pos % 64);
+    };
+
+    write(1 << 6, 7);
+
+    for (int c = 0; c < 4; ++c)
+    {
+        write(block.endpoints[0][c] >> 1, 7);
+        write(block.endpoints[1][c] >> 1, 7);
+    }
+
+    write(block.endpoints[0][0] & 1, 1);
+    write(block.endpoints[1][0] & 1, 1);
+    write(block.indices[0], 3);
+
+    for (int i = 1; i < 16; ++i)
+        write(block.indices[i], 4);
+
+    for (int i = 0; i < 16; ++i)
+        out[i] = (std::uint8_t)(bits[i / 8] >> ((i % 8) * 8));
+}
+
+// picks the closest palette entry for each pixel, and returns the sum of squared errors
+static int AssignBc7Indices(const std::uint8_t (*pixels)[4], Bc7Mode6Block& block)
+{
+    int palette[16][4];
+    GetBc7Palette(block, palette);
+
+    int total = 0;
+
+    for (int i = 0; i < 16; ++i)
+    {
+        int bestDist = std::numeric_limits<int>::max();
+
+        for (int p = 0; p < 16; ++p)
+        {
+            int dist = 0;
+            for (int c = 0; c < 4; ++c)
+            {
+                int d = pixels[i][c] - palette[p][c];
+                dist += d * d;
+            }
+
+            if (dist < bestDist) {
+                bestDist = dist;
+                block.indices[i] = p;
+            }
+        }
+
+        total += bestDist;
+    }
+
+    return total;
+}
+
+// Quantizes the endpoints with each combination of low bits, and replaces
+// 'best' with the result if it's closer to the block's pixels.
+static void FitBc7Endpoints(
+    const std::uint8_t (*pixels)[4], const float* e0, const float* e1,
+    Bc7Mode6Block& best, int& bestError)
+{
+    const float* ends[2] = { e0, e1 };
+
+    for (int lowBits = 0; lowBits < 4; ++lowBits)
+    {
+        Bc7Mode6Block block;
+
+        for (int e = 0; e < 2; ++e)
+        {
+            int low = (lowBits >> e) & 1;
+
+            for (int c = 0; c < 4; ++c)
+            {
+                int value = std::clamp((int)std::lround((ends[e][c] - low) / 2.0f), 0, 127);
+                block.endpoints[e][c] = (value << 1) | low;
+            }
+        }
+
+        int error = AssignBc7Indices(pixels, block);
+
+        if (error < bestError) {
+            best = block;
+            bestError = error;
+        }
+    }
+}
+
+// Fits a line through the block's colors and alpha along their principal
+// axis, like EncodeColorBlock, then refits the endpoints to the indices it
+// picked by least squares. Only mode 6 is used, which covers RGBA in one
+// subset at 8 bits per pixel.
+static void EncodeBc7Block(const std::uint8_t (*pixels)[4], std::uint8_t* out)
+{
+    float mean[4] = {};
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 4; ++c)
+            mean[c] += pixels[i][c] / 16.0f;
+
+    float cov[4][4] = {};
+    float lo[4] = { 255, 255, 255, 255 };
+    float hi[4] = { 0, 0, 0, 0 };
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float d[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            d[c] = pixels[i][c] - mean[c];
+            lo[c] = std::min(lo[c], (float)pixels[i][c]);
+            hi[c] = std::max(hi[c], (float)pixels[i][c]);
+        }
+
+        for (int a = 0; a < 4; ++a)
+            for (int b = 0; b < 4; ++b)
+                cov[a][b] += d[a] * d[b];
+    }
+
+    // power iteration, starting from the diagonal of the bounding box
+    float axis[4] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2], hi[3] - lo[3] };
+
+    for (int it = 0; it < 8; ++it)
+    {
+        float next[4] = {};
+        for (int a = 0; a < 4; ++a)
+            for (int b = 0; b < 4; ++b)
+                next[a] += cov[a][b] * axis[b];
+
+        float scale = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]), std::abs(next[3]) });
+        if (!(scale > 0))
+            break;
+
+        for (int c = 0; c < 4; ++c)
+            axis[c] = next[c] / scale;
+    }
+
+    float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+    float tmin = 0, tmax = 0;
+
+    if (length > 0)
+    {
+        for (int c = 0; c < 4; ++c)
+            axis[c] /= length;
+
+        tmin = std::numeric_limits<float>::max();
+        tmax = -tmin;
+
+        for (int i = 0; i < 16; ++i)
+        {
+            float t = 0;
+            for (int c = 0; c < 4; ++c)
+                t += (pixels[i][c] - mean[c]) * axis[c];
+
+            tmin = std::min(tmin, t);
+            tmax = std::max(tmax, t);
+        }
+    }
+
+    float e0[4], e1[4];
+    for (int c = 0; c < 4; ++c)
+    {
+        e0[c] = mean[c] + axis[c] * tmin;
+        e1[c] = mean[c] + axis[c] * tmax;
+    }
+
+    Bc7Mode6Block best;
+    int bestError = std::numeric_limits<int>::max();
+    FitBc7Endpoints(pixels, e0, e1, best, bestError);
+
+    // solve for the endpoints that best reproduce the pixels with those weights
+    float aa = 0, ab = 0, bb = 0;
+    float ra[4] = {}, rb[4] = {};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float w = Bc7Weights[best.indices[i]] / 64.0f;
+        aa += (1 - w) * (1 - w);
+        ab += (1 - w) * w;
+        bb += w * w;
+
+        for (int c = 0; c < 4; ++c)
+        {
+            ra[c] += (1 - w) * pixels[i][c];
+            rb[c] += w * pixels[i][c];
+        }
+    }
+
+    float det = aa * bb - ab * ab;
+
+    if (std::abs(det) > 1e-6f)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            e0[c] = (ra[c] * bb - rb[c] * ab) / det;
+            e1[c] = (rb[c] * aa - ra[c] * ab) / det;
+        }
+
+        FitBc7Endpoints(pixels, e0, e1, best, bestError);
+    }
+
+    WriteBc7Block(best, out);
+}
+
+// Only decodes mode 6, which is the only one EncodeBc7Block writes. Blocks
+// in other modes decode to transparent black, like invalid blocks do.
+static void DecodeBc7Block(const std::uint8_t* in, std::uint8_t (*pixels)[4])
+{
+    Bc7Mode6Block block;
+
+    if (!ReadBc7Block(in, block))
+    {
+        std::memset(pixels, 0, 16 * 4);
+        return;
+    }
+
+    int palette[16][4];
+    GetBc7Palette(block, palette);
+
+    for (int i = 0; i < 16; ++i)
+        for (int c = 0; c < 4; ++c)
+            pixels[i][c] = (std::uint8_t)palette[block.indices[i]][c];
+}
+
+// Blocks in other modes would have to be re-encoded, since their
+// partitions and anchor pixels don't flip.
+static bool CanFlipBc7Block(const std::uint8_t* in) {
+    return (in[0] & 0x7F) == 0x40;
+}
+
+// reverses the first 'rows' rows of a mode 6 block
+static void FlipBc7Block(std::uint8_t* inout, int rows)
+{
+    Bc7Mode6Block block;
+    if (!ReadBc7Block(inout, block))
+        return;
+
+    Bc7Mode6Block flipped = block;
+
+    for (int r = 0; r < rows; ++r)
+        for (int c = 0; c < 4; ++c)
+            flipped.indices[r * 4 + c] = block.indices[(rows - 1 - r) * 4 + c];
+
+    WriteBc7Block(flipped, inout);
+}
+
+// calls fun(x, y, index) for each 4x4 block covering an image of 'size',
+// where 'index' is the block's position in row-major order
+template<class F>
+static void ForEachBlock(IVec2 size, F&& fun)
+{
+    int blocksX = (size.x + 3) / 4;
+    int blocksY = (size.y + 3) / 4;
+
+    JobSystem::GetInstance().ParallelFor(blocksY, BlockRowsPerJob, [&](std::size_t first, std::size_t last)
+    {
+        for (int by = (int)first; by < (int)last; ++by)
+            for (int bx = 0; bx < blocksX; ++bx)
+                fun(bx, by, by * blocksX + bx);
+    });
+}
+
+static std::vector<std::byte> CompressLevel(const std::byte* rgba, IVec2 size, TextureCompression compression)
+{
+    auto blockSize = GetBlockSize(compression);
+    std::vector<std::byte> ret(GetLevelByteCount(size, PixelDataFormat::RGBA32, compression));
+
+    ForEachBlock(size, [&](int bx, int by, std::size_t index)
+    {
+        // pixels past the edge repeat the last row and column
+        std::uint8_t pixels[16][4];
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int x = std::min(bx * 4 + i % 4, size.x - 1);
+            int y = std::min(by * 4 + i / 4, size.y - 1);
+            std::memcpy(pixels[i], rgba + ((std::size_t)y * size.x + x) * 4, 4);
+        }
+
+        auto out = (std::uint8_t*)ret.data() + index * blockSize;
+
+        switch (compression)
+        {
+        case TextureCompression::BC1:
+            EncodeColorBlock(pixels, out);
+            break;
+
+        case TextureCompression::BC3:
+            EncodeAlphaBlock(pixels, out);
+            EncodeColorBlock(pixels, out + 8);
+            break;
+
+        case TextureCompression::ETC2_RGB:
+            EncodeEtcBlock(pixels, out);
+            break;
+
+        case TextureCompression::ETC2_RGBA:
+            EncodeEacBlock(pixels, out);
+            EncodeEtcBlock(pixels, out + 8);
+            break;
+
+        case TextureCompression::BC7:
+            EncodeBc7Block(pixels, out);
+            break;
+        }
+    });
+
+    return ret;
+}
+
+static std::vector<std::byte> DecompressLevel(const std::byte* blocks, IVec2 size, TextureCompression compression)
+{
+    auto blockSize = GetBlockSize(compression);
+    std::vector<std::byte> ret((std::size_t)size.x * size.y * 4);
+
+    ForEachBlock(size, [&](int bx, int by, std::size_t index)
+    {
+        auto in = (const std::uint8_t*)blocks + index * blockSize;
+        std::uint8_t pixels[16][4];
+
+        switch (compression)
+        {
+        case TextureCompression::BC1:
+            DecodeColorBlock(in, false, pixels);
+            break;
+
+        case TextureCompression::BC3:
+            DecodeColorBlock(in + 8, true, pixels);
+            DecodeAlphaBlock(in, pixels);
+            break;
+
+        case TextureCompression::ETC2_RGB:
+            DecodeEtcBlock(in, pixels);
+            break;
+
+        case TextureCompression::ETC2_RGBA:
+            DecodeEtcBlock(in + 8, pixels);
+            DecodeEacBlock(in, pixels);
+            break;
+
+        case TextureCompression::BC7:
+            DecodeBc7Block(in, pixels);
+            break;
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int x = bx * 4 + i % 4;
+            int y = by * 4 + i / 4;
+
+            if (x < size.x && y < size.y)
+                std::memcpy(ret.data() + ((std::size_t)y * size.x + x) * 4, pixels[i], 4);
+        }
+    });
+
+    return ret;
+}
+
+// reverses the first 'rows' rows of pixels in a block
+static void FlipBlock(std::uint8_t* block, TextureCompression compression, int rows)
+{
+    if (compression == TextureCompression::BC7) {
+        FlipBc7Block(block, rows);
+        return;
+    }
+
+    if (compression == TextureCompression::ETC2_RGBA) {
+        FlipEacBlock(block, rows);
+        block += 8;
+    }
+
+    if (compression == TextureCompression::ETC2_RGB ||
+        compression == TextureCompression::ETC2_RGBA)
+    {
+        FlipEtcBlock(block, rows);
+        return;
+    }
+
+    if (compression == TextureCompression::BC3)
+    {
+        std::uint64_t indices = 0;
+        for (int i = 0; i < 6; ++i)
+            indices |= (std::uint64_t)block[2 + i] << (i * 8);
+
+        std::uint64_t flipped = indices;
+
+        for (int r = 0; r < rows; ++r)
+        {
+            std::uint64_t row = (indices >> ((rows - 1 - r) * 12)) & 0xFFF;
+            flipped &= ~((std::uint64_t)0xFFF << (r * 12));
+            flipped |= row << (r * 12);
+        }
+
+        for (int i = 0; i < 6; ++i)
+            block[2 + i] = (std::uint8_t)(flipped >> (i * 8));
+
+        block += 8;
+    }
+
+    // one byte of color indices per row
+    std::reverse(block + 4, block + 4 + rows);
+}
+
+static TextureCompressionTarget GetDefaultCompressionTarget()
+{
+#if PLATFORM_IOS || PLATFORM_ANDROID
+    return TextureCompressionTarget::ETC2;
+#else
+    return TextureCompressionTarget::BC;
+#endif
+}
+
+IVec2 TextureData::GetSize() const {
+    return levels.empty() ? IVec2::Zero() : levels[0].size;
+}
+
+std::size_t TextureData::GetByteCount() const
+{
+    std::size_t count = 0;
+
+    for (auto& level : levels)
+        count += level.data.size();
+
+    return count;
+}
+
+TextureData TextureData::Build(const Image& image, const TextureBuildSettings& settings)
+{
+    auto srcFormat = image.GetFormat();
+    auto size = image.GetSize();
+    auto src = image.GetData();
+
+    if (srcFormat == PixelDataFormat::Unspecified || src.empty())
+        throw Exception("image cannot be empty");
+
+    bool color = srcFormat == PixelDataFormat::RGB24 || srcFormat == PixelDataFormat::RGBA32;
+    bool hasAlpha = srcFormat == PixelDataFormat::RGBA32 || srcFormat == PixelDataFormat::RGBAFloat;
+    bool sRGB = settings.sRGB && color;
+
+    TextureData ret;
+    ret.format = srcFormat;
+
+    if (settings.compress && color && size.x % 4 == 0 && size.y % 4 == 0)
+    {
+        bool opaque = true;
+
+        if (srcFormat == PixelDataFormat::RGBA32)
+        {
+            for (std::size_t i = 3; i < src.size() && opaque; i += 4)
+                opaque = src[i] == std::byte{ 255 };
+        }
+
+        auto target = settings.target;
+        if (target == TextureCompressionTarget::Default)
+            target = GetDefaultCompressionTarget();
+
+        ret.format = PixelDataFormat::RGBA32;
+
+        if (target == TextureCompressionTarget::ETC2)
+            ret.compression = opaque ? TextureCompression::ETC2_RGB : TextureCompression::ETC2_RGBA;
+        else
+            ret.compression = opaque ? TextureCompression::BC1 : TextureCompression::BC7;
+    }
+
+    // Colors are averaged in linear space, so that mips are as bright as the
+    // image they came from. They're also weighted by alpha, so the colors of
+    // transparent pixels don't bleed into their neighbors.
+    auto decode = PixelConversion::None;
+    auto encode = PixelConversion::None;
+
+    if (sRGB) {
+        decode |= PixelConversion::SRGBToLinear;
+        encode |= PixelConversion::LinearToSRGB;
+    }
+
+    if (hasAlpha)
+        decode |= PixelConversion::PremultiplyAlpha;
+
+    std::size_t count = (std::size_t)size.x * size.y;
+    std::vector<float> linear(count * 4);
+    ConvertPixels(src.data(), srcFormat, (std::byte*)linear.data(), PixelDataFormat::RGBAFloat, count, decode);
+
+    auto finishLevel = [&](TextureLevel& level)
+    {
+        if (ret.compression != TextureCompression::None)
+            level.data = CompressLevel(level.data.data(), level.size, ret.compression);
+    };
+
+    // the top level keeps the image's own pixels
+    auto& top = ret.levels.emplace_back();
+    top.size = size;
+    top.data.resize(count * GetBytesPerPixel(ret.format));
+    ConvertPixels(src.data(), srcFormat, top.data.data(), ret.format, count, PixelConversion::None);
+    finishLevel(top);
+
+    while (size.x > 1 || size.y > 1)
+    {
+        IVec2 next(std::max(size.x / 2, 1), std::max(size.y / 2, 1));
+        linear = Downsample(linear, size, next);
+        size = next;
+        count = (std::size_t)size.x * size.y;
+
+        std::vector<float> pixels = linear;
+
+        if (hasAlpha)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                float* p = &pixels[i * 4];
+                if (p[3] > 0) {
+                    p[0] /= p[3];
+                    p[1] /= p[3];
+                    p[2] /= p[3];
+                }
+            }
+        }
+
+        auto& level = ret.levels.emplace_back();
+        level.size = size;
+        level.data.resize(count * GetBytesPerPixel(ret.format));
+        ConvertPixels((const std::byte*)pixels.data(), PixelDataFormat::RGBAFloat, level.data.data(), ret.format, count, encode);
+        finishLevel(level);
+    }
+
+    return ret;
+}
+
+TextureData TextureData::Decompress() const
+{
+    TextureData ret;
+    ret.format = PixelDataFormat::RGBA32;
+
+    for (auto& level : levels)
+    {
+        auto& out = ret.levels.emplace_back();
+        out.size = level.size;
+
+        if (compression != TextureCompression::None)
+        {
+            out.data = DecompressLevel(level.data.data(), level.size, compression);
+        }
+        else
+        {
+            std::size_t count = (std::size_t)level.size.x * level.size.y;
+            out.data.resize(count * 4);
+            ConvertPixels(level.data.data(), format, out.data.data(), ret.format, count, PixelConversion::None);
+        }
+    }
+
+    return ret;
+}
+
+bool TextureData::FlipVertical()
+{
+    auto blockSize = GetBlockSize(compression);
+
+    if (!blockSize)
+    {
+        for (auto& level : levels)
+            Image::FlipVertical(level.data.data(), level.size, format);
+
+        return true;
+    }
+
+    bool etc = compression == TextureCompression::ETC2_RGB ||
+               compression == TextureCompression::ETC2_RGBA;
+
+    for (auto& level : levels)
+    {
+        if (level.size.y > 4 && level.size.y % 4 != 0)
+            return false;
+
+        auto data = (const std::uint8_t*)level.data.data();
+
+        if (etc)
+        {
+            std::size_t colorOffset = blockSize - 8;
+
+            for (std::size_t i = 0; i < level.data.size(); i += blockSize)
+            {
+                if (!CanFlipEtcBlock(data + i + colorOffset))
+                    return false;
+            }
+        }
+        else if (compression == TextureCompression::BC7)
+        {
+            for (std::size_t i = 0; i < level.data.size(); i += blockSize)
+            {
+                if (!CanFlipBc7Block(data + i))
+                    return false;
+            }
+        }
+    }
+
+    for (auto& level : levels)
+    {
+        int blocksX = (level.size.x + 3) / 4;
+        int blocksY = (level.size.y + 3) / 4;
+        std::size_t rowSize = blocksX * blockSize;
+        auto data = (std::uint8_t*)level.data.data();
+
+        for (int y1 = 0, y2 = blocksY - 1; y1 < y2; ++y1, --y2)
+            std::swap_ranges(data + y1 * rowSize, data + (y1 + 1) * rowSize, data + y2 * rowSize);
+
+        int rows = std::min(level.size.y, 4);
+
+        for (std::size_t i = 0; i < level.data.size(); i += blockSize)
+            FlipBlock(data + i, compression, rows);
+    }
+
+    return true;
+}
+
+void TextureData::Save(const gptr<Stream>& stream) const
+{
+    TextureFileHeader header;
+    std::copy_n(TextureFileMagic, 4, header.magic);
+    header.version = TextureFileVersion;
+    header.format = (std::uint32_t)format;
+    header.compression = (std::uint32_t)compression;
+    header.width = GetSize().x;
+    header.height = GetSize().y;
+    header.levelCount = (std::uint32_t)levels.size();
+    stream->WriteValue(header);
+
+    for (auto& level : levels)
+    {
+        TextureLevelHeader levelHeader;
+        levelHeader.width = level.size.x;
+        levelHeader.height = level.size.y;
+        levelHeader.byteCount = level.data.size();
+        stream->WriteValue(levelHeader);
+
+        auto data = const_cast<std::byte*>(level.data.data());
+        stream->Write(std::span<std::byte>(data, level.data.size()));
+    }
+}
+
+TextureData TextureData::Load(const gptr<Stream>& stream)
+{
+    auto header = stream->ReadValue<TextureFileHeader>();
+
+    if (!std::equal(header.magic, header.magic + 4, TextureFileMagic))
+        throw Exception("not a texture data file");
+
+    if (header.version != TextureFileVersion)
+        throw Exception("unsupported texture data version");
+
+    if (header.format > (std::uint32_t)PixelDataFormat::RGBAFloat ||
+        header.compression > (std::uint32_t)TextureCompression::BC7)
+    {
+        throw Exception("invalid texture data format");
+    }
+
+    TextureData ret;
+    ret.format = (PixelDataFormat)header.format;
+    ret.compression = (TextureCompression)header.compression;
+    ret.levels.resize(header.levelCount);
+
+    for (auto& level : ret.levels)
+    {
+        auto levelHeader = stream->ReadValue<TextureLevelHeader>();
+        level.size = IVec2(levelHeader.width, levelHeader.height);
+
+        if (levelHeader.byteCount != GetLevelByteCount(level.size, ret.format, ret.compression))
+            throw Exception("invalid texture data level");
+
+        level.data.resize(levelHeader.byteCount);
+
+        for (std::size_t read = 0; read < level.data.size(); )
+        {
+            int count = stream->Read(std::span(level.data).subspan(read));
+            if (count <= 0)
+                throw Exception("unexpected end of stream");
+
+            read += count;
+        }
+    }
+
+    return ret;
+}
+
+TextureData TextureData::Load(const path& p)
+{
+    auto stream = File::Open(p, OpenMode::In | OpenMode::Binary);
+    if (!stream)
+        throw Exception("could not open file");
+
+    return Load(stream);
+}
+
+std::optional<ImageInfo> TextureData::GetInfo(const path& p)
+{
+    auto stream = File::Open(p, OpenMode::In | OpenMode::Binary);
+    if (!stream)
+        throw Exception("could not open file");
+
+    TextureFileHeader header;
+
+    if (!stream->ReadValue(header) ||
+        !std::equal(header.magic, header.magic + 4, TextureFileMagic))
+    {
+        return std::nullopt;
+    }
+
+    ImageInfo info;
+    info.format = (PixelDataFormat)header.format;
+    info.size = IVec2(header.width, header.height);
+    return info;
+}
+
+} // gfx
+} // mw
@@ -0,0 +1,100 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.Graphics.TextureData;
+import Microwave.Graphics.GraphicsTypes;
+import Microwave.Graphics.Image;
+import Microwave.IO.Stream;
+import Microwave.Math;
+import Microwave.System.Path;
+import Microwave.System.Pointers;
+import std;
+
+export namespace mw {
+inline namespace gfx {
+
+// Block compressed formats store 4x4 pixel blocks in a fixed number of
+// bytes. BC1 holds opaque RGB in 8 bytes per block, and BC3 adds a
+// separately compressed alpha channel in another 8. ETC2_RGB and
+// ETC2_RGBA are laid out the same way, with an EAC alpha block first.
+// BC7 stores RGBA in 16 bytes, with more accurate color and alpha than
+// BC3, and is what textures with alpha are compressed to for desktop GPUs.
+enum class TextureCompression
+{
+    None,
+    BC1,
+    BC3,
+    ETC2_RGB,
+    ETC2_RGBA,
+    BC7
+};
+
+// Which family of block formats to compress to. Desktop GPUs read BC, and
+// OpenGL ES 3 GPUs read ETC2. Default picks the one the platform the
+// texture is built on can upload.
+enum class TextureCompressionTarget
+{
+    Default,
+    BC,
+    ETC2
+};
+
+// bytes per 4x4 block, or zero for uncompressed data
+std::size_t GetBlockSize(TextureCompression compression);
+
+struct TextureBuildSettings
+{
+    // color channels are sRGB encoded, so they're filtered in linear space
+    bool sRGB = true;
+
+    // compress 8-bit color images whose size is a multiple of 4
+    bool compress = true;
+
+    TextureCompressionTarget target = TextureCompressionTarget::Default;
+};
+
+struct TextureLevel
+{
+    IVec2 size;
+    std::vector<std::byte> data;
+};
+
+// Every mip level of a texture, in the layout it's uploaded in. Levels go
+// from the full size image down to 1x1, and rows are stored top to bottom.
+// When compressed, each level is a grid of blocks covering its pixels, and
+// 'format' is the format the pixels decompress to.
+//
+// Textures are imported into this form so they can be uploaded without
+// decoding an image file or generating mip levels at load time.
+class TextureData
+{
+public:
+    PixelDataFormat format = PixelDataFormat::Unspecified;
+    TextureCompression compression = TextureCompression::None;
+    std::vector<TextureLevel> levels;
+
+    IVec2 GetSize() const;
+    std::size_t GetByteCount() const;
+
+    // filters 'image' down to 1x1 and converts each level
+    static TextureData Build(const Image& image, const TextureBuildSettings& settings);
+
+    // the same levels as uncompressed RGBA32 pixels
+    TextureData Decompress() const;
+
+    // Flips every level upside down. Blocks can only be flipped whole, so
+    // this returns false, without changing anything, if a compressed level
+    // taller than one block isn't a whole number of blocks tall.
+    bool FlipVertical();
+
+    void Save(const gptr<Stream>& stream) const;
+    static TextureData Load(const gptr<Stream>& stream);
+    static TextureData Load(const path& p);
+
+    // the format and size of a texture data file, or nullopt if 'p' isn't one
+    static std::optional<ImageInfo> GetInfo(const path& p);
+};
+
+} // gfx
+} // mw
@@ -0,0 +1,304 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module;
+#include <MW/System/Internal/Platform.h>
+
+#if PLATFORM_WINDOWS
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <Windows.h>
+#endif
+
+module Microwave.IO.BinaryArtifact;
+import Microwave.IO.File;
+import Microwave.IO.FileStream;
+import Microwave.System.Exception;
+import std;
+
+#if !PLATFORM_WINDOWS
+  import <fcntl.h>;
+  import <unistd.h>;
+  import <sys/mman.h>;
+  import <sys/stat.h>;
+#endif
+
+namespace mw {
+inline namespace io {
+
+static std::size_t AlignOffset(std::size_t offset) {
+    auto align = BinaryArtifact::StreamAlignment;
+    return (offset + align - 1) / align * align;
+}
+
+int BinaryArtifactWriter::AddStream(std::span<const std::byte> data)
+{
+    streams.emplace_back(data.begin(), data.end());
+    return (int)streams.size() - 1;
+}
+
+std::vector<std::byte> BinaryArtifactWriter::Write() const
+{
+    std::string headerText = header.dump();
+
+    BinaryArtifactHeader fileHeader;
+    fileHeader.magic = BinaryArtifact::Magic;
+    fileHeader.version = BinaryArtifact::Version;
+    fileHeader.streamCount = (std::uint32_t)streams.size();
+    fileHeader.headerSize = (std::uint32_t)headerText.size();
+
+    std::size_t offset = sizeof(BinaryArtifactHeader)
+                       + sizeof(BinaryArtifactStream) * streams.size()
+                       + headerText.size();
+
+    std::vector<BinaryArtifactStream> table;
+    table.reserve(streams.size());
+
+    for (auto& stream : streams)
+    {
+        offset = AlignOffset(offset);
+        table.push_back({ offset, stream.size() });
+        offset += stream.size();
+    }
+
+    std::vector<std::byte> ret(offset);
+    auto out = ret.data();
+
+    std::memcpy(out, &fileHeader, sizeof(fileHeader));
+    out += sizeof(fileHeader);
+
+    if (!table.empty())
+        std::memcpy(out, table.data(), sizeof(BinaryArtifactStream) * table.size());
+
+    out += sizeof(BinaryArtifactStream) * table.size();
+    std::copy(headerText.begin(), headerText.end(), (char*)out);
+
+    for (std::size_t i = 0; i < streams.size(); ++i)
+        std::copy(streams[i].begin(), streams[i].end(), ret.begin() + table[i].offset);
+
+    return ret;
+}
+
+void BinaryArtifactWriter::Save(const path& p) const {
+    auto data = Write();
+    File::WriteAllBytes(p, data);
+}
+
+BinaryArtifact::BinaryArtifact(std::vector<std::byte>&& data)
+    : data(std::move(data))
+{
+    ReadContents(GetContents());
+}
+
+BinaryArtifact::BinaryArtifact(const path& p)
+{
+    // paths with a scheme go through a FileResolver, and can't be mapped
+    if (p.string().find("://") == std::string::npos)
+        MapFile(p);
+    else
+        data = File::ReadAllBytes(p);
+
+    try {
+        ReadContents(GetContents());
+    }
+    catch (...) {
+        UnmapFile();
+        throw;
+    }
+}
+
+BinaryArtifact::~BinaryArtifact() {
+    UnmapFile();
+}
+
+void BinaryArtifact::Close()
+{
+    UnmapFile();
+    data = {};
+    streams.clear();
+}
+
+bool BinaryArtifact::IsBinaryArtifact(const path& p)
+{
+    auto stream = File::Open(p, OpenMode::In | OpenMode::Binary);
+
+    std::array<char, 4> magic{};
+    auto bytes = std::as_writable_bytes(std::span(magic));
+
+    return (std::size_t)stream->Read(bytes) == bytes.size() && magic == Magic;
+}
+
+const json& BinaryArtifact::GetHeader() const {
+    return header;
+}
+
+std::size_t BinaryArtifact::GetStreamCount() const {
+    return streams.size();
+}
+
+std::span<std::byte> BinaryArtifact::GetStream(int index) const
+{
+    if (index < 0)
+        return {};
+
+    if ((std::size_t)index >= streams.size())
+        throw Exception("artifact stream index out of range");
+
+    auto& stream = streams[index];
+    return GetContents().subspan((std::size_t)stream.offset, (std::size_t)stream.size);
+}
+
+std::span<std::byte> BinaryArtifact::GetContents() const
+{
+    if (mappedData)
+        return { mappedData, mappedSize };
+
+    return { const_cast<std::byte*>(data.data()), data.size() };
+}
+
+void BinaryArtifact::ReadContents(std::span<std::byte> contents)
+{
+    BinaryArtifactHeader fileHeader;
+
+    if (contents.size() < sizeof(fileHeader))
+        throw Exception("binary artifact is truncated");
+
+    std::memcpy(&fileHeader, contents.data(), sizeof(fileHeader));
+
+    if (fileHeader.magic != Magic)
+        throw Exception("not a binary artifact");
+
+    if (fileHeader.version != Version)
+        throw Exception({ "unsupported binary artifact version: ", std::to_string(fileHeader.version) });
+
+    std::size_t tableSize = sizeof(BinaryArtifactStream) * fileHeader.streamCount;
+    std::size_t textOffset = sizeof(fileHeader) + tableSize;
+
+    if (contents.size() < textOffset + fileHeader.headerSize)
+        throw Exception("binary artifact is truncated");
+
+    streams.resize(fileHeader.streamCount);
+
+    if (!streams.empty())
+        std::memcpy(streams.data(), contents.data() + sizeof(fileHeader), tableSize);
+
+    for (auto& stream : streams)
+    {
+        if (stream.offset > contents.size() || stream.size > contents.size() - stream.offset)
+            throw Exception("binary artifact stream is out of bounds");
+    }
+
+    header = json::parse(std::string_view(
+        (const char*)contents.data() + textOffset,
+        fileHeader.headerSize));
+}
+
+#if PLATFORM_WINDOWS
+
+void BinaryArtifact::MapFile(const path& p)
+{
+    auto& str = p.string();
+    int len = MultiByteToWideChar(CP_UTF8, 0, str.data(), (int)str.size(), nullptr, 0);
+    std::wstring wpath(len, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, str.data(), (int)str.size(), wpath.data(), len);
+
+    HANDLE file = CreateFileW(
+        wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+        throw Exception({ "failed to open file: ", str });
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        throw Exception({ "failed to map file: ", str });
+    }
+
+    // copy-on-write, so the file is never modified through a mapped stream
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0) : nullptr;
+
+    if (!view)
+    {
+        if (mapping)
+            CloseHandle(mapping);
+
+        CloseHandle(file);
+        throw Exception({ "failed to map file: ", str });
+    }
+
+    fileHandle = (std::intptr_t)file;
+    mappingHandle = mapping;
+    mappedData = (std::byte*)view;
+    mappedSize = (std::size_t)size.QuadPart;
+}
+
+void BinaryArtifact::UnmapFile()
+{
+    if (mappedData)
+        UnmapViewOfFile(mappedData);
+
+    if (mappingHandle)
+        CloseHandle((HANDLE)mappingHandle);
+
+    if (fileHandle != -1)
+        CloseHandle((HANDLE)fileHandle);
+
+    mappedData = nullptr;
+    mappedSize = 0;
+    mappingHandle = nullptr;
+    fileHandle = -1;
+}
+
+#else
+
+void BinaryArtifact::MapFile(const path& p)
+{
+    int fd = open(p.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw Exception({ "failed to open file: ", p.string() });
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        throw Exception({ "failed to map file: ", p.string() });
+    }
+
+    // private, so the file is never modified through a mapped stream
+    void* view = mmap(nullptr, (std::size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED)
+    {
+        close(fd);
+        throw Exception({ "failed to map file: ", p.string() });
+    }
+
+    fileHandle = fd;
+    mappedData = (std::byte*)view;
+    mappedSize = (std::size_t)st.st_size;
+}
+
+void BinaryArtifact::UnmapFile()
+{
+    if (mappedData)
+        munmap(mappedData, mappedSize);
+
+    if (fileHandle != -1)
+        close((int)fileHandle);
+
+    mappedData = nullptr;
+    mappedSize = 0;
+    fileHandle = -1;
+}
+
+#endif
+
+} // io
+} // mw
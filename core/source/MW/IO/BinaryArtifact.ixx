@@ -0,0 +1,144 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.IO.BinaryArtifact;
+import Microwave.System.Exception;
+import Microwave.System.Json;
+import Microwave.System.Path;
+import Microwave.System.Pointers;
+import std;
+
+export namespace mw {
+inline namespace io {
+
+// Versioned container for imported asset data. A small JSON header
+// describes the object, and bulk data like vertices, indices and
+// keyframes is stored in raw streams, so it can be copied or handed
+// to the GPU without being parsed.
+//
+// Layout:
+//   BinaryArtifactHeader
+//   BinaryArtifactStream[streamCount]
+//   header text (UTF-8 JSON)
+//   stream data, each stream starting on a StreamAlignment boundary
+struct BinaryArtifactHeader
+{
+    std::array<char, 4> magic{};
+    std::uint32_t version = 0;
+    std::uint32_t streamCount = 0;
+    std::uint32_t headerSize = 0;
+};
+
+struct BinaryArtifactStream
+{
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+};
+
+class BinaryArtifactWriter
+{
+    std::vector<std::vector<std::byte>> streams;
+public:
+    json header = json::object();
+
+    // returns the index of the stream, which should be saved in 'header'
+    int AddStream(std::span<const std::byte> data);
+
+    template<class T> requires std::is_trivially_copyable_v<T>
+    int AddStream(std::span<const T> data) {
+        return AddStream(std::as_bytes(data));
+    }
+
+    template<class T> requires std::is_trivially_copyable_v<T>
+    int AddStream(const std::vector<T>& data) {
+        return AddStream(std::span<const T>(data));
+    }
+
+    std::vector<std::byte> Write() const;
+    void Save(const path& p) const;
+};
+
+// A binary artifact opened for reading. Local files are memory-mapped
+// copy-on-write, so streams can be passed to APIs that take writable
+// spans without touching the file.
+//
+// Streams point straight into the mapping, and stay valid until the
+// artifact is closed. Artifacts are usually held through a gptr, so
+// loaders call Close() when they're done instead of leaving the file
+// mapped until the next collection.
+class BinaryArtifact
+{
+public:
+    static constexpr std::array<char, 4> Magic = { 'M', 'W', 'B', 'A' };
+    static constexpr std::uint32_t Version = 1;
+    static constexpr std::size_t StreamAlignment = 64;
+
+    BinaryArtifact(std::vector<std::byte>&& data);
+    BinaryArtifact(const path& p);
+    ~BinaryArtifact();
+
+    BinaryArtifact(const BinaryArtifact&) = delete;
+    BinaryArtifact& operator=(const BinaryArtifact&) = delete;
+
+    // true if the file at 'p' starts with a binary artifact header
+    static bool IsBinaryArtifact(const path& p);
+
+    const json& GetHeader() const;
+    std::size_t GetStreamCount() const;
+
+    // a negative index returns an empty stream
+    std::span<std::byte> GetStream(int index) const;
+
+    // the stream as an array of T, without copying it
+    template<class T> requires std::is_trivially_copyable_v<T>
+    std::span<const T> GetStreamAs(int index) const;
+
+    // copies the stream, for data that has to outlive the artifact
+    template<class T> requires std::is_trivially_copyable_v<T>
+    void ReadStream(int index, std::vector<T>& values) const;
+
+    // unmaps the file, or frees the buffer, invalidating every stream
+    void Close();
+
+private:
+    std::vector<std::byte> data;
+
+    std::byte* mappedData = nullptr;
+    std::size_t mappedSize = 0;
+    std::intptr_t fileHandle = -1;
+    void* mappingHandle = nullptr;
+
+    json header;
+    std::vector<BinaryArtifactStream> streams;
+
+    void MapFile(const path& p);
+    void UnmapFile();
+    void ReadContents(std::span<std::byte> contents);
+    std::span<std::byte> GetContents() const;
+};
+
+template<class T> requires std::is_trivially_copyable_v<T>
+std::span<const T> BinaryArtifact::GetStreamAs(int index) const
+{
+    auto bytes = GetStream(index);
+    if (bytes.size() % sizeof(T) != 0)
+        throw Exception("artifact stream size does not match its element type");
+
+    // streams start on StreamAlignment boundaries, so this only fails for
+    // types with a larger alignment
+    if ((std::uintptr_t)bytes.data() % alignof(T) != 0)
+        throw Exception("artifact stream is misaligned for its element type");
+
+    return { (const T*)bytes.data(), bytes.size() / sizeof(T) };
+}
+
+template<class T> requires std::is_trivially_copyable_v<T>
+void BinaryArtifact::ReadStream(int index, std::vector<T>& values) const
+{
+    auto stream = GetStreamAs<T>(index);
+    values.assign(stream.begin(), stream.end());
+}
+
+} // io
+} // mw
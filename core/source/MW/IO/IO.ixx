@@ -3,6 +3,7 @@
 *--------------------------------------------------------------*/
 
 export module Microwave.IO;
+export import Microwave.IO.BinaryArtifact;
 export import Microwave.IO.File;
 export import Microwave.IO.FileStream;
 export import Microwave.IO.MemoryStream;
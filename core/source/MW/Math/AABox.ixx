@@ -7,6 +7,7 @@ import Microwave.Math.Vec3;
 import Microwave.Math.Vec4;
 import Microwave.Math.Mat4;
 import Microwave.Math.Operators;
+import Microwave.Math.Simd;
 import std;
 
 export namespace mw {
@@ -127,6 +128,13 @@ public:
 
     AABox Transform(const Mat4& mtx) const
     {
+        if constexpr (simd::Enabled)
+        {
+            AABox ret;
+            simd::TransformBox(simd::Rows(&mtx.m11), &center.x, &extents.x, &ret.center.x, &ret.extents.x);
+            return ret;
+        }
+
         Vec3 worldCenter = Vec4(center, 1.0f) * mtx;
         Vec3 worldExtentsX = Vec4(extents.x, 0, 0, 0) * mtx;
         Vec3 worldExtentsY = Vec4(0, extents.y, 0, 0) * mtx;
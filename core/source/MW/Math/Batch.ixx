@@ -0,0 +1,143 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.Math.Batch;
+import Microwave.Math.AABox;
+import Microwave.Math.Mat4;
+import Microwave.Math.Operators;
+import Microwave.Math.Simd;
+import Microwave.Math.Vec3;
+import Microwave.Math.Vec4;
+import std;
+
+export namespace mw {
+inline namespace math {
+
+// Applies one operation to many values, keeping the matrix in registers
+// instead of reloading it for every call. Each function writes its results
+// to the same indices of 'out', which may alias the input, and stops at
+// the end of whichever span is shorter.
+
+// (p, 1) * m
+void TransformPoints(const Mat4& m, std::span<const Vec3> points, std::span<Vec3> out)
+{
+    std::size_t count = std::min(points.size(), out.size());
+
+    if constexpr (simd::Enabled)
+    {
+        simd::Rows rows(&m.m11);
+        alignas(16) float values[4];
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto& p = points[i];
+            simd::Store(values, rows.TransformPoint(p.x, p.y, p.z));
+            out[i] = Vec3(values[0], values[1], values[2]);
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = Vec4(points[i], 1.0f) * m;
+    }
+}
+
+// (v, 0) * m
+void TransformVectors(const Mat4& m, std::span<const Vec3> vectors, std::span<Vec3> out)
+{
+    std::size_t count = std::min(vectors.size(), out.size());
+
+    if constexpr (simd::Enabled)
+    {
+        simd::Rows rows(&m.m11);
+        alignas(16) float values[4];
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto& v = vectors[i];
+            simd::Store(values, rows.TransformVector(v.x, v.y, v.z));
+            out[i] = Vec3(values[0], values[1], values[2]);
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = Vec4(vectors[i], 0.0f) * m;
+    }
+}
+
+// v * m, for points in homogeneous coordinates
+void TransformPoints(const Mat4& m, std::span<const Vec4> values, std::span<Vec4> out)
+{
+    std::size_t count = std::min(values.size(), out.size());
+
+    if constexpr (simd::Enabled)
+    {
+        simd::Rows rows(&m.m11);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto& v = values[i];
+            simd::Store(&out[i].x, rows.Transform(v.x, v.y, v.z, v.w));
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = values[i] * m;
+    }
+}
+
+// a[i] * b
+void MultiplyMatrices(std::span<const Mat4> a, const Mat4& b, std::span<Mat4> out)
+{
+    std::size_t count = std::min(a.size(), out.size());
+
+    if constexpr (simd::Enabled)
+    {
+        simd::Rows rows(&b.m11);
+
+        for (std::size_t i = 0; i < count; ++i)
+            simd::Multiply(&a[i].m11, rows, &out[i].m11);
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = a[i] * b;
+    }
+}
+
+// a[i] * b[i]
+void MultiplyMatrices(std::span<const Mat4> a, std::span<const Mat4> b, std::span<Mat4> out)
+{
+    std::size_t count = std::min({ a.size(), b.size(), out.size() });
+
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = a[i] * b[i];
+}
+
+// the bounds of each box after transforming it by 'm'
+void TransformBoxes(const Mat4& m, std::span<const AABox> boxes, std::span<AABox> out)
+{
+    std::size_t count = std::min(boxes.size(), out.size());
+
+    if constexpr (simd::Enabled)
+    {
+        simd::Rows rows(&m.m11);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto& box = boxes[i];
+            simd::TransformBox(rows, &box.center.x, &box.extents.x, &out[i].center.x, &out[i].extents.x);
+        }
+    }
+    else
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            out[i] = boxes[i].Transform(m);
+    }
+}
+
+} // math
+} // mw
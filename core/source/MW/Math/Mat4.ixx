@@ -6,6 +6,7 @@ export module Microwave.Math.Mat4;
 import Microwave.Math.Vec3;
 import Microwave.Math.Mat3;
 import Microwave.Math.Quat;
+import Microwave.Math.Simd;
 import Microwave.Math.Constants;
 import std;
 
@@ -122,6 +123,13 @@ public:
 
     Mat4 operator*(const Mat4& m) const
     {
+        if constexpr (simd::Enabled)
+        {
+            Mat4 ret;
+            simd::Multiply(&m11, &m.m11, &ret.m11);
+            return ret;
+        }
+
         return Mat4(
             m11 * m.m11 + m12 * m.m21 + m13 * m.m31 + m14 * m.m41,
             m11 * m.m12 + m12 * m.m22 + m13 * m.m32 + m14 * m.m42,
@@ -217,6 +225,12 @@ public:
 
     Mat4 Inverse() const
     {
+        if constexpr (simd::Enabled)
+        {
+            Mat4 ret;
+            return simd::Inverse(&m11, &ret.m11) ? ret : *this;
+        }
+
         Mat4 adj;
 
         adj.m11 = m22 * m33 * m44 - m22 * m34 * m43 - m32 * m23 * m44 + m32 * m24 * m43 + m42 * m23 * m34 - m42 * m24 * m33;
@@ -4,6 +4,7 @@
 
 export module Microwave.Math;
 export import Microwave.Math.AABox;
+export import Microwave.Math.Batch;
 export import Microwave.Math.Constants;
 export import Microwave.Math.Functions;
 export import Microwave.Math.IntRect;
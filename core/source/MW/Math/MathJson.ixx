@@ -4,6 +4,7 @@
 
 export module Microwave.Math.MathJson;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.Math.IVec2;
 import Microwave.Math.IVec4;
 import Microwave.Math.Vec2;
@@ -258,5 +259,53 @@ void from_json(const json& obj, Triangle& t) {
     t.c = obj.value("c", t.c);
 }
 
+// streamed versions of the above, for types that are saved in bulk
+
+void to_json(JsonWriter& writer, const IVec2& v) {
+    writer.BeginObject().Property("x", v.x).Property("y", v.y).EndObject();
+}
+
+void to_json(JsonWriter& writer, const IVec4& v) {
+    writer.BeginObject().Property("x", v.x).Property("y", v.y).Property("z", v.z).Property("w", v.w).EndObject();
+}
+
+void to_json(JsonWriter& writer, const Vec2& v) {
+    writer.BeginObject().Property("x", v.x).Property("y", v.y).EndObject();
+}
+
+void to_json(JsonWriter& writer, const Vec3& v) {
+    writer.BeginObject().Property("x", v.x).Property("y", v.y).Property("z", v.z).EndObject();
+}
+
+void to_json(JsonWriter& writer, const Vec4& v) {
+    writer.BeginObject().Property("x", v.x).Property("y", v.y).Property("z", v.z).Property("w", v.w).EndObject();
+}
+
+void to_json(JsonWriter& writer, const Quat& q) {
+    writer.BeginObject().Property("x", q.v.x).Property("y", q.v.y).Property("z", q.v.z).Property("w", q.w).EndObject();
+}
+
+void to_json(JsonWriter& writer, const Mat4& m)
+{
+    writer.BeginObject()
+        .Property("m11", m.m11).Property("m12", m.m12).Property("m13", m.m13).Property("m14", m.m14)
+        .Property("m21", m.m21).Property("m22", m.m22).Property("m23", m.m23).Property("m24", m.m24)
+        .Property("m31", m.m31).Property("m32", m.m32).Property("m33", m.m33).Property("m34", m.m34)
+        .Property("m41", m.m41).Property("m42", m.m42).Property("m43", m.m43).Property("m44", m.m44)
+        .EndObject();
+}
+
+void to_json(JsonWriter& writer, const AABox& b) {
+    writer.BeginObject().Property("center", b.center).Property("extents", b.extents).EndObject();
+}
+
+void to_json(JsonWriter& writer, const Sphere& s) {
+    writer.BeginObject().Property("center", s.center).Property("radius", s.radius).EndObject();
+}
+
+void to_json(JsonWriter& writer, const Transform& t) {
+    writer.BeginObject().Property("position", t.position).Property("rotation", t.rotation).Property("scale", t.scale).EndObject();
+}
+
 } // math
 } // mw
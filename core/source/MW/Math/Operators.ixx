@@ -8,6 +8,7 @@ import Microwave.Math.Vec4;
 import Microwave.Math.Quat;
 import Microwave.Math.Mat3;
 import Microwave.Math.Mat4;
+import Microwave.Math.Simd;
 
 export namespace mw {
 inline namespace math {
@@ -26,6 +27,13 @@ Vec3& operator*=(Vec3& v, const Mat3& m) {
 
 Vec4 operator*(const Vec4& v, const Mat4& m)
 {
+    if constexpr (simd::Enabled)
+    {
+        Vec4 ret;
+        simd::Store(&ret.x, simd::Rows(&m.m11).Transform(v.x, v.y, v.z, v.w));
+        return ret;
+    }
+
     return Vec4(
         m.m11 * v.x + m.m21 * v.y + m.m31 * v.z + m.m41 * v.w,
         m.m12 * v.x + m.m22 * v.y + m.m32 * v.z + m.m42 * v.w,
@@ -39,6 +47,13 @@ Vec4& operator*=(Vec4& v, const Mat4& m) {
 
 Vec3 operator*(const Vec3& v, const Quat& q)
 {
+    if constexpr (simd::Enabled)
+    {
+        Vec3 ret;
+        simd::QuatRotate(&q.v.x, &v.x, &ret.x);
+        return ret;
+    }
+
     Vec3 uv = q.v.Cross(v);
     Vec3 uuv = q.v.Cross(uv);
     uv = uv * (2.0f * q.w);
@@ -5,6 +5,7 @@
 export module Microwave.Math.Quat;
 import Microwave.Math.Vec3;
 import Microwave.Math.Mat3;
+import Microwave.Math.Simd;
 import Microwave.Math.Constants;
 import std;
 
@@ -75,6 +76,13 @@ public:
 
     Quat operator*(const Quat& q) const
     {
+        if constexpr (simd::Enabled)
+        {
+            Quat ret;
+            simd::QuatMultiply(&v.x, &q.v.x, &ret.v.x);
+            return ret;
+        }
+
         return Quat(
             v.z * q.v.y - v.y * q.v.z + v.x * q.w + w * q.v.x,
             v.x * q.v.z - v.z * q.v.x + v.y * q.w + w * q.v.y,
@@ -118,6 +126,9 @@ public:
 
     const Quat& operator*=(const Quat& q)
     {
+        if constexpr (simd::Enabled)
+            return (*this = *this * q);
+
         Quat c = *this;
         v.x = c.v.z * q.v.y - c.v.y * q.v.z + c.v.x * q.w + c.w * q.v.x;
         v.y = c.v.x * q.v.z - c.v.z * q.v.x + c.v.y * q.w + c.w * q.v.y;
@@ -287,6 +298,14 @@ public:
     {
         float ta = (1.0f - t);
         float tb = (a.Dot(b) < 0) ? -t : t;
+
+        if constexpr (simd::Enabled)
+        {
+            Quat ret;
+            simd::Blend(&a.v.x, ta, &b.v.x, tb, &ret.v.x);
+            return ret.Normalized();
+        }
+
         return (a * ta + b * tb).Normalized();
     }
 
@@ -317,6 +336,13 @@ public:
             tb = flip ? -sin(t * angle) * invSinAngle : sin(t * angle) * invSinAngle;
         }
 
+        if constexpr (simd::Enabled)
+        {
+            Quat ret;
+            simd::Blend(&a.v.x, ta, &b.v.x, tb, &ret.v.x);
+            return ret;
+        }
+
         return a * ta + b * tb;
     }
 
@@ -348,5 +374,8 @@ private:
     }
 };
 
+// the simd paths load x, y, z, w as four consecutive floats
+static_assert(sizeof(Quat) == sizeof(float) * 4);
+
 } // math
 } // mw
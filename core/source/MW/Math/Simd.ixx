@@ -0,0 +1,305 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#  include <xmmintrin.h>
+#  define MW_MATH_SSE 1
+#elif defined(_M_ARM64) || defined(_M_ARM) || defined(__ARM_NEON)
+#  include <arm_neon.h>
+#  define MW_MATH_NEON 1
+#endif
+
+export module Microwave.Math.Simd;
+import std;
+
+export namespace mw {
+inline namespace math {
+namespace simd {
+
+// Four floats operated on together. Each operation maps to an SSE or NEON
+// instruction where one is available, and to a loop otherwise, so code
+// written against them builds everywhere. 'Enabled' is false when there
+// is no vector unit to use, and callers should keep their scalar code.
+//
+// Matrices are passed as 16 floats in Mat4's row-major order, and points
+// are multiplied as row vectors, like the rest of Microwave.Math.
+#if MW_MATH_SSE
+
+using float4 = __m128;
+constexpr bool Enabled = true;
+
+inline float4 Load(const float* p) { return _mm_loadu_ps(p); }
+inline void Store(float* p, float4 a) { _mm_storeu_ps(p, a); }
+inline float4 Set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline float4 Splat(float s) { return _mm_set1_ps(s); }
+inline float4 Zero() { return _mm_setzero_ps(); }
+inline float4 Add(float4 a, float4 b) { return _mm_add_ps(a, b); }
+inline float4 Sub(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+inline float4 Mul(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+inline float4 MulAdd(float4 a, float4 b, float4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline float4 Abs(float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline float4 SwapPairs(float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)); }
+inline float4 SwapHalves(float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)); }
+inline float GetX(float4 a) { return _mm_cvtss_f32(a); }
+
+// (a[X], a[Y], a[Z], a[W])
+template<int X, int Y, int Z, int W>
+inline float4 Shuffle(float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(W, Z, Y, X)); }
+
+inline void Transpose(float4& r0, float4& r1, float4& r2, float4& r3) {
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+#elif MW_MATH_NEON
+
+using float4 = float32x4_t;
+constexpr bool Enabled = true;
+
+inline float4 Load(const float* p) { return vld1q_f32(p); }
+inline void Store(float* p, float4 a) { vst1q_f32(p, a); }
+inline float4 Splat(float s) { return vdupq_n_f32(s); }
+inline float4 Zero() { return vdupq_n_f32(0.0f); }
+inline float4 Add(float4 a, float4 b) { return vaddq_f32(a, b); }
+inline float4 Sub(float4 a, float4 b) { return vsubq_f32(a, b); }
+inline float4 Mul(float4 a, float4 b) { return vmulq_f32(a, b); }
+inline float4 MulAdd(float4 a, float4 b, float4 c) { return vmlaq_f32(c, a, b); }
+inline float4 Abs(float4 a) { return vabsq_f32(a); }
+inline float4 SwapPairs(float4 a) { return vrev64q_f32(a); }
+inline float4 SwapHalves(float4 a) { return vextq_f32(a, a, 2); }
+inline float GetX(float4 a) { return vgetq_lane_f32(a, 0); }
+
+template<int X, int Y, int Z, int W>
+inline float4 Shuffle(float4 a)
+{
+    float4 r = vdupq_n_f32(vgetq_lane_f32(a, X));
+    r = vsetq_lane_f32(vgetq_lane_f32(a, Y), r, 1);
+    r = vsetq_lane_f32(vgetq_lane_f32(a, Z), r, 2);
+    return vsetq_lane_f32(vgetq_lane_f32(a, W), r, 3);
+}
+
+inline float4 Set(float x, float y, float z, float w) {
+    float values[4] = { x, y, z, w };
+    return vld1q_f32(values);
+}
+
+inline void Transpose(float4& r0, float4& r1, float4& r2, float4& r3)
+{
+    float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+#else
+
+struct float4 { float v[4]; };
+constexpr bool Enabled = false;
+
+inline float4 Load(const float* p) { return { p[0], p[1], p[2], p[3] }; }
+inline void Store(float* p, float4 a) { std::copy_n(a.v, 4, p); }
+inline float4 Set(float x, float y, float z, float w) { return { x, y, z, w }; }
+inline float4 Splat(float s) { return { s, s, s, s }; }
+inline float4 Zero() { return { 0, 0, 0, 0 }; }
+inline float4 Add(float4 a, float4 b) { return { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] }; }
+inline float4 Sub(float4 a, float4 b) { return { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] }; }
+inline float4 Mul(float4 a, float4 b) { return { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] }; }
+inline float4 MulAdd(float4 a, float4 b, float4 c) { return Add(Mul(a, b), c); }
+inline float4 Abs(float4 a) { return { std::abs(a.v[0]), std::abs(a.v[1]), std::abs(a.v[2]), std::abs(a.v[3]) }; }
+inline float4 SwapPairs(float4 a) { return { a.v[1], a.v[0], a.v[3], a.v[2] }; }
+inline float4 SwapHalves(float4 a) { return { a.v[2], a.v[3], a.v[0], a.v[1] }; }
+inline float GetX(float4 a) { return a.v[0]; }
+
+template<int X, int Y, int Z, int W>
+inline float4 Shuffle(float4 a) { return { a.v[X], a.v[Y], a.v[Z], a.v[W] }; }
+
+inline void Transpose(float4& r0, float4& r1, float4& r2, float4& r3)
+{
+    float4 c0 = { r0.v[0], r1.v[0], r2.v[0], r3.v[0] };
+    float4 c1 = { r0.v[1], r1.v[1], r2.v[1], r3.v[1] };
+    float4 c2 = { r0.v[2], r1.v[2], r2.v[2], r3.v[2] };
+    float4 c3 = { r0.v[3], r1.v[3], r2.v[3], r3.v[3] };
+    r0 = c0; r1 = c1; r2 = c2; r3 = c3;
+}
+
+#endif
+
+// the rows of a matrix, kept in registers while it's applied many times
+struct Rows
+{
+    float4 r0, r1, r2, r3;
+
+    explicit Rows(const float* m)
+        : r0(Load(m)), r1(Load(m + 4)), r2(Load(m + 8)), r3(Load(m + 12)) {}
+
+    Rows(float4 r0, float4 r1, float4 r2, float4 r3)
+        : r0(r0), r1(r1), r2(r2), r3(r3) {}
+
+    // (x, y, z, w) * m
+    float4 Transform(float x, float y, float z, float w) const {
+        return MulAdd(Splat(x), r0, MulAdd(Splat(y), r1, MulAdd(Splat(z), r2, Mul(Splat(w), r3))));
+    }
+
+    // (x, y, z, 1) * m
+    float4 TransformPoint(float x, float y, float z) const {
+        return MulAdd(Splat(x), r0, MulAdd(Splat(y), r1, MulAdd(Splat(z), r2, r3)));
+    }
+
+    // (x, y, z, 0) * m
+    float4 TransformVector(float x, float y, float z) const {
+        return MulAdd(Splat(x), r0, MulAdd(Splat(y), r1, Mul(Splat(z), r2)));
+    }
+};
+
+// out = a * b
+inline void Multiply(const float* a, const Rows& b, float* out)
+{
+    for (int i = 0; i < 16; i += 4)
+        Store(out + i, b.Transform(a[i], a[i + 1], a[i + 2], a[i + 3]));
+}
+
+inline void Multiply(const float* a, const float* b, float* out) {
+    Multiply(a, Rows(b), out);
+}
+
+// Cramer's rule, with the cofactors for four elements computed at once.
+// Returns false, leaving 'out' untouched, if 'm' is singular.
+inline bool Inverse(const float* m, float* out)
+{
+    float4 row0 = Load(m);
+    float4 row1 = Load(m + 4);
+    float4 row2 = Load(m + 8);
+    float4 row3 = Load(m + 12);
+
+    // columns, with the halves of the second and fourth swapped
+    Transpose(row0, row1, row2, row3);
+    row1 = SwapHalves(row1);
+    row3 = SwapHalves(row3);
+
+    float4 tmp = SwapPairs(Mul(row2, row3));
+    float4 minor0 = Mul(row1, tmp);
+    float4 minor1 = Mul(row0, tmp);
+    tmp = SwapHalves(tmp);
+    minor0 = Sub(Mul(row1, tmp), minor0);
+    minor1 = SwapHalves(Sub(Mul(row0, tmp), minor1));
+
+    tmp = SwapPairs(Mul(row1, row2));
+    minor0 = MulAdd(row3, tmp, minor0);
+    float4 minor3 = Mul(row0, tmp);
+    tmp = SwapHalves(tmp);
+    minor0 = Sub(minor0, Mul(row3, tmp));
+    minor3 = SwapHalves(Sub(Mul(row0, tmp), minor3));
+
+    tmp = SwapPairs(Mul(SwapHalves(row1), row3));
+    row2 = SwapHalves(row2);
+    minor0 = MulAdd(row2, tmp, minor0);
+    float4 minor2 = Mul(row0, tmp);
+    tmp = SwapHalves(tmp);
+    minor0 = Sub(minor0, Mul(row2, tmp));
+    minor2 = SwapHalves(Sub(Mul(row0, tmp), minor2));
+
+    tmp = SwapPairs(Mul(row0, row1));
+    minor2 = MulAdd(row3, tmp, minor2);
+    minor3 = Sub(Mul(row2, tmp), minor3);
+    tmp = SwapHalves(tmp);
+    minor2 = Sub(Mul(row3, tmp), minor2);
+    minor3 = Sub(minor3, Mul(row2, tmp));
+
+    tmp = SwapPairs(Mul(row0, row3));
+    minor1 = Sub(minor1, Mul(row2, tmp));
+    minor2 = MulAdd(row1, tmp, minor2);
+    tmp = SwapHalves(tmp);
+    minor1 = MulAdd(row2, tmp, minor1);
+    minor2 = Sub(minor2, Mul(row1, tmp));
+
+    tmp = SwapPairs(Mul(row0, row2));
+    minor1 = MulAdd(row3, tmp, minor1);
+    minor3 = Sub(minor3, Mul(row1, tmp));
+    tmp = SwapHalves(tmp);
+    minor1 = Sub(minor1, Mul(row3, tmp));
+    minor3 = MulAdd(row1, tmp, minor3);
+
+    float4 det = Mul(row0, minor0);
+    det = Add(SwapHalves(det), det);
+    det = Add(SwapPairs(det), det);
+
+    float d = GetX(det);
+    if (!(std::abs(d) > 0))
+        return false;
+
+    float4 invDet = Splat(1.0f / d);
+    Store(out, Mul(minor0, invDet));
+    Store(out + 4, Mul(minor1, invDet));
+    Store(out + 8, Mul(minor2, invDet));
+    Store(out + 12, Mul(minor3, invDet));
+    return true;
+}
+
+// The bounds of a box after transforming it. The center is transformed as
+// a point, and each axis of the new extents is the sum of how far the old
+// extents reach along it.
+inline void TransformBox(const Rows& m, const float* center, const float* extents, float* outCenter, float* outExtents)
+{
+    float4 c = m.TransformPoint(center[0], center[1], center[2]);
+    float4 e = MulAdd(Splat(extents[0]), Abs(m.r0),
+               MulAdd(Splat(extents[1]), Abs(m.r1),
+               Mul(Splat(extents[2]), Abs(m.r2))));
+
+    alignas(16) float values[8];
+    Store(values, c);
+    Store(values + 4, e);
+    std::copy_n(values, 3, outCenter);
+    std::copy_n(values + 4, 3, outExtents);
+}
+
+// out = a * b, for quaternions stored as (x, y, z, w), with the same
+// terms as Quat::operator*. Each row adds one component of 'a' times 'b'
+// with its components reordered and negated to match.
+inline void QuatMultiply(const float* a, const float* b, float* out)
+{
+    float4 qb = Load(b);
+
+    float4 r = Mul(Splat(a[3]), qb);
+    r = MulAdd(Splat(a[0]), Mul(Shuffle<3, 2, 1, 0>(qb), Set(1, 1, -1, -1)), r);
+    r = MulAdd(Splat(a[1]), Mul(Shuffle<2, 3, 0, 1>(qb), Set(-1, 1, 1, -1)), r);
+    r = MulAdd(Splat(a[2]), Mul(Shuffle<1, 0, 3, 2>(qb), Set(1, -1, 1, -1)), r);
+
+    Store(out, r);
+}
+
+// the cross products of the xyz parts of 'a' and 'b', with w set to zero
+inline float4 Cross(float4 a, float4 b)
+{
+    return Sub(
+        Mul(Shuffle<1, 2, 0, 3>(a), Shuffle<2, 0, 1, 3>(b)),
+        Mul(Shuffle<2, 0, 1, 3>(a), Shuffle<1, 2, 0, 3>(b)));
+}
+
+// 'v' rotated by quaternion 'q', like operator*(Vec3, Quat):
+// v + 2w(q x v) + 2(q x (q x v))
+inline void QuatRotate(const float* q, const float* v, float* out)
+{
+    float4 qv = Load(q);
+    float4 p = Set(v[0], v[1], v[2], 0);
+
+    float4 uv = Cross(qv, p);
+    float4 uuv = Cross(qv, uv);
+    float4 r = MulAdd(uv, Splat(2.0f * q[3]), MulAdd(uuv, Splat(2.0f), p));
+
+    alignas(16) float values[4];
+    Store(values, r);
+    std::copy_n(values, 3, out);
+}
+
+// a * ta + b * tb, for blending quaternions
+inline void Blend(const float* a, float ta, const float* b, float tb, float* out) {
+    Store(out, MulAdd(Load(a), Splat(ta), Mul(Load(b), Splat(tb))));
+}
+
+} // simd
+} // math
+} // mw
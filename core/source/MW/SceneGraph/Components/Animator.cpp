@@ -32,6 +32,25 @@ void Animator::ToJson(json& obj) const
     obj["animationStates"] = animStateObjs;
 }
 
+void Animator::WriteProperties(JsonWriter& writer) const
+{
+    Component::WriteProperties(writer);
+
+    writer.Key("animationStates");
+    writer.BeginObject();
+
+    for(auto& [name, state] : animationStates)
+    {
+        writer.Key(name);
+        writer.BeginObject();
+        ObjectLinker::SaveAsset(writer, "clip", state->clip);
+        writer.Property("speed", state->speed);
+        writer.EndObject();
+    }
+
+    writer.EndObject();
+}
+
 void Animator::FromJson(const json& obj, ObjectLinker* linker)
 {
     Component::FromJson(obj, linker);
@@ -45,6 +64,25 @@ void Animator::FromJson(const json& obj, ObjectLinker* linker)
         auto state = gpnew<AnimationState>();
         ObjectLinker::RestoreAsset(linker, self(this), state->clip, stateObj, "clip");
         state->speed = stateObj["speed"];
+        animationStates[std::string(name)] = std::move(state);
+    }
+
+    dirtyInfluences = true;
+}
+
+gptr<Object> Animator::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void Animator::CloneFrom(const Animator& source, ObjectCloner& cloner)
+{
+    Component::CloneFrom(source, cloner);
+
+    for (auto& [name, sourceState] : source.animationStates)
+    {
+        auto state = gpnew<AnimationState>();
+        state->clip = sourceState->clip;
+        state->speed = sourceState->speed;
         animationStates[name] = std::move(state);
     }
 
@@ -63,14 +101,43 @@ void Animator::StopAnimation(AnimationState& state)
 
 void Animator::UpdateInfluences()
 {
+    for (auto& [name, state] : animationStates)
+    {
+        if (state->clip != state->boundClip)
+            dirtyInfluences = true;
+    }
+
     if(dirtyInfluences)
     {
+        // resolve each animated path to its node once, so sampling
+        // doesn't have to look nodes up by name every frame
+        gptr<Node> rootNode = GetNode();
+        std::unordered_map<path, std::uint32_t> indices;
+
         influences.clear();
+        influenceNodes.clear();
 
         for (auto& [name, state] : animationStates)
         {
+            state->boundClip = state->clip;
+            state->bindings.clear();
+
+            if (!state->clip)
+                continue;
+
+            state->bindings.reserve(state->clip->GetTracks().size());
+
             for(auto& [path, track] : state->clip->GetTracks())
-                influences[path] = {};
+            {
+                auto [it, added] = indices.try_emplace(path, (std::uint32_t)influences.size());
+                if (added)
+                {
+                    influences.emplace_back();
+                    influenceNodes.push_back(rootNode ? rootNode->GetChild(path) : nullptr);
+                }
+
+                state->bindings.push_back({ track.get(), it->second });
+            }
         }
 
         dirtyInfluences = false;
@@ -172,12 +239,10 @@ void Animator::UpdateAnimationStates()
 
 void Animator::Sample()
 {
-    gptr<Node> rootNode = GetNode();
-
     UpdateInfluences();
 
     // reset influences
-    for (auto& [path, inf] : influences) {
+    for (auto& inf : influences) {
         inf = {};
     }
 
@@ -186,12 +251,12 @@ void Animator::Sample()
     {
         if (state->enabled && state->clip)
         {
-            for(auto& [path, track] : state->clip->GetTracks())
+            for(auto& binding : state->bindings)
             {
-                auto& inf = influences[path];
+                auto& inf = influences[binding.influence];
 
                 float time = state->time;
-                Transform localTransform = track->Evaluate(time);
+                Transform localTransform = binding.track->Evaluate(time, binding.cursor);
                 
                 auto localRot = localTransform.rotation;
                 if(inf.weight > 0 && localRot.Dot(inf.localRot) < 0)
@@ -206,8 +271,10 @@ void Animator::Sample()
     }
 
     // apply influences
-    for(auto& [path, inf] : influences)
+    for(std::size_t i = 0; i != influences.size(); ++i)
     {
+        auto& inf = influences[i];
+
         if (inf.weight >= std::numeric_limits<float>::epsilon())
         {
             inf.localPos /= inf.weight;
@@ -215,8 +282,7 @@ void Animator::Sample()
             inf.localRot.Normalize();
             inf.localScale /= inf.weight;
 
-            gptr<Node> node = rootNode->GetChild(path);
-            if (node)
+            if (auto& node = influenceNodes[i])
                 node->SetLocalTransform(inf.localPos, inf.localRot, inf.localScale);
         }
     }
@@ -323,6 +389,10 @@ bool Animator::IsPlaying() const
     );
 }
 
+void Animator::OnStructureChanged() {
+    dirtyInfluences = true;
+}
+
 void Animator::SystemUpdate1()
 {
     UpdateAnimationStates();
@@ -4,10 +4,12 @@
 
 export module Microwave.SceneGraph.Components.Animator;
 import Microwave.Graphics.AnimationClip;
+import Microwave.Graphics.AnimationTrack;
 import Microwave.Math;
 import Microwave.SceneGraph.Components.Component;
 import Microwave.SceneGraph.Events;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Path;
 import Microwave.System.Pointers;
@@ -16,6 +18,16 @@ import std;
 export namespace mw {
 inline namespace scene {
 
+class Node;
+
+// a track of a clip, bound to the influence of the node it animates
+struct AnimationBinding
+{
+    const AnimationTrack* track = nullptr;
+    std::uint32_t influence = 0;
+    TrackCursor cursor;
+};
+
 class AnimationState
 {
 public:
@@ -28,6 +40,10 @@ public:
     float weightFadeRate = 0.0f;
     bool enabled = false;
     bool fadingOut = false;
+
+    // tracks of 'boundClip', set up by the Animator
+    gptr<AnimationClip> boundClip;
+    std::vector<AnimationBinding> bindings;
 };
 
 struct Influence
@@ -43,7 +59,9 @@ class Animator : public Component, public ISystemEvents
     inline static Type::Pin<Animator> pin;
 
     gmap<std::string, gptr<AnimationState>> animationStates;
-    std::unordered_map<path, Influence> influences;
+    // one influence per animated node, in the order they were bound
+    std::vector<Influence> influences;
+    gvector<gptr<Node>> influenceNodes;
     bool dirtyInfluences = true;
 
     void StopAnimation(AnimationState& state);
@@ -54,8 +72,12 @@ public:
     Animator(){}
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const Animator& source, ObjectCloner& cloner);
+
     void AddClip(const gptr<AnimationClip>& clip, const std::string& clipName);
     void RemoveClip(const gptr<AnimationClip>& clip);
     void RemoveClip(const std::string& clipName);
@@ -71,6 +93,7 @@ public:
     AnimationState& GetAnimationState(std::string_view name);
     AnimationState& operator[](std::string_view name);
 
+    virtual void OnStructureChanged() override;
     virtual void SystemUpdate1() override;
 };
 
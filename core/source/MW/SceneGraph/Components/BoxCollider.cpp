@@ -25,6 +25,12 @@ void BoxCollider::ToJson(json& obj) const
     obj["extents"] = extents;
 }
 
+void BoxCollider::WriteProperties(JsonWriter& writer) const
+{
+    Collider::WriteProperties(writer);
+    writer.Property("extents", extents);
+}
+
 void BoxCollider::FromJson(const json& obj, ObjectLinker* linker)
 {
     Collider::FromJson(obj, linker);
@@ -32,6 +38,17 @@ void BoxCollider::FromJson(const json& obj, ObjectLinker* linker)
     dirty = true;
 }
 
+gptr<Object> BoxCollider::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void BoxCollider::CloneFrom(const BoxCollider& source, ObjectCloner& cloner)
+{
+    Collider::CloneFrom(source, cloner);
+    extents = source.extents;
+    dirty = true;
+}
+
 void BoxCollider::SetExtents(const Vec3& extents)
 {
     this->extents = extents;
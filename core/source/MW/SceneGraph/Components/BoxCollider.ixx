@@ -10,6 +10,7 @@ import Microwave.SceneGraph.Components.Collider;
 import Microwave.SceneGraph.Events;
 import Microwave.SceneGraph.Renderable;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Pointers;
 import Microwave.System.Object;
 import Microwave.Utilities.Sink;
@@ -35,8 +36,12 @@ public:
     ~BoxCollider(){}
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const BoxCollider& source, ObjectCloner& cloner);
+
     void SetExtents(const Vec3& extents);
     Vec3 GetExtents() const;
 
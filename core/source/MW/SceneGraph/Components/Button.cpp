@@ -15,11 +15,25 @@ void Button::ToJson(json& obj) const
     ImageView::ToJson(obj);
 }
 
+void Button::WriteProperties(JsonWriter& writer) const
+{
+    ImageView::WriteProperties(writer);
+}
+
 void Button::FromJson(const json& obj, ObjectLinker* linker)
 {
     ImageView::FromJson(obj, linker);
 }
 
+gptr<Object> Button::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void Button::CloneFrom(const Button& source, ObjectCloner& cloner)
+{
+    ImageView::CloneFrom(source, cloner);
+}
+
 void Button::SetAction(const std::function<void()>& act) {
     action = act;
 }
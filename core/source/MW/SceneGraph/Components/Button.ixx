@@ -8,6 +8,7 @@ import Microwave.SceneGraph.Events;
 import Microwave.SceneGraph.Components.View;
 import Microwave.SceneGraph.Components.ImageView;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import std;
@@ -31,8 +32,12 @@ public:
     void SetAction(const std::function<void()>& act);
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const Button& source, ObjectCloner& cloner);
+
     virtual void OnPointerDown(Vec2 pos, int id) override;
     virtual void OnPointerMove(Vec2 pos, int id) override;
     virtual void OnPointerUp(Vec2 pos, int id) override;
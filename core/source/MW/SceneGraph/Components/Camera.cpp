@@ -7,6 +7,7 @@ import Microwave.Graphics.RenderTarget;
 import Microwave.Graphics.GraphicsContext;
 import Microwave.SceneGraph.LayerMask;
 import Microwave.SceneGraph.Node;
+import Microwave.SceneGraph.Scene;
 import std;
 
 namespace mw {
@@ -101,6 +102,11 @@ const Plane& Camera::GetFrustumPlane(int p) const {
     return _frustumPlanes[p];
 }
 
+const Frustum& Camera::GetFrustum() const {
+    UpdateView();
+    return _frustum;
+}
+
 bool Camera::CanSee(const std::span<Vec3>& vertices) const
 {
     UpdateView();
@@ -141,40 +147,7 @@ bool Camera::CanSee(const Sphere& sphere) const
 bool Camera::CanSee(const AABox& bbox) const
 {
     UpdateView();
-
-    std::array<Vec3, 8> corners;
-    bbox.GetCorners(corners);
-    
-    using std::ranges::all_of;
-
-    for (auto& plane : _frustumPlanes)
-    {
-        if(all_of(corners, [&](auto& c){ return !plane.InFront(c); }))
-            return false;
-    }
-
-    Vec3 vmin = bbox.GetMin();
-    Vec3 vmax = bbox.GetMax();
-    
-    if(all_of(_frustumCorners, [&](auto& c){ return c.x < vmin.x; }))
-        return false;
-
-    if(all_of(_frustumCorners, [&](auto& c){ return c.x > vmax.x; }))
-        return false;
-
-    if(all_of(_frustumCorners, [&](auto& c){ return c.y < vmin.y; }))
-        return false;
-
-    if(all_of(_frustumCorners, [&](auto& c){ return c.y > vmax.y; }))
-        return false;
-
-    if(all_of(_frustumCorners, [&](auto& c){ return c.z < vmin.z; }))
-        return false;
-
-    if(all_of(_frustumCorners, [&](auto& c){ return c.z > vmax.z; }))
-        return false;
-
-    return true;
+    return _frustum.Intersects(bbox);
 }
 
 Ray Camera::ScreenPointToRay(const Vec3& point) const {
@@ -251,6 +224,15 @@ Ray Camera::ScreenPointToRay(float x, float y) const
     return ray;
 }
 
+std::optional<RaycastHit> Camera::RaycastScreenPoint(float x, float y, float maxDistance) const
+{
+    auto scene = GetScene();
+    if (!scene)
+        return std::nullopt;
+
+    return scene->GetPhysics()->Raycast(ScreenPointToRay(x, y), maxDistance, GetCullingMask());
+}
+
 Vec3 Camera::WorldToScreen(const Vec3& position) const
 {
     auto graphics = GraphicsContext::GetCurrent();
@@ -393,6 +375,8 @@ void Camera::UpdateView() const
         _frustumPlanes[FrustumPlane::Bottom] = Plane(farBR, nearBR, nearBL);
         _frustumPlanes[FrustumPlane::Near] = Plane(nearTL, nearBL, nearBR);
         _frustumPlanes[FrustumPlane::Far] = Plane(farTR, farBR, farBL);
+
+        _frustum = Frustum(_frustumPlanes, _frustumCorners);
     }
 
     _dirty = false;
@@ -4,8 +4,10 @@
 
 export module Microwave.SceneGraph.Components.Camera;
 import Microwave.SceneGraph.Components.Component;
+import Microwave.SceneGraph.Culling;
 import Microwave.SceneGraph.Events;
 import Microwave.SceneGraph.LayerMask;
+import Microwave.SceneGraph.PhysicsWorld;
 import Microwave.Math;
 import Microwave.System.Json;
 import Microwave.System.Object;
@@ -77,6 +79,7 @@ public:
     const Mat4& GetViewProjectionMatrix() const;
     const Mat4& GetProjectionMatrix() const;
     const Plane& GetFrustumPlane(int p) const;
+    const Frustum& GetFrustum() const;
 
     bool CanSee(const std::span<Vec3>& vertices) const;
     bool CanSee(const Sphere& sphere) const;
@@ -85,6 +88,9 @@ public:
     Ray ScreenPointToRay(const Vec3& point) const;
     Ray ScreenPointToRay(float x, float y) const;
 
+    // the closest collider under a screen point, on a layer this camera renders
+    std::optional<RaycastHit> RaycastScreenPoint(float x, float y, float maxDistance = MaxQueryDistance) const;
+
     Vec3 WorldToScreen(const Vec3& position) const;
     Vec3 ScreenToWorld(const Vec3& point) const;
 
@@ -110,6 +116,7 @@ protected:
     mutable IntRect _vp;
     mutable std::array<Vec3, 8> _frustumCorners;
     mutable std::array<Plane, 6> _frustumPlanes;
+    mutable Frustum _frustum;
 
     CameraViewMode _mode = CameraViewMode::OrthoFixedHeight;
     LayerMask _cullingMask = LayerMask::All;
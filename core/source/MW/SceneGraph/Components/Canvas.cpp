@@ -25,6 +25,17 @@ void Canvas::ToJson(json& obj) const
     ObjectLinker::SaveLink(obj, "camera", camera.lock());
 }
 
+void Canvas::WriteProperties(JsonWriter& writer) const
+{
+    View::WriteProperties(writer);
+
+    writer.Property("scaleFactor", scaleFactor);
+    writer.Property("referenceSize", referenceSize);
+    writer.Property("fitMode", fitMode);
+
+    ObjectLinker::SaveLink(writer, "camera", camera.lock());
+}
+
 void Canvas::FromJson(const json& obj, ObjectLinker* linker)
 {
     View::FromJson(obj, linker);
@@ -38,6 +49,23 @@ void Canvas::FromJson(const json& obj, ObjectLinker* linker)
     structureDirty = true;
 }
 
+gptr<Object> Canvas::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void Canvas::CloneFrom(const Canvas& source, ObjectCloner& cloner)
+{
+    View::CloneFrom(source, cloner);
+
+    scaleFactor = source.scaleFactor;
+    referenceSize = source.referenceSize;
+    fitMode = source.fitMode;
+
+    cloner.CloneLink(self(this), camera, source.camera.lock());
+
+    structureDirty = true;
+}
+
 Canvas::Canvas() {}
 
 void Canvas::SetScaleFactor(float scale) {
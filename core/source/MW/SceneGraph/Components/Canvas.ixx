@@ -10,6 +10,7 @@ import Microwave.SceneGraph.Components.Component;
 import Microwave.SceneGraph.Components.View;
 import Microwave.SceneGraph.Events;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Pointers;
 import Microwave.System.Window;
 import std;
@@ -54,8 +55,12 @@ protected:
 public:
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const Canvas& source, ObjectCloner& cloner);
+
     Canvas();
 
     void SetScaleFactor(float scale);
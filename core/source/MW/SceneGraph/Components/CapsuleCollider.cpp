@@ -24,6 +24,14 @@ void CapsuleCollider::ToJson(json& obj) const
     obj["height"] = height;
 }
 
+void CapsuleCollider::WriteProperties(JsonWriter& writer) const
+{
+    Collider::WriteProperties(writer);
+    writer.Property("upAxis", upAxis);
+    writer.Property("radius", radius);
+    writer.Property("height", height);
+}
+
 void CapsuleCollider::FromJson(const json& obj, ObjectLinker* linker)
 {
     Collider::FromJson(obj, linker);
@@ -33,6 +41,20 @@ void CapsuleCollider::FromJson(const json& obj, ObjectLinker* linker)
     dirty = true;
 }
 
+gptr<Object> CapsuleCollider::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void CapsuleCollider::CloneFrom(const CapsuleCollider& source, ObjectCloner& cloner)
+{
+    Collider::CloneFrom(source, cloner);
+
+    upAxis = source.upAxis;
+    radius = source.radius;
+    height = source.height;
+    dirty = true;
+}
+
 void CapsuleCollider::SetUpAxis(Axis upAxis)
 {
     this->upAxis = upAxis;
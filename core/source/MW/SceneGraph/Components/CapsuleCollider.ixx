@@ -11,6 +11,7 @@ import Microwave.SceneGraph.Axis;
 import Microwave.SceneGraph.Events;
 import Microwave.SceneGraph.Renderable;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Pointers;
 import Microwave.Utilities.Sink;
 import std;
@@ -44,8 +45,12 @@ public:
     ~CapsuleCollider(){}
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const CapsuleCollider& source, ObjectCloner& cloner);
+
     void SetUpAxis(Axis upAxis);
     Axis GetUpAxis() const;
 
@@ -14,12 +14,24 @@ void Collider::ToJson(json& obj) const
     ObjectLinker::SaveLink(obj, "pivot", pivot.lock());
 }
 
+void Collider::WriteProperties(JsonWriter& writer) const
+{
+    Component::WriteProperties(writer);
+    ObjectLinker::SaveLink(writer, "pivot", pivot.lock());
+}
+
 void Collider::FromJson(const json& obj, ObjectLinker* linker)
 {
     Component::FromJson(obj, linker);
     ObjectLinker::RestoreLink(linker, self(this), pivot, obj, "pivot");
 }
 
+void Collider::CloneFrom(const Collider& source, ObjectCloner& cloner)
+{
+    Component::CloneFrom(source, cloner);
+    cloner.CloneLink(self(this), pivot, source.pivot.lock());
+}
+
 void Collider::SetPivot(const gptr<Node>& pv) {
     pivot = pv;
 }
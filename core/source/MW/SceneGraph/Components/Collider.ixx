@@ -5,6 +5,7 @@
 export module Microwave.SceneGraph.Components.Collider;
 import Microwave.SceneGraph.Components.Component;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 
@@ -23,8 +24,11 @@ public:
     ~Collider(){}
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    void CloneFrom(const Collider& source, ObjectCloner& cloner);
+
     void SetPivot(const gptr<Node>& pivot);
     gptr<Node> GetPivot();
 
@@ -23,12 +23,35 @@ void Component::ToJson(json& obj) const
     obj["enabled"] = enabled;
 }
 
+void Component::WriteJson(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WriteProperties(writer);
+    writer.EndObject();
+}
+
+void Component::WriteProperties(JsonWriter& writer) const
+{
+    WriteObjectJson(writer);
+    writer.Property("enabled", enabled);
+}
+
 void Component::FromJson(const json& obj, ObjectLinker* linker)
 {
     Object::FromJson(obj, linker);
     enabled = obj.value("enabled", enabled);
 }
 
+gptr<Object> Component::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void Component::CloneFrom(const Component& source, ObjectCloner& cloner)
+{
+    Object::CloneFrom(source, cloner);
+    enabled = source.enabled;
+}
+
 bool Component::IsEnabled() const {
     return enabled;
 }
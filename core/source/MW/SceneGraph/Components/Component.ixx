@@ -6,6 +6,7 @@ export module Microwave.SceneGraph.Components.Component;
 import Microwave.SceneGraph.Events;
 import Microwave.System.Clock;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 
@@ -33,8 +34,17 @@ public:
     gptr<const Clock> GetClock() const;
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteJson(JsonWriter& writer) const override;
+
+    // Writes the members saved by ToJson without the braces. Subclasses
+    // chain to their base the same way they do in ToJson, and have to
+    // override this whenever they override ToJson.
+    virtual void WriteProperties(JsonWriter& writer) const;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const Component& source, ObjectCloner& cloner);
+
     virtual void OnAttachedToScene() {}
     virtual void OnDetachFromScene() {}
 
@@ -68,6 +68,44 @@ void D6Joint::ToJson(json& obj) const
     obj["rotationOrder"] = rotationOrder;
 }
 
+void D6Joint::WriteProperties(JsonWriter& writer) const
+{
+    Component::WriteProperties(writer);
+
+    ObjectLinker::SaveLink(writer, "linkBody", linkBody);
+
+    writer.Property("linkOffset", linkOffset);
+    writer.Property("linkPivotOffset", linkPivotOffset);
+
+    writer.Property("linearJointMotionX", linearJointMotion[0]);
+    writer.Property("linearJointMotionY", linearJointMotion[1]);
+    writer.Property("linearJointMotionZ", linearJointMotion[2]);
+
+    writer.Property("angularJointMotionX", angularJointMotion[0]);
+    writer.Property("angularJointMotionY", angularJointMotion[1]);
+    writer.Property("angularJointMotionZ", angularJointMotion[2]);
+
+    writer.Property("linearLowerLimit", linearLowerLimit);
+    writer.Property("linearUpperLimit", linearUpperLimit);
+    writer.Property("angularLowerLimit", angularLowerLimit);
+    writer.Property("angularUpperLimit", angularUpperLimit);
+
+    writer.Property("linearMotorEnabledX", linearMotorEnabled[0]);
+    writer.Property("linearMotorEnabledY", linearMotorEnabled[1]);
+    writer.Property("linearMotorEnabledZ", linearMotorEnabled[2]);
+    writer.Property("angularMotorEnabledX", angularMotorEnabled[0]);
+    writer.Property("angularMotorEnabledY", angularMotorEnabled[1]);
+    writer.Property("angularMotorEnabledZ", angularMotorEnabled[2]);
+
+    writer.Property("linearMotorTargetVelocity", linearMotorTargetVelocity);
+    writer.Property("angularMotorTargetVelocity", angularMotorTargetVelocity);
+
+    writer.Property("linearMotorMaxForce", linearMotorMaxForce);
+    writer.Property("angularMotorMaxForce", angularMotorMaxForce);
+
+    writer.Property("rotationOrder", rotationOrder);
+}
+
 void D6Joint::FromJson(const json& obj, ObjectLinker* linker)
 {
     Component::FromJson(obj, linker);
@@ -109,6 +147,42 @@ void D6Joint::FromJson(const json& obj, ObjectLinker* linker)
     propertiesDirty = true;
 }
 
+gptr<Object> D6Joint::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void D6Joint::CloneFrom(const D6Joint& source, ObjectCloner& cloner)
+{
+    Component::CloneFrom(source, cloner);
+
+    cloner.CloneLink(self(this), linkBody, source.linkBody);
+
+    linkOffset = source.linkOffset;
+    linkPivotOffset = source.linkPivotOffset;
+
+    linearJointMotion = source.linearJointMotion;
+    angularJointMotion = source.angularJointMotion;
+
+    linearLowerLimit = source.linearLowerLimit;
+    linearUpperLimit = source.linearUpperLimit;
+    angularLowerLimit = source.angularLowerLimit;
+    angularUpperLimit = source.angularUpperLimit;
+
+    linearMotorEnabled = source.linearMotorEnabled;
+    angularMotorEnabled = source.angularMotorEnabled;
+
+    linearMotorTargetVelocity = source.linearMotorTargetVelocity;
+    angularMotorTargetVelocity = source.angularMotorTargetVelocity;
+
+    linearMotorMaxForce = source.linearMotorMaxForce;
+    angularMotorMaxForce = source.angularMotorMaxForce;
+
+    rotationOrder = source.rotationOrder;
+
+    structureDirty = true;
+    propertiesDirty = true;
+}
+
 void D6Joint::SetLinkBody(const gptr<RigidBody>& body) {
     linkBody = body;
     structureDirty = true;
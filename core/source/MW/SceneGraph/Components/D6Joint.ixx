@@ -8,6 +8,7 @@ import Microwave.SceneGraph.Axis;
 import Microwave.SceneGraph.Events;
 import Microwave.SceneGraph.Components.Component;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import std;
@@ -82,8 +83,12 @@ public:
     ~D6Joint(){}
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const D6Joint& source, ObjectCloner& cloner);
+
     void SetLinkBody(const gptr<RigidBody>& body);
 
     void SetLinkOffset(const Vec3& offset);
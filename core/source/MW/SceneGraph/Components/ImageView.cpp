@@ -26,6 +26,15 @@ void ImageView::ToJson(json& obj) const
     ObjectLinker::SaveAsset(obj, "tex", tex);
 }
 
+void ImageView::WriteProperties(JsonWriter& writer) const
+{
+    View::WriteProperties(writer);
+
+    writer.Property("border", border);
+    writer.Property("color", color);
+    ObjectLinker::SaveAsset(writer, "tex", tex);
+}
+
 void ImageView::FromJson(const json& obj, ObjectLinker* linker)
 {
     View::FromJson(obj, linker);
@@ -37,6 +46,21 @@ void ImageView::FromJson(const json& obj, ObjectLinker* linker)
     meshDirty = true;
 }
 
+gptr<Object> ImageView::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void ImageView::CloneFrom(const ImageView& source, ObjectCloner& cloner)
+{
+    View::CloneFrom(source, cloner);
+
+    border = source.border;
+    color = source.color;
+    tex = source.tex;
+
+    meshDirty = true;
+}
+
 void ImageView::Construct()
 {
     auto assetLib = App::Get()->GetAssetLibrary();
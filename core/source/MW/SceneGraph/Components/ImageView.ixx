@@ -13,6 +13,7 @@ import Microwave.SceneGraph.Components.View;
 import Microwave.SceneGraph.Events;
 import Microwave.SceneGraph.Renderable;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import Microwave.Utilities.Sink;
@@ -41,8 +42,12 @@ protected:
 public:
     
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const ImageView& source, ObjectCloner& cloner);
+
     ImageView(){ Construct(); }
 
     void SetBorder(const Box& box);
@@ -19,19 +19,67 @@ inline namespace scene {
 void MeshCollider::ToJson(json& obj) const
 {
     Collider::ToJson(obj);
-    obj["mesh"] = mesh;
+
+    if (meshIsAsset)
+        ObjectLinker::SaveAsset(obj, "mesh", mesh);
+    else
+        obj["mesh"] = mesh;
+
+    obj["convex"] = convex;
+}
+
+void MeshCollider::WriteProperties(JsonWriter& writer) const
+{
+    Collider::WriteProperties(writer);
+
+    if (meshIsAsset) {
+        ObjectLinker::SaveAsset(writer, "mesh", mesh);
+    }
+    else {
+        writer.Key("mesh");
+        if (mesh)
+            mesh->WriteJson(writer);
+        else
+            writer.Null();
+    }
+
+    writer.Property("convex", convex);
 }
 
 void MeshCollider::FromJson(const json& obj, ObjectLinker* linker)
 {
     Collider::FromJson(obj, linker);
-    mesh = obj.value("mesh", mesh);
+
+    // meshes that aren't assets are stored in the collider
+    auto it = obj.find("mesh");
+    meshIsAsset = it != obj.end() && !it->IsObject() && !it->IsNull();
+
+    if (meshIsAsset)
+        ObjectLinker::RestoreAsset(linker, self(this), mesh, obj, "mesh");
+    else
+        mesh = obj.value("mesh", mesh);
+
+    convex = obj.value("convex", convex);
+    dirty = true;
+}
+
+gptr<Object> MeshCollider::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void MeshCollider::CloneFrom(const MeshCollider& source, ObjectCloner& cloner)
+{
+    Collider::CloneFrom(source, cloner);
+    mesh = source.mesh;
+    meshIsAsset = source.meshIsAsset;
+    convex = source.convex;
     dirty = true;
 }
 
-void MeshCollider::SetMesh(const gptr<Mesh>& mesh)
+void MeshCollider::SetMesh(const gptr<Mesh>& mesh, bool isAsset)
 {
     this->mesh = mesh;
+    this->meshIsAsset = isAsset;
     dirty = true;
 }
 
@@ -39,6 +87,16 @@ gptr<Mesh> MeshCollider::GetMesh() const {
     return mesh;
 }
 
+void MeshCollider::SetConvex(bool convex)
+{
+    this->convex = convex;
+    dirty = true;
+}
+
+bool MeshCollider::IsConvex() const {
+    return convex;
+}
+
 void MeshCollider::UpdateGizmo()
 {
     auto assetLib = App::Get()->GetAssetLibrary();
@@ -10,6 +10,7 @@ import Microwave.SceneGraph.Components.Collider;
 import Microwave.SceneGraph.Events;
 import Microwave.SceneGraph.Renderable;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import Microwave.Utilities.Sink;
@@ -24,6 +25,8 @@ class MeshCollider : public Collider, public IRenderEvents
     inline static Type::Pin<MeshCollider> pin;
 
     gptr<Mesh> mesh;
+    bool meshIsAsset = false;
+    bool convex = true;
     gptr<Material> gizmoMat;
     gptr<Renderable> renderable;
 
@@ -34,11 +37,23 @@ public:
     ~MeshCollider(){}
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
-    void SetMesh(const gptr<Mesh>& mesh);
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const MeshCollider& source, ObjectCloner& cloner);
+
+    // Meshes are saved inline with the collider, unless 'isAsset' is set,
+    // in which case only their UUID is saved and they're loaded from the
+    // asset library, like the collision meshes of imported models.
+    void SetMesh(const gptr<Mesh>& mesh, bool isAsset = false);
     gptr<Mesh> GetMesh() const;
 
+    // Concave colliders collide with the mesh's triangles instead of its
+    // convex hull. Only static bodies can be concave - others use the hull.
+    void SetConvex(bool convex);
+    bool IsConvex() const;
+
     void UpdateGizmo();
 
     virtual void GetRenderables(Sink<gptr<Renderable>> sink) override;
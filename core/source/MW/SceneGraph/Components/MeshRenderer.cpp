@@ -3,13 +3,17 @@
 *--------------------------------------------------------------*/
 
 module Microwave.SceneGraph.Components.MeshRenderer;
+import Microwave.Graphics.Buffer;
+import Microwave.Graphics.Internal.HWBuffer;
 import Microwave.Graphics.Mesh;
 import Microwave.Graphics.Shader;
 import Microwave.Graphics.ShaderInfo;
+import Microwave.Graphics.Skinning;
 import Microwave.Math;
 import Microwave.SceneGraph.Node;
 import Microwave.SceneGraph.Renderable;
 import Microwave.System.Exception;
+import Microwave.System.JobSystem;
 import Microwave.System.Pointers;
 import std;
 import <MW/System/Debug.h>;
@@ -17,6 +21,12 @@ import <MW/System/Debug.h>;
 namespace mw {
 inline namespace scene {
 
+// vertices skinned by a single job
+constexpr std::size_t SkinChunkSize = 2048;
+
+// vertices needed before skinning goes wide
+constexpr std::size_t ParallelSkinThreshold = 8192;
+
 AABox MeshRenderer::GetBounds() const
 {
     AABox ret;
@@ -29,88 +39,95 @@ AABox MeshRenderer::GetBounds() const
     return ret;
 }
 
-void MeshRenderer::SystemLateUpdate()
+void MeshRenderer::BindBones(const gptr<Node>& rootBone)
 {
-    if (!mesh || mesh->skinType == SkinType::None)
-        return;
-
-    auto rootBone = this->rootBone.lock();
-    if (!rootBone)
-        return;
-
     std::size_t boneCount = mesh->bones.size();
     std::size_t vertCount = mesh->vertices.size();
 
+    boneNodes.resize(boneCount);
+    bindMatrices.resize(boneCount);
+
+    for (std::size_t i = 0; i < boneCount; ++i)
+    {
+        auto& bone = mesh->bones[i];
+        boneNodes[i] = rootBone->GetChild(bone.linkNodePath);
+        bindMatrices[i] = bone.meshBindMatrix * bone.invBoneBindMatrix;
+    }
+
     boneMatrices.resize(boneCount);
+    boneDualQuats.resize(mesh->skinType == SkinType::DualQuaternion ? boneCount : 0);
     blendedVerts.resize(vertCount);
-    blendedNorms.resize(vertCount);
+    blendedNorms.resize(mesh->normals.empty() ? 0 : vertCount);
 
-    auto node = GetNode();
+    // the bind pose until the first update
+    auto MakeBuffer = [](std::vector<Vec3>& data) {
+        return data.empty() ? gptr<Buffer>() : gpnew<Buffer>(
+            BufferType::Vertex, BufferUsage::Dynamic, BufferCPUAccess::WriteOnly,
+            std::as_writable_bytes(std::span(data)));
+    };
 
-    // calculate all bone matrices
-    for (std::uint32_t i = 0; i < mesh->bones.size(); ++i)
+    if (skinnedMesh != mesh)
     {
-        auto linkNode = rootBone->GetChild(mesh->bones[i].linkNodePath);
-
-        boneMatrices[i] =
-            mesh->bones[i].meshBindMatrix *     // mesh bind matrix
-            mesh->bones[i].invBoneBindMatrix *  // bone inverse bind matrix
-            linkNode->GetLocalToWorldMatrix() * // bone current matrix
-            node->GetWorldToLocalMatrix();  // mesh current inverse matrix
+        skinnedVertexBuffer = MakeBuffer(mesh->vertices);
+        skinnedNormalBuffer = MakeBuffer(mesh->normals);
     }
 
-    BoneLinkMode mode = mesh->bones[0].linkMode;
+    skinnedMesh = mesh;
+    skinnedRootBone = rootBone;
+    bonesDirty = false;
+}
+
+void MeshRenderer::SystemLateUpdate()
+{
+    if (!mesh || mesh->skinType == SkinType::None || mesh->bones.empty())
+        return;
+
+    auto rootBone = this->rootBone.lock();
+    if (!rootBone)
+        return;
 
-    // transform all vertices
-    int nVerts = (int)mesh->vertices.size();
+    if (bonesDirty || skinnedMesh != mesh || skinnedRootBone.lock() != rootBone)
+        BindBones(rootBone);
 
-    std::uint32_t maxBoneCount = 4; // 1-4
+    Mat4 worldToLocal = GetNode()->GetWorldToLocalMatrix();
 
-    for (int i = 0; i < nVerts; ++i)
+    // bind pose mesh space -> bone space -> world space -> current mesh space.
+    // Bones missing from the hierarchy keep their vertices in the bind pose.
+    for (std::size_t i = 0; i < boneMatrices.size(); ++i)
     {
-        Mat4 deformation = (mode == BoneLinkMode::Additive) ? Mat4::Identity() : Mat4::Zero();
-        float totalWeight = 0;
-
-        for (std::uint32_t b = 0; b < maxBoneCount; ++b)
-        {
-            float weight = mesh->boneWeights[i][b];
-            Mat4 influence = boneMatrices[mesh->boneIndices[i][b]] * weight;
-
-            if (mode == BoneLinkMode::Additive)
-            {
-                float inv_weight = 1.0f - weight;
-                influence.m11 += inv_weight;
-                influence.m22 += inv_weight;
-                influence.m33 += inv_weight;
-                influence.m44 += inv_weight;
-
-                deformation = influence * deformation;
-                totalWeight = 1.0f;
-            }
-            else // link_mode::normalize or link_mode::total_one
-            {
-                deformation += influence;
-                totalWeight += weight;
-            }
-        }
-
-        blendedVerts[i] = Vec4(mesh->vertices[i], 1.0f) * deformation;
-        blendedNorms[i] = Vec4(mesh->normals[i], 0.0f) * deformation;
-
-        if (mode == BoneLinkMode::Normalize)
-        {
-            blendedVerts[i] /= totalWeight;
-            blendedNorms[i] /= totalWeight;
-        }
-        else if (mode == BoneLinkMode::TotalOne)
-        {
-            blendedVerts[i] *= (1.0f - totalWeight);
-            blendedNorms[i] *= (1.0f - totalWeight);
-        }
+        auto bone = boneNodes[i].lock();
+        boneMatrices[i] = bone
+            ? bindMatrices[i] * bone->GetLocalToWorldMatrix() * worldToLocal
+            : Mat4::Identity();
     }
 
-    mesh->vertexBuffer->UpdateSubData(0, std::span<std::byte>((std::byte*)blendedVerts.data(), blendedVerts.size() * sizeof(Vec3)));
-    mesh->normalBuffer->UpdateSubData(0, std::span<std::byte>((std::byte*)blendedNorms.data(), blendedNorms.size() * sizeof(Vec3)));
+    for (std::size_t i = 0; i < boneDualQuats.size(); ++i)
+        boneDualQuats[i] = DualQuatBone(boneMatrices[i]);
+
+    auto skin = [&](std::size_t first, std::size_t last)
+    {
+        if (!boneDualQuats.empty())
+            SkinDualQuaternion(*mesh, boneDualQuats, first, last, blendedVerts, blendedNorms);
+        else
+            SkinLinear(*mesh, boneMatrices, first, last, blendedVerts, blendedNorms);
+    };
+
+    std::size_t vertCount = blendedVerts.size();
+
+    if (vertCount < ParallelSkinThreshold)
+        skin(0, vertCount);
+    else
+        JobSystem::GetInstance().ParallelFor(vertCount, SkinChunkSize, skin);
+
+    if (skinnedVertexBuffer)
+        skinnedVertexBuffer->UpdateSubData(0, std::as_writable_bytes(std::span(blendedVerts)));
+
+    if (skinnedNormalBuffer)
+        skinnedNormalBuffer->UpdateSubData(0, std::as_writable_bytes(std::span(blendedNorms)));
+}
+
+void MeshRenderer::OnStructureChanged() {
+    bonesDirty = true;
 }
 
 void MeshRenderer::ToJson(json& obj) const
@@ -131,6 +148,21 @@ void MeshRenderer::ToJson(json& obj) const
     ObjectLinker::SaveLink(obj, "rootBone", rootBone.lock());
 }
 
+void MeshRenderer::WriteProperties(JsonWriter& writer) const
+{
+    Component::WriteProperties(writer);
+
+    ObjectLinker::SaveAsset(writer, "mesh", mesh);
+
+    writer.Key("materials");
+    writer.BeginArray();
+    for (auto& mat : materials)
+        ObjectLinker::SaveAsset(writer, mat);
+    writer.EndArray();
+
+    ObjectLinker::SaveLink(writer, "rootBone", rootBone.lock());
+}
+
 void MeshRenderer::FromJson(const json& obj, ObjectLinker* linker)
 {
     Component::FromJson(obj, linker);
@@ -151,6 +183,19 @@ void MeshRenderer::FromJson(const json& obj, ObjectLinker* linker)
     ObjectLinker::RestoreLink(linker, self(this), rootBone, obj, "rootBone");
 }
 
+gptr<Object> MeshRenderer::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void MeshRenderer::CloneFrom(const MeshRenderer& source, ObjectCloner& cloner)
+{
+    Component::CloneFrom(source, cloner);
+
+    mesh = source.mesh;
+    materials = source.materials;
+    cloner.CloneLink(self(this), rootBone, source.rootBone.lock());
+}
+
 void MeshRenderer::GetRenderables(Sink<gptr<Renderable>> sink)
 {
     if (!mesh)
@@ -164,6 +209,11 @@ void MeshRenderer::GetRenderables(Sink<gptr<Renderable>> sink)
 
     auto bounds = mesh->bbox.Transform(mtxModel);
 
+    // skinned buffers belong to the mesh they were made for
+    bool skinned = skinnedMesh == mesh && skinnedVertexBuffer;
+    auto& vertexBuffer = skinned ? skinnedVertexBuffer : mesh->vertexBuffer;
+    auto& normalBuffer = skinned ? skinnedNormalBuffer : mesh->normalBuffer;
+
     renderables.resize(mesh->elements.size());
 
     for (int i = 0; i != mesh->elements.size(); ++i)
@@ -180,8 +230,8 @@ void MeshRenderer::GetRenderables(Sink<gptr<Renderable>> sink)
         gptr<Renderable> renderable = renderables[i];
 
         renderable->vertexMapping = {
-            { Semantic::POSITION, 0, mesh->vertexBuffer, 0, sizeof(Vec3) },
-            { Semantic::NORMAL, 0, mesh->normalBuffer, 0, sizeof(Vec3) },
+            { Semantic::POSITION, 0, vertexBuffer, 0, sizeof(Vec3) },
+            { Semantic::NORMAL, 0, normalBuffer, 0, sizeof(Vec3) },
             { Semantic::TEXCOORD, 0, mesh->texcoordBuffer, 0, sizeof(Vec2) }
         };
 
@@ -189,7 +239,7 @@ void MeshRenderer::GetRenderables(Sink<gptr<Renderable>> sink)
         renderable->material = mat;
         renderable->mtxModel = mtxModel;
         renderable->bounds = bounds;
-        renderable->extra.SetUniform("uMtxNormal", mtxNormal);
+        renderable->extra.SetUniform(UniformNames::MtxNormal, mtxNormal);
         renderable->indexBuffer = elem.indexBuffer;
         renderable->drawStart = 0;
         renderable->drawCount = elem.indices.size();
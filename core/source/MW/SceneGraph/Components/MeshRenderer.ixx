@@ -3,13 +3,16 @@
 *--------------------------------------------------------------*/
 
 export module Microwave.SceneGraph.Components.MeshRenderer;
+import Microwave.Graphics.Buffer;
 import Microwave.Graphics.Material;
 import Microwave.Graphics.Mesh;
+import Microwave.Graphics.Skinning;
 import Microwave.Math;
 import Microwave.SceneGraph.Components.Component;
 import Microwave.SceneGraph.Events;
 import Microwave.SceneGraph.Renderable;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import Microwave.Utilities.Sink;
@@ -38,15 +41,36 @@ public:
     AABox GetBounds() const;
 
     virtual void SystemLateUpdate() override;
+    virtual void OnStructureChanged() override;
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const MeshRenderer& source, ObjectCloner& cloner);
+
     virtual void GetRenderables(Sink<gptr<Renderable>> sink) override;
 private:
+    // Bone nodes are looked up once, and again when the mesh, root bone or
+    // hierarchy changes. They're weak, so a renderer doesn't keep bones
+    // alive after they're removed from the hierarchy. Skinned vertices go
+    // to buffers owned by this renderer, so instances sharing a mesh don't
+    // overwrite each other.
+    gptr<Mesh> skinnedMesh;
+    wgptr<Node> skinnedRootBone;
+    gvector<wgptr<Node>> boneNodes;
+    std::vector<Mat4> bindMatrices;
+    bool bonesDirty = true;
+
     std::vector<Mat4> boneMatrices;
+    std::vector<DualQuatBone> boneDualQuats;
     std::vector<Vec3> blendedVerts;
     std::vector<Vec3> blendedNorms;
+    gptr<Buffer> skinnedVertexBuffer;
+    gptr<Buffer> skinnedNormalBuffer;
+
+    void BindBones(const gptr<Node>& rootBone);
 
     gvector<gptr<Renderable>> renderables;
 };
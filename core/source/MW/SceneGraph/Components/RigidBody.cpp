@@ -39,16 +39,16 @@ void RigidBodyMotionState::getWorldTransform(btTransform& worldTrans) const
 
 void RigidBodyMotionState::setWorldTransform(const btTransform& worldTrans)
 {
-    auto node = pBody->GetNode();
-    Assert(node);
+    simulatedTransform = worldTrans;
 
-    Vec3 pos = Bullet::ToVec3(worldTrans.getOrigin());
-    Quat rot = Bullet::ToQuat(worldTrans.getRotation());
-    pos -= (pBody->localCenterOfMass * rot);
+    if (!moved)
+    {
+        auto world = pBody->world.lock();
+        Assert(world);
 
-    node->SetPosition(pos);
-    node->SetRotation(rot);
-    pBody->transformDirty = false;
+        world->movedBodies.push_back(pBody);
+        moved = true;
+    }
 }
 
 void RigidBody::Construct()
@@ -87,6 +87,26 @@ void RigidBody::ToJson(json& obj) const
     obj["restitution"] = restitution;
     obj["linearDamping"] = linearDamping;
     obj["angularDamping"] = angularDamping;
+
+    if (collisionMask)
+        obj["collisionMask"] = *collisionMask;
+}
+
+void RigidBody::WriteProperties(JsonWriter& writer) const
+{
+    Component::WriteProperties(writer);
+
+    writer.Property("bodyType", bodyType);
+    writer.Property("mass", mass);
+    writer.Property("friction", friction);
+    writer.Property("rollingFriction", rollingFriction);
+    writer.Property("spinningFriction", spinningFriction);
+    writer.Property("restitution", restitution);
+    writer.Property("linearDamping", linearDamping);
+    writer.Property("angularDamping", angularDamping);
+
+    if (collisionMask)
+        writer.Property("collisionMask", *collisionMask);
 }
 
 void RigidBody::FromJson(const json& obj, ObjectLinker* linker)
@@ -101,16 +121,44 @@ void RigidBody::FromJson(const json& obj, ObjectLinker* linker)
     restitution = obj.value("restitution", restitution);
     linearDamping = obj.value("linearDamping", linearDamping);
     angularDamping = obj.value("angularDamping", angularDamping);
+
+    if (auto it = obj.find("collisionMask"); it != obj.end())
+        collisionMask = it->get<LayerMask>();
+    else
+        collisionMask.reset();
     
     structureDirty = true;
     transformDirty = true;
 }
 
+gptr<Object> RigidBody::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void RigidBody::CloneFrom(const RigidBody& source, ObjectCloner& cloner)
+{
+    Component::CloneFrom(source, cloner);
+
+    bodyType = source.bodyType;
+    mass = source.mass;
+    friction = source.friction;
+    rollingFriction = source.rollingFriction;
+    spinningFriction = source.spinningFriction;
+    restitution = source.restitution;
+    linearDamping = source.linearDamping;
+    angularDamping = source.angularDamping;
+    collisionMask = source.collisionMask;
+
+    structureDirty = true;
+    transformDirty = true;
+}
+
 void RigidBody::ClearCollisionShape()
 {
     body->setCollisionShape(nullptr);
     shape.reset();
     childShapes.clear();
+    meshShapes.clear();
     colliders.clear();
 }
 
@@ -160,17 +208,19 @@ void RigidBody::RebuildCollisionShape()
         }
         else if (auto c = dynamic_cast<MeshCollider*>(collider.get()))
         {
-            auto meshShape = upnew<btConvexHullShape>();
-            
             if (auto mesh = c->GetMesh())
             {
-                for (auto& v : mesh->vertices)
-                    meshShape->addPoint(Bullet::FromVec3(v), false);
-                
-                meshShape->recalcLocalAabb();
-            }
+                // moving bodies can't collide with triangle meshes
+                bool convex = c->IsConvex() || bodyType != BodyType::Static;
 
-            childShape = std::move(meshShape);
+                auto meshShape = CollisionShapeCache::GetInstance().GetMeshShape(mesh, convex);
+                childShape = meshShape->CreateInstance();
+                meshShapes.push_back(std::move(meshShape));
+            }
+            else
+            {
+                childShape = upnew<btConvexHullShape>();
+            }
         }
         else if (auto c = dynamic_cast<SphereCollider*>(collider.get()))
         {
@@ -339,6 +389,13 @@ void RigidBody::SystemUpdate1()
     UpdateStructure();
     UpdateChildTransforms();
     UpdateTransform();
+
+    // nodes don't report layer changes, so check for them here
+    if (GetNode()->GetLayerMask() != filterLayers)
+    {
+        if (auto w = world.lock())
+            w->UpdateFilter(this);
+    }
 }
 
 void RigidBody::OnAttachedToScene() {
@@ -382,8 +439,31 @@ void RigidBody::OnTransformChanged() {
     transformDirty = true;
 }
 
-void RigidBody::OnStructureChanged() {
+void RigidBody::OnStructureChanged()
+{
     structureDirty = true;
+
+    // the handlers may be about to be destroyed
+    collisionHandlers.clear();
+    handlersDirty = true;
+}
+
+std::vector<ICollisionEvents*>& RigidBody::GetCollisionHandlers()
+{
+    if (handlersDirty)
+    {
+        collisionHandlers.clear();
+
+        for (auto& c : GetNode()->GetComponents())
+        {
+            if (auto h = dynamic_cast<ICollisionEvents*>(c.get()))
+                collisionHandlers.push_back(h);
+        }
+
+        handlersDirty = false;
+    }
+
+    return collisionHandlers;
 }
 
 float RigidBody::GetMass() const {
@@ -405,6 +485,18 @@ void RigidBody::SetBodyType(BodyType type) {
     structureDirty = true;
 }
 
+std::optional<LayerMask> RigidBody::GetCollisionMask() const {
+    return collisionMask;
+}
+
+void RigidBody::SetCollisionMask(std::optional<LayerMask> mask)
+{
+    collisionMask = mask;
+
+    if (auto w = world.lock())
+        w->UpdateFilter(this);
+}
+
 Vec3 RigidBody::GetLinearFactor() const {
     const auto& factor = body->getLinearFactor();
     return { factor.x(), factor.y(), factor.z() };
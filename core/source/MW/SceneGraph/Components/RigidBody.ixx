@@ -7,7 +7,10 @@ import Microwave.Math;
 import Microwave.SceneGraph.Components.Component;
 import Microwave.SceneGraph.Components.Collider;
 import Microwave.SceneGraph.Events;
+import Microwave.SceneGraph.Internal.CollisionShapes;
+import Microwave.SceneGraph.LayerMask;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import std;
@@ -45,11 +48,18 @@ class RigidBody : public Component
     uptr<RigidBodyMotionState> motionState;
     uptr<btRigidBody> body;
     uptr<btCompoundShape> shape;
+    std::vector<sptr<MeshShape>> meshShapes;
     std::vector<uptr<btCollisionShape>> childShapes;
     gvector<gptr<Collider>> colliders;
     bool structureDirty = true;
     bool transformDirty = true;
 
+    std::vector<ICollisionEvents*> collisionHandlers;
+    bool handlersDirty = true;
+
+    std::optional<LayerMask> collisionMask;
+    LayerMask filterLayers = LayerMask::None;  // the node's layers when last filtered
+
     BodyType bodyType = BodyType::Dynamic;
     float mass = 1.0f;
     float friction = 0.5f;
@@ -74,14 +84,23 @@ public:
     virtual ~RigidBody() { Destruct(); }
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const RigidBody& source, ObjectCloner& cloner);
+
     float GetMass() const;
     void SetMass(float mass);
 
     BodyType GetBodyType() const;
     void SetBodyType(BodyType type);
 
+    // The layers this body collides with, instead of those the world's
+    // layer matrix gives its node's layers. nullopt uses the matrix again.
+    std::optional<LayerMask> GetCollisionMask() const;
+    void SetCollisionMask(std::optional<LayerMask> mask);
+
     Vec3 GetLinearFactor() const;
     void SetLinearFactor(const Vec3& factors);
 
@@ -140,11 +159,21 @@ private:
 
     // average of all collider pivots in world space
     Vec3 CalcShapeCenter();
+
+    // the node's components that handle collision events, found again
+    // after components are added or removed
+    std::vector<ICollisionEvents*>& GetCollisionHandlers();
 };
 
+// Bullet reports bodies that moved here during a step, and the world
+// writes them to their nodes together once it's done.
 class RigidBodyMotionState : public btMotionState
 {
     RigidBody* pBody;
+    btTransform simulatedTransform;
+    bool moved = false;
+
+    friend PhysicsWorld;
 public:
     RigidBodyMotionState(RigidBody* pBody);
     virtual void getWorldTransform(btTransform& worldTrans) const override;
@@ -22,6 +22,12 @@ void SphereCollider::ToJson(json& obj) const
     obj["radius"] = radius;
 }
 
+void SphereCollider::WriteProperties(JsonWriter& writer) const
+{
+    Collider::WriteProperties(writer);
+    writer.Property("radius", radius);
+}
+
 void SphereCollider::FromJson(const json& obj, ObjectLinker* linker)
 {
     Collider::FromJson(obj, linker);
@@ -29,6 +35,17 @@ void SphereCollider::FromJson(const json& obj, ObjectLinker* linker)
     dirty = true;
 }
 
+gptr<Object> SphereCollider::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void SphereCollider::CloneFrom(const SphereCollider& source, ObjectCloner& cloner)
+{
+    Collider::CloneFrom(source, cloner);
+    radius = source.radius;
+    dirty = true;
+}
+
 void SphereCollider::SetRadius(float radius)
 {
     this->radius = radius;
@@ -10,6 +10,7 @@ import Microwave.SceneGraph.Events;
 import Microwave.SceneGraph.Renderable;
 import Microwave.SceneGraph.Components.Collider;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import Microwave.Utilities.Sink;
@@ -36,8 +37,12 @@ public:
     ~SphereCollider(){}
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const SphereCollider& source, ObjectCloner& cloner);
+
     void SetRadius(float radius);
     float GetRadius() const;
 
@@ -29,6 +29,18 @@ void TextView::ToJson(json& obj) const
     obj["text"] = text;
 }
 
+void TextView::WriteProperties(JsonWriter& writer) const
+{
+    View::WriteProperties(writer);
+
+    ObjectLinker::SaveAsset(writer, "font", font);
+    writer.Property("fontSize", fontSize);
+    writer.Property("wrapping", wrapping);
+    writer.Property("alignment", alignment);
+    writer.Property("lineSpacing", lineSpacing);
+    writer.Property("text", text);
+}
+
 void TextView::FromJson(const json& obj, ObjectLinker* linker)
 {
     View::FromJson(obj, linker);
@@ -44,6 +56,24 @@ void TextView::FromJson(const json& obj, ObjectLinker* linker)
     textDirty = true;
 }
 
+gptr<Object> TextView::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void TextView::CloneFrom(const TextView& source, ObjectCloner& cloner)
+{
+    View::CloneFrom(source, cloner);
+
+    font = source.font;
+    fontSize = source.fontSize;
+    wrapping = source.wrapping;
+    alignment = source.alignment;
+    lineSpacing = source.lineSpacing;
+    text = source.text;
+
+    textDirty = true;
+}
+
 void TextView::Construct()
 {
     vertexBuffer = gpnew<Buffer>(
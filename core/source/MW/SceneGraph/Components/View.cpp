@@ -18,6 +18,16 @@ void View::ToJson(json& obj) const
     obj["renderDepth"] = renderDepth;
 }
 
+void View::WriteProperties(JsonWriter& writer) const
+{
+    Component::WriteProperties(writer);
+    writer.Property("size", size);
+    writer.Property("anchorEnabled", anchorEnabled);
+    writer.Property("anchorBox", anchorBox);
+    writer.Property("offsetBox", offsetBox);
+    writer.Property("renderDepth", renderDepth);
+}
+
 void View::FromJson(const json& obj, ObjectLinker* linker)
 {
     Component::FromJson(obj, linker);
@@ -28,6 +38,21 @@ void View::FromJson(const json& obj, ObjectLinker* linker)
     renderDepth = obj.value("renderDepth", renderDepth);
 }
 
+gptr<Object> View::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void View::CloneFrom(const View& source, ObjectCloner& cloner)
+{
+    Component::CloneFrom(source, cloner);
+
+    size = source.size;
+    anchorEnabled = source.anchorEnabled;
+    anchorBox = source.anchorBox;
+    offsetBox = source.offsetBox;
+    renderDepth = source.renderDepth;
+}
+
 void View::SetAnchorEnabled(bool enabled) {
     anchorEnabled = enabled;
 }
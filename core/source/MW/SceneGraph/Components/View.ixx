@@ -8,6 +8,7 @@ import Microwave.Math;
 import Microwave.SceneGraph.Components.Component;
 import Microwave.SceneGraph.Events;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 
 export namespace mw {
@@ -28,8 +29,12 @@ protected:
     friend Canvas;
 public:
     virtual void ToJson(json& obj) const override;
+    virtual void WriteProperties(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const View& source, ObjectCloner& cloner);
+
     void SetRenderDepth(int depth) { renderDepth = depth; }
     int GetRenderDepth() const { return renderDepth; }
 
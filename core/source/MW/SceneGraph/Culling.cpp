@@ -0,0 +1,261 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#  include <xmmintrin.h>
+#  define MW_CULLING_SSE 1
+#endif
+
+module Microwave.SceneGraph.Culling;
+import std;
+
+namespace mw {
+inline namespace scene {
+
+// below this many lights, scanning them all is faster than the grid
+constexpr std::size_t MinGridLights = 8;
+
+static float GetAxis(const Vec3& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+Frustum::Frustum(const std::array<Plane, 6>& planes, const std::array<Vec3, 8>& corners)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        auto& plane = planes[i < 6 ? i : 0];
+        nx[i] = plane.a;
+        ny[i] = plane.b;
+        nz[i] = plane.c;
+        nd[i] = plane.d;
+    }
+
+    cornerMin = corners[0];
+    cornerMax = corners[0];
+
+    for (auto& c : corners)
+    {
+        cornerMin = Vec3(std::min(cornerMin.x, c.x), std::min(cornerMin.y, c.y), std::min(cornerMin.z, c.z));
+        cornerMax = Vec3(std::max(cornerMax.x, c.x), std::max(cornerMax.y, c.y), std::max(cornerMax.z, c.z));
+    }
+}
+
+bool Frustum::Intersects(const AABox& box) const
+{
+    const Vec3& c = box.center;
+    const Vec3& e = box.extents;
+
+    // The corner furthest along a plane's normal is at the center plus the
+    // extents projected onto the normal's absolute value. The box is
+    // outside if even that corner is behind the plane.
+#if MW_CULLING_SSE
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 cx = _mm_set1_ps(c.x);
+    __m128 cy = _mm_set1_ps(c.y);
+    __m128 cz = _mm_set1_ps(c.z);
+    __m128 ex = _mm_set1_ps(e.x);
+    __m128 ey = _mm_set1_ps(e.y);
+    __m128 ez = _mm_set1_ps(e.z);
+
+    for (int i = 0; i < 8; i += 4)
+    {
+        __m128 px = _mm_load_ps(nx + i);
+        __m128 py = _mm_load_ps(ny + i);
+        __m128 pz = _mm_load_ps(nz + i);
+        __m128 pd = _mm_load_ps(nd + i);
+
+        __m128 dist = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)),
+            _mm_add_ps(_mm_mul_ps(pz, cz), pd));
+
+        __m128 radius = _mm_add_ps(
+            _mm_add_ps(
+                _mm_mul_ps(_mm_andnot_ps(signMask, px), ex),
+                _mm_mul_ps(_mm_andnot_ps(signMask, py), ey)),
+            _mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+
+        if (_mm_movemask_ps(_mm_cmple_ps(_mm_add_ps(dist, radius), zero)) != 0)
+            return false;
+    }
+#else
+    for (int i = 0; i < 6; ++i)
+    {
+        float dist = nx[i] * c.x + ny[i] * c.y + nz[i] * c.z + nd[i];
+        float radius = std::abs(nx[i]) * e.x + std::abs(ny[i]) * e.y + std::abs(nz[i]) * e.z;
+
+        if (dist + radius <= 0.0f)
+            return false;
+    }
+#endif
+
+    Vec3 vmin = c - e;
+    Vec3 vmax = c + e;
+
+    return
+        cornerMax.x >= vmin.x && cornerMin.x <= vmax.x &&
+        cornerMax.y >= vmin.y && cornerMin.y <= vmax.y &&
+        cornerMax.z >= vmin.z && cornerMin.z <= vmax.z;
+}
+
+void LightGrid::Build(std::span<const Vec3> positions, std::span<const std::uint32_t> masks)
+{
+    this->positions.assign(positions.begin(), positions.end());
+    this->masks.assign(masks.begin(), masks.end());
+
+    cellStarts.clear();
+    cellLights.clear();
+    dims = { 0, 0, 0 };
+
+    auto count = positions.size();
+    if (count < MinGridLights)
+        return;
+
+    Vec3 vmin = positions[0];
+    Vec3 vmax = positions[0];
+
+    for (auto& p : positions)
+    {
+        vmin = Vec3(std::min(vmin.x, p.x), std::min(vmin.y, p.y), std::min(vmin.z, p.z));
+        vmax = Vec3(std::max(vmax.x, p.x), std::max(vmax.y, p.y), std::max(vmax.z, p.z));
+    }
+
+    // cubic cells, about one light per cell along the longest axis
+    Vec3 size = vmax - vmin;
+    float longest = std::max({ size.x, size.y, size.z });
+    int cellsAlongLongest = std::max(1, (int)std::ceil(std::cbrt((float)count)));
+
+    origin = vmin;
+    cellSize = longest > 0.0f ? longest / cellsAlongLongest : 1.0f;
+
+    for (int axis = 0; axis < 3; ++axis)
+        dims[axis] = std::min(cellsAlongLongest, (int)(GetAxis(size, axis) / cellSize) + 1);
+
+    auto cellCount = (std::size_t)dims[0] * dims[1] * dims[2];
+    cellStarts.assign(cellCount + 1, 0);
+    cellLights.resize(count);
+
+    auto cellOf = [&](const Vec3& p) {
+        return ((std::size_t)GetCell(p.z, 2) * dims[1] + GetCell(p.y, 1)) * dims[0] + GetCell(p.x, 0);
+    };
+
+    for (auto& p : positions)
+        ++cellStarts[cellOf(p) + 1];
+
+    for (std::size_t i = 0; i < cellCount; ++i)
+        cellStarts[i + 1] += cellStarts[i];
+
+    std::vector<std::uint32_t> cursor(cellStarts.begin(), cellStarts.end() - 1);
+
+    for (std::uint32_t i = 0; i < (std::uint32_t)count; ++i)
+        cellLights[cursor[cellOf(positions[i])]++] = i;
+
+    // make each start the end of its cell, so cell 'c' is [cellStarts[c - 1], cellStarts[c])
+    cellStarts.erase(cellStarts.begin());
+}
+
+int LightGrid::GetCell(float value, int axis) const
+{
+    int cell = (int)std::floor((value - GetAxis(origin, axis)) / cellSize);
+    return std::clamp(cell, 0, dims[axis] - 1);
+}
+
+std::uint32_t LightGrid::FindClosestLinear(const Vec3& point, std::uint32_t mask) const
+{
+    std::uint32_t closest = None;
+    float closestDist = std::numeric_limits<float>::max();
+
+    for (std::uint32_t i = 0; i < (std::uint32_t)positions.size(); ++i)
+    {
+        if ((masks[i] & mask) != 0)
+        {
+            float dist = positions[i].DistanceSq(point);
+            if (dist < closestDist)
+            {
+                closest = i;
+                closestDist = dist;
+            }
+        }
+    }
+
+    return closest;
+}
+
+std::uint32_t LightGrid::FindClosest(const Vec3& point, std::uint32_t mask) const
+{
+    if (cellStarts.empty())
+        return FindClosestLinear(point, mask);
+
+    std::array<int, 3> home = { GetCell(point.x, 0), GetCell(point.y, 1), GetCell(point.z, 2) };
+    int maxRing = std::max({ dims[0], dims[1], dims[2] });
+
+    std::uint32_t closest = None;
+    float closestDist = std::numeric_limits<float>::max();
+
+    for (int ring = 0; ring < maxRing; ++ring)
+    {
+        // Every cell beyond this ring is outside the box covered by the
+        // rings before it. Stop once the closest light so far is nearer
+        // than any point outside that box could be.
+        if (ring > 0 && closest != None)
+        {
+            float bound = std::numeric_limits<float>::max();
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                float lo = GetAxis(origin, axis) + (home[axis] - ring + 1) * cellSize;
+                float hi = GetAxis(origin, axis) + (home[axis] + ring) * cellSize;
+                float p = GetAxis(point, axis);
+                bound = std::min(bound, std::max(0.0f, std::min(p - lo, hi - p)));
+            }
+
+            if (closestDist <= bound * bound)
+                break;
+        }
+
+        int z0 = std::max(home[2] - ring, 0), z1 = std::min(home[2] + ring, dims[2] - 1);
+        int y0 = std::max(home[1] - ring, 0), y1 = std::min(home[1] + ring, dims[1] - 1);
+        int x0 = std::max(home[0] - ring, 0), x1 = std::min(home[0] + ring, dims[0] - 1);
+
+        for (int z = z0; z <= z1; ++z)
+        {
+            for (int y = y0; y <= y1; ++y)
+            {
+                for (int x = x0; x <= x1; ++x)
+                {
+                    int dist = std::max({ std::abs(x - home[0]), std::abs(y - home[1]), std::abs(z - home[2]) });
+                    if (dist != ring)
+                        continue;
+
+                    auto cell = ((std::size_t)z * dims[1] + y) * dims[0] + x;
+                    auto begin = cell ? cellStarts[cell - 1] : 0;
+                    auto end = cellStarts[cell];
+
+                    for (auto i = begin; i < end; ++i)
+                    {
+                        auto light = cellLights[i];
+
+                        if ((masks[light] & mask) != 0)
+                        {
+                            float d = positions[light].DistanceSq(point);
+                            if (d < closestDist || (d == closestDist && light < closest))
+                            {
+                                closest = light;
+                                closestDist = d;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return closest;
+}
+
+} // scene
+} // mw
@@ -0,0 +1,67 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.SceneGraph.Culling;
+import Microwave.Math;
+import std;
+
+export namespace mw {
+inline namespace scene {
+
+// A view frustum laid out for testing boxes against it. The planes are
+// stored as structure-of-arrays, so a box in center/extents form is tested
+// against four of them at a time. Immutable once built, so any number of
+// threads may test against it at once.
+class Frustum
+{
+public:
+    Frustum() = default;
+
+    // 'planes' face inward, as Camera builds them
+    Frustum(const std::array<Plane, 6>& planes, const std::array<Vec3, 8>& corners);
+
+    // false if 'box' is fully behind one of the planes, or beside the
+    // bounds of the frustum's corners
+    bool Intersects(const AABox& box) const;
+
+private:
+    // two groups of four planes - the last two lanes repeat the first plane
+    alignas(16) float nx[8] = {};
+    alignas(16) float ny[8] = {};
+    alignas(16) float nz[8] = {};
+    alignas(16) float nd[8] = {};
+
+    Vec3 cornerMin;
+    Vec3 cornerMax;
+};
+
+// Uniform grid of light positions, for finding the closest light to a
+// point without checking every light. Lights are only matched against
+// points whose layer mask overlaps their culling mask.
+class LightGrid
+{
+public:
+    static constexpr std::uint32_t None = std::numeric_limits<std::uint32_t>::max();
+
+    void Build(std::span<const Vec3> positions, std::span<const std::uint32_t> masks);
+
+    // index of the closest matching light, or None. Safe to call from any thread.
+    std::uint32_t FindClosest(const Vec3& point, std::uint32_t mask) const;
+
+private:
+    std::vector<Vec3> positions;
+    std::vector<std::uint32_t> masks;
+
+    Vec3 origin;
+    float cellSize = 1.0f;
+    std::array<int, 3> dims = { 0, 0, 0 };
+    std::vector<std::uint32_t> cellStarts;  // into 'cellLights', one past the end for each cell
+    std::vector<std::uint32_t> cellLights;
+
+    int GetCell(float value, int axis) const;
+    std::uint32_t FindClosestLinear(const Vec3& point, std::uint32_t mask) const;
+};
+
+} // scene
+} // mw
@@ -0,0 +1,374 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Microwave.SceneGraph.Internal.CollisionShapes;
+import Microwave.Graphics.GraphicsTypes;
+import std;
+import <MW/SceneGraph/Internal/Bullet.h>;
+
+namespace mw {
+inline namespace scene {
+
+// A btOptimizedBvh that can be saved and restored. The layout is:
+//   uint32 triangleCount, nodeCount, subtreeCount
+//   float aabbMin[3], aabbMax[3], quantization[3]
+//   nodeCount x { uint16 aabbMin[3], aabbMax[3]; int32 escapeIndexOrTriangleIndex }
+//   subtreeCount x { uint16 aabbMin[3], aabbMax[3]; int32 rootNodeIndex, subtreeSize }
+class TriangleTree : public btOptimizedBvh
+{
+public:
+    std::vector<std::byte> Save(std::uint32_t triangleCount) const;
+
+    // returns false, leaving the tree empty, if 'data' isn't a valid tree
+    // over 'triangleCount' triangles
+    bool Load(std::span<const std::byte> data, std::uint32_t triangleCount);
+};
+
+struct SavedNode
+{
+    std::uint16_t aabbMin[3];
+    std::uint16_t aabbMax[3];
+    std::int32_t index;
+};
+
+struct SavedSubtree
+{
+    std::uint16_t aabbMin[3];
+    std::uint16_t aabbMax[3];
+    std::int32_t rootNodeIndex;
+    std::int32_t subtreeSize;
+};
+
+template<class T>
+static void Write(std::vector<std::byte>& out, const T& value)
+{
+    auto bytes = std::as_bytes(std::span(&value, 1));
+    out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+// reads the next value from the front of 'data', or returns false if it's too short
+template<class T>
+static bool Read(std::span<const std::byte>& data, T& value)
+{
+    if (data.size() < sizeof(T))
+        return false;
+
+    std::memcpy(&value, data.data(), sizeof(T));
+    data = data.subspan(sizeof(T));
+    return true;
+}
+
+std::vector<std::byte> TriangleTree::Save(std::uint32_t triangleCount) const
+{
+    std::vector<std::byte> out;
+
+    Write(out, triangleCount);
+    Write(out, (std::uint32_t)m_curNodeIndex);
+    Write(out, (std::uint32_t)m_SubtreeHeaders.size());
+
+    for (const btVector3* v : { &m_bvhAabbMin, &m_bvhAabbMax, &m_bvhQuantization })
+    {
+        for (int i = 0; i < 3; ++i)
+            Write(out, (float)(*v)[i]);
+    }
+
+    for (int n = 0; n < m_curNodeIndex; ++n)
+    {
+        auto& node = m_quantizedContiguousNodes[n];
+
+        SavedNode saved;
+        std::copy_n(node.m_quantizedAabbMin, 3, saved.aabbMin);
+        std::copy_n(node.m_quantizedAabbMax, 3, saved.aabbMax);
+        saved.index = node.m_escapeIndexOrTriangleIndex;
+        Write(out, saved);
+    }
+
+    for (int s = 0; s < m_SubtreeHeaders.size(); ++s)
+    {
+        auto& subtree = m_SubtreeHeaders[s];
+
+        SavedSubtree saved;
+        std::copy_n(subtree.m_quantizedAabbMin, 3, saved.aabbMin);
+        std::copy_n(subtree.m_quantizedAabbMax, 3, saved.aabbMax);
+        saved.rootNodeIndex = subtree.m_rootNodeIndex;
+        saved.subtreeSize = subtree.m_subtreeSize;
+        Write(out, saved);
+    }
+
+    return out;
+}
+
+bool TriangleTree::Load(std::span<const std::byte> data, std::uint32_t triangleCount)
+{
+    std::uint32_t savedTriangleCount = 0;
+    std::uint32_t nodeCount = 0;
+    std::uint32_t subtreeCount = 0;
+    float bounds[9];
+
+    if (!Read(data, savedTriangleCount) || !Read(data, nodeCount) || !Read(data, subtreeCount))
+        return false;
+
+    for (auto& value : bounds)
+    {
+        if (!Read(data, value))
+            return false;
+    }
+
+    if (savedTriangleCount != triangleCount ||
+        nodeCount == 0 || nodeCount > triangleCount * 2 ||
+        data.size() != nodeCount * sizeof(SavedNode) + subtreeCount * sizeof(SavedSubtree))
+    {
+        return false;
+    }
+
+    std::vector<SavedNode> nodes(nodeCount);
+    std::vector<SavedSubtree> subtrees(subtreeCount);
+
+    for (std::uint32_t n = 0; n < nodeCount; ++n)
+    {
+        Read(data, nodes[n]);
+
+        // leaves hold a triangle index, and other nodes hold minus the
+        // number of nodes to skip to get past their children
+        std::int64_t index = nodes[n].index;
+        if (index >= 0 ? index >= triangleCount : n - index > nodeCount)
+            return false;
+    }
+
+    for (std::uint32_t s = 0; s < subtreeCount; ++s)
+    {
+        Read(data, subtrees[s]);
+
+        auto& subtree = subtrees[s];
+        if (subtree.rootNodeIndex < 0 || subtree.subtreeSize < 0 ||
+            (std::uint32_t)subtree.rootNodeIndex + subtree.subtreeSize > nodeCount)
+        {
+            return false;
+        }
+    }
+
+    m_bvhAabbMin.setValue(bounds[0], bounds[1], bounds[2]);
+    m_bvhAabbMax.setValue(bounds[3], bounds[4], bounds[5]);
+    m_bvhQuantization.setValue(bounds[6], bounds[7], bounds[8]);
+    m_useQuantization = true;
+    m_traversalMode = TRAVERSAL_STACKLESS;
+    m_curNodeIndex = (int)nodeCount;
+
+    m_quantizedContiguousNodes.resize((int)nodeCount);
+
+    for (std::uint32_t n = 0; n < nodeCount; ++n)
+    {
+        auto& node = m_quantizedContiguousNodes[n];
+        std::copy_n(nodes[n].aabbMin, 3, node.m_quantizedAabbMin);
+        std::copy_n(nodes[n].aabbMax, 3, node.m_quantizedAabbMax);
+        node.m_escapeIndexOrTriangleIndex = nodes[n].index;
+    }
+
+    m_SubtreeHeaders.resize((int)subtreeCount);
+
+    for (std::uint32_t s = 0; s < subtreeCount; ++s)
+    {
+        auto& subtree = m_SubtreeHeaders[s];
+        subtree = btBvhSubtreeInfo();
+        std::copy_n(subtrees[s].aabbMin, 3, subtree.m_quantizedAabbMin);
+        std::copy_n(subtrees[s].aabbMax, 3, subtree.m_quantizedAabbMax);
+        subtree.m_rootNodeIndex = subtrees[s].rootNodeIndex;
+        subtree.m_subtreeSize = subtrees[s].subtreeSize;
+    }
+
+    m_subtreeHeaderCount = (int)subtreeCount;
+    return true;
+}
+
+// indices of every triangle in 'mesh', skipping any that reference missing vertices
+static std::vector<int> GetTriangles(const Mesh& mesh)
+{
+    std::vector<int> triangles;
+    int vertexCount = (int)mesh.vertices.size();
+
+    for (auto& elem : mesh.elements)
+    {
+        if (elem.drawMode != DrawMode::Triangles)
+            continue;
+
+        for (std::size_t i = 0; i + 2 < elem.indices.size(); i += 3)
+        {
+            const int* tri = &elem.indices[i];
+
+            if (std::all_of(tri, tri + 3, [=](int v) { return v >= 0 && v < vertexCount; }))
+                triangles.insert(triangles.end(), tri, tri + 3);
+        }
+    }
+
+    return triangles;
+}
+
+static std::pair<btVector3, btVector3> GetBounds(std::span<const Vec3> points)
+{
+    btVector3 vmin(points[0].x, points[0].y, points[0].z);
+    btVector3 vmax = vmin;
+
+    for (auto& p : points)
+    {
+        btVector3 v(p.x, p.y, p.z);
+        vmin.setMin(v);
+        vmax.setMax(v);
+    }
+
+    return { vmin, vmax };
+}
+
+std::vector<Vec3> ReduceHull(std::span<const Vec3> points, int maxPoints)
+{
+    if (points.empty() || maxPoints <= 0)
+        return {};
+
+    // directions on a golden angle spiral, which covers the sphere evenly
+    constexpr float GoldenAngle = 2.39996323f;
+
+    std::vector<std::size_t> support;
+    support.reserve(maxPoints);
+
+    for (int d = 0; d < maxPoints; ++d)
+    {
+        float z = 1.0f - (2.0f * d + 1.0f) / maxPoints;
+        float r = std::sqrt(std::max(1.0f - z * z, 0.0f));
+        float a = GoldenAngle * d;
+        Vec3 dir(r * std::cos(a), r * std::sin(a), z);
+
+        std::size_t best = 0;
+        float bestDist = points[0].Dot(dir);
+
+        for (std::size_t i = 1; i < points.size(); ++i)
+        {
+            float dist = points[i].Dot(dir);
+            if (dist > bestDist)
+            {
+                best = i;
+                bestDist = dist;
+            }
+        }
+
+        support.push_back(best);
+    }
+
+    std::sort(support.begin(), support.end());
+    support.erase(std::unique(support.begin(), support.end()), support.end());
+
+    std::vector<Vec3> hull;
+    hull.reserve(support.size());
+
+    for (auto i : support)
+        hull.push_back(points[i]);
+
+    return hull;
+}
+
+std::vector<std::byte> BuildTriangleTree(const Mesh& mesh)
+{
+    std::vector<Vec3> vertices = mesh.vertices;
+    std::vector<int> indices = GetTriangles(mesh);
+
+    if (indices.empty())
+        return {};
+
+    int triangleCount = (int)indices.size() / 3;
+
+    btTriangleIndexVertexArray triangles(
+        triangleCount, indices.data(), 3 * sizeof(int),
+        (int)vertices.size(), &vertices[0].x, sizeof(Vec3));
+
+    auto [aabbMin, aabbMax] = GetBounds(vertices);
+
+    TriangleTree tree;
+    tree.build(&triangles, true, aabbMin, aabbMax);
+    return tree.Save((std::uint32_t)triangleCount);
+}
+
+MeshShape::MeshShape(const Mesh& mesh, bool convex)
+    : convex(convex)
+{
+    if (!convex)
+    {
+        vertices = mesh.vertices;
+        indices = GetTriangles(mesh);
+
+        // nothing to build a tree from
+        if (indices.empty())
+            this->convex = true;
+    }
+
+    if (this->convex)
+    {
+        auto points = !mesh.collisionHull.empty() ? mesh.collisionHull : ReduceHull(mesh.vertices);
+        hull.reserve((int)points.size());
+
+        for (auto& p : points)
+            hull.push_back(btVector3(p.x, p.y, p.z));
+
+        return;
+    }
+
+    int triangleCount = (int)indices.size() / 3;
+
+    triangles = upnew<btTriangleIndexVertexArray>(
+        triangleCount, indices.data(), 3 * sizeof(int),
+        (int)vertices.size(), &vertices[0].x, sizeof(Vec3));
+
+    auto [aabbMin, aabbMax] = GetBounds(vertices);
+    triangles->setPremadeAabb(aabbMin, aabbMax);
+
+    auto savedTree = upnew<TriangleTree>();
+
+    if (savedTree->Load(mesh.collisionTree, (std::uint32_t)triangleCount))
+    {
+        tree = std::move(savedTree);
+    }
+    else
+    {
+        tree = upnew<btOptimizedBvh>();
+        tree->build(triangles.get(), true, aabbMin, aabbMax);
+    }
+
+    triangleShape = upnew<btBvhTriangleMeshShape>(triangles.get(), true, aabbMin, aabbMax, false);
+    triangleShape->setOptimizedBvh(tree.get());
+}
+
+uptr<btCollisionShape> MeshShape::CreateInstance()
+{
+    if (!convex)
+        return upnew<btScaledBvhTriangleMeshShape>(triangleShape.get(), btVector3(1, 1, 1));
+
+    if (hull.size() == 0)
+        return upnew<btConvexHullShape>();
+
+    return upnew<btConvexPointCloudShape>(&hull[0], hull.size(), btVector3(1, 1, 1));
+}
+
+sptr<MeshShape> CollisionShapeCache::GetMeshShape(const gptr<Mesh>& mesh, bool convex)
+{
+    Key key{ mesh->GetUUID(), convex };
+
+    if (auto it = shapes.find(key); it != shapes.end())
+    {
+        if (auto shape = it->second.lock())
+            return shape;
+    }
+
+    // forget shapes that are no longer used before adding another
+    std::erase_if(shapes, [](const auto& entry) { return entry.second.expired(); });
+
+    auto shape = spnew<MeshShape>(*mesh, convex);
+    shapes[key] = shape;
+    return shape;
+}
+
+CollisionShapeCache& CollisionShapeCache::GetInstance()
+{
+    static CollisionShapeCache instance;
+    return instance;
+}
+
+} // scene
+} // mw
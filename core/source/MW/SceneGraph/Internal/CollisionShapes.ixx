@@ -0,0 +1,83 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.SceneGraph.Internal.CollisionShapes;
+import Microwave.Graphics.Mesh;
+import Microwave.Math;
+import Microwave.System.Pointers;
+import Microwave.System.UUID;
+import std;
+import <MW/SceneGraph/Internal/Bullet.h>;
+
+export namespace mw {
+inline namespace scene {
+
+// convex hulls are reduced to at most this many points
+constexpr int MaxHullPoints = 64;
+
+// The support points of 'points' in 'maxPoints' directions spread evenly
+// over a sphere. Each one is a vertex of the full hull, so the reduced hull
+// fits inside it, missing only detail finer than the spacing of directions.
+std::vector<Vec3> ReduceHull(std::span<const Vec3> points, int maxPoints = MaxHullPoints);
+
+// a quantized AABB tree over the triangles of 'mesh', for Mesh::collisionTree
+std::vector<std::byte> BuildTriangleTree(const Mesh& mesh);
+
+// The collision data of one mesh, shared by all the colliders that use it.
+// Convex shapes hold a reduced hull, and concave ones hold the mesh's
+// triangles and a tree over them, which can only collide as static bodies.
+class MeshShape
+{
+    bool convex = true;
+    btAlignedObjectArray<btVector3> hull;
+    std::vector<Vec3> vertices;
+    std::vector<int> indices;
+    uptr<btTriangleIndexVertexArray> triangles;
+    uptr<btOptimizedBvh> tree;
+    uptr<btBvhTriangleMeshShape> triangleShape;
+
+public:
+    MeshShape(const Mesh& mesh, bool convex);
+
+    MeshShape(const MeshShape&) = delete;
+    MeshShape& operator=(const MeshShape&) = delete;
+
+    bool IsConvex() const { return convex; }
+
+    // A shape for a single collider, which references this one's data, so
+    // it must not outlive it. Each has its own scaling, so colliders with
+    // different scales can still share the data.
+    uptr<btCollisionShape> CreateInstance();
+};
+
+// MeshShapes by mesh UUID and collider settings. Each is kept while any
+// collider still holds it. Meshes are expected not to change once they're
+// in use by a collider, since they're identified by UUID alone.
+class CollisionShapeCache
+{
+    struct Key
+    {
+        UUID mesh;
+        bool convex = true;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const noexcept {
+            return key.mesh.GetHash() ^ (std::size_t)key.convex;
+        }
+    };
+
+    std::unordered_map<Key, wptr<MeshShape>, KeyHash> shapes;
+
+public:
+    sptr<MeshShape> GetMeshShape(const gptr<Mesh>& mesh, bool convex);
+
+    static CollisionShapeCache& GetInstance();
+};
+
+} // scene
+} // mw
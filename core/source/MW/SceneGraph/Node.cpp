@@ -11,13 +11,30 @@ import std;
 namespace mw {
 inline namespace scene {
 
+static TransformStore& transforms() {
+    return TransformStore::GetInstance();
+}
+
+// nodes marked by SetDirty(), waiting to be notified
+static thread_local std::vector<ITransformOwner*> transformChanged;
+
+Node::Node()
+{
+    transforms().Allocate(this);
+}
+
+Node::~Node()
+{
+    transforms().Free(this);
+}
+
 void Node::ToJson(json& obj) const
 {
     Object::ToJson(obj);
 
-    obj["localPos"] = _localPos;
-    obj["localRot"] = _localRot;
-    obj["localScale"] = _localScale;
+    obj["localPos"] = GetLocalPosition();
+    obj["localRot"] = GetLocalRotation();
+    obj["localScale"] = GetLocalScale();
 
     obj["active"] = _active;
     obj["layerMask"] = _layerMask;
@@ -39,13 +56,56 @@ void Node::ToJson(json& obj) const
     obj["components"] = std::move(componentsObj);
 }
 
+void Node::WriteJson(JsonWriter& writer) const
+{
+    writer.BeginObject();
+    WriteObjectJson(writer);
+
+    Transform local = GetLocalTransform();
+    writer.Property("localPos", local.position);
+    writer.Property("localRot", local.rotation);
+    writer.Property("localScale", local.scale);
+
+    writer.Property("active", _active);
+    writer.Property("layerMask", _layerMask);
+
+    // children and components are streamed too, so a hierarchy is
+    // written without building a json for any of it
+    writer.Key("children");
+    writer.BeginArray();
+    for (auto& child : _children)
+    {
+        if (child)
+            child->WriteJson(writer);
+        else
+            writer.Null();
+    }
+    writer.EndArray();
+
+    writer.Key("components");
+    writer.BeginArray();
+    for (auto& comp : _components)
+    {
+        if (comp)
+            comp->WriteJson(writer);
+        else
+            writer.Null();
+    }
+    writer.EndArray();
+
+    writer.EndObject();
+}
+
 void Node::FromJson(const json& obj, ObjectLinker* linker)
 {
     Object::FromJson(obj, linker);
 
-    _localPos = obj.value("localPos", _localPos);
-    _localRot = obj.value("localRot", _localRot);
-    _localScale = obj.value("localScale", _localScale);
+    auto& store = transforms();
+    Transform local = store.GetLocalTransform(this);
+    store.SetLocalTransform(this,
+        obj.value("localPos", local.position),
+        obj.value("localRot", local.rotation),
+        obj.value("localScale", local.scale));
 
     _active = obj.value("active", _active);
     _layerMask = obj.value("layerMask", _layerMask);
@@ -55,6 +115,7 @@ void Node::FromJson(const json& obj, ObjectLinker* linker)
     {
         auto child = Object::CreateFromJson<Node>(childObj, linker);
         child->_parent = self(this);
+        store.SetParent(child.get(), this);
         _children.push_back(std::move(child));
     }
 
@@ -69,6 +130,49 @@ void Node::FromJson(const json& obj, ObjectLinker* linker)
     SetDirty();
 }
 
+gptr<Object> Node::Clone(ObjectCloner& cloner) const {
+    return cloner.Create(this);
+}
+
+void Node::CloneFrom(const Node& source, ObjectCloner& cloner)
+{
+    Object::CloneFrom(source, cloner);
+
+    auto& store = transforms();
+    Transform local = source.GetLocalTransform();
+    store.SetLocalTransform(this, local.position, local.rotation, local.scale);
+
+    _active = source._active;
+    _layerMask = source._layerMask;
+
+    _children.reserve(source._children.size());
+
+    for (auto& sourceChild : source._children)
+    {
+        if (!sourceChild)
+            continue;
+
+        auto child = gpcast<Node>(cloner.Clone(sourceChild));
+        child->_parent = self(this);
+        store.SetParent(child.get(), this);
+        _children.push_back(std::move(child));
+    }
+
+    _components.reserve(source._components.size());
+
+    for (auto& sourceComp : source._components)
+    {
+        if (!sourceComp)
+            continue;
+
+        auto comp = gpcast<Component>(cloner.Clone(sourceComp));
+        comp->node = self(this);
+        _components.push_back(std::move(comp));
+    }
+
+    SetDirty();
+}
+
 void Node::SetActive(bool active)
 {
     if(_active != active)
@@ -99,55 +203,44 @@ bool Node::IsBranchActive() const
 
 void Node::SetDirty()
 {
-    if (!_dirty)
+    auto& store = transforms();
+
+    if (store.IsDirty(this))
+        return;
+
+    // Mark the whole subtree first, then notify components, since their
+    // handlers may change the hierarchy. Nested calls append past 'last'
+    // and remove what they added before returning.
+    auto first = transformChanged.size();
+
+    if (store.MarkSubtreeDirty(this, transformChanged))
     {
-        _dirty = true;
+        auto last = transformChanged.size();
 
-        for (auto& c : _components)
-            c->OnTransformChanged();
+        for (auto i = first; i < last; ++i)
+            static_cast<Node*>(transformChanged[i])->NotifyTransformChanged();
+
+        transformChanged.resize(first);
+    }
+    else
+    {
+        // the store's order is stale until the next update, so walk the hierarchy
+        store.MarkDirty(this);
+        NotifyTransformChanged();
 
         for (auto& c : _children)
             c->SetDirty();
     }
 }
 
-void Node::UpdateWorldTransform() const
+void Node::NotifyTransformChanged()
 {
-    if (_dirty)
-    {
-        if (_parent)
-        {
-            _parent->UpdateWorldTransform();
-
-            Vec3 worldPos = _localPos;
-            Quat worldRot = _localRot;
-            Vec3 worldScale = _localScale;
-
-            Vec3 parentScale = _parent->_worldScale;
-            Quat parentRot = _parent->_worldRot;
-            Vec3 parentPos = _parent->_worldPos;
-
-            worldPos = worldPos.Multiply(parentScale);
-            worldPos *= parentRot;
-            worldPos += parentPos;
-
-            worldRot *= parentRot;
-
-            worldScale = worldScale.Multiply(parentScale);
-
-            _worldPos = worldPos;
-            _worldRot = worldRot;
-            _worldScale = worldScale;
-        }
-        else
-        {
-            _worldPos = _localPos;
-            _worldRot = _localRot;
-            _worldScale = _localScale;
-        }
+    for (auto& c : _components)
+        c->OnTransformChanged();
+}
 
-        _dirty = false;
-    }
+void Node::UpdateWorldTransform() const {
+    transforms().Resolve(this);
 }
 
 void Node::SetLocalTransform(const Transform& transform)
@@ -161,19 +254,13 @@ void Node::SetLocalTransform(const Transform& transform)
 
 void Node::SetLocalTransform(const Vec3& pos, const Quat& rot, const Vec3& scale)
 {
-    _localPos = pos;
-    _localRot = rot;
-    _localScale = scale;
+    transforms().SetLocalTransform(this, pos, rot, scale);
     SetDirty();
 }
 
 Transform Node::GetLocalTransform() const
 {
-    return {
-        _localPos,
-        _localRot,
-        _localScale
-    };
+    return transforms().GetLocalTransform(this);
 }
 
 void Node::SetGlobalTransform(const Transform& transform)
@@ -187,6 +274,8 @@ void Node::SetGlobalTransform(const Transform& transform)
 
 void Node::SetGlobalTransform(const Vec3& pos, const Quat& rot, const Vec3& scale)
 {
+    auto& store = transforms();
+
     if (_parent)
     {
         Vec3 parentInvScale = Vec3::One().Divide(_parent->GetScale());
@@ -197,36 +286,33 @@ void Node::SetGlobalTransform(const Vec3& pos, const Quat& rot, const Vec3& scal
         localPos -= _parent->GetPosition();
         localPos *= parentInvRot;
         localPos = localPos.Multiply(parentInvScale);
-        _localPos = localPos;
-
-        // rotation
-        _localRot = rot * parentInvRot;
-
-        // scale
-        _localScale = scale.Multiply(parentInvScale);
+        store.SetLocalTransform(this, localPos,
+            rot * parentInvRot,
+            scale.Multiply(parentInvScale));
     }
     else
     {
-        _localPos = pos;
-        _localRot = rot;
-        _localScale = scale;
+        store.SetLocalTransform(this, pos, rot, scale);
     }
 
     SetDirty();
 }
 
+void Node::SetPositionAndRotation(const Vec3& pos, const Quat& rot)
+{
+    auto& store = transforms();
+    store.SetLocalPosition(this, WorldToLocalPos(pos));
+    store.SetLocalRotation(this, _parent ? rot * _parent->GetRotation().Inverse() : rot);
+    SetDirty();
+}
+
 Transform Node::GetGlobalTransform() const
 {
-    UpdateWorldTransform();
-    return {
-        _worldPos,
-        _worldRot,
-        _worldScale
-    };
+    return transforms().GetWorldTransform(this);
 }
 
 void Node::SetPosition(const Vec3& pos) {
-    _localPos = WorldToLocalPos(pos);
+    transforms().SetLocalPosition(this, WorldToLocalPos(pos));
     SetDirty();
 }
 
@@ -235,13 +321,12 @@ void Node::SetPosition(float x, float y, float z) {
 }
 
 Vec3 Node::GetPosition() const {
-    UpdateWorldTransform();
-    return _worldPos;
+    return transforms().GetWorldPosition(this);
 }
 
 //Vec3 Node::LocalToWorldPos(const Vec3& pos) const
 //{
-//    Vec3 worldPos = _localPos;
+//    Vec3 worldPos = GetLocalPosition();
 //
 //    if (_parent) {
 //        worldPos = worldPos.Multiply(_parent->GetScale());
@@ -266,7 +351,7 @@ Vec3 Node::WorldToLocalPos(const Vec3& pos) const
 }
 
 void Node::SetLocalPosition(const Vec3& pos) {
-    _localPos = pos;
+    transforms().SetLocalPosition(this, pos);
     SetDirty();
 }
 
@@ -275,11 +360,11 @@ void Node::SetLocalPosition(float x, float y, float z) {
 }
 
 Vec3 Node::GetLocalPosition() const {
-    return _localPos;
+    return transforms().GetLocalPosition(this);
 }
 
 void Node::SetRotation(const Quat& rot) {
-    _localRot = _parent ? rot * _parent->GetRotation().Inverse() : rot;
+    transforms().SetLocalRotation(this, _parent ? rot * _parent->GetRotation().Inverse() : rot);
     SetDirty();
 }
 
@@ -296,21 +381,20 @@ void Node::SetRotation(float angle, const Vec3& axis) {
 }
 
 Quat Node::GetRotation() const {
-    UpdateWorldTransform();
-    return _worldRot;
+    return transforms().GetWorldRotation(this);
 }
 
 void Node::SetLocalRotation(const Quat& rot) {
-    _localRot = rot;
+    transforms().SetLocalRotation(this, rot);
     SetDirty();
 }
 
 Quat Node::GetLocalRotation() const {
-    return _localRot;
+    return transforms().GetLocalRotation(this);
 }
 
 void Node::SetScale(const Vec3& scale) {
-    _localScale = _parent ? scale.Divide(_parent->GetScale()) : scale;
+    transforms().SetLocalScale(this, _parent ? scale.Divide(_parent->GetScale()) : scale);
     SetDirty();
 }
 
@@ -319,12 +403,11 @@ void Node::SetScale(float x, float y, float z) {
 }
 
 Vec3 Node::GetScale() const {
-    UpdateWorldTransform();
-    return _worldScale;
+    return transforms().GetWorldScale(this);
 }
 
 void Node::SetLocalScale(const Vec3& scale) {
-    _localScale = scale;
+    transforms().SetLocalScale(this, scale);
     SetDirty();
 }
 
@@ -333,7 +416,7 @@ void Node::SetLocalScale(float x, float y, float z) {
 }
 
 Vec3 Node::GetLocalScale() const {
-    return _localScale;
+    return transforms().GetLocalScale(this);
 }
 
 Vec3 Node::Right() const {
@@ -348,31 +431,8 @@ Vec3 Node::Forward() const {
     return Vec3::Forward() * GetRotation();
 }
 
-Mat4 Node::GetLocalToWorldMatrix() const
-{
-    Vec3 pos = GetPosition();
-    Quat rot = GetRotation();
-    Vec3 scale = GetScale();
-
-    Mat4 mtx = rot.ToMatrix();
-
-    mtx.m11 *= scale.x;
-    mtx.m12 *= scale.x;
-    mtx.m13 *= scale.x;
-
-    mtx.m21 *= scale.y;
-    mtx.m22 *= scale.y;
-    mtx.m23 *= scale.y;
-
-    mtx.m31 *= scale.z;
-    mtx.m32 *= scale.z;
-    mtx.m33 *= scale.z;
-
-    mtx.m41 = pos.x;
-    mtx.m42 = pos.y;
-    mtx.m43 = pos.z;
-
-    return mtx;
+Mat4 Node::GetLocalToWorldMatrix() const {
+    return transforms().GetWorldMatrix(this);
 }
 
 Mat4 Node::GetWorldToLocalMatrix() const
@@ -452,6 +512,8 @@ void Node::SetParent(const gptr<Node>& newParent, bool preserveWorldTransform)
     if (auto scene = GetScene())
         DetachFromScene();
 
+    auto& store = transforms();
+
     if (oldParent)
     {
         if (preserveWorldTransform)
@@ -459,13 +521,13 @@ void Node::SetParent(const gptr<Node>& newParent, bool preserveWorldTransform)
             Vec3 parentScale = oldParent->GetScale();
             Quat parentRot = oldParent->GetRotation();
 
-            _localPos = _localPos.Multiply(parentScale);
-            _localPos *= parentRot;
-            _localPos += oldParent->GetPosition();
+            Vec3 localPos = GetLocalPosition().Multiply(parentScale);
+            localPos *= parentRot;
+            localPos += oldParent->GetPosition();
 
-            _localRot = _localRot * parentRot;
-
-            _localScale = _localScale.Multiply(parentScale);
+            store.SetLocalTransform(this, localPos,
+                GetLocalRotation() * parentRot,
+                GetLocalScale().Multiply(parentScale));
         }
 
         auto it = std::find(
@@ -478,6 +540,7 @@ void Node::SetParent(const gptr<Node>& newParent, bool preserveWorldTransform)
     }
 
     _parent = newParent;
+    store.SetParent(this, newParent.get());
 
     if (newParent)
     {
@@ -486,13 +549,13 @@ void Node::SetParent(const gptr<Node>& newParent, bool preserveWorldTransform)
             Quat invParentRot = newParent->GetRotation().Inverse();
             Vec3 invParentScale = Vec3::One().Divide(newParent->GetScale());
 
-            _localPos -= newParent->GetPosition();
-            _localPos *= invParentRot;
-            _localPos = _localPos.Multiply(invParentScale);
-
-            _localRot = _localRot * invParentRot;
+            Vec3 localPos = GetLocalPosition() - newParent->GetPosition();
+            localPos *= invParentRot;
+            localPos = localPos.Multiply(invParentScale);
 
-            _localScale = _localScale.Multiply(invParentScale);
+            store.SetLocalTransform(this, localPos,
+                GetLocalRotation() * invParentRot,
+                GetLocalScale().Multiply(invParentScale));
         }
 
         newParent->_children.push_back(self(this));
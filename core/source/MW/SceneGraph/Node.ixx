@@ -5,7 +5,9 @@
 export module Microwave.SceneGraph.Node;
 import Microwave.Math;
 import Microwave.SceneGraph.LayerMask;
+import Microwave.SceneGraph.TransformStore;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Object;
 import Microwave.System.Path;
 import Microwave.System.Pointers;
@@ -18,17 +20,10 @@ inline namespace scene {
 class Scene;
 class Component;
 
-class Node : public Object
+class Node : public Object, public ITransformOwner
 {
     inline static Type::Pin<Node> pin;
 
-    Vec3                         _localPos = Vec3::Zero();
-    Quat                         _localRot = Quat::Identity();
-    Vec3                         _localScale = Vec3::One();
-    mutable Vec3                 _worldPos = Vec3::Zero();
-    mutable Quat                 _worldRot = Quat::Identity();
-    mutable Vec3                 _worldScale = Vec3::One();
-    mutable bool                 _dirty = true;
     bool                         _active = true;
     gvector<gptr<Node>>          _children;
     gvector<gptr<Component>>     _components;
@@ -40,12 +35,16 @@ public:
     friend Component;
     friend Scene;
 
-    Node(){}
-    virtual ~Node(){};
+    Node();
+    virtual ~Node();
 
     virtual void ToJson(json& obj) const override;
+    virtual void WriteJson(JsonWriter& writer) const override;
     virtual void FromJson(const json& obj, ObjectLinker* linker) override;
 
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const override;
+    void CloneFrom(const Node& source, ObjectCloner& cloner);
+
     // mark this node as active
     void SetActive(bool active);
 
@@ -68,6 +67,9 @@ public:
     void SetGlobalTransform(const Transform& transform);
     void SetGlobalTransform(const Vec3& pos, const Quat& rot, const Vec3& scale);
 
+    // world space, marking the node dirty once instead of once for each
+    void SetPositionAndRotation(const Vec3& pos, const Quat& rot);
+
     void SetPosition(const Vec3& pos);
     void SetPosition(float x, float y, float z);
     Vec3 GetPosition() const;
@@ -219,6 +221,7 @@ private:
     void AttachToScene(const gptr<Scene>& scene);
     void DetachFromScene();
     void SignalStructureChanged();
+    void NotifyTransformChanged();
 };
 
 gptr<Node> Node::FindChild(std::predicate<const gptr<Node>&> auto const& pred)
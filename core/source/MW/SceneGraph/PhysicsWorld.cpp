@@ -3,11 +3,16 @@
 *--------------------------------------------------------------*/
 
 module Microwave.SceneGraph.PhysicsWorld;
+import Microwave.SceneGraph.Axis;
+import Microwave.SceneGraph.Components.Collider;
 import Microwave.SceneGraph.Components.RigidBody;
 import Microwave.SceneGraph.Events;
+import Microwave.SceneGraph.Internal.Bullet;
+import Microwave.SceneGraph.Internal.CapsuleShape;
 import Microwave.SceneGraph.Node;
 import Microwave.System.App;
 import Microwave.System.Exception;
+import Microwave.System.JobSystem;
 import Microwave.Utilities.Util;
 import <MW/SceneGraph/Internal/Bullet.h>;
 import <MW/System/Debug.h>;
@@ -16,15 +21,123 @@ import std;
 namespace mw {
 inline namespace scene {
 
-PhysicsWorld::PhysicsWorld()
+// Runs Bullet's parallel loops on the JobSystem. Bullet gives each thread
+// that calls into it an index the first time it does, with the main thread
+// always being 0, so any thread could end up with one, not just workers.
+class JobTaskScheduler : public btITaskScheduler
 {
+public:
+    JobTaskScheduler() : btITaskScheduler("JobSystem") {}
+
+    virtual int getMaxNumThreads() const override { return BT_MAX_THREAD_COUNT; }
+    virtual int getNumThreads() const override { return BT_MAX_THREAD_COUNT; }
+    virtual void setNumThreads(int numThreads) override {}
+
+    virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override
+    {
+        if (iEnd <= iBegin)
+            return;
+
+        JobSystem::GetInstance().ParallelFor(
+            iEnd - iBegin, std::max(grainSize, 1),
+            [&](std::size_t begin, std::size_t end) {
+                body.forLoop(iBegin + (int)begin, iBegin + (int)end);
+            });
+    }
+
+    virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override
+    {
+        if (iEnd <= iBegin)
+            return 0;
+
+        return JobSystem::GetInstance().ParallelReduce(
+            iEnd - iBegin, std::max(grainSize, 1), btScalar(0),
+            [&](std::size_t begin, std::size_t end) {
+                return body.sumLoop(iBegin + (int)begin, iBegin + (int)end);
+            },
+            std::plus<btScalar>());
+    }
+
+    // must be called from the main thread before the first multithreaded world is created
+    static void Install()
+    {
+        static JobTaskScheduler scheduler;
+
+        if (btGetTaskScheduler() != &scheduler)
+            btSetTaskScheduler(&scheduler);
+    }
+};
+
+// a body's user index, when it has its own collision mask
+constexpr int OwnCollisionMask = 1;
+
+// Filters pairs by the layers in each body's filter group and the layers it
+// collides with in its filter mask. Usually both must accept each other,
+// but a body with its own mask decides alone against one without. Static
+// and kinematic bodies never collide with each other, like Bullet's default.
+class LayerFilter : public btOverlapFilterCallback
+{
+public:
+    virtual bool needBroadphaseCollision(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1) const override
+    {
+        bool accepts0 = (proxy0->m_collisionFilterMask & proxy1->m_collisionFilterGroup) != 0;
+        bool accepts1 = (proxy1->m_collisionFilterMask & proxy0->m_collisionFilterGroup) != 0;
+
+        if (!accepts0 && !accepts1)
+            return false;
+
+        auto object0 = (btCollisionObject*)proxy0->m_clientObject;
+        auto object1 = (btCollisionObject*)proxy1->m_clientObject;
+
+        if (object0->isStaticOrKinematicObject() && object1->isStaticOrKinematicObject())
+            return false;
+
+        bool own0 = object0->getUserIndex() == OwnCollisionMask;
+        bool own1 = object1->getUserIndex() == OwnCollisionMask;
+
+        if (own0 != own1)
+            return own0 ? accepts0 : accepts1;
+
+        return accepts0 && accepts1;
+    }
+};
+
+PhysicsWorld::PhysicsWorld(const PhysicsSettings& settings)
+    : settings(settings)
+{
+    this->settings.stepRate = std::max(this->settings.stepRate, 1.0f);
+    this->settings.maxStepsPerFrame = std::max(this->settings.maxStepsPerFrame, 1);
+
     config = upnew<btDefaultCollisionConfiguration>();
-    dispatcher = upnew<btCollisionDispatcher>(config.get());
     broadphase = upnew<btDbvtBroadphase>();
-    solver = upnew<btSequentialImpulseConstraintSolver>();
-    world = upnew<btDiscreteDynamicsWorld>(dispatcher.get(), broadphase.get(), solver.get(), config.get());
-    world->setSynchronizeAllMotionStates(true);
+
+    if (settings.multithreaded)
+    {
+        JobTaskScheduler::Install();
+
+        // one solver per thread that can take part in solving islands
+        int solverCount = JobSystem::GetInstance().GetWorkerCount() + 1;
+        auto solverPool = upnew<btConstraintSolverPoolMt>(solverCount);
+
+        dispatcher = upnew<btCollisionDispatcherMt>(config.get());
+        world = upnew<btDiscreteDynamicsWorldMt>(
+            dispatcher.get(), broadphase.get(), solverPool.get(), nullptr, config.get());
+        solver = std::move(solverPool);
+    }
+    else
+    {
+        dispatcher = upnew<btCollisionDispatcher>(config.get());
+        solver = upnew<btSequentialImpulseConstraintSolver>();
+        world = upnew<btDiscreteDynamicsWorld>(dispatcher.get(), broadphase.get(), solver.get(), config.get());
+    }
+
+    // only active bodies report their interpolated transforms after each step
+    world->setSynchronizeAllMotionStates(false);
     world->setGravity(btVector3(0, 0, 0));
+
+    layerCollisions.fill(LayerMask::All);
+    filter = upnew<LayerFilter>();
+    world->getPairCache()->setOverlapFilterCallback(filter.get());
 }
 
 PhysicsWorld::~PhysicsWorld()
@@ -51,6 +164,22 @@ PhysicsWorld::~PhysicsWorld()
     config.reset();
 }
 
+void PhysicsWorld::SetDefaultSettings(const PhysicsSettings& settings) {
+    defaultSettings = settings;
+}
+
+PhysicsSettings PhysicsWorld::GetDefaultSettings() {
+    return defaultSettings;
+}
+
+void PhysicsWorld::SetStepRate(float stepRate) {
+    settings.stepRate = std::max(stepRate, 1.0f);
+}
+
+void PhysicsWorld::SetMaxStepsPerFrame(int maxSteps) {
+    settings.maxStepsPerFrame = std::max(maxSteps, 1);
+}
+
 Vec3 PhysicsWorld::GetGravity() const {
     btVector3 gravity = world->getGravity();
     return Vec3(gravity.getX(), gravity.getY(), gravity.getZ());
@@ -60,17 +189,164 @@ void PhysicsWorld::SetGravity(const Vec3& gravity) {
     world->setGravity(btVector3(gravity.x, gravity.y, gravity.z));
 }
 
+void PhysicsWorld::SetLayerCollision(LayerMask a, LayerMask b, bool collide)
+{
+    for (int i = 0; i < (int)layerCollisions.size(); ++i)
+    {
+        auto layer = (LayerMask)(1u << i);
+        auto& row = layerCollisions[i];
+
+        if ((a & layer) != LayerMask::None)
+            row = collide ? (row | b) : (row & ~b);
+
+        if ((b & layer) != LayerMask::None)
+            row = collide ? (row | a) : (row & ~a);
+    }
+
+    UpdateFilters();
+}
+
+LayerMask PhysicsWorld::GetLayerCollisions(LayerMask layers) const
+{
+    LayerMask result = LayerMask::None;
+
+    for (int i = 0; i < (int)layerCollisions.size(); ++i)
+    {
+        if ((layers & (1u << i)) != 0)
+            result |= layerCollisions[i];
+    }
+
+    return result;
+}
+
+void PhysicsWorld::SetTriggerLayers(LayerMask layers)
+{
+    triggerLayers = layers;
+    UpdateFilters();
+}
+
 void PhysicsWorld::AddRigidBody(const gptr<RigidBody>& body)
 {
     auto bodyWorld = body->world.lock();
     if (!bodyWorld)
     {
         bodies.push_back(body);
-        world->addRigidBody(body->body.get());
+        auto [group, mask] = ApplyLayers(body.get());
+        world->addRigidBody(body->body.get(), group, mask);
         body->world = self(this);
     }
 }
 
+std::pair<int, int> PhysicsWorld::ApplyLayers(RigidBody* body)
+{
+    auto layers = body->GetNode()->GetLayerMask();
+    auto mask = body->collisionMask.value_or(GetLayerCollisions(layers));
+    auto object = body->body.get();
+
+    object->setUserIndex(body->collisionMask ? OwnCollisionMask : -1);
+
+    auto flags = object->getCollisionFlags();
+
+    if (body->bodyType == BodyType::Ghost || (layers & triggerLayers) != LayerMask::None)
+        flags |= btCollisionObject::CF_NO_CONTACT_RESPONSE;
+    else
+        flags &= ~btCollisionObject::CF_NO_CONTACT_RESPONSE;
+
+    object->setCollisionFlags(flags);
+
+    body->filterLayers = layers;
+    return { (int)layers, (int)mask };
+}
+
+void PhysicsWorld::UpdateFilters()
+{
+    std::vector<RigidBody*> all(bodies.size());
+    std::transform(bodies.begin(), bodies.end(), all.begin(), [](auto& b) { return b.get(); });
+    UpdateFilters(all);
+}
+
+void PhysicsWorld::UpdateFilters(std::span<RigidBody* const> changed)
+{
+    std::vector<btBroadphaseProxy*> proxies;
+
+    for (RigidBody* body : changed)
+    {
+        auto [group, mask] = ApplyLayers(body);
+        auto object = body->body.get();
+        auto proxy = object->getBroadphaseHandle();
+
+        if (!proxy || (proxy->m_collisionFilterGroup == group && proxy->m_collisionFilterMask == mask))
+            continue;
+
+        proxy->m_collisionFilterGroup = group;
+        proxy->m_collisionFilterMask = mask;
+        proxies.push_back(proxy);
+
+        if (!object->isStaticOrKinematicObject())
+            object->activate();
+    }
+
+    if (proxies.empty())
+        return;
+
+    auto pairs = world->getPairCache();
+
+    // Drop the pairs that are no longer allowed. Their manifolds are freed
+    // with them, so their collisions are cancelled instead of stopped.
+    struct RemovePairs : public btOverlapCallback
+    {
+        PhysicsWorld* physics;
+        btManifoldArray manifolds;
+
+        virtual bool processOverlap(btBroadphasePair& pair) override
+        {
+            if (physics->filter->needBroadphaseCollision(pair.m_pProxy0, pair.m_pProxy1))
+                return false;
+
+            if (pair.m_algorithm)
+            {
+                manifolds.resize(0);
+                pair.m_algorithm->getAllContactManifolds(manifolds);
+
+                for (int i = 0; i < manifolds.size(); ++i)
+                {
+                    if (auto tracked = physics->FindCollision(manifolds[i]))
+                        tracked->state = CollisionState::Cancel;
+                }
+            }
+
+            return true;
+        }
+    } removePairs;
+
+    removePairs.physics = this;
+    pairs->processAllOverlappingPairs(&removePairs, dispatcher.get());
+
+    // The broadphase only looks for pairs when a body moves, so look for the
+    // ones that are now allowed here. The pair cache filters them again.
+    struct AddPairs : public btBroadphaseAabbCallback
+    {
+        btOverlappingPairCache* pairs;
+        btBroadphaseProxy* proxy;
+
+        virtual bool process(const btBroadphaseProxy* other) override
+        {
+            if (other != proxy)
+                pairs->addOverlappingPair(proxy, const_cast<btBroadphaseProxy*>(other));
+
+            return true;
+        }
+    } addPairs;
+
+    addPairs.pairs = pairs;
+
+    for (auto proxy : proxies)
+    {
+        addPairs.proxy = proxy;
+        broadphase->aabbTest(proxy->m_aabbMin, proxy->m_aabbMax, addPairs);
+    }
+}
+
 void PhysicsWorld::RemoveRigidBody(const gptr<RigidBody>& body)
 {
     auto bodyWorld = body->world.lock();
@@ -78,13 +354,16 @@ void PhysicsWorld::RemoveRigidBody(const gptr<RigidBody>& body)
     {
         body->world.reset();
         std::erase(bodies, body);
+
+        if (std::exchange(body->motionState->moved, false))
+            std::erase(movedBodies, body.get());
         
-        for (auto& [manifold, state] : collisions)
+        for (auto& tracked : collisions)
         {
-            if (manifold->getBody0() == body->body.get() ||
-                manifold->getBody1() == body->body.get())
+            if (tracked.manifold &&
+                (tracked.body0 == body.get() || tracked.body1 == body.get()))
             {
-                state = CollisionState::Cancel;
+                tracked.state = CollisionState::Cancel;
             }
         }
 
@@ -94,100 +373,206 @@ void PhysicsWorld::RemoveRigidBody(const gptr<RigidBody>& body)
 
 void PhysicsWorld::StepSimulation(float deltaTime)
 {
-    world->stepSimulation(deltaTime, 10);
+    auto startTime = std::chrono::steady_clock::now();
 
-    btDispatcher* disp = world->getDispatcher();
+    // Bullet keeps the time left over after whole steps, and reports the
+    // transforms of active bodies that far past their last step
+    int steps = world->stepSimulation(
+        deltaTime, settings.maxStepsPerFrame, 1.0f / settings.stepRate);
 
-    auto numManifolds = disp->getNumManifolds();
-    for (int i = 0; i != numManifolds; ++i)
+    stats.steps = steps;
+    stats.movedBodies = (int)movedBodies.size();
+    stats.pairs = world->getPairCache()->getNumOverlappingPairs();
+    stats.manifolds = dispatcher->getNumManifolds();
+
+    WriteTransforms();
+
+    stats.stepTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    // contacts only change when the simulation steps
+    if (steps == 0)
     {
-        btPersistentManifold* manifold = disp->getManifoldByIndexInternal(i);
-        
-        auto [it, didInsert] = collisions.insert(
-            std::make_pair(manifold, CollisionState::Start));
+        stats.collisionEvents = 0;
+        return;
+    }
 
-        if (!didInsert && it->second != CollisionState::Cancel)
-            it->second = CollisionState::Update;
+    UpdateCollisions();
+
+    // Deliver events in a stable order. A handler may remove a body, which
+    // cancels its collisions, so their remaining events are skipped.
+    std::sort(collisionEvents.begin(), collisionEvents.end(),
+        [](const CollisionEvent& a, const CollisionEvent& b) {
+            return a.state != b.state ? a.state < b.state : a.slot < b.slot;
+        });
+
+    stats.collisionEvents = (int)collisionEvents.size();
+
+    for (auto& event : collisionEvents)
+    {
+        if (collisions[event.slot].state != CollisionState::Cancel)
+            PerformCollisionCallbacks(event);
     }
 
-    for (auto it = collisions.begin(); it != collisions.end(); )
+    collisionEvents.clear();
+
+    // forget manifolds that are gone
+    for (int slot = 0; slot < (int)collisions.size(); ++slot)
     {
-        if (it->second == CollisionState::Start)
-        {
-            PerformCollisionCallbacks(it->first, it->second);
+        auto& tracked = collisions[slot];
 
-            if (it->second == CollisionState::Cancel) {
-                it = collisions.erase(it);
-            }
-            else {
-                it->second = CollisionState::Stop;
-                ++it;
-            }
+        if (tracked.manifold &&
+            (tracked.state == CollisionState::Stop || tracked.state == CollisionState::Cancel))
+        {
+            tracked.manifold = nullptr;
+            freeCollisions.push_back(slot);
         }
-        else if (it->second == CollisionState::Update)
+    }
+}
+
+void PhysicsWorld::WriteTransforms()
+{
+    for (RigidBody* body : movedBodies)
+    {
+        auto motionState = body->motionState.get();
+        motionState->moved = false;
+
+        auto node = body->GetNode();
+        Assert(node);
+
+        auto& transform = motionState->simulatedTransform;
+        Vec3 pos = Bullet::ToVec3(transform.getOrigin());
+        Quat rot = Bullet::ToQuat(transform.getRotation());
+        pos -= (body->localCenterOfMass * rot);
+
+        node->SetPositionAndRotation(pos, rot);
+        body->transformDirty = false;
+    }
+
+    movedBodies.clear();
+}
+
+PhysicsWorld::TrackedCollision* PhysicsWorld::FindCollision(btPersistentManifold* manifold)
+{
+    int slot = manifold->m_companionIdA - 1;
+
+    if (slot >= 0 && slot < (int)collisions.size() && collisions[slot].manifold == manifold)
+        return &collisions[slot];
+
+    return nullptr;
+}
+
+void PhysicsWorld::UpdateCollisions()
+{
+    ++collisionStep;
+
+    btDispatcher* disp = world->getDispatcher();
+
+    int numManifolds = disp->getNumManifolds();
+    for (int i = 0; i != numManifolds; ++i)
+    {
+        btPersistentManifold* manifold = disp->getManifoldByIndexInternal(i);
+
+        if (auto tracked = FindCollision(manifold))
         {
-            PerformCollisionCallbacks(it->first, it->second);
+            if (tracked->state != CollisionState::Cancel)
+                tracked->state = CollisionState::Update;
 
-            if (it->second == CollisionState::Cancel) {
-                it = collisions.erase(it);
-            }
-            else {
-                it->second = CollisionState::Stop;
-                ++it;
-            }
+            tracked->lastStep = collisionStep;
+            continue;
         }
-        else if (it->second == CollisionState::Stop)
+
+        int slot;
+
+        if (!freeCollisions.empty())
         {
-            PerformCollisionCallbacks(it->first, it->second);
-            it = collisions.erase(it);
+            slot = freeCollisions.back();
+            freeCollisions.pop_back();
         }
-        else if (it->second == CollisionState::Cancel)
+        else
         {
-            it = collisions.erase(it);
+            slot = (int)collisions.size();
+            collisions.emplace_back();
+        }
+
+        auto& tracked = collisions[slot];
+        tracked.manifold = manifold;
+        tracked.body0 = (RigidBody*)manifold->getBody0()->getUserPointer();
+        tracked.body1 = (RigidBody*)manifold->getBody1()->getUserPointer();
+        tracked.state = CollisionState::Start;
+        tracked.lastStep = collisionStep;
+        Assert(tracked.body0 && tracked.body1);
+
+        manifold->m_companionIdA = slot + 1;
+    }
+
+    // Manifolds that weren't seen this step are gone, and only collisions
+    // between bodies with handlers become events.
+    for (int slot = 0; slot < (int)collisions.size(); ++slot)
+    {
+        auto& tracked = collisions[slot];
+
+        if (!tracked.manifold || tracked.state == CollisionState::Cancel)
+            continue;
+
+        if (tracked.lastStep != collisionStep)
+            tracked.state = CollisionState::Stop;
+
+        if (!tracked.body0->GetCollisionHandlers().empty() ||
+            !tracked.body1->GetCollisionHandlers().empty())
+        {
+            collisionEvents.push_back({ slot, tracked.state });
         }
     }
 }
 
-void PhysicsWorld::PerformCollisionCallbacks(btPersistentManifold* manifold, CollisionState& state)
+void PhysicsWorld::PerformCollisionCallbacks(const CollisionEvent& event)
 {
-    auto body0 = (RigidBody*)manifold->getBody0()->getUserPointer();
-    auto body1 = (RigidBody*)manifold->getBody1()->getUserPointer();
-    Assert(body0 && body1);
-    
+    auto& tracked = collisions[event.slot];
+    auto state = event.state;
+
+    // handlers may destroy either body, so hold on to both until they're done
+    gptr<RigidBody> body0 = tracked.body0->self(tracked.body0);
+    gptr<RigidBody> body1 = tracked.body1->self(tracked.body1);
+
     int contacts = 0;
     std::array<ContactPoint, 8> contactPoints;
 
-    int numContacts = manifold->getNumContacts();
-    for (int c = 0; c != numContacts; ++c)
-    {
-        btManifoldPoint& contactPoint = manifold->getContactPoint(c);
-        auto worldPosA = contactPoint.m_positionWorldOnA;
-        auto worldPosB = contactPoint.m_positionWorldOnB;
-        btVector3 point = worldPosA + ((worldPosB - worldPosA) *= 0.5f);
-        auto normal = contactPoint.m_normalWorldOnB;
-        auto distance = contactPoint.m_distance1;
-
-        auto index0 = contactPoint.m_index0;
-        auto index1 = contactPoint.m_index1;
-        auto partId0 = contactPoint.m_partId0;
-        auto partId1 = contactPoint.m_partId1;
-
-        contactPoints[contacts++] = ContactPoint{
-            { point.x(), point.y(), point.z() },
-            { normal.x(), normal.y(), normal.z() },
-            distance
-        };
+    // a stopped collision's manifold is already gone
+    if (state != CollisionState::Stop)
+    {
+        auto manifold = tracked.manifold;
+
+        int numContacts = manifold->getNumContacts();
+        for (int c = 0; c != numContacts; ++c)
+        {
+            btManifoldPoint& contactPoint = manifold->getContactPoint(c);
+            auto worldPosA = contactPoint.m_positionWorldOnA;
+            auto worldPosB = contactPoint.m_positionWorldOnB;
+            btVector3 point = worldPosA + ((worldPosB - worldPosA) *= 0.5f);
+            auto normal = contactPoint.m_normalWorldOnB;
+            auto distance = contactPoint.m_distance1;
+
+            contactPoints[contacts++] = ContactPoint{
+                { point.x(), point.y(), point.z() },
+                { normal.x(), normal.y(), normal.z() },
+                distance
+            };
+        }
     }
 
     Collision collision = {
-        body1->self(body1),
+        body1,
         std::span<ContactPoint>(contactPoints.data(), contacts)
     };
 
-    for (auto& c : body0->GetNode()->GetComponents())
+    auto deliver = [&](std::vector<ICollisionEvents*>& handlers)
     {
-        if (auto h = dynamic_cast<ICollisionEvents*>(c.get()))
+        // handlers are cleared if a component is added or removed, so
+        // check the size each time around
+        for (std::size_t i = 0; i < handlers.size(); ++i)
         {
+            auto h = handlers[i];
+
             switch (state)
             {
             case CollisionState::Start:
@@ -203,39 +588,397 @@ void PhysicsWorld::PerformCollisionCallbacks(btPersistentManifold* manifold, Col
                 break;
             }
 
-            if (state == CollisionState::Cancel)
-                return;
+            if (collisions[event.slot].state == CollisionState::Cancel)
+                return false;
         }
-    }
 
-    collision.body = body0->self(body0);
-    
+        return true;
+    };
+
+    if (!deliver(body0->GetCollisionHandlers()))
+        return;
+
+    collision.body = body0;
+
     for (auto& contact : collision.contacts)
         contact.normal = -contact.normal;
 
-    for (auto& c : body1->GetNode()->GetComponents())
+    deliver(body1->GetCollisionHandlers());
+}
+
+QueryShape QueryShape::Sphere(float radius)
+{
+    QueryShape shape;
+    shape.type = QueryShapeType::Sphere;
+    shape.radius = radius;
+    return shape;
+}
+
+QueryShape QueryShape::Box(const Vec3& extents, const Quat& rotation)
+{
+    QueryShape shape;
+    shape.type = QueryShapeType::Box;
+    shape.extents = extents;
+    shape.rotation = rotation;
+    return shape;
+}
+
+QueryShape QueryShape::Capsule(float radius, float height, const Quat& rotation)
+{
+    QueryShape shape;
+    shape.type = QueryShapeType::Capsule;
+    shape.radius = radius;
+    shape.height = height;
+    shape.rotation = rotation;
+    return shape;
+}
+
+// the Bullet shape for a QueryShape, without allocating
+class QueryConvexShape
+{
+    std::optional<btSphereShape> sphere;
+    std::optional<btBoxShape> box;
+    std::optional<CapsuleShape> capsule;
+public:
+    explicit QueryConvexShape(const QueryShape& shape)
+    {
+        if (shape.type == QueryShapeType::Sphere)
+            sphere.emplace(shape.radius);
+        else if (shape.type == QueryShapeType::Box)
+            box.emplace(Bullet::FromVec3(shape.extents));
+        else if (shape.type == QueryShapeType::Capsule)
+            capsule.emplace(Axis::Y, shape.radius, shape.height);
+        else
+            throw Exception("invalid QueryShapeType");
+    }
+
+    const btConvexShape* Get() const
     {
-        if (auto h = dynamic_cast<ICollisionEvents*>(c.get()))
+        if (sphere) return &*sphere;
+        if (box) return &*box;
+        return &*capsule;
+    }
+};
+
+static bool Overlaps(
+    const btConvexShape* shape, const btTransform& transform,
+    const btCollisionShape* other, const btTransform& otherTransform)
+{
+    if (other->isConvex())
+    {
+        btVoronoiSimplexSolver simplexSolver;
+        btGjkEpaPenetrationDepthSolver depthSolver;
+        btGjkPairDetector detector(shape, (const btConvexShape*)other, &simplexSolver, &depthSolver);
+
+        btGjkPairDetector::ClosestPointInput input;
+        input.m_transformA = transform;
+        input.m_transformB = otherTransform;
+
+        btPointCollector result;
+        detector.getClosestPoints(input, result, nullptr);
+        return result.m_hasResult && result.m_distance <= 0;
+    }
+    else if (other->isConcave())
+    {
+        // test the triangles near 'shape', in the space of 'other'
+        struct TriangleTester : public btTriangleCallback
         {
-            switch (state)
-            {
-            case CollisionState::Start:
-                h->OnCollisionStart(collision);
-                break;
+            const btConvexShape* shape;
+            btTransform transform;
+            bool overlaps = false;
 
-            case CollisionState::Update:
-                h->OnCollisionUpdate(collision);
-                break;
+            virtual void processTriangle(btVector3* vertices, int partId, int triangleIndex) override
+            {
+                if (overlaps)
+                    return;
 
-            case CollisionState::Stop:
-                h->OnCollisionStop(collision);
-                break;
+                btTriangleShape triangle(vertices[0], vertices[1], vertices[2]);
+                overlaps = Overlaps(shape, transform, &triangle, btTransform::getIdentity());
             }
+        };
+
+        TriangleTester tester;
+        tester.shape = shape;
+        tester.transform = otherTransform.inverse() * transform;
+
+        btVector3 aabbMin, aabbMax;
+        shape->getAabb(tester.transform, aabbMin, aabbMax);
+
+        ((const btConcaveShape*)other)->processAllTriangles(&tester, aabbMin, aabbMax);
+        return tester.overlaps;
+    }
+
+    return false;
+}
+
+Collider* PhysicsWorld::FindCollider(const btCollisionObject* object, int child, LayerMask layers)
+{
+    auto body = (RigidBody*)object->getUserPointer();
+    if (!body || child >= (int)body->colliders.size())
+        return nullptr;
+
+    if (object->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE)
+        return nullptr;
+
+    Collider* collider = body->colliders[child].get();
+    auto node = collider->GetNode();
+
+    if (!node || (node->GetLayerMask() & layers) == LayerMask::None)
+        return nullptr;
 
-            if (state == CollisionState::Cancel)
+    return collider;
+}
+
+std::optional<RaycastHit> PhysicsWorld::Cast(
+    const btConvexShape* shape, const Quat& rotation,
+    const Ray& ray, float maxDistance, LayerMask layers) const
+{
+    float length = ray.direction.Length();
+    float distance = std::min(maxDistance, MaxQueryDistance);
+
+    if (length == 0 || !(distance > 0))
+        return std::nullopt;
+
+    Vec3 direction = ray.direction / length;
+
+    btVector3 from = Bullet::FromVec3(ray.origin);
+    btVector3 to = Bullet::FromVec3(ray.origin + direction * distance);
+    btQuaternion orientation = Bullet::FromQuat(rotation);
+
+    // test each body the ray or swept shape's bounds pass through
+    struct Tester : public btDbvt::ICollide
+    {
+        const btConvexShape* shape;
+        btTransform fromTrans;
+        btTransform toTrans;
+        LayerMask layers;
+
+        btScalar fraction = 1;
+        const btCollisionObject* object = nullptr;
+        Collider* collider = nullptr;
+        btVector3 point;
+        btVector3 normal;
+
+        void Process(const btDbvtNode* leaf)
+        {
+            auto proxy = (const btBroadphaseProxy*)leaf->data;
+            auto obj = (btCollisionObject*)proxy->m_clientObject;
+            auto compound = (const btCompoundShape*)obj->getCollisionShape();
+
+            if (!compound || !compound->isCompound())
                 return;
+
+            for (int i = 0; i < compound->getNumChildShapes(); ++i)
+            {
+                Collider* c = FindCollider(obj, i, layers);
+                if (!c)
+                    continue;
+
+                auto childShape = compound->getChildShape(i);
+                auto childTrans = obj->getWorldTransform() * compound->getChildTransform(i);
+
+                if (shape)
+                {
+                    btCollisionWorld::ClosestConvexResultCallback result(fromTrans.getOrigin(), toTrans.getOrigin());
+                    result.m_closestHitFraction = fraction;
+
+                    btCollisionWorld::objectQuerySingle(
+                        shape, fromTrans, toTrans, obj, childShape, childTrans, result, 0);
+
+                    if (result.m_hitCollisionObject)
+                    {
+                        fraction = result.m_closestHitFraction;
+                        object = obj;
+                        collider = c;
+                        point = result.m_hitPointWorld;
+                        normal = result.m_hitNormalWorld;
+                    }
+                }
+                else
+                {
+                    btCollisionWorld::ClosestRayResultCallback result(fromTrans.getOrigin(), toTrans.getOrigin());
+                    result.m_closestHitFraction = fraction;
+
+                    btCollisionWorld::rayTestSingle(
+                        fromTrans, toTrans, obj, childShape, childTrans, result);
+
+                    if (result.m_collisionObject)
+                    {
+                        fraction = result.m_closestHitFraction;
+                        object = obj;
+                        collider = c;
+                        point = result.m_hitPointWorld;
+                        normal = result.m_hitNormalWorld;
+                    }
+                }
+            }
         }
+    };
+
+    Tester tester;
+    tester.shape = shape;
+    tester.fromTrans = btTransform(orientation, from);
+    tester.toTrans = btTransform(orientation, to);
+    tester.layers = layers;
+
+    btVector3 aabbMin(0, 0, 0);
+    btVector3 aabbMax(0, 0, 0);
+
+    if (shape)
+        shape->getAabb(btTransform(orientation), aabbMin, aabbMax);
+
+    btVector3 rayDirection = Bullet::FromVec3(direction);
+    btVector3 rayDirectionInverse;
+    unsigned int signs[3];
+
+    for (int i = 0; i < 3; ++i)
+    {
+        rayDirectionInverse[i] = rayDirection[i] == 0 ? BT_LARGE_FLOAT : 1 / rayDirection[i];
+        signs[i] = rayDirectionInverse[i] < 0;
+    }
+
+    // one traversal stack per thread, so queries can run in parallel
+    thread_local btAlignedObjectArray<const btDbvtNode*> stack;
+
+    for (auto& set : broadphase->m_sets)
+    {
+        set.rayTestInternal(
+            set.m_root, from, to, rayDirectionInverse, signs, distance,
+            aabbMin, aabbMax, stack, tester);
     }
+
+    if (!tester.object)
+        return std::nullopt;
+
+    auto body = (RigidBody*)tester.object->getUserPointer();
+
+    RaycastHit hit;
+    hit.body = body->self(body);
+    hit.collider = tester.collider->self(tester.collider);
+    hit.point = Bullet::ToVec3(tester.point);
+    hit.normal = Bullet::ToVec3(tester.normal).Normalized();
+    hit.distance = tester.fraction * distance;
+    return hit;
+}
+
+std::optional<RaycastHit> PhysicsWorld::Raycast(
+    const Ray& ray, float maxDistance, LayerMask layers) const
+{
+    return Cast(nullptr, Quat::Identity(), ray, maxDistance, layers);
+}
+
+std::optional<RaycastHit> PhysicsWorld::ShapeCast(
+    const QueryShape& shape, const Ray& ray, float maxDistance, LayerMask layers) const
+{
+    QueryConvexShape convexShape(shape);
+    return Cast(convexShape.Get(), shape.rotation, ray, maxDistance, layers);
+}
+
+gvector<OverlapHit> PhysicsWorld::Overlap(
+    const QueryShape& shape, const Vec3& position, LayerMask layers) const
+{
+    gvector<OverlapHit> hits;
+    Overlap(OverlapQuery{ shape, position, layers }, hits);
+    return hits;
+}
+
+void PhysicsWorld::Overlap(const OverlapQuery& query, gvector<OverlapHit>& hits) const
+{
+    hits.clear();
+
+    QueryConvexShape convexShape(query.shape);
+
+    struct Tester : public btDbvt::ICollide
+    {
+        const btConvexShape* shape;
+        btTransform transform;
+        LayerMask layers;
+        gvector<OverlapHit>* hits;
+
+        void Process(const btDbvtNode* leaf)
+        {
+            auto proxy = (const btBroadphaseProxy*)leaf->data;
+            auto obj = (const btCollisionObject*)proxy->m_clientObject;
+            auto compound = (const btCompoundShape*)obj->getCollisionShape();
+
+            if (!compound || !compound->isCompound())
+                return;
+
+            for (int i = 0; i < compound->getNumChildShapes(); ++i)
+            {
+                Collider* c = FindCollider(obj, i, layers);
+                if (!c)
+                    continue;
+
+                auto childShape = compound->getChildShape(i);
+                auto childTrans = obj->getWorldTransform() * compound->getChildTransform(i);
+
+                if (Overlaps(shape, transform, childShape, childTrans))
+                {
+                    auto body = (RigidBody*)obj->getUserPointer();
+                    hits->push_back({ body->self(body), c->self(c) });
+                }
+            }
+        }
+    };
+
+    Tester tester;
+    tester.shape = convexShape.Get();
+    tester.transform = btTransform(Bullet::FromQuat(query.shape.rotation), Bullet::FromVec3(query.position));
+    tester.layers = query.layers;
+    tester.hits = &hits;
+
+    btVector3 aabbMin, aabbMax;
+    tester.shape->getAabb(tester.transform, aabbMin, aabbMax);
+    auto bounds = btDbvtVolume::FromMM(aabbMin, aabbMax);
+
+    for (auto& set : broadphase->m_sets)
+        set.collideTV(set.m_root, bounds, tester);
+}
+
+void PhysicsWorld::Raycast(
+    std::span<const RaycastQuery> queries,
+    std::span<std::optional<RaycastHit>> hits) const
+{
+    std::size_t count = std::min(queries.size(), hits.size());
+
+    JobSystem::GetInstance().ParallelFor(count, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            auto& q = queries[i];
+            hits[i] = Raycast(q.ray, q.maxDistance, q.layers);
+        }
+    });
+}
+
+void PhysicsWorld::ShapeCast(
+    std::span<const ShapeCastQuery> queries,
+    std::span<std::optional<RaycastHit>> hits) const
+{
+    std::size_t count = std::min(queries.size(), hits.size());
+
+    JobSystem::GetInstance().ParallelFor(count, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            auto& q = queries[i];
+            hits[i] = ShapeCast(q.shape, q.ray, q.maxDistance, q.layers);
+        }
+    });
+}
+
+void PhysicsWorld::Overlap(
+    std::span<const OverlapQuery> queries,
+    std::span<gvector<OverlapHit>> hits) const
+{
+    std::size_t count = std::min(queries.size(), hits.size());
+
+    JobSystem::GetInstance().ParallelFor(count, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            Overlap(queries[i], hits[i]);
+    });
 }
 
 } // scene
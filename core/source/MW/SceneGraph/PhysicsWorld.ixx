@@ -4,6 +4,7 @@
 
 export module Microwave.SceneGraph.PhysicsWorld;
 import Microwave.Math;
+import Microwave.SceneGraph.LayerMask;
 import Microwave.System.Object;
 import Microwave.System.Pointers;
 import std;
@@ -12,17 +13,22 @@ export {
 class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
 struct btDbvtBroadphase;
-class btSequentialImpulseConstraintSolver;
+class btConstraintSolver;
 class btDiscreteDynamicsWorld;
 class btPersistentManifold;
+class btCollisionObject;
+class btConvexShape;
+struct btOverlapFilterCallback;
 }
 
 export namespace mw {
 inline namespace scene {
 
 class Bullet;
+class Collider;
 class D6Joint;
 class RigidBody;
+class RigidBodyMotionState;
 
 enum class CollisionState
 {
@@ -32,34 +38,244 @@ enum class CollisionState
     Cancel
 };
 
+struct PhysicsSettings
+{
+    // The simulation advances in fixed steps of 1 / stepRate seconds, as
+    // many as fit in the time that has passed. Bodies are drawn between
+    // their last two steps, so they move smoothly at any frame rate.
+    float stepRate = 60.0f;
+
+    // when a frame needs more steps than this, the simulation slows down
+    int maxStepsPerFrame = 10;
+
+    // solve collisions and islands in parallel on the JobSystem
+    bool multithreaded = false;
+};
+
+struct PhysicsStats
+{
+    // during the last StepSimulation
+    int steps = 0;
+    int movedBodies = 0;      // active bodies written back to their nodes
+    int collisionEvents = 0;  // delivered to handlers
+    int pairs = 0;            // overlapping pairs the layer filter let through to narrowphase
+    int manifolds = 0;        // pairs whose shapes are close enough to have contact points
+    double stepTime = 0;      // seconds spent stepping and writing back, without callbacks
+};
+
+// queries never reach further than this, even if asked to
+constexpr float MaxQueryDistance = 100000.0f;
+
+struct RaycastHit
+{
+    gptr<RigidBody> body;
+    gptr<Collider> collider;
+    Vec3 point;
+    Vec3 normal;
+    float distance = 0; // along the ray, from its origin
+};
+
+struct OverlapHit
+{
+    gptr<RigidBody> body;
+    gptr<Collider> collider;
+};
+
+enum class QueryShapeType
+{
+    Sphere,
+    Box,
+    Capsule
+};
+
+// A shape to sweep or test for overlaps, with the same dimensions as the
+// matching collider. Capsules run along the Y axis of 'rotation'.
+struct QueryShape
+{
+    QueryShapeType type = QueryShapeType::Sphere;
+    float radius = 0.5f;                 // Sphere, Capsule
+    float height = 1.0f;                 // Capsule, between the caps
+    Vec3 extents = { 0.5f, 0.5f, 0.5f }; // Box, half of its size
+    Quat rotation;
+
+    static QueryShape Sphere(float radius);
+    static QueryShape Box(const Vec3& extents, const Quat& rotation = Quat::Identity());
+    static QueryShape Capsule(float radius, float height, const Quat& rotation = Quat::Identity());
+};
+
+struct RaycastQuery
+{
+    Ray ray;
+    float maxDistance = MaxQueryDistance;
+    LayerMask layers = LayerMask::All;
+};
+
+struct ShapeCastQuery
+{
+    QueryShape shape;
+    Ray ray; // 'shape' starts centered on the ray's origin
+    float maxDistance = MaxQueryDistance;
+    LayerMask layers = LayerMask::All;
+};
+
+struct OverlapQuery
+{
+    QueryShape shape;
+    Vec3 position;
+    LayerMask layers = LayerMask::All;
+};
+
 class PhysicsWorld : public Object
 {
+    // A manifold, from the step it appears in until the step after it's
+    // gone. Each manifold's m_companionIdA, which Bullet doesn't otherwise
+    // use, holds its slot + 1, and is 0 for manifolds that aren't tracked yet.
+    struct TrackedCollision
+    {
+        btPersistentManifold* manifold = nullptr;  // null for free slots
+        RigidBody* body0 = nullptr;
+        RigidBody* body1 = nullptr;
+        CollisionState state = CollisionState::Start;
+        std::uint32_t lastStep = 0;  // the last step the manifold existed in
+    };
+
+    struct CollisionEvent
+    {
+        int slot;
+        CollisionState state;
+    };
+
     uptr<btDefaultCollisionConfiguration> config;
     uptr<btCollisionDispatcher> dispatcher;
     uptr<btDbvtBroadphase> broadphase;
-    uptr<btSequentialImpulseConstraintSolver> solver;
+    uptr<btConstraintSolver> solver;
     uptr<btDiscreteDynamicsWorld> world;
-    std::unordered_map<btPersistentManifold*, CollisionState> collisions;
+    uptr<btOverlapFilterCallback> filter;
+    std::vector<TrackedCollision> collisions;
+    std::vector<int> freeCollisions;
+    std::vector<CollisionEvent> collisionEvents;
+    std::uint32_t collisionStep = 0;
     gvector<gptr<RigidBody>> bodies;
+    std::vector<RigidBody*> movedBodies;
+    PhysicsSettings settings;
+    PhysicsStats stats;
+
+    // the layers each layer collides with, by bit index
+    std::array<LayerMask, 32> layerCollisions;
+    LayerMask triggerLayers = LayerMask::None;
 
-    void PerformCollisionCallbacks(btPersistentManifold* manifold, CollisionState& state);
+    inline static PhysicsSettings defaultSettings;
+
+    // the tracked collision for a manifold that still exists, if any
+    TrackedCollision* FindCollision(btPersistentManifold* manifold);
+
+    void UpdateCollisions();
+    void PerformCollisionCallbacks(const CollisionEvent& event);
 
     friend Bullet;
     friend D6Joint;
     friend RigidBody;
+    friend RigidBodyMotionState;
 public:
-    PhysicsWorld();
+    // 'multithreaded' can't change once a world is created
+    explicit PhysicsWorld(const PhysicsSettings& settings = defaultSettings);
     ~PhysicsWorld();
 
+    // used by worlds created without settings, such as each Scene's
+    static void SetDefaultSettings(const PhysicsSettings& settings);
+    static PhysicsSettings GetDefaultSettings();
+
+    const PhysicsSettings& GetSettings() const { return settings; }
+    void SetStepRate(float stepRate);
+    void SetMaxStepsPerFrame(int maxSteps);
+    bool IsMultithreaded() const { return settings.multithreaded; }
+
     Vec3 GetGravity() const;
     void SetGravity(const Vec3& gravity);
 
+    // advances by 'deltaTime', in as many fixed steps as it covers
     void StepSimulation(float deltaTime);
 
+    PhysicsStats GetStats() const { return stats; }
+
     int GetBodyCount() const { return (int)bodies.size(); }
+
+    // Bodies are filtered by the layers of their node. Two bodies collide if
+    // the layer matrix lets any of their layers collide, so a body on no
+    // layers collides with nothing. A body with its own collision mask
+    // decides for itself which layers it collides with. All layers collide
+    // with each other by default. Changes apply to bodies already in the
+    // world, and pairs that are no longer allowed stop without a callback.
+
+    // sets whether every layer in 'a' collides with every layer in 'b'
+    void SetLayerCollision(LayerMask a, LayerMask b, bool collide);
+
+    // the layers that any of 'layers' collide with
+    LayerMask GetLayerCollisions(LayerMask layers) const;
+
+    // Bodies on trigger layers report collisions like ghost bodies do,
+    // without pushing other bodies away.
+    void SetTriggerLayers(LayerMask layers);
+    LayerMask GetTriggerLayers() const { return triggerLayers; }
+
+    // Queries test colliders whose node is on one of 'layers', and ignore
+    // ghost bodies and bodies on trigger layers. They only read the world,
+    // so any number of them can run at once, but not while it's stepped or
+    // bodies are added or removed.
+
+    // the closest hit along 'ray'
+    std::optional<RaycastHit> Raycast(
+        const Ray& ray,
+        float maxDistance = MaxQueryDistance,
+        LayerMask layers = LayerMask::All) const;
+
+    // the first hit of 'shape' as it's swept along 'ray'
+    std::optional<RaycastHit> ShapeCast(
+        const QueryShape& shape,
+        const Ray& ray,
+        float maxDistance = MaxQueryDistance,
+        LayerMask layers = LayerMask::All) const;
+
+    // every collider touching 'shape' at 'position'
+    gvector<OverlapHit> Overlap(
+        const QueryShape& shape,
+        const Vec3& position,
+        LayerMask layers = LayerMask::All) const;
+
+    // Batched queries, split across the JobSystem's workers. Each result is
+    // written to the same index as its query, up to the shorter of the two.
+    void Raycast(std::span<const RaycastQuery> queries, std::span<std::optional<RaycastHit>> hits) const;
+    void ShapeCast(std::span<const ShapeCastQuery> queries, std::span<std::optional<RaycastHit>> hits) const;
+    void Overlap(std::span<const OverlapQuery> queries, std::span<gvector<OverlapHit>> hits) const;
 private:
     void AddRigidBody(const gptr<RigidBody>& body);
     void RemoveRigidBody(const gptr<RigidBody>& body);
+
+    // sets the flags of 'body' from the layer settings, and returns its
+    // collision filter group and mask
+    std::pair<int, int> ApplyLayers(RigidBody* body);
+
+    // Applies the layer settings to bodies that are already in the world.
+    // Pairs the filter no longer allows are dropped along with their
+    // manifolds, and pairs it now allows are found without waiting for
+    // either body to move.
+    void UpdateFilters(std::span<RigidBody* const> bodies);
+    void UpdateFilter(RigidBody* body) { UpdateFilters({ &body, 1 }); }
+    void UpdateFilters();
+
+    // copies the transforms of bodies that moved during the last step to their nodes
+    void WriteTransforms();
+
+    // 'shape' is null for rays
+    std::optional<RaycastHit> Cast(
+        const btConvexShape* shape, const Quat& rotation,
+        const Ray& ray, float maxDistance, LayerMask layers) const;
+
+    void Overlap(const OverlapQuery& query, gvector<OverlapHit>& hits) const;
+
+    // the collider for child shape 'child' of 'object', or null if it
+    // isn't on one of 'layers'
+    static Collider* FindCollider(const btCollisionObject* object, int child, LayerMask layers);
 };
 
 } // scene
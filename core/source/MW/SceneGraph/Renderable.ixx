@@ -41,17 +41,26 @@ public:
     std::size_t drawCount = {};
     DrawMode drawMode = DrawMode::Triangles;
 
-    static std::uint64_t MakeSortKey(std::uint32_t renderQueue, float depth)
+    // Queue in the top 16 bits. Below the transparent queue, 'state' comes
+    // next so that draws sharing a shader and material end up together, and
+    // depth sorts front to back within each state. From the transparent
+    // queue up, 'state' is ignored and depth sorts back to front.
+    static std::uint64_t MakeSortKey(std::uint32_t renderQueue, float depth, std::uint32_t state = 0)
     {
-        constexpr std::uint32_t maxDepth = std::numeric_limits<std::uint32_t>::max();
-
-        std::uint64_t uQueue = (std::uint64_t)renderQueue;
-        std::uint64_t uDepth = (std::uint64_t)((double)depth * maxDepth);
+        std::uint64_t uQueue = (std::uint64_t)std::min<std::uint32_t>(renderQueue, 0xFFFF);
 
         if (uQueue >= RenderQueue::Transparent)
-            uDepth = maxDepth - uDepth;
+        {
+            constexpr std::uint32_t maxDepth = std::numeric_limits<std::uint32_t>::max();
+            std::uint64_t uDepth = maxDepth - (std::uint64_t)((double)depth * maxDepth);
+            return (uQueue << 48) | uDepth;
+        }
+
+        constexpr std::uint32_t maxDepth = 0xFFFFFF;
+        std::uint64_t uDepth = (std::uint64_t)((double)depth * maxDepth);
+        std::uint64_t uState = (std::uint64_t)(state & 0xFFFFFF);
 
-        return (uQueue << 32) | uDepth;
+        return (uQueue << 48) | (uState << 24) | uDepth;
     }
 };
 
@@ -9,6 +9,7 @@ import Microwave.SceneGraph.Components.DirectionalLight;
 import Microwave.SceneGraph.Components.Script;
 import Microwave.SceneGraph.Node;
 import Microwave.SceneGraph.PhysicsWorld;
+import Microwave.SceneGraph.TransformStore;
 import Microwave.System.App;
 import Microwave.Utilities.Util;
 import std;
@@ -160,6 +161,10 @@ void Scene::Update()
     RunUpdates(systemUpdates, updateCache, {}, &ISystemEvents::SystemUpdate1);
     RunUpdates(systemUpdates, updateCache, {}, &ISystemEvents::SystemUpdate2);
 
+    // resolve everything moved by the updates above in one batch, rather
+    // than one node at a time as physics and rendering query them
+    TransformStore::GetInstance().UpdateWorldTransforms();
+
     physicsWorld->StepSimulation(clock->GetDeltaTime());
 
     RunUpdates(userUpdates, updateCache, {}, &IUserEvents::LateUpdate);
@@ -192,7 +197,10 @@ void Scene::RegisterComponent(const gptr<Component>& comp)
         lights.push_back(p);
 
     if (auto p = gpcast<IRenderEvents>(comp))
+    {
         renderEvents.push_back(p);
+        renderComponents.push_back(comp);
+    }
 }
 
 void Scene::UnregisterComponent(const gptr<Component>& comp)
@@ -223,7 +231,14 @@ void Scene::UnregisterComponent(const gptr<Component>& comp)
         std::erase(lights, p);
 
     if (auto p = gpcast<IRenderEvents>(comp))
-        std::erase(renderEvents, p);
+    {
+        auto it = std::find(renderEvents.begin(), renderEvents.end(), p);
+        if (it != renderEvents.end())
+        {
+            renderComponents.erase(renderComponents.begin() + (it - renderEvents.begin()));
+            renderEvents.erase(it);
+        }
+    }
 }
 
 }
@@ -41,6 +41,7 @@ public:
     gvector<gptr<Script>> scripts;
     gvector<gptr<DirectionalLight>> lights;
     gvector<gptr<IRenderEvents>> renderEvents;
+    gvector<gptr<Component>> renderComponents; // same order as 'renderEvents'
 
     gvector<gptr<void>> updateCache;
     gptr<PhysicsWorld> physicsWorld;
@@ -6,6 +6,7 @@ export module Microwave.SceneGraph;
 export import Microwave.SceneGraph.Axis;
 export import Microwave.SceneGraph.Components;
 export import Microwave.SceneGraph.Coroutine;
+export import Microwave.SceneGraph.Culling;
 export import Microwave.SceneGraph.Events;
 export import Microwave.SceneGraph.LayerMask;
 export import Microwave.SceneGraph.Node;
@@ -13,3 +14,4 @@ export import Microwave.SceneGraph.PhysicsWorld;
 export import Microwave.SceneGraph.Renderable;
 export import Microwave.SceneGraph.Scene;
 export import Microwave.SceneGraph.SceneRenderer;
+export import Microwave.SceneGraph.TransformStore;
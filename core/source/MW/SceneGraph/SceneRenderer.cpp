@@ -5,24 +5,35 @@
 module Microwave.SceneGraph.SceneRenderer;
 import Microwave.Graphics.Color;
 import Microwave.Graphics.GraphicsContext;
+import Microwave.Graphics.ShaderInfo;
 import Microwave.Math;
 import Microwave.SceneGraph.Components.Camera;
 import Microwave.SceneGraph.Components.DirectionalLight;
 import Microwave.SceneGraph.LayerMask;
 import Microwave.SceneGraph.Node;
 import Microwave.SceneGraph.Scene;
+import Microwave.SceneGraph.TransformStore;
+import Microwave.System.JobSystem;
 import std;
 
 namespace mw {
 inline namespace scene {
 
+// renderables culled by a single job
+constexpr std::size_t CullChunkSize = 1024;
+
+// renderables needed before culling goes wide
+constexpr std::size_t ParallelCullThreshold = 4096;
+
 SceneRenderer::SceneRenderer()
 {
-    temp.reserve(16);
+    renderables.reserve(16);
 }
 
 void SceneRenderer::Render(const gptr<Scene>& scene)
 {
+    TransformStore::GetInstance().UpdateWorldTransforms();
+
     auto graphics = GraphicsContext::GetCurrent();
     
     graphics->SetClearColor(Color::Clear());
@@ -35,94 +46,95 @@ void SceneRenderer::Render(const gptr<Scene>& scene)
         }
     );
 
+    stats = {};
+    GatherRenderables(scene);
+
     for (auto& camera : scene->cameras)
     {
         if (!camera->IsActiveAndEnabled())
             continue;
 
-        auto camCullingMask = camera->GetCullingMask();
+        CullRenderables(*camera);
+        SortCommands(commands, sortBuffer);
 
-        for (gptr<IRenderEvents>& r : scene->renderEvents)
-        {
-            auto comp = dynamic_cast<Component*>(r.get());
-            if (comp->IsActiveAndEnabled())
-            {
-                r->GetRenderables(temp);
+        auto camPosition = Vec4(camera->GetNode()->GetPosition(), 0);
+        auto mtxViewProj = camera->GetViewProjectionMatrix();
+        auto ambientColor = scene->GetAmbientColor();
 
-                for(auto& rend : temp)
-                {
-                    if ((rend->layerMask & camCullingMask) != 0 && camera->CanSee(rend->bounds))
-                    {
-                        auto queue = rend->queueOverride ? rend->queueOverride : rend->material->renderQueue;
-                        auto depth = camera->GetDepth(rend->mtxModel.GetTranslation());
-                        rend->sortKey = Renderable::MakeSortKey(queue, depth);
-                        renderables.push_back(std::move(rend));
-                    }
-                }
+        // Consecutive draws with the same material only apply it once. A
+        // renderable with its own properties re-applies it before and after.
+        Material* lastMaterial = nullptr;
+        Shader* lastShader = nullptr;
+        bool lastHadExtra = false;
+        std::uint32_t lastLight = NoLight;
 
-                temp.clear();
-            }
-        }
+        int idMtxModel = -1;
+        int idMtxMVP = -1;
+        int idCameraPos = -1;
+        int idAmbientColor = -1;
+        int idLightPos = -1;
+        int idLightColor = -1;
 
-        std::sort(
-            renderables.begin(), renderables.end(),
-            [](const gptr<Renderable>& a, const gptr<Renderable>& b) {
-                return a->sortKey < b->sortKey;
-            }
-        );
+        for (auto& cmd : commands)
+        {
+            auto& rend = renderables[cmd.renderable];
+            auto material = rend->material.get();
+            auto shader = material->shader.get();
+            bool hasExtra = !rend->extra.IsEmpty();
+            bool lightChanged = (cmd.light != lastLight);
 
-        auto camPosition = camera->GetNode()->GetPosition();
-        auto mtxViewProj = camera->GetViewProjectionMatrix();
-        auto ambientColor = scene->GetAmbientColor();
+            rend->sortKey = cmd.key;
 
-        for (auto& rend : renderables)
-        {
-            DirectionalLight* closestLight = nullptr;
-            float closestLightDist = std::numeric_limits<float>::max();
-            
-            for(auto& light : scene->lights)
+            if (material != lastMaterial || hasExtra || lastHadExtra)
             {
-                if ((rend->layerMask & light->GetCullingMask()) != 0)
+                material->SetActive(hasExtra ? &rend->extra : nullptr);
+
+                if (shader != lastShader)
                 {
-                    auto lightPos = light->GetNode()->GetPosition();
-                    auto objectPos = rend->mtxModel.GetTranslation();
-
-                    auto dist = lightPos.DistanceSq(objectPos);
-                    if(dist < closestLightDist)
-                    {
-                        closestLight = light.get();
-                        closestLightDist = dist;
-                    }
+                    idMtxModel = shader->GetUniformID(UniformNames::MtxModel);
+                    idMtxMVP = shader->GetUniformID(UniformNames::MtxMVP);
+                    idCameraPos = shader->GetUniformID(UniformNames::CameraPos);
+                    idAmbientColor = shader->GetUniformID(UniformNames::AmbientColor);
+                    idLightPos = shader->GetUniformID(UniformNames::LightPos);
+                    idLightColor = shader->GetUniformID(UniformNames::LightColor);
+                    lastShader = shader;
                 }
-            }
 
-            Vec4 lightPos = Vec3::Zero();
-            Color lightColor = Color::Clear();
+                shader->SetUniform(idCameraPos, camPosition);
+                shader->SetUniform(idAmbientColor, ambientColor);
 
-            if (closestLight)
-            {
-                // DirectionalLight: { -direction, 0 }
-                // PointLight: { pos, 1 }
-                lightPos = Vec4(-closestLight->GetNode()->Forward(), 0);
-                lightColor = closestLight->GetColor() * closestLight->GetIntensity();
+                lastMaterial = material;
+                lastHadExtra = hasExtra;
+                lightChanged = true;
             }
 
-            rend->material->SetActive(&rend->extra);
+            if (lightChanged)
+            {
+                Vec4 lightPos = Vec3::Zero();
+                Color lightColor = Color::Clear();
 
-            rend->material->shader->SetUniform("uMtxModel", rend->mtxModel);
-            rend->material->shader->SetUniform("uMtxMVP", rend->mtxModel * mtxViewProj);
+                if (cmd.light != NoLight)
+                {
+                    // DirectionalLight: { -direction, 0 }
+                    // PointLight: { pos, 1 }
+                    auto& light = scene->lights[cmd.light];
+                    lightPos = Vec4(-light->GetNode()->Forward(), 0);
+                    lightColor = light->GetColor() * light->GetIntensity();
+                }
 
-            rend->material->shader->SetUniform("uCameraPos", Vec4(camPosition, 0));
-            rend->material->shader->SetUniform("uAmbientColor", ambientColor);
+                shader->SetUniform(idLightPos, lightPos);
+                shader->SetUniform(idLightColor, lightColor);
+                lastLight = cmd.light;
+            }
 
-            rend->material->shader->SetUniform("uLightPos", lightPos);
-            rend->material->shader->SetUniform("uLightColor", lightColor);
+            shader->SetUniform(idMtxModel, rend->mtxModel);
+            shader->SetUniform(idMtxMVP, rend->mtxModel * mtxViewProj);
 
-            rend->material->shader->SetVertexBuffer(rend->vertexMapping);
+            shader->SetVertexBuffer(rend->vertexMapping);
             
             if (rend->indexBuffer)
             {
-                rend->material->shader->SetIndexBuffer(rend->indexBuffer);
+                shader->SetIndexBuffer(rend->indexBuffer);
                 graphics->DrawIndexed(rend->drawStart, rend->drawCount, rend->drawMode);
             }
             else
@@ -131,12 +143,179 @@ void SceneRenderer::Render(const gptr<Scene>& scene)
             }
         }
 
-        renderables.clear();
+        stats.visible += commands.size();
+        commands.clear();
     }
 
+    renderables.clear();
+    items.clear();
+    shaderIDs.clear();
+    materialIDs.clear();
+
     graphics->Flip();
 }
 
+void SceneRenderer::GatherRenderables(const gptr<Scene>& scene)
+{
+    // Renderables don't depend on the camera, so they're only gathered once
+    // per frame. Components may create GPU resources while doing so, which
+    // keeps this part on the calling thread.
+    for (std::size_t i = 0; i < scene->renderEvents.size(); ++i)
+    {
+        if (scene->renderComponents[i]->IsActiveAndEnabled())
+            scene->renderEvents[i]->GetRenderables(renderables);
+    }
+
+    lightPositions.clear();
+    lightMasks.clear();
+
+    for (auto& light : scene->lights)
+    {
+        lightPositions.push_back(light->GetNode()->GetPosition());
+        lightMasks.push_back((std::uint32_t)light->GetCullingMask());
+    }
+
+    lightGrid.Build(lightPositions, lightMasks);
+
+    items.resize(renderables.size());
+
+    for (std::size_t i = 0; i < renderables.size(); ++i)
+    {
+        auto& rend = renderables[i];
+        auto& item = items[i];
+        item.bounds = rend->bounds;
+        item.position = rend->mtxModel.GetTranslation();
+        item.layerMask = (std::uint32_t)rend->layerMask;
+        item.queue = rend->queueOverride ? rend->queueOverride : rend->material->renderQueue;
+        item.state = GetStateID(rend->material.get());
+    }
+
+    // each renderable is lit by the closest light that affects its layer
+    JobSystem::GetInstance().ParallelFor(items.size(), CullChunkSize, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+            items[i].light = lightGrid.FindClosest(items[i].position, items[i].layerMask);
+    });
+
+    stats.renderables = renderables.size();
+}
+
+void SceneRenderer::CullRenderables(const Camera& camera)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    // evaluated here, since they update the camera's cached view
+    const Frustum& frustum = camera.GetFrustum();
+    auto cullingMask = (std::uint32_t)camera.GetCullingMask();
+    Mat4 worldToCamera = camera.GetNode()->GetWorldToLocalMatrix();
+    float nearPlane = camera.GetNearPlane();
+    float depthScale = 1.0f / (camera.GetFarPlane() - nearPlane);
+
+    auto count = items.size();
+    auto chunks = (count + CullChunkSize - 1) / CullChunkSize;
+
+    if (chunkCommands.size() < chunks)
+        chunkCommands.resize(chunks);
+
+    // each chunk of renderables gets its own command list, so jobs never
+    // share one, and merging them in order keeps the result deterministic
+    auto cullChunks = [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t c = first; c < last; ++c)
+        {
+            auto& out = chunkCommands[c];
+            out.clear();
+
+            std::size_t end = std::min((c + 1) * CullChunkSize, count);
+
+            for (std::size_t i = c * CullChunkSize; i < end; ++i)
+            {
+                auto& item = items[i];
+
+                if ((item.layerMask & cullingMask) == 0 || !frustum.Intersects(item.bounds))
+                    continue;
+
+                // same as Camera::GetDepth()
+                auto p = Vec4(item.position, 1.0f) * worldToCamera;
+                float depth = math::Clamp01((p.z - nearPlane) * depthScale);
+
+                out.push_back({
+                    Renderable::MakeSortKey(item.queue, depth, item.state),
+                    (std::uint32_t)i,
+                    item.light
+                });
+            }
+        }
+    };
+
+    if (count < ParallelCullThreshold)
+        cullChunks(0, chunks);
+    else
+        JobSystem::GetInstance().ParallelFor(chunks, 1, cullChunks);
+
+    commands.clear();
+
+    for (std::size_t c = 0; c < chunks; ++c)
+        commands.insert(commands.end(), chunkCommands[c].begin(), chunkCommands[c].end());
+
+    stats.cullTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+std::uint32_t SceneRenderer::GetStateID(Material* material)
+{
+    // dense per-frame IDs - 10 bits of shader, then 14 bits of material
+    auto shaderID = shaderIDs.try_emplace(material->shader.get(), (std::uint32_t)shaderIDs.size()).first->second;
+    auto materialID = materialIDs.try_emplace(material, (std::uint32_t)materialIDs.size()).first->second;
+    return ((shaderID & 0x3FF) << 14) | (materialID & 0x3FFF);
+}
+
+void SceneRenderer::SortCommands(std::vector<DrawCommand>& commands, std::vector<DrawCommand>& buffer)
+{
+    // LSD radix sort on the key, one byte at a time, skipping bytes that are
+    // the same for every command. Stable, so equal keys keep their order.
+    if (commands.size() < 2)
+        return;
+
+    buffer.resize(commands.size());
+
+    std::array<std::array<std::uint32_t, 256>, 8> counts{};
+
+    for (auto& cmd : commands)
+    {
+        for (int b = 0; b < 8; ++b)
+            ++counts[b][(cmd.key >> (b * 8)) & 0xFF];
+    }
+
+    auto* src = &commands;
+    auto* dst = &buffer;
+
+    for (int b = 0; b < 8; ++b)
+    {
+        auto& count = counts[b];
+        auto shift = b * 8;
+
+        if (count[(src->front().key >> shift) & 0xFF] == src->size())
+            continue;
+
+        std::uint32_t offset = 0;
+
+        for (auto& c : count)
+        {
+            auto n = c;
+            c = offset;
+            offset += n;
+        }
+
+        for (auto& cmd : *src)
+            (*dst)[count[(cmd.key >> shift) & 0xFF]++] = cmd;
+
+        std::swap(src, dst);
+    }
+
+    if (src != &commands)
+        commands.swap(buffer);
+}
+
 void SceneRenderer::SetGizmosEnabled(bool enable) {
     gizmosEnabled = enable;
 }
@@ -145,5 +324,9 @@ bool SceneRenderer::GetGizmosEnabled() const {
     return gizmosEnabled;
 }
 
+const SceneRenderStats& SceneRenderer::GetStats() const {
+    return stats;
+}
+
 } // scene
 } // mw
@@ -3,6 +3,10 @@
 *--------------------------------------------------------------*/
 
 export module Microwave.SceneGraph.SceneRenderer;
+import Microwave.Graphics.Material;
+import Microwave.Graphics.Shader;
+import Microwave.Math;
+import Microwave.SceneGraph.Culling;
 import Microwave.SceneGraph.Renderable;
 import Microwave.System.Pointers;
 import std;
@@ -10,13 +14,58 @@ import std;
 export namespace mw {
 inline namespace scene {
 
+class Camera;
 class Scene;
 
+struct SceneRenderStats
+{
+    std::size_t renderables = 0;    // gathered for the last frame
+    std::size_t visible = 0;        // drawn by all cameras in the last frame
+    double cullTime = 0;            // seconds spent culling in the last frame
+};
+
 class SceneRenderer
 {
+    struct DrawCommand
+    {
+        std::uint64_t key;
+        std::uint32_t renderable; // index into 'renderables'
+        std::uint32_t light;      // index into the scene's lights, or NoLight
+    };
+
+    // what culling needs from each renderable, gathered once per frame
+    struct CullItem
+    {
+        AABox bounds;
+        Vec3 position;
+        std::uint32_t layerMask;
+        std::uint32_t queue;
+        std::uint32_t state;
+        std::uint32_t light;
+    };
+
+    static constexpr std::uint32_t NoLight = LightGrid::None;
+
     bool gizmosEnabled = false;
     gvector<gptr<Renderable>> renderables;
-    gvector<gptr<Renderable>> temp;
+
+    // reused from frame to frame to avoid reallocating
+    std::vector<CullItem> items;
+    std::vector<DrawCommand> commands;
+    std::vector<std::vector<DrawCommand>> chunkCommands;
+    std::vector<DrawCommand> sortBuffer;
+    std::vector<Vec3> lightPositions;
+    std::vector<std::uint32_t> lightMasks;
+    LightGrid lightGrid;
+    std::unordered_map<Shader*, std::uint32_t> shaderIDs;
+    std::unordered_map<Material*, std::uint32_t> materialIDs;
+
+    SceneRenderStats stats;
+
+    void GatherRenderables(const gptr<Scene>& scene);
+    void CullRenderables(const Camera& camera);
+    std::uint32_t GetStateID(Material* material);
+    static void SortCommands(std::vector<DrawCommand>& commands, std::vector<DrawCommand>& buffer);
 
 public:
     SceneRenderer();
@@ -25,6 +74,8 @@ public:
 
     void SetGizmosEnabled(bool enable);
     bool GetGizmosEnabled() const;
+
+    const SceneRenderStats& GetStats() const;
 };
 
 } // scene
@@ -0,0 +1,530 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Microwave.SceneGraph.TransformStore;
+import Microwave.System.JobSystem;
+import std;
+
+namespace mw {
+inline namespace scene {
+
+// dirty transforms needed before UpdateWorldTransforms() goes wide
+constexpr std::size_t ParallelUpdateThreshold = 4096;
+
+// smallest range of slots handed to a single job
+constexpr std::size_t MinUpdateRangeSize = 512;
+
+void TransformStore::Allocate(ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+
+    // new slots are appended as roots, which keeps the order valid
+    auto slot = (std::int32_t)parents.size();
+
+    parents.push_back(None);
+    subtreeEnds.push_back(slot + 1);
+    localPos.push_back(Vec3::Zero());
+    localRot.push_back(Quat::Identity());
+    localScale.push_back(Vec3::One());
+    worldPos.push_back(Vec3::Zero());
+    worldRot.push_back(Quat::Identity());
+    worldScale.push_back(Vec3::One());
+    worldMatrix.push_back(Mat4::Identity());
+    dirty.push_back(1);
+    owners.push_back(owner);
+
+    owner->transformSlot = slot;
+    ++dirtyCount;
+}
+
+void TransformStore::Free(ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+
+    std::int32_t slot = owner->transformSlot;
+
+    if (dirty[slot]) {
+        dirty[slot] = 0;
+        --dirtyCount;
+    }
+
+    // The slot stays behind as a hole until the next rebuild. Parents own
+    // their children, so a hole normally has no live descendants, but when a
+    // collection destroys a parent before its children they may still point
+    // at it. UpdateRange() skips holes, and RebuildOrder() turns the children
+    // of a hole into roots.
+    parents[slot] = None;
+    owners[slot] = nullptr;
+    owner->transformSlot = None;
+    ++holeCount;
+}
+
+void TransformStore::SetParent(ITransformOwner* owner, const ITransformOwner* parentOwner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+
+    std::int32_t slot = owner->transformSlot;
+    std::int32_t parent = parentOwner ? parentOwner->transformSlot : None;
+
+    std::int32_t oldParent = parents[slot];
+    if (parent == oldParent)
+        return;
+
+    parents[slot] = parent;
+
+    if (!orderValid)
+        return;
+
+    // A root subtree at the end of the arrays can be attached to a parent
+    // whose subtree ends right before it without reordering anything. This
+    // is the common case for hierarchies that are built top-down, like the
+    // ones created by loading or importing.
+    std::int32_t end = subtreeEnds[slot];
+
+    if (oldParent == None && parent != None &&
+        end == (std::int32_t)parents.size() &&
+        subtreeEnds[parent] == slot)
+    {
+        for (auto p = parent; p != None; p = parents[p])
+            subtreeEnds[p] = end;
+
+        return;
+    }
+
+    orderValid = false;
+}
+
+Vec3 TransformStore::GetLocalPosition(const ITransformOwner* owner) {
+    std::lock_guard<Spinlock> lk(lock);
+    return localPos[owner->transformSlot];
+}
+
+Quat TransformStore::GetLocalRotation(const ITransformOwner* owner) {
+    std::lock_guard<Spinlock> lk(lock);
+    return localRot[owner->transformSlot];
+}
+
+Vec3 TransformStore::GetLocalScale(const ITransformOwner* owner) {
+    std::lock_guard<Spinlock> lk(lock);
+    return localScale[owner->transformSlot];
+}
+
+Transform TransformStore::GetLocalTransform(const ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+    std::int32_t slot = owner->transformSlot;
+    return { localPos[slot], localRot[slot], localScale[slot] };
+}
+
+void TransformStore::SetLocalPosition(const ITransformOwner* owner, const Vec3& pos) {
+    std::lock_guard<Spinlock> lk(lock);
+    localPos[owner->transformSlot] = pos;
+}
+
+void TransformStore::SetLocalRotation(const ITransformOwner* owner, const Quat& rot) {
+    std::lock_guard<Spinlock> lk(lock);
+    localRot[owner->transformSlot] = rot;
+}
+
+void TransformStore::SetLocalScale(const ITransformOwner* owner, const Vec3& scale) {
+    std::lock_guard<Spinlock> lk(lock);
+    localScale[owner->transformSlot] = scale;
+}
+
+void TransformStore::SetLocalTransform(
+    const ITransformOwner* owner, const Vec3& pos, const Quat& rot, const Vec3& scale)
+{
+    std::lock_guard<Spinlock> lk(lock);
+    std::int32_t slot = owner->transformSlot;
+    localPos[slot] = pos;
+    localRot[slot] = rot;
+    localScale[slot] = scale;
+}
+
+Vec3 TransformStore::GetWorldPosition(const ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+    ResolveSlot(owner->transformSlot);
+    return worldPos[owner->transformSlot];
+}
+
+Quat TransformStore::GetWorldRotation(const ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+    ResolveSlot(owner->transformSlot);
+    return worldRot[owner->transformSlot];
+}
+
+Vec3 TransformStore::GetWorldScale(const ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+    ResolveSlot(owner->transformSlot);
+    return worldScale[owner->transformSlot];
+}
+
+Mat4 TransformStore::GetWorldMatrix(const ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+    ResolveSlot(owner->transformSlot);
+    return worldMatrix[owner->transformSlot];
+}
+
+Transform TransformStore::GetWorldTransform(const ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+    std::int32_t slot = owner->transformSlot;
+    ResolveSlot(slot);
+    return { worldPos[slot], worldRot[slot], worldScale[slot] };
+}
+
+bool TransformStore::IsDirty(const ITransformOwner* owner) {
+    std::lock_guard<Spinlock> lk(lock);
+    return dirty[owner->transformSlot] != 0;
+}
+
+bool TransformStore::MarkSubtreeDirty(const ITransformOwner* owner, std::vector<ITransformOwner*>& marked)
+{
+    std::lock_guard<Spinlock> lk(lock);
+
+    if (!orderValid)
+        return false;
+
+    std::int32_t slot = owner->transformSlot;
+    std::int32_t end = subtreeEnds[slot];
+
+    for (std::int32_t i = slot; i < end; )
+    {
+        if (dirty[i]) {
+            i = subtreeEnds[i];
+            continue;
+        }
+
+        if (owners[i])
+        {
+            dirty[i] = 1;
+            ++dirtyCount;
+            marked.push_back(owners[i]);
+        }
+
+        ++i;
+    }
+
+    return true;
+}
+
+bool TransformStore::MarkDirty(const ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+
+    std::int32_t slot = owner->transformSlot;
+
+    if (dirty[slot])
+        return false;
+
+    dirty[slot] = 1;
+    ++dirtyCount;
+    return true;
+}
+
+void TransformStore::Resolve(const ITransformOwner* owner)
+{
+    std::lock_guard<Spinlock> lk(lock);
+    ResolveSlot(owner->transformSlot);
+}
+
+void TransformStore::ResolveSlot(std::int32_t slot)
+{
+    if (!dirty[slot])
+        return;
+
+    std::int32_t parent = parents[slot];
+    if (parent != None)
+        ResolveSlot(parent);
+
+    ComputeWorld(slot);
+    dirty[slot] = 0;
+    --dirtyCount;
+}
+
+void TransformStore::ComputeWorld(std::int32_t slot)
+{
+    Vec3 pos = localPos[slot];
+    Quat rot = localRot[slot];
+    Vec3 scale = localScale[slot];
+
+    std::int32_t parent = parents[slot];
+    if (parent != None)
+    {
+        Vec3 parentScale = worldScale[parent];
+        Quat parentRot = worldRot[parent];
+        Vec3 parentPos = worldPos[parent];
+
+        pos = pos.Multiply(parentScale);
+        pos *= parentRot;
+        pos += parentPos;
+
+        rot *= parentRot;
+
+        scale = scale.Multiply(parentScale);
+    }
+
+    worldPos[slot] = pos;
+    worldRot[slot] = rot;
+    worldScale[slot] = scale;
+
+    Mat4 mtx = rot.ToMatrix();
+
+    mtx.m11 *= scale.x;
+    mtx.m12 *= scale.x;
+    mtx.m13 *= scale.x;
+
+    mtx.m21 *= scale.y;
+    mtx.m22 *= scale.y;
+    mtx.m23 *= scale.y;
+
+    mtx.m31 *= scale.z;
+    mtx.m32 *= scale.z;
+    mtx.m33 *= scale.z;
+
+    mtx.m41 = pos.x;
+    mtx.m42 = pos.y;
+    mtx.m43 = pos.z;
+
+    worldMatrix[slot] = mtx;
+}
+
+std::size_t TransformStore::UpdateRange(std::int32_t begin, std::int32_t end)
+{
+    // parents always come before their children, so they're already resolved
+    std::size_t updated = 0;
+
+    for (std::int32_t i = begin; i < end; ++i)
+    {
+        if (dirty[i])
+        {
+            ComputeWorld(i);
+            dirty[i] = 0;
+            ++updated;
+        }
+    }
+
+    return updated;
+}
+
+void TransformStore::UpdateWorldTransforms(bool parallel)
+{
+    // Held for the whole pass. The range jobs work on disjoint slots on
+    // behalf of this thread without taking it, and no other foreground
+    // job touches the store, so helping while waiting can't deadlock.
+    std::lock_guard<Spinlock> lk(lock);
+
+    if (dirtyCount == 0) {
+        updatedLastPass = 0;
+        return;
+    }
+
+    if (!orderValid || holeCount > parents.size() / 2)
+        Reorder();
+
+    auto count = (std::int32_t)parents.size();
+    auto& jobs = JobSystem::GetInstance();
+
+    if (!parallel || dirtyCount < ParallelUpdateThreshold || jobs.GetWorkerCount() == 0)
+    {
+        updatedLastPass = UpdateRange(0, count);
+        dirtyCount = 0;
+        return;
+    }
+
+    // Descend into subtrees that are too big for one job, updating their
+    // roots here, until the rest of the arrays are split into independent
+    // ranges. Neighbouring ranges are merged while they stay small enough.
+    auto rangeSize = (std::int32_t)std::max(
+        MinUpdateRangeSize, (std::size_t)count / ((jobs.GetWorkerCount() + 1) * 4));
+
+    std::size_t updated = 0;
+    updateRanges.clear();
+
+    for (std::int32_t i = 0; i < count; )
+    {
+        std::int32_t end = subtreeEnds[i];
+
+        if (end - i <= rangeSize)
+        {
+            if (!updateRanges.empty() &&
+                updateRanges.back().second == i &&
+                end - updateRanges.back().first <= rangeSize)
+            {
+                updateRanges.back().second = end;
+            }
+            else
+            {
+                updateRanges.emplace_back(i, end);
+            }
+
+            i = end;
+        }
+        else
+        {
+            updated += UpdateRange(i, i + 1);
+            ++i;
+        }
+    }
+
+    std::atomic<std::size_t> rangeUpdated = 0;
+
+    jobs.ParallelFor(updateRanges.size(), 1, [&](std::size_t first, std::size_t last)
+    {
+        std::size_t n = 0;
+
+        for (std::size_t r = first; r < last; ++r)
+            n += UpdateRange(updateRanges[r].first, updateRanges[r].second);
+
+        rangeUpdated.fetch_add(n, std::memory_order_relaxed);
+    });
+
+    updatedLastPass = updated + rangeUpdated.load(std::memory_order_relaxed);
+    dirtyCount = 0;
+}
+
+bool TransformStore::IsOrderValid() {
+    std::lock_guard<Spinlock> lk(lock);
+    return orderValid;
+}
+
+void TransformStore::RebuildOrder()
+{
+    std::lock_guard<Spinlock> lk(lock);
+    Reorder();
+}
+
+void TransformStore::Reorder()
+{
+    auto count = (std::int32_t)parents.size();
+
+    auto isRoot = [&](std::int32_t slot) {
+        std::int32_t parent = parents[slot];
+        return parent == None || !owners[parent];
+    };
+
+    // children of each slot, keeping siblings in slot order
+    std::vector<std::int32_t> childStart(count + 1, 0);
+
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        if (owners[i] && !isRoot(i))
+            ++childStart[parents[i] + 1];
+    }
+
+    for (std::int32_t i = 0; i < count; ++i)
+        childStart[i + 1] += childStart[i];
+
+    std::vector<std::int32_t> children(childStart[count]);
+    std::vector<std::int32_t> cursor(childStart.begin(), childStart.end() - 1);
+
+    for (std::int32_t i = 0; i < count; ++i)
+    {
+        if (owners[i] && !isRoot(i))
+            children[cursor[parents[i]]++] = i;
+    }
+
+    // depth-first order from each root, dropping holes
+    std::vector<std::int32_t> order;
+    order.reserve(count - holeCount);
+
+    std::vector<std::int32_t> stack;
+
+    for (std::int32_t root = 0; root < count; ++root)
+    {
+        if (!owners[root] || !isRoot(root))
+            continue;
+
+        stack.push_back(root);
+
+        while (!stack.empty())
+        {
+            std::int32_t slot = stack.back();
+            stack.pop_back();
+            order.push_back(slot);
+
+            for (std::int32_t c = childStart[slot + 1]; c-- > childStart[slot]; )
+                stack.push_back(children[c]);
+        }
+    }
+
+    std::vector<std::int32_t> newSlots(count, None);
+
+    for (std::int32_t i = 0; i < (std::int32_t)order.size(); ++i)
+        newSlots[order[i]] = i;
+
+    auto permute = [&](auto& values)
+    {
+        std::remove_reference_t<decltype(values)> sorted;
+        sorted.reserve(order.size());
+
+        for (std::int32_t slot : order)
+            sorted.push_back(std::move(values[slot]));
+
+        values.swap(sorted);
+    };
+
+    permute(parents);
+    permute(localPos);
+    permute(localRot);
+    permute(localScale);
+    permute(worldPos);
+    permute(worldRot);
+    permute(worldScale);
+    permute(worldMatrix);
+    permute(dirty);
+    permute(owners);
+
+    auto newCount = (std::int32_t)order.size();
+
+    for (std::int32_t i = 0; i < newCount; ++i)
+    {
+        std::int32_t parent = parents[i];
+        parents[i] = (parent != None) ? newSlots[parent] : None;
+    }
+
+    // a subtree ends where the last subtree of its children ends
+    subtreeEnds.resize(newCount);
+
+    for (std::int32_t i = 0; i < newCount; ++i)
+        subtreeEnds[i] = i + 1;
+
+    for (std::int32_t i = newCount; i-- > 0; )
+    {
+        std::int32_t parent = parents[i];
+        if (parent != None)
+            subtreeEnds[parent] = std::max(subtreeEnds[parent], subtreeEnds[i]);
+    }
+
+    for (std::int32_t i = 0; i < newCount; ++i)
+        owners[i]->transformSlot = i;
+
+    holeCount = 0;
+    orderValid = true;
+    ++rebuildCount;
+}
+
+TransformStats TransformStore::GetStats()
+{
+    std::lock_guard<Spinlock> lk(lock);
+
+    TransformStats stats;
+    stats.slots = parents.size() - holeCount;
+    stats.updated = updatedLastPass;
+    stats.rebuilds = rebuildCount;
+    return stats;
+}
+
+TransformStore& TransformStore::GetInstance()
+{
+    static TransformStore instance;
+    return instance;
+}
+
+} // scene
+} // mw
@@ -0,0 +1,130 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.SceneGraph.TransformStore;
+import Microwave.Math;
+import Microwave.System.Spinlock;
+import std;
+
+export namespace mw {
+inline namespace scene {
+
+class TransformStore;
+
+// Objects with a transform in the store. The store keeps track of which slot
+// belongs to the owner, and moves it when the arrays are reordered.
+class ITransformOwner
+{
+    friend TransformStore;
+    std::int32_t transformSlot = -1;
+public:
+    virtual ~ITransformOwner() = default;
+};
+
+struct TransformStats
+{
+    std::size_t slots = 0;         // live transforms
+    std::size_t updated = 0;       // world transforms recomputed by the last UpdateWorldTransforms()
+    std::size_t rebuilds = 0;      // times the hierarchy order has been rebuilt
+};
+
+// Structure-of-arrays storage for Node transforms.
+//
+// Each node owns a slot holding its parent slot, local TRS, and cached world
+// TRS and matrix. After a structural change, the next RebuildOrder() sorts
+// the arrays so that every subtree is a contiguous range that follows its
+// root, letting UpdateWorldTransforms() resolve all dirty transforms in a
+// single forward pass, and letting SetDirty() visit a subtree linearly.
+//
+// A dirty slot implies that every slot in its subtree is dirty as well.
+//
+// Nodes are created and destroyed on any thread, by asset imports, jobs, and
+// the garbage collector, so every access takes the lock. Slots are looked up
+// from their owner under the lock, since a rebuild on another thread may move
+// them, and values are returned by copy for the same reason.
+class TransformStore
+{
+public:
+    static constexpr std::int32_t None = -1;
+
+    void Allocate(ITransformOwner* owner);
+    void Free(ITransformOwner* owner);
+    void SetParent(ITransformOwner* owner, const ITransformOwner* parent);
+
+    Vec3 GetLocalPosition(const ITransformOwner* owner);
+    Quat GetLocalRotation(const ITransformOwner* owner);
+    Vec3 GetLocalScale(const ITransformOwner* owner);
+    Transform GetLocalTransform(const ITransformOwner* owner);
+
+    // callers are responsible for marking the slot dirty afterward
+    void SetLocalPosition(const ITransformOwner* owner, const Vec3& pos);
+    void SetLocalRotation(const ITransformOwner* owner, const Quat& rot);
+    void SetLocalScale(const ITransformOwner* owner, const Vec3& scale);
+    void SetLocalTransform(const ITransformOwner* owner, const Vec3& pos, const Quat& rot, const Vec3& scale);
+
+    // world transform, recomputing it and any dirty ancestors first if needed
+    Vec3 GetWorldPosition(const ITransformOwner* owner);
+    Quat GetWorldRotation(const ITransformOwner* owner);
+    Vec3 GetWorldScale(const ITransformOwner* owner);
+    Mat4 GetWorldMatrix(const ITransformOwner* owner);
+    Transform GetWorldTransform(const ITransformOwner* owner);
+
+    bool IsDirty(const ITransformOwner* owner);
+
+    // Marks the owner's slot and its subtree dirty, appending the owner of each
+    // slot that wasn't already dirty to 'marked'. Subtrees that are already
+    // dirty are skipped. Returns false without doing anything if the order is
+    // stale, in which case the caller has to walk the hierarchy itself.
+    bool MarkSubtreeDirty(const ITransformOwner* owner, std::vector<ITransformOwner*>& marked);
+
+    // only marks the owner's slot itself, for callers walking the hierarchy themselves
+    bool MarkDirty(const ITransformOwner* owner);
+
+    // recomputes the world transform of the owner's slot and its dirty ancestors
+    void Resolve(const ITransformOwner* owner);
+
+    // Recomputes every dirty world transform in one pass over the arrays,
+    // rebuilding the hierarchy order first if needed. Large updates are
+    // split across the JobSystem by subtree when 'parallel' is set.
+    void UpdateWorldTransforms(bool parallel = true);
+
+    bool IsOrderValid();
+    void RebuildOrder();
+
+    TransformStats GetStats();
+
+    static TransformStore& GetInstance();
+
+private:
+    Spinlock lock;
+
+    std::vector<std::int32_t> parents;
+    std::vector<std::int32_t> subtreeEnds;  // one past the last slot of each subtree, when 'orderValid'
+    std::vector<Vec3> localPos;
+    std::vector<Quat> localRot;
+    std::vector<Vec3> localScale;
+    std::vector<Vec3> worldPos;
+    std::vector<Quat> worldRot;
+    std::vector<Vec3> worldScale;
+    std::vector<Mat4> worldMatrix;
+    std::vector<std::uint8_t> dirty;
+    std::vector<ITransformOwner*> owners;
+
+    std::size_t holeCount = 0;  // freed slots, removed by the next RebuildOrder()
+    std::size_t dirtyCount = 0;
+    bool orderValid = true;
+    std::vector<std::pair<std::int32_t, std::int32_t>> updateRanges;
+
+    std::size_t updatedLastPass = 0;
+    std::size_t rebuildCount = 0;
+
+    // the rest assume the lock is held
+    void ResolveSlot(std::int32_t slot);
+    void ComputeWorld(std::int32_t slot);
+    std::size_t UpdateRange(std::int32_t begin, std::int32_t end);
+    void Reorder();
+};
+
+} // scene
+} // mw
@@ -53,6 +53,10 @@ gptr<ApplicationDispatcher> App::GetDispatcher()
     return _dispatcher;
 }
 
+const std::vector<std::string>& App::GetArgs() const {
+    return _args;
+}
+
 gptr<Window> App::GetMainWindow()
 {
     return _mainWindow;
@@ -112,6 +116,9 @@ Task<void> DoCollection()
 int App::Run(int argc, char *argv[])
 {
     auto app = App::Get();
+
+    for (int i = 1; i < argc; ++i)
+        app->_args.push_back(argv[i]);
     
     auto dispatcher = app->GetDispatcher();
     Dispatcher::SetCurrent(dispatcher);
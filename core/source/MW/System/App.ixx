@@ -21,6 +21,7 @@ class App : public Object, public IWindowEventHandler
 {
     static App* _instance;
     gptr<ApplicationDispatcher> _dispatcher;
+    std::vector<std::string> _args;
 protected:
     gptr<Window> _mainWindow;
     gvector<wgptr<Window>> _allWindows;
@@ -35,6 +36,9 @@ public:
 
     static gptr<App> Get();
     gptr<ApplicationDispatcher> GetDispatcher();
+
+    // command line arguments, not including the program name
+    const std::vector<std::string>& GetArgs() const;
     
     // only works on desktop platforms
     gptr<Window> CreateWindow(const WindowConfig& config);
@@ -15,7 +15,7 @@ class AsyncExecutor : public Executor
 {
     inline static Type::Pin<AsyncExecutor> pin;
 
-    gvector<gfunction<void()>> jobs;
+    glist<gfunction<void()>> jobs;
     std::vector<std::thread> threads;
     std::condition_variable cond;
     std::mutex mut;
@@ -71,7 +71,7 @@ protected:
                 if (!jobs.empty())
                 {
                     job = std::move(jobs.front());
-                    jobs.erase(jobs.begin());
+                    jobs.pop_front();
                 }
             }
 
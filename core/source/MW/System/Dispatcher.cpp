@@ -22,7 +22,13 @@ Dispatcher::~Dispatcher()
 
 void Dispatcher::Wake()
 {
-    cv.notify_one();
+    // WaitForNextAction() sets 'waiting' and re-checks the queues under 'mut'
+    // before sleeping, so locking here ensures the notification isn't lost
+    if (waiting.load(std::memory_order_seq_cst))
+    {
+        std::unique_lock<std::mutex> lk(mut);
+        cv.notify_one();
+    }
 }
 
 gptr<DispatchAction> Dispatcher::InvokeAsync(
@@ -30,25 +36,24 @@ gptr<DispatchAction> Dispatcher::InvokeAsync(
     std::chrono::steady_clock::time_point when
 )
 {
-    std::unique_lock<std::mutex> lk(mut);
-
     auto action = gpnew<DispatchAction>(std::move(function), when);
-    sorted_insert(actions, std::move(action), DispatchActionComparison());
-    Wake();
+    Enqueue(action);
     return action;
 }
 
 bool Dispatcher::Cancel(const gptr<DispatchAction>& action)
 {
+    if (!action)
+        return false;
+
     std::unique_lock<std::mutex> lk(mut);
 
-    auto it = std::lower_bound(actions.begin(), actions.end(), action, DispatchActionComparison());
-    if (it != actions.end()) {
-        actions.erase(it);
+    if (UnscheduleTimer(action))
         return true;
-    }
 
-    return false;
+    // immediate actions can't be unlinked from the queue,
+    // so they're skipped by DequeueAction() instead
+    return action->pending.exchange(false);
 }
 
 void Dispatcher::Run()
@@ -81,37 +86,38 @@ void Dispatcher::SetContinuousDispatchRate(std::uint32_t rate)
         continuousDispatchInterval = std::chrono::milliseconds((2 * 1000 / rate + 1) / 2);
         continuousDispatchWakeTime = std::chrono::steady_clock::now();
 
+        if (continuousDispatchAction) {
+            UnscheduleTimer(continuousDispatchAction);
+            continuousDispatchAction->pending = false;
+            continuousDispatchAction = nullptr;
+        }
+
         if (continuousDispatchRate > 0)
         {
-            if (continuousDispatchAction) {
-                continuousDispatchAction->function = nullptr;
-                continuousDispatchAction->when = std::chrono::steady_clock::time_point{ std::chrono::steady_clock::duration::zero() };
-            }
-
             continuousDispatchAction = gpnew<DispatchAction>(
-                [this]{
+                [this, rate]{
                     InvokeDelegates();
 
                     {
                         std::unique_lock<std::mutex> lk(mut);
+
+                        // skip rescheduling if the rate changed while delegates were running
+                        if (continuousDispatchRate != rate || !continuousDispatchAction)
+                            return;
+
                         continuousDispatchWakeTime += continuousDispatchInterval;
                         continuousDispatchAction->when = continuousDispatchWakeTime;
-                        sorted_insert(actions, continuousDispatchAction, DispatchActionComparison());
-                        Wake();
+                        continuousDispatchAction->pending = true;
+                        ScheduleTimer(continuousDispatchAction);
                     }
+
+                    Wake();
                 },
                 continuousDispatchWakeTime
             );
         }
-        else
-        {
-            if (continuousDispatchAction) {
-                continuousDispatchAction->function = nullptr;
-                continuousDispatchAction->when = std::chrono::steady_clock::time_point{ std::chrono::steady_clock::duration::zero() };
-                continuousDispatchAction = nullptr;
-            }
-        }
 
+        lk.unlock();
         Wake();
     }
 }
@@ -163,24 +169,188 @@ gptr<DispatchAction> Dispatcher::WaitForNextAction()
 {
     std::unique_lock<std::mutex> lk(mut);
 
-    auto wake = std::chrono::steady_clock::time_point::max();
-    if (!actions.empty() && actions.front()->when > std::chrono::steady_clock::time_point(std::chrono::microseconds(0)))
-        wake = actions.front()->when;
+    while (run)
+    {
+        if (auto action = DequeueAction(std::chrono::steady_clock::now()))
+            return action;
+
+        // producers only lock 'mut' to notify when they see 'waiting' set, so
+        // it must be published before the final check of the immediate queue
+        waiting.store(true, std::memory_order_seq_cst);
+
+        if (!HasImmediateActions())
+        {
+            auto wake = GetNextTimerTime();
+
+            if (wake == std::chrono::steady_clock::time_point::max())
+                cv.wait(lk);
+            else
+                cv.wait_until(lk, wake);
+        }
+
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    return nullptr;
+}
+
+void Dispatcher::Enqueue(const gptr<DispatchAction>& action)
+{
+    action->pending = true;
 
-    cv.wait_until(
-        lk, wake,
-        [this]{ return !run || (!actions.empty() && std::chrono::steady_clock::now() > actions.front()->when); }
-    );
+    if (action->when == std::chrono::steady_clock::time_point{ std::chrono::steady_clock::duration::zero() })
+    {
+        immediateActions.Push(action);
+    }
+    else
+    {
+        std::unique_lock<std::mutex> lk(mut);
+        ScheduleTimer(action);
+    }
 
+    Wake();
+}
+
+gptr<DispatchAction> Dispatcher::DequeueAction(std::chrono::steady_clock::time_point now)
+{
     gptr<DispatchAction> action;
 
-    if (run) {
-        action = std::move(actions.front());
-        actions.erase(actions.begin());
+    // immediate actions run ahead of timers, as they did when both
+    // were kept in a single list sorted by time
+    while (immediateActions.Pop(action))
+    {
+        if (action->pending.exchange(false))
+            return action;
+    }
+
+    while (!timers.empty() && timers.front()->when <= now)
+    {
+        action = PopTimer();
+        if (action->pending.exchange(false))
+            return action;
+    }
+
+    return nullptr;
+}
+
+bool Dispatcher::HasImmediateActions() const {
+    return !immediateActions.Empty();
+}
+
+std::chrono::steady_clock::time_point Dispatcher::GetNextTimerTime() const
+{
+    if (timers.empty())
+        return std::chrono::steady_clock::time_point::max();
+
+    return timers.front()->when;
+}
+
+void Dispatcher::ScheduleTimer(const gptr<DispatchAction>& action)
+{
+    action->sequence = nextSequence++;
+    timers.push_back(action);
+    action->heapIndex = timers.size() - 1;
+    SiftUp(action->heapIndex);
+}
+
+bool Dispatcher::UnscheduleTimer(const gptr<DispatchAction>& action)
+{
+    std::size_t index = action->heapIndex;
+    if (index >= timers.size() || timers[index] != action)
+        return false;
+
+    action->heapIndex = DispatchAction::NotScheduled;
+    action->pending = false;
+
+    auto last = std::move(timers.back());
+    timers.pop_back();
+
+    if (index < timers.size())
+    {
+        PlaceTimer(index, std::move(last));
+
+        if (index > 0 && TimerLess(index, (index - 1) / 2))
+            SiftUp(index);
+        else
+            SiftDown(index);
+    }
+
+    return true;
+}
+
+gptr<DispatchAction> Dispatcher::PopTimer()
+{
+    auto action = std::move(timers.front());
+    action->heapIndex = DispatchAction::NotScheduled;
+
+    auto last = std::move(timers.back());
+    timers.pop_back();
+
+    if (!timers.empty()) {
+        PlaceTimer(0, std::move(last));
+        SiftDown(0);
     }
 
     return action;
 }
 
+void Dispatcher::SiftUp(std::size_t index)
+{
+    while (index > 0)
+    {
+        std::size_t parent = (index - 1) / 2;
+        if (!TimerLess(index, parent))
+            break;
+
+        auto action = std::move(timers[index]);
+        PlaceTimer(index, std::move(timers[parent]));
+        PlaceTimer(parent, std::move(action));
+        index = parent;
+    }
+}
+
+void Dispatcher::SiftDown(std::size_t index)
+{
+    std::size_t count = timers.size();
+
+    while (true)
+    {
+        std::size_t smallest = index;
+        std::size_t left = index * 2 + 1;
+        std::size_t right = left + 1;
+
+        if (left < count && TimerLess(left, smallest))
+            smallest = left;
+
+        if (right < count && TimerLess(right, smallest))
+            smallest = right;
+
+        if (smallest == index)
+            break;
+
+        auto action = std::move(timers[index]);
+        PlaceTimer(index, std::move(timers[smallest]));
+        PlaceTimer(smallest, std::move(action));
+        index = smallest;
+    }
+}
+
+bool Dispatcher::TimerLess(std::size_t a, std::size_t b) const
+{
+    auto& left = timers[a];
+    auto& right = timers[b];
+
+    if (left->when != right->when)
+        return left->when < right->when;
+
+    return left->sequence < right->sequence;
+}
+
+void Dispatcher::PlaceTimer(std::size_t index, gptr<DispatchAction> action)
+{
+    action->heapIndex = index;
+    timers[index] = std::move(action);
+}
+
 } // system
 } // mw
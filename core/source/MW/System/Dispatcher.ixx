@@ -5,6 +5,7 @@
 export module Microwave.System.Dispatcher;
 import Microwave.System.Pointers;
 import Microwave.System.EventHandlerList;
+import Microwave.System.MPSCQueue;
 import std;
 
 export namespace mw {
@@ -22,6 +23,15 @@ struct DispatchAction
         Func&& function,
         std::chrono::steady_clock::time_point when = {}
     ) : function(std::forward<Func>(function)), when(when) {}
+
+private:
+    friend class Dispatcher;
+
+    static constexpr std::size_t NotScheduled = std::numeric_limits<std::size_t>::max();
+
+    std::atomic<bool> pending = false;        // queued and not yet invoked or cancelled
+    std::uint64_t sequence = 0;               // orders timers with equal 'when'
+    std::size_t heapIndex = NotScheduled;     // position in Dispatcher::timers
 };
 
 class IDispatchHandler
@@ -33,19 +43,8 @@ public:
 class Dispatcher : public sp_from_this<Dispatcher>
 {
 protected:
-    struct DispatchActionComparison {
-        bool operator()(const gptr<DispatchAction>& left, const gptr<DispatchAction>& right) const {
-            return left->when < right->when;
-        }
-    };
-
-    template<class T, class S, class Compare>
-    inline static auto sorted_insert(gvector<T>& cont, S&& val, Compare comp)
-    {
-        auto it = std::upper_bound(cont.begin(), cont.end(), val, comp);
-        return cont.insert(it, std::forward<S>(val));
-    }
-
+    // Called after an action is queued. May be called from any thread,
+    // but never with 'mut' held.
     virtual void Wake();
 
 public:
@@ -75,7 +74,14 @@ protected:
     mutable std::mutex mut;
     mutable std::condition_variable cv;
     std::atomic<bool> run = false;
-    gvector<gptr<DispatchAction>> actions;
+    std::atomic<bool> waiting = false;
+
+    // actions with a zero 'when' go through the lock-free queue,
+    // everything else goes into a binary min-heap guarded by 'mut'
+    MPSCQueue<gptr<DispatchAction>> immediateActions;
+    gvector<gptr<DispatchAction>> timers;
+    std::uint64_t nextSequence = 0;
+
     std::chrono::steady_clock::time_point continuousDispatchWakeTime;
     std::chrono::milliseconds continuousDispatchInterval = std::chrono::milliseconds(0);
     std::uint32_t continuousDispatchRate = 0;
@@ -83,10 +89,26 @@ protected:
     EventHandlerList<IDispatchHandler> dispatchHandlers;
     gptr<DispatchAction> continuousDispatchAction;
 
+    void Enqueue(const gptr<DispatchAction>& action);
     void InvokeFunction(const gptr<DispatchAction>& action);
     void InvokeDelegates();
     gptr<DispatchAction> WaitForNextAction();
 
+    // The following require 'mut' to be held, and must only be
+    // called from the thread that runs the dispatcher.
+    gptr<DispatchAction> DequeueAction(std::chrono::steady_clock::time_point now);
+    bool HasImmediateActions() const;
+    std::chrono::steady_clock::time_point GetNextTimerTime() const;
+
+    // The following require 'mut' to be held.
+    void ScheduleTimer(const gptr<DispatchAction>& action);
+    bool UnscheduleTimer(const gptr<DispatchAction>& action);
+    gptr<DispatchAction> PopTimer();
+    void SiftUp(std::size_t index);
+    void SiftDown(std::size_t index);
+    bool TimerLess(std::size_t a, std::size_t b) const;
+    void PlaceTimer(std::size_t index, gptr<DispatchAction> action);
+
     static thread_local gptr<Dispatcher> _currentDispatcher;
 };
 
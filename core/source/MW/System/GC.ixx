@@ -10,6 +10,7 @@ import Microwave.System.Pointers;
 import Microwave.System.Task;
 import Microwave.System.ThreadPool;
 import <gc/gc.h>;
+import std;
 
 export namespace mw {
 inline namespace system {
@@ -30,6 +31,17 @@ public:
 
         g = {};
     }
+
+    // Performs at most 'budget' worth of collection work on the main thread,
+    // resuming a previously started collection. Can be called once per frame
+    // to spread a collection out instead of running it on a worker.
+    static void CollectIncremental(std::chrono::steady_clock::duration budget)
+    {
+        if (Dispatcher::GetCurrent() != App::Get()->GetDispatcher())
+            throw Exception("GC should only be run on main thread");
+
+        gc::garbage g = gc::graph::collect(budget);
+    }
 };
 
 } // system
@@ -40,19 +40,6 @@ ApplicationDispatcherAndroid::~ApplicationDispatcherAndroid()
 {
 }
 
-gptr<DispatchAction> ApplicationDispatcherAndroid::InvokeAsync(
-    std::function<void()> function,
-    DispatchTime when
-)
-{
-    std::unique_lock<std::mutex> lk(mut);
-
-    auto action = gpnew<DispatchAction>(std::move(function), when);
-    sorted_insert(actions, action, DispatchActionComparison());
-    Wake();
-    return action;
-}
-
 void ApplicationDispatcherAndroid::Wake()
 {
     if (run && processEvents) {
@@ -67,15 +54,21 @@ void ApplicationDispatcherAndroid::Quit() {
 
 long long ApplicationDispatcherAndroid::GetDispatchTimeout()
 {
+    std::unique_lock<std::mutex> lk(mut);
+
     long long timeout = -1;
 
     if (run && processEvents)
     {
-        auto now = DispatchClock::now();
+        auto now = std::chrono::steady_clock::now();
 
-        if (!actions.empty())
+        if (HasImmediateActions())
         {
-            auto when = actions.front()->when;
+            timeout = 0;
+        }
+        else if (GetNextTimerTime() != std::chrono::steady_clock::time_point::max())
+        {
+            auto when = GetNextTimerTime();
             auto to = std::chrono::duration_cast<std::chrono::milliseconds>(when - now).count();
             to = std::max(to, 0LL);
             timeout = to;
@@ -315,10 +308,8 @@ gptr<DispatchAction> ApplicationDispatcherAndroid::GetNextAction()
 
     gptr<DispatchAction> action;
 
-    if (run && !actions.empty() && DispatchClock::now() >= actions.front()->when) {
-        action = std::move(actions.front());
-        actions.popFront();
-    }
+    if (run)
+        action = DequeueAction(std::chrono::steady_clock::now());
 
     return action;
 }
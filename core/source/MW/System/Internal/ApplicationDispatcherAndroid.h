@@ -25,9 +25,6 @@ public:
 
     virtual void Run(int argc, char* argv[]) override;
     virtual void Quit() override;
-    virtual gptr<DispatchAction> InvokeAsync(
-        std::function<void()> function,
-        DispatchTime when = DispatchTime()) override;
 
 private:
     long long GetDispatchTimeout();
@@ -32,11 +32,8 @@ gptr<ApplicationDispatcher> ApplicationDispatcher::New() {
 
 void ApplicationDispatcherIOS::Wake()
 {
-    if(run && !wakeMessageQueued)
-    {
-        wakeMessageQueued = true;
+    if(run && !wakeMessageQueued.exchange(true))
         dispatch_async(mainQueue, processActions);
-    }
 }
 
 ApplicationDispatcherIOS::ApplicationDispatcherIOS()
@@ -57,19 +54,6 @@ ApplicationDispatcherIOS::~ApplicationDispatcherIOS()
 {
 }
 
-gptr<DispatchAction> ApplicationDispatcherIOS::InvokeAsync(
-    std::function<void()> function,
-    DispatchTime when
-)
-{
-    std::unique_lock<std::mutex> lk(mut);
-
-    auto action = gpnew<DispatchAction>(std::move(function), when);
-    sorted_insert(actions, action, DispatchActionComparison());
-    Wake();
-    return action;
-}
-
 void ApplicationDispatcherIOS::SetReady()
 {
     run = true;
@@ -133,10 +117,8 @@ gptr<DispatchAction> ApplicationDispatcherIOS::GetNextAction()
 
     gptr<DispatchAction> action;
 
-    if (run && !actions.empty() && DispatchClock::now() >= actions.front()->when) {
-        action = std::move(actions.front());
-        actions.popFront();
-    }
+    if (run)
+        action = DequeueAction(std::chrono::steady_clock::now());
 
     UpdateActionTimer();
 
@@ -147,13 +129,13 @@ void ApplicationDispatcherIOS::UpdateActionTimer()
 {
     // TODO: stop existing timer somehow
     
-    if (run && !actions.empty())
+    if (run && !HasImmediateActions())
     {
-        auto now = DispatchClock::now();
-        auto when = actions.front()->when;
+        auto now = std::chrono::steady_clock::now();
+        auto when = GetNextTimerTime();
 
         // queue timer for next action if needed
-        if (when > now)
+        if (when > now && when != std::chrono::steady_clock::time_point::max())
         {
             auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(when - now).count();
             
@@ -19,7 +19,7 @@ class ApplicationDispatcherIOS : public ApplicationDispatcher
 protected:
     void Wake() override;
 public:
-    bool wakeMessageQueued = false;
+    std::atomic<bool> wakeMessageQueued = false;
     dispatch_queue_main_t mainQueue = nil;
     void(^processActions)() = nil;
     void(^invokeDelegates)(NSTimer*) = nil;
@@ -31,9 +31,6 @@ public:
     virtual void Run(int argc, char* argv[]) override;
     virtual void Quit() override;
     virtual void SetContinuousDispatchRate(uint32_t rate) override;
-    virtual gptr<DispatchAction> InvokeAsync(
-        std::function<void()> function,
-        DispatchTime when = DispatchTime()) override;
 
     void SetReady();
 private:
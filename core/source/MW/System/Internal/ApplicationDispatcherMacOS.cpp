@@ -25,11 +25,8 @@ gptr<ApplicationDispatcher> ApplicationDispatcher::New() {
 
 void ApplicationDispatcherMacOS::Wake()
 {
-    if(!wakeMessageQueued)
-    {
-        wakeMessageQueued = true;
+    if(!wakeMessageQueued.exchange(true))
         dispatch_async(mainQueue, processActions);
-    }
 }
 
 ApplicationDispatcherMacOS::ApplicationDispatcherMacOS()
@@ -50,19 +47,6 @@ ApplicationDispatcherMacOS::~ApplicationDispatcherMacOS()
 {
 }
 
-gptr<DispatchAction> ApplicationDispatcherMacOS::InvokeAsync(
-    std::function<void()> function,
-    DispatchTime when
-)
-{
-    std::unique_lock<std::mutex> lk(mut);
-
-    auto action = gpnew<DispatchAction>(std::move(function), when);
-    sorted_insert(actions, action, DispatchActionComparison());
-    Wake();
-    return action;
-}
-
 void ApplicationDispatcherMacOS::Run(int argc, char *argv[])
 {
     run = true;
@@ -123,10 +107,8 @@ gptr<DispatchAction> ApplicationDispatcherMacOS::GetNextAction()
 
     gptr<DispatchAction> action;
 
-    if (run && !actions.empty() && DispatchClock::now() >= actions.front()->when) {
-        action = std::move(actions.front());
-        actions.popFront();
-    }
+    if (run)
+        action = DequeueAction(std::chrono::steady_clock::now());
 
     UpdateActionTimer();
 
@@ -137,13 +119,13 @@ void ApplicationDispatcherMacOS::UpdateActionTimer()
 {
     // TODO: stop existing timer somehow
     
-    if (run && !actions.empty())
+    if (run && !HasImmediateActions())
     {
-        auto now = DispatchClock::now();
-        auto when = actions.front()->when;
+        auto now = std::chrono::steady_clock::now();
+        auto when = GetNextTimerTime();
 
         // queue timer for next action if needed
-        if (when > now)
+        if (when > now && when != std::chrono::steady_clock::time_point::max())
         {
             auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(when - now).count();
             
@@ -22,7 +22,7 @@ protected:
     void Wake() override;
 public:
     AppDelegate* appDelegate = nil;
-    bool wakeMessageQueued = false;
+    std::atomic<bool> wakeMessageQueued = false;
     dispatch_queue_main_t mainQueue = nil;
     void(^ processActions)() = nil;
     void(^ invokeDelegates)(NSTimer*) = nil;
@@ -34,9 +34,6 @@ public:
     virtual void Run(int argc, char* argv[]) override;
     virtual void Quit() override;
     virtual void SetContinuousDispatchRate(uint32_t rate) override;
-    virtual gptr<DispatchAction> InvokeAsync(
-        std::function<void()> function,
-        DispatchTime when = DispatchTime()) override;
 private:
 
     void ProcessActions();
@@ -21,11 +21,8 @@ gptr<ApplicationDispatcher> ApplicationDispatcher::New() {
 
 void ApplicationDispatcherWindows::Wake()
 {
-    if (!wakeMessageQueued)
-    {
-        wakeMessageQueued = true;
+    if (!wakeMessageQueued.exchange(true))
         PostMessage(hWndMsg, WM_DISPATCHER_WAKE, 0, 0);
-    }
 }
 
 ApplicationDispatcherWindows::ApplicationDispatcherWindows()
@@ -39,18 +36,6 @@ ApplicationDispatcherWindows::~ApplicationDispatcherWindows()
         DestroyWindow(hWndMsg);
 }
 
-gptr<DispatchAction> ApplicationDispatcherWindows::InvokeAsync(
-    gfunction<void()> function, std::chrono::steady_clock::time_point when
-)
-{
-    std::unique_lock<std::mutex> lk(mut);
-
-    auto action = gpnew<DispatchAction>(std::move(function), when);
-    sorted_insert(actions, action, DispatchActionComparison());
-    Wake();
-    return action;
-}
-
 //BOOL GetMessageWithTimeout(MSG *msg, UINT timeout)
 //{
 //    UINT_PTR timerId = SetTimer(NULL, NULL, timeout, NULL);
@@ -212,10 +197,8 @@ gptr<DispatchAction> ApplicationDispatcherWindows::GetNextAction()
 
     gptr<DispatchAction> action;
 
-    if (run && !actions.empty() && std::chrono::steady_clock::now() >= actions.front()->when) {
-        action = std::move(actions.front());
-        actions.erase(actions.begin());
-    }
+    if (run)
+        action = DequeueAction(std::chrono::steady_clock::now());
 
     UpdateActionTimer();
 
@@ -229,13 +212,13 @@ void ApplicationDispatcherWindows::UpdateActionTimer()
         timerID = 0;
     }
 
-    if (!actions.empty())
+    if (!HasImmediateActions())
     {
         auto now = std::chrono::steady_clock::now();
-        auto when = actions.front()->when;
+        auto when = GetNextTimerTime();
 
         // queue timer for next action if needed
-        if (when > now)
+        if (when > now && when != std::chrono::steady_clock::time_point::max())
         {
             // TODO: figure out what to do about USER_TIMER_MINIMUM (SetTimer rounds up to this - 10ms)
             auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(when - now).count();
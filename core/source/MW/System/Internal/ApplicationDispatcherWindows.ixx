@@ -17,7 +17,7 @@ class ApplicationDispatcherWindows : public ApplicationDispatcher
 {
     HWND hWndMsg = NULL;
     bool isQuitting = false;
-    bool wakeMessageQueued = false;
+    std::atomic<bool> wakeMessageQueued = false;
     std::uint64_t timerID = 0;
 
 protected:
@@ -27,11 +27,6 @@ public:
     ApplicationDispatcherWindows();
     ~ApplicationDispatcherWindows();
 
-    virtual gptr<DispatchAction> InvokeAsync(
-        gfunction<void()> function,
-        std::chrono::steady_clock::time_point when = std::chrono::steady_clock::time_point{ std::chrono::steady_clock::duration::zero() }
-    ) override;
-
     virtual void Run(int argc, char* argv[]) override;
     virtual void Quit() override;
 
@@ -0,0 +1,441 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Microwave.System.JobSystem;
+import Microwave.System.Exception;
+import std;
+
+namespace mw {
+inline namespace system {
+
+struct JobSystem::Worker
+{
+    JobSystem* system = nullptr;
+    int index = 0;
+    WorkStealingDeque<Job> jobs;
+    std::uint32_t random = 0;
+    std::thread thread;
+};
+
+thread_local JobSystem::Worker* JobSystem::currentWorker = nullptr;
+thread_local Job* JobSystem::currentJob = nullptr;
+
+// attempts made by Wait() to find work before it starts backing off
+constexpr int WaitSpinCount = 64;
+
+JobSystem::JobSystem(int workerCount)
+{
+    if (workerCount <= 0)
+        workerCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+
+    for (int i = 0; i < workerCount; ++i)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->system = this;
+        worker->index = i;
+        worker->random = 0x9E3779B9u * (i + 1);
+        workers.push_back(std::move(worker));
+    }
+
+    // start threads after all workers exist, since they steal from each other
+    for (auto& worker : workers)
+        worker->thread = std::thread(&JobSystem::WorkerMain, this, worker.get());
+}
+
+JobSystem::~JobSystem()
+{
+    run = false;
+    workEpoch.fetch_add(1, std::memory_order_seq_cst);
+    workEpoch.notify_all();
+
+    for (auto& worker : workers)
+        worker->thread.join();
+
+    // release anything that never got to run
+    for (auto& worker : workers) {
+        while (Job* job = worker->jobs.Pop())
+            Release(job);
+    }
+
+    for (Job* job : injectedJobs)
+        Release(job);
+
+    for (Job* job : backgroundJobs)
+        Release(job);
+}
+
+JobHandle JobSystem::Schedule(gfunction<void()> function)
+{
+    Job* job = CreateJob(std::move(function), nullptr);
+    Submit(job, false);
+    return JobHandle(job);
+}
+
+JobHandle JobSystem::Schedule(gfunction<void()> function, const JobHandle& parent)
+{
+    Job* job = CreateJob(std::move(function), parent.job);
+    Submit(job, false);
+    return JobHandle(job);
+}
+
+JobHandle JobSystem::ScheduleBackground(gfunction<void()> function)
+{
+    Job* job = CreateJob(std::move(function), nullptr);
+    Submit(job, true);
+    return JobHandle(job);
+}
+
+void JobSystem::Wait(const JobHandle& handle)
+{
+    Job* job = handle.job;
+    if (!job)
+        return;
+
+    Worker* worker = GetCurrentWorker();
+    int idle = 0;
+
+    while (!job->IsFinished())
+    {
+        if (Job* other = FindJob(worker))
+        {
+            Execute(other);
+            idle = 0;
+        }
+        else if (++idle < WaitSpinCount)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            // workers that are waiting can't sleep on 'workEpoch', since
+            // job completion doesn't signal it, so back off instead
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    std::exception_ptr ex;
+    {
+        std::lock_guard<Spinlock> lk(job->lock);
+        ex = job->exception;
+    }
+
+    if (ex)
+        std::rethrow_exception(ex);
+}
+
+Task<void> JobSystem::WaitAsync(const JobHandle& handle)
+{
+    auto awaitable = gpnew<Awaitable<void>>();
+
+    Job* job = handle.job;
+    if (!job)
+    {
+        awaitable->SetCompleted();
+        return Task<void>(awaitable);
+    }
+
+    std::exception_ptr ex;
+    {
+        std::lock_guard<Spinlock> lk(job->lock);
+
+        // Finish() takes the lock after the job is marked finished,
+        // so the awaitable is either completed here or by Finish()
+        if (!job->IsFinished()) {
+            job->awaiters.push_back(awaitable);
+            return Task<void>(awaitable);
+        }
+
+        ex = job->exception;
+    }
+
+    if (ex)
+        awaitable->SetException(ex);
+    else
+        awaitable->SetCompleted();
+
+    return Task<void>(awaitable);
+}
+
+int JobSystem::GetWorkerCount() const {
+    return (int)workers.size();
+}
+
+JobStats JobSystem::GetStats() const
+{
+    JobStats stats;
+    stats.executed = executedJobs.load(std::memory_order_relaxed);
+    stats.stolen = stolenJobs.load(std::memory_order_relaxed);
+    return stats;
+}
+
+JobSystem& JobSystem::GetInstance()
+{
+    static JobSystem instance;
+    return instance;
+}
+
+Job* JobSystem::CreateJob(gfunction<void()> function, Job* parent)
+{
+    if (parent)
+    {
+        // a parent can only gain children while it or one of its children is
+        // still running, since finishing it already released its resources
+        int unfinished = parent->unfinished.load(std::memory_order_relaxed);
+        do
+        {
+            if (unfinished == 0)
+                throw Exception("cannot add a child to a job that has already finished");
+        }
+        while (!parent->unfinished.compare_exchange_weak(unfinished, unfinished + 1, std::memory_order_relaxed));
+
+        parent->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Job* job = new Job(std::move(function), parent);
+
+    // one reference for the returned handle, one for the scheduler
+    job->refs.store(2, std::memory_order_relaxed);
+    return job;
+}
+
+void JobSystem::Submit(Job* job, bool background)
+{
+    Worker* worker = GetCurrentWorker();
+
+    if (worker && !background)
+    {
+        worker->jobs.Push(job);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lk(queueLock);
+        (background ? backgroundJobs : injectedJobs).push_back(job);
+        queuedJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // a worker going to sleep registers itself before its final check for
+    // work, so either it finds this job or we see it and wake it up
+    workEpoch.fetch_add(1, std::memory_order_seq_cst);
+
+    if (sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+        workEpoch.notify_one();
+}
+
+void JobSystem::WorkerMain(Worker* worker)
+{
+    currentWorker = worker;
+
+    while (run.load(std::memory_order_relaxed))
+    {
+        if (Job* job = FindJob(worker)) {
+            Execute(job);
+            continue;
+        }
+
+        sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+        auto epoch = workEpoch.load(std::memory_order_seq_cst);
+
+        Job* job = FindJob(worker);
+        if (!job && run.load(std::memory_order_relaxed))
+            workEpoch.wait(epoch, std::memory_order_seq_cst);
+
+        sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+
+        if (job)
+            Execute(job);
+    }
+
+    currentWorker = nullptr;
+}
+
+Job* JobSystem::FindJob(Worker* worker)
+{
+    if (worker)
+    {
+        if (Job* job = worker->jobs.Pop())
+            return job;
+    }
+
+    if (queuedJobs.load(std::memory_order_relaxed) > 0)
+    {
+        if (Job* job = PopQueue(injectedJobs))
+            return job;
+    }
+
+    std::size_t count = workers.size();
+    std::size_t start = 0;
+
+    if (worker)
+    {
+        // xorshift, to spread thieves across victims
+        worker->random ^= worker->random << 13;
+        worker->random ^= worker->random >> 17;
+        worker->random ^= worker->random << 5;
+        start = worker->random % count;
+    }
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto& victim = workers[(start + i) % count];
+        if (victim.get() == worker)
+            continue;
+
+        if (Job* job = victim->jobs.Steal()) {
+            stolenJobs.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+
+    // only workers take background jobs, since they may block
+    if (worker && queuedJobs.load(std::memory_order_relaxed) > 0)
+    {
+        if (Job* job = PopQueue(backgroundJobs))
+            return job;
+    }
+
+    return nullptr;
+}
+
+Job* JobSystem::PopQueue(std::deque<Job*>& queue)
+{
+    std::lock_guard<std::mutex> lk(queueLock);
+
+    if (queue.empty())
+        return nullptr;
+
+    Job* job = queue.front();
+    queue.pop_front();
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+}
+
+void JobSystem::Execute(Job* job)
+{
+    Job* previousJob = currentJob;
+    currentJob = job;
+
+    try
+    {
+        job->function();
+    }
+    catch (...)
+    {
+        std::lock_guard<Spinlock> lk(job->lock);
+        if (!job->exception)
+            job->exception = std::current_exception();
+    }
+
+    // release captures now rather than when the last handle goes away
+    job->function = nullptr;
+
+    currentJob = previousJob;
+    executedJobs.fetch_add(1, std::memory_order_relaxed);
+
+    Finish(job);
+}
+
+void JobSystem::Finish(Job* job)
+{
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+
+    std::vector<gptr<Awaitable<void>>> awaiters;
+    std::exception_ptr ex;
+    {
+        std::lock_guard<Spinlock> lk(job->lock);
+        awaiters.swap(job->awaiters);
+        ex = job->exception;
+    }
+
+    Job* parent = job->parent;
+
+    if (parent && ex)
+    {
+        std::lock_guard<Spinlock> lk(parent->lock);
+        if (!parent->exception)
+            parent->exception = ex;
+    }
+
+    for (auto& awaitable : awaiters)
+    {
+        if (ex)
+            awaitable->SetException(ex);
+        else
+            awaitable->SetCompleted();
+    }
+
+    // the scheduler's reference
+    Release(job);
+
+    if (parent)
+    {
+        Finish(parent);
+        Release(parent); // the child's reference
+    }
+}
+
+void JobSystem::Release(Job* job)
+{
+    if (job->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete job;
+}
+
+JobSystem::Worker* JobSystem::GetCurrentWorker() const {
+    return (currentWorker && currentWorker->system == this) ? currentWorker : nullptr;
+}
+
+std::size_t JobSystem::GetGrainSize(std::size_t count, std::size_t grainSize) const
+{
+    if (grainSize > 0)
+        return grainSize;
+
+    // a few chunks per thread, so that stealing can even out uneven work
+    std::size_t chunks = (workers.size() + 1) * 4;
+    return std::max<std::size_t>(1, (count + chunks - 1) / chunks);
+}
+
+void JobSystem::ParallelForRange(std::size_t count, std::size_t grainSize, const RangeFunction& body)
+{
+    if (count == 0)
+        return;
+
+    grainSize = GetGrainSize(count, grainSize);
+
+    if (count <= grainSize || workers.empty()) {
+        body(0, count);
+        return;
+    }
+
+    auto root = Schedule([this, count, grainSize, &body]{
+        SplitRange(0, count, grainSize, body);
+    });
+
+    Wait(root);
+}
+
+void JobSystem::SplitRange(std::size_t begin, std::size_t end, std::size_t grainSize, const RangeFunction& body)
+{
+    // hand off the upper half of the range as a child of the current job until
+    // what's left is small enough, so that thieves take the largest pieces
+    Job* parent = currentJob;
+
+    while (end - begin > grainSize)
+    {
+        std::size_t mid = begin + (end - begin) / 2;
+
+        Job* child = CreateJob([this, mid, end, grainSize, &body]{
+            SplitRange(mid, end, grainSize, body);
+        }, parent);
+
+        Submit(child, false);
+        Release(child); // no handle is kept
+
+        end = mid;
+    }
+
+    body(begin, end);
+}
+
+} // system
+} // mw
@@ -0,0 +1,208 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.System.JobSystem;
+import Microwave.System.Awaitable;
+import Microwave.System.Pointers;
+import Microwave.System.Spinlock;
+import Microwave.System.Task;
+import Microwave.System.WorkStealingDeque;
+import std;
+
+export namespace mw {
+inline namespace system {
+
+class Job
+{
+    friend class JobHandle;
+    friend class JobSystem;
+
+    gfunction<void()> function;
+    Job* parent = nullptr;
+    std::atomic<int> unfinished = 1; // this job plus its unfinished children
+    std::atomic<int> refs = 1;
+
+    Spinlock lock;
+    std::exception_ptr exception;
+    std::vector<gptr<Awaitable<void>>> awaiters;
+
+    Job(gfunction<void()> function, Job* parent)
+        : function(std::move(function)), parent(parent) {}
+
+public:
+    bool IsFinished() const {
+        return unfinished.load(std::memory_order_acquire) == 0;
+    }
+};
+
+class JobHandle
+{
+    friend class JobSystem;
+
+    Job* job = nullptr;
+
+    // adopts a reference
+    explicit JobHandle(Job* job) : job(job) {}
+
+public:
+    JobHandle() = default;
+
+    JobHandle(const JobHandle& other) : job(other.job) {
+        if (job) job->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    JobHandle(JobHandle&& other) noexcept
+        : job(std::exchange(other.job, nullptr)) {}
+
+    ~JobHandle() {
+        Reset();
+    }
+
+    JobHandle& operator=(JobHandle other) noexcept {
+        std::swap(job, other.job);
+        return *this;
+    }
+
+    void Reset()
+    {
+        if (job && job->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete job;
+
+        job = nullptr;
+    }
+
+    bool IsFinished() const {
+        return !job || job->IsFinished();
+    }
+
+    explicit operator bool() const { return job != nullptr; }
+};
+
+struct JobStats
+{
+    std::uint64_t executed = 0;
+    std::uint64_t stolen = 0;
+};
+
+// Work-stealing scheduler. Each worker owns a Chase-Lev deque - jobs
+// scheduled from a worker go to the bottom of its own deque, and idle
+// workers steal from the top of others. Jobs scheduled from any other
+// thread go through a shared injection queue.
+//
+// Jobs may have a parent, which isn't considered finished until all of
+// its children are. Wait() runs other jobs while it waits instead of
+// blocking, so it's safe to call from inside a job.
+class JobSystem
+{
+    struct Worker;
+    using RangeFunction = gfunction<void(std::size_t, std::size_t)>;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex queueLock;
+    std::deque<Job*> injectedJobs;
+    std::deque<Job*> backgroundJobs;
+    std::atomic<int> queuedJobs = 0;
+
+    std::atomic<bool> run = true;
+    std::atomic<std::uint32_t> workEpoch = 0;
+    std::atomic<int> sleepingWorkers = 0;
+
+    std::atomic<std::uint64_t> executedJobs = 0;
+    std::atomic<std::uint64_t> stolenJobs = 0;
+
+    static thread_local Worker* currentWorker;
+    static thread_local Job* currentJob;
+
+public:
+    // 'workerCount' of zero uses one worker per core, minus one for the main thread
+    explicit JobSystem(int workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    JobHandle Schedule(gfunction<void()> function);
+
+    // 'parent' must still be unfinished, i.e. this is called from 'parent'
+    // or one of its children, otherwise an Exception is thrown
+    JobHandle Schedule(gfunction<void()> function, const JobHandle& parent);
+
+    // For jobs that may block (file IO, decoding, etc). They only run on
+    // workers, and only when there's no other work, so they never stall
+    // a thread that is helping out in Wait().
+    JobHandle ScheduleBackground(gfunction<void()> function);
+
+    // runs other jobs until 'job' and all of its children have finished,
+    // then rethrows the first exception raised by any of them
+    void Wait(const JobHandle& job);
+
+    // completes on the awaiting coroutine's dispatcher once 'job' finishes
+    Task<void> WaitAsync(const JobHandle& job);
+
+    // calls fun(begin, end) over subranges of [0, count) no larger than 'grainSize',
+    // returning when all have completed. A 'grainSize' of zero picks one automatically.
+    template<class Fun>
+    void ParallelFor(std::size_t count, std::size_t grainSize, Fun&& fun)
+    {
+        RangeFunction body = [&fun](std::size_t begin, std::size_t end) { fun(begin, end); };
+        ParallelForRange(count, grainSize, body);
+    }
+
+    template<class Fun>
+    void ParallelFor(std::size_t count, Fun&& fun) {
+        ParallelFor(count, 0, std::forward<Fun>(fun));
+    }
+
+    // folds map(begin, end) over subranges of [0, count) with 'combine'.
+    // Partial results are combined in order, so the result is deterministic.
+    template<class T, class Map, class Combine>
+    T ParallelReduce(std::size_t count, std::size_t grainSize, T identity, Map&& map, Combine&& combine)
+    {
+        grainSize = GetGrainSize(count, grainSize);
+        std::size_t chunks = (count + grainSize - 1) / grainSize;
+
+        std::vector<T> partials(chunks, identity);
+
+        ParallelFor(chunks, 1, [&](std::size_t first, std::size_t last)
+        {
+            for (std::size_t c = first; c < last; ++c)
+            {
+                std::size_t begin = c * grainSize;
+                std::size_t end = std::min(begin + grainSize, count);
+                partials[c] = map(begin, end);
+            }
+        });
+
+        T result = std::move(identity);
+
+        for (auto& partial : partials)
+            result = combine(std::move(result), partial);
+
+        return result;
+    }
+
+    int GetWorkerCount() const;
+    JobStats GetStats() const;
+
+    static JobSystem& GetInstance();
+
+private:
+    Job* CreateJob(gfunction<void()> function, Job* parent);
+    void Submit(Job* job, bool background);
+    void WorkerMain(Worker* worker);
+    Job* FindJob(Worker* worker);
+    Job* PopQueue(std::deque<Job*>& queue);
+    void Execute(Job* job);
+    void Finish(Job* job);
+    static void Release(Job* job);
+    Worker* GetCurrentWorker() const;
+
+    std::size_t GetGrainSize(std::size_t count, std::size_t grainSize) const;
+    void ParallelForRange(std::size_t count, std::size_t grainSize, const RangeFunction& body);
+    void SplitRange(std::size_t begin, std::size_t end, std::size_t grainSize, const RangeFunction& body);
+};
+
+} // system
+} // mw
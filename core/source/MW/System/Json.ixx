@@ -2,6 +2,13 @@
 *  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
 *--------------------------------------------------------------*/
 
+module;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#  include <emmintrin.h>
+#  define MW_JSON_SSE2 1
+#endif
+
 export module Microwave.System.Json;
 import Microwave.System.Exception;
 import Microwave.System.Pointers;
@@ -13,422 +20,107 @@ import <utf8.h>;
 export namespace mw {
 inline namespace system {
 
-enum class JsonTokenType
-{
-    EndOfFile,
-    ObjectStart,
-    ObjectEnd,
-    ArrayStart,
-    ArrayEnd,
-    Colon,
-    Comma,
-    String,
-    Integer,
-    Float,
-    Boolean,
-    Null
-};
+class json;
+struct JsonMember;
 
-struct JsonToken
+// Bump allocator for a parsed document. It holds a copy of the source
+// text, the document's arrays and object members, and any strings that
+// had to be unescaped. Everything is freed at once with the arena, so
+// nothing placed in it is ever destroyed.
+class JsonArena
 {
-    typedef std::variant<std::nullptr_t, std::int64_t, double, bool, char, std::string> DataStorageType;
-
-    DataStorageType data;
-    JsonTokenType type = JsonTokenType::EndOfFile;
-    std::string::iterator pos;
-
-    JsonToken(){}
-
-    JsonToken(JsonTokenType type, std::string::iterator pos, const std::string& value)
-        : data(value), type(type), pos(pos){}
-
-    JsonToken(JsonTokenType type, std::string::iterator pos, std::string&& value)
-        : data(std::move(value)), type(type), pos(pos){}
-
-    JsonToken(JsonTokenType type, std::string::iterator pos, std::int64_t value)
-        : data(value), type(type), pos(pos){}
-
-    JsonToken(JsonTokenType type, std::string::iterator pos, double value)
-        : data(value), type(type), pos(pos){}
-
-    JsonToken(JsonTokenType type, std::string::iterator pos, bool value)
-        : data(value), type(type), pos(pos){}
-
-    JsonToken(JsonTokenType type, std::string::iterator pos, char value)
-        : data(value), type(type), pos(pos){}
-
-    JsonToken(JsonTokenType type, std::string::iterator pos, std::nullptr_t value)
-        : data(value), type(type), pos(pos){}
-
-    std::int64_t GetInteger() const {
-        return std::get<std::int64_t>(data);
-    }
-
-    double GetFloat() const {
-        return std::get<double>(data);
-    }
-
-    bool GetBoolean() const {
-        return std::get<bool>(data);
-    }
-
-    char GetChar() const {
-        return std::get<char>(data);
-    }
-
-    const std::string& GetString() const {
-        return std::get<std::string>(data);
-    }
-
-    std::string_view GetTypeName() const
-    {
-        static std::unordered_map<JsonTokenType, std::string_view> typeNames {
-            { JsonTokenType::EndOfFile, "EndOfFile" },
-            { JsonTokenType::ObjectStart, "ObjectStart" },
-            { JsonTokenType::ObjectEnd, "ObjectEnd" },
-            { JsonTokenType::ArrayStart, "ArrayStart" },
-            { JsonTokenType::ArrayEnd, "ArrayEnd" },
-            { JsonTokenType::Colon, "Colon" },
-            { JsonTokenType::Comma, "Comma" },
-            { JsonTokenType::String, "String" },
-            { JsonTokenType::Integer, "Integer" },
-            { JsonTokenType::Float, "Float" },
-            { JsonTokenType::Boolean, "Boolean" },
-            { JsonTokenType::Null, "Null" }
-        };
+    static constexpr std::size_t MinBlockSize = 4096;
 
-        return typeNames[type];
-    }
-};
-
-class JsonLexer
-{
-    std::size_t line{};
-    std::size_t column{};
-    std::string::iterator pos;
-    std::string::iterator next;
-    char32_t value{};
-    std::string chars;
-    int tabLength = 4;
+    std::vector<uptr<std::byte[]>> blocks;
+    std::byte* next = nullptr;
+    std::byte* last = nullptr;
+    std::size_t blockSize;
 public:
+    // the first block holds at least 'capacity' bytes, and each block
+    // after that is twice the size of the one before it
+    explicit JsonArena(std::size_t capacity)
+        : blockSize(std::max(capacity, MinBlockSize)) {}
 
-    bool endOfFile() const {
-        return pos == chars.end();
-    }
-
-    char32_t getValue() const {
-        return value;
-    }
-
-    std::size_t getOffset() const {
-        return pos - chars.begin();
-    }
-
-    JsonLexer(const std::string& text)
-    {
-        chars = text;
-
-        pos = chars.begin();
-        next = pos;
-        value = utf8::next(next, chars.end());
-        line = 0;
-        column = 0;
-    }
-
-    static std::vector<JsonToken> Tokenize(const std::string& text)
-    {
-        std::vector<JsonToken> tokens;
-        JsonLexer lexer(text);
-
-        do {
-            tokens.push_back(lexer.GetNextToken());
-        } while (!lexer.endOfFile());
-
-        return tokens;
-    }
-
-    JsonToken GetNextToken()
-    {
-        SkipWhitespace();
-
-        if (pos == chars.end()) {
-            return JsonToken(JsonTokenType::EndOfFile, pos, (char)EOF);
-        }
-        else if (value == '{') {
-            SkipChar();
-            return JsonToken(JsonTokenType::ObjectStart, pos, '{');
-        }
-        else if (value == '}') {
-            SkipChar();
-            return JsonToken(JsonTokenType::ObjectEnd, pos, '}');
-        }
-        else if (value == '[') {
-            SkipChar();
-            return JsonToken(JsonTokenType::ArrayStart, pos, '[');
-        }
-        else if (value == ']') {
-            SkipChar();
-            return JsonToken(JsonTokenType::ArrayEnd, pos, ']');
-        }
-        else if (value == ':') {
-            SkipChar();
-            return JsonToken(JsonTokenType::Colon, pos, ':');
-        }
-        else if (value == ',') {
-            SkipChar();
-            return JsonToken(JsonTokenType::Comma, pos, ',');
-        }
-        else if (value == '\"') {
-            return GetStringToken();
-        }
-        else if ((value >= '0' && value <= '9') || value == '-' || value == '+') {
-            return GetNumberToken();
-        }
-        else if (value == 't' || value == 'f') {
-            return GetBooleanToken();
-        }
-        else if (value == 'n') {
-            return GetNullToken();
-        }
-        else {
-            throw Exception({ "found unexpected input: ", (char)value });
-        }
-    }
-
-private:
-
-    void SkipWhitespace()
-    {
-        while (pos != chars.end())
-        {
-            if (value == ' ') // spaces
-            {
-                ++column;
-            }
-            else if (value == '\t')
-            {
-                column += tabLength;
-            }
-            else if (value == '\n') // new line
-            {
-                ++line;
-                column = 0;
-            }
-            else if (value == '\v' || value == '\f' || value == '\r')
-            {
-                // ignore
-            }
-            else
-            {
-                // found non-whitespace character
-                break;
-            }
-
-            SkipChar();
-        }
-    }
-
-    void SkipChar()
-    {
-        Assert(pos != next);
-        pos = next;
-        value = (next != chars.end()) ?
-            utf8::next(next, chars.end()) : 0;
-    }
-
-    void SkipChars(ptrdiff_t count)
-    {
-        Assert(pos != next);
-        utf8::advance(pos, count, chars.end());
-        next = pos;
-        value = (next != chars.end()) ?
-            utf8::next(next, chars.end()) : 0;
-    }
-
-    bool IsStartOfNumber(char32_t c) {
-        return (c >= '0' && c <= '9') || c == '-' || c == '+';
-    }
-
-    bool IsStartOf(char32_t c) {
-        return (c >= '0' && c <= '9') || c == '-' || c == '+';
-    }
-
-    JsonToken GetStringToken()
-    {
-        Assert(value == U'\"');
-
-        auto start = pos;
-        SkipChar();
-
-        std::string str;
-
-        while (pos != chars.end())
-        {
-            if (value == U'\"')
-            {
-                SkipChar();
-                return JsonToken(JsonTokenType::String, start, str);
-            }
-            else if (value == U'\\')
-            {
-                SkipChar();
-
-                if (pos == chars.end())
-                    throw Exception("unexpected end of input");
-
-                if (value == U'\"') {
-                    SkipChar();
-                    utf8::append(U'\"', std::back_inserter(str));
-                }
-                else if (value == U'\\') {
-                    SkipChar();
-                    utf8::append(U'\\', std::back_inserter(str));
-                }
-                else if (value == U'r') {
-                    SkipChar();
-                    utf8::append(U'\r', std::back_inserter(str));
-                }
-                else if (value == U'n') {
-                    SkipChar();
-                    utf8::append(U'\n', std::back_inserter(str));
-                }
-                else if (value == U't') {
-                    SkipChar();
-                    utf8::append(U'\t', std::back_inserter(str));
-                }
-                else if (value == U'b') {
-                    SkipChar();
-                    utf8::append(U'\b', std::back_inserter(str));
-                }
-                else if (value == U'f') {
-                    SkipChar();
-                    utf8::append(U'\f', std::back_inserter(str));
-                }
-                else if (value == U'u')
-                {
-                    SkipChar();
-
-                    if ((chars.end() - pos) < 4)
-                        throw Exception("unexpected end of input");
-
-                    char hex[4];
-
-                    for (int i = 0; i < 4; ++i)
-                    {
-                        if (!std::isxdigit(value))
-                            throw Exception("invalid unicode escape sequence");
-
-                        hex[i] = (char)value;
-                        SkipChar();
-                    }
-
-                    char32_t charValue = (char32_t)std::strtoul(hex, nullptr, 16);
-                    utf8::append(charValue, std::back_inserter(str));
-                }
-                else
-                {
-                    utf8::append(value, std::back_inserter(str));
-                    SkipChar();
-                }
-            }
-            else
-            {
-                utf8::append(value, std::back_inserter(str));
-                SkipChar();
-            }
-        }
-
-        Assert(pos == chars.end());
-        throw Exception("unexpected end of input");
-    }
+    JsonArena(const JsonArena&) = delete;
+    JsonArena& operator=(const JsonArena&) = delete;
 
-    JsonToken GetNumberToken()
+    // returns uninitialized storage for 'count' objects of type T
+    template<class T>
+    T* Allocate(std::size_t count)
     {
-        auto start = pos;
-        auto beg = chars.data() + (pos - chars.begin());
-        auto end = chars.data() + chars.size();
+        if (count == 0)
+            return nullptr;
 
-        double value;
-        std::from_chars_result ret = std::from_chars(beg, end, value);
-        if(ret.ec != std::errc())
-            throw Exception("invalid number");
+        std::size_t size = sizeof(T) * count;
+        std::size_t padding = (alignof(T) - (std::uintptr_t)next % alignof(T)) % alignof(T);
 
-        auto len = ret.ptr - &start[0];
-        std::string_view number(beg, beg + len);
-
-        SkipChars(len);
-
-        if(number.find('.') != std::string_view::npos)
+        if ((std::size_t)(last - next) < padding + size)
         {
-            return JsonToken(JsonTokenType::Float, start, value);
+            std::size_t capacity = std::max(blockSize, size + alignof(T));
+            blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(capacity));
+            next = blocks.back().get();
+            last = next + capacity;
+            blockSize *= 2;
+            padding = (alignof(T) - (std::uintptr_t)next % alignof(T)) % alignof(T);
         }
-        else
-        {
-            std::int64_t intValue;
-            ret = std::from_chars(beg, end, intValue);
-            if(ret.ec != std::errc())
-                throw Exception("invalid number");
 
-            return JsonToken(JsonTokenType::Integer, start, intValue);
-        }
-    }
-
-    JsonToken GetBooleanToken()
-    {
-        auto start = pos;
-        auto p = &*pos;
-
-        bool val;
-
-        if (std::equal(p, p + 4, "true")) {
-            val = true;
-            SkipChars(4);
-        }
-        else if (std::equal(p, p + 5, "false")) {
-            val = false;
-            SkipChars(5);
-        }
-        else {
-            throw Exception("expected boolean literal");
-        }
-
-        return JsonToken(JsonTokenType::Boolean, start, val);
+        T* ret = (T*)(next + padding);
+        next += padding + size;
+        return ret;
     }
 
-    JsonToken GetNullToken()
+    std::string_view CopyString(std::string_view str)
     {
-        auto start = pos;
-        auto p = &*pos;
-
-        if (std::equal(p, p + 4, "null"))
-            SkipChars(4);
-        else
-            throw Exception("expected null literal");
-
-        return JsonToken(JsonTokenType::Null, start, nullptr);
+        char* chars = Allocate<char>(str.size());
+        std::copy(str.begin(), str.end(), chars);
+        return std::string_view(chars, str.size());
     }
 };
 
-class json;
-
+// Recursive descent parser that builds the document in an arena.
+//
+// The input is first scanned for structural characters, 16 bytes at a
+// time where SSE2 is available, to count the entries of every array and
+// object. That's enough to size the arena, and lets each array or object
+// be allocated at its final size when it opens, so values are parsed
+// straight into place.
+//
+// The input is then copied into the arena once and parsed in place,
+// without being tokenized. Strings without escapes point into that copy.
 class JsonParser
 {
-    JsonLexer lexer;
-    JsonToken token;
+    static constexpr int MaxDepth = 512;
+
+    sptr<JsonArena> arena;
+    const char* beg = nullptr;
+    const char* pos = nullptr;
+    const char* end = nullptr;
+    int depth = 0;
+
+    // the number of entries in each array and object, in the order they open
+    std::vector<std::uint32_t> sizes;
+    std::size_t nextSize = 0;
+
+    // strings with escapes are decoded here before going into the arena
+    std::string escaped;
 public:
-    JsonParser(const std::string& text);
+    JsonParser(std::string_view text);
     json parse();
 
 private:
-    bool NextToken(bool thrownOnEOF = true);
+    std::size_t ScanStructure(std::string_view text);
+    std::size_t NextSize();
+    [[noreturn]] void Error(std::string_view message) const;
+    void SkipWhitespace();
+    void Expect(char c);
     json ParseValue();
-    json ParseString();
-    json ParseInteger();
-    json ParseFloat();
-    json ParseBoolean();
-    json ParseNull();
     json ParseObject();
     json ParseArray();
+    json ParseNumber();
+    json ParseLiteral();
+    std::string_view ParseString();
+    void ParseEscape(std::string& str);
+    char32_t ParseHex4();
 };
 
 class JsonPrinter
@@ -437,7 +129,7 @@ class JsonPrinter
     bool pretty;
 
     void Indent(std::ostream& stream, int indent);
-    void WriteEscaped(std::ostream& stream, const std::string& val);
+    void WriteEscaped(std::ostream& stream, std::string_view val);
 public:
 
     JsonPrinter(int indentWidth);
@@ -495,27 +187,115 @@ enum class DataType
     Boolean
 };
 
+
+// The members of an object built in code. They're kept sorted by key, the
+// same as the members of a parsed object, so both can be looked up with a
+// binary search and read through json::ObjectView. The object owns its keys.
+class JsonObject
+{
+    std::vector<JsonMember> members;
+    std::forward_list<std::string> keys;
+public:
+    using value_type = JsonMember;
+    using iterator = JsonMember*;
+    using const_iterator = const JsonMember*;
+
+    JsonObject() = default;
+    JsonObject(const_iterator first, const_iterator last);
+    JsonObject(const JsonObject& other);
+    JsonObject(JsonObject&& other) = default;
+    JsonObject& operator=(const JsonObject& other);
+    JsonObject& operator=(JsonObject&& other) = default;
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    std::size_t size() const;
+    bool empty() const;
+
+    // return end() if there's no member with the key
+    iterator find(std::string_view key);
+    const_iterator find(std::string_view key) const;
+
+    bool contains(std::string_view key) const;
+
+    json& at(std::string_view key);
+    const json& at(std::string_view key) const;
+
+    // adds a null member if there's none with the key
+    json& operator[](std::string_view key);
+
+    void insert_or_assign(std::string_view key, json value);
+    void clear();
+};
+
+// Returns a pointer to the member with the key, or to the end of 'members'
+// if there's none. The members must be sorted by key.
+const JsonMember* FindJsonMember(std::span<const JsonMember> members, std::string_view key);
+
 class json
 {
 public:
     using NullType = std::nullptr_t;
-    using ObjectType = std::unordered_map<std::string, json>;
+    using ObjectType = JsonObject;
     using ArrayType = std::vector<json>;
     using StringType = std::string;
     using IntegerType = std::int64_t;
     using FloatType = double;
     using BooleanType = bool;
 
+    // what GetObject() and GetArray() return for a const json, which works
+    // the same whether the value was parsed or built in code
+    using ObjectView = std::span<const JsonMember>;
+    using ArrayView = std::span<const json>;
+
     friend JsonParser;
 
 private:
-    typedef std::variant<NullType, ObjectType, ArrayType, StringType, IntegerType, FloatType, BooleanType> DataStorageType;
+    // Values returned by parse() are views into the arena of the document
+    // they came from, and are read-only. Anything that could modify one
+    // copies it into ordinary owned storage first, so parsed documents
+    // should be read through const references.
+    //
+    // Only the root holds on to the arena. Copying the root shares it, but
+    // a copy of anything below the root gets its own storage, since the
+    // copy could outlive the document.
+    struct ParsedObject
+    {
+        const JsonMember* members = nullptr;
+        std::size_t count = 0;
+        sptr<const JsonArena> arena;
+    };
+
+    struct ParsedArray
+    {
+        const json* elements = nullptr;
+        std::size_t count = 0;
+        sptr<const JsonArena> arena;
+    };
+
+    using ParsedString = std::string_view;
+
+    typedef std::variant<
+        NullType, ObjectType, ArrayType, StringType, IntegerType, FloatType, BooleanType,
+        ParsedObject, ParsedArray, ParsedString> DataStorageType;
+
     DataStorageType data;
 
+    void MakeOwned();
+    const json* FindValue(std::string_view key) const;
+
 public:
     json(nullptr_t = nullptr)
         : data(nullptr) {}
 
+    json(const json& other);
+    json(json&& other) = default;
+    json& operator=(const json& other);
+    json& operator=(json&& other) = default;
+
     json(const ObjectType& obj)
         : data(obj) {}
 
@@ -594,10 +374,7 @@ public:
         return get<T>();
     }
 
-    static json parse(const std::string& text) {
-        JsonParser parser(text);
-        return parser.parse();
-    }
+    static json parse(std::string_view text);
 
     std::string dump(int indent = -1)
     {
@@ -607,45 +384,48 @@ public:
 
     DataType GetType() const
     {
-        std::array<DataType, 7> types {
+        static constexpr std::array<DataType, 10> types {
             DataType::Null,
             DataType::Object,
             DataType::Array,
             DataType::String,
             DataType::Integer,
             DataType::Float,
-            DataType::Boolean
+            DataType::Boolean,
+            DataType::Object,
+            DataType::Array,
+            DataType::String
         };
         
         return types[data.index()];
     }
 
     bool IsNull() const {
-        return std::holds_alternative<NullType>(data);
+        return GetType() == DataType::Null;
     }
 
     bool IsObject() const {
-        return std::holds_alternative<ObjectType>(data);
+        return GetType() == DataType::Object;
     }
 
     bool IsArray() const {
-        return std::holds_alternative<ArrayType>(data);
+        return GetType() == DataType::Array;
     }
 
     bool IsString() const {
-        return std::holds_alternative<StringType>(data);
+        return GetType() == DataType::String;
     }
 
     bool IsInteger() const {
-        return std::holds_alternative<IntegerType>(data);
+        return GetType() == DataType::Integer;
     }
 
     bool IsFloat() const {
-        return std::holds_alternative<FloatType>(data);
+        return GetType() == DataType::Float;
     }
 
     bool IsBoolean() const {
-        return std::holds_alternative<BooleanType>(data);
+        return GetType() == DataType::Boolean;
     }
 
     bool is_null() const {
@@ -656,16 +436,26 @@ public:
         return GetArray().at(index);
     }
 
-    const json& at(std::size_t index) const {
-        return GetArray().at(index);
+    const json& at(std::size_t index) const
+    {
+        auto arr = GetArray();
+
+        if (index >= arr.size())
+            throw std::out_of_range("json array index out of range");
+
+        return arr[index];
     }
 
-    json& at(const ObjectType::key_type& key) {
+    json& at(std::string_view key) {
         return GetObject().at(key);
     }
 
-    const json& at(const ObjectType::key_type& key) const {
-        return GetObject().at(key);
+    const json& at(std::string_view key) const
+    {
+        if (auto val = FindValue(key))
+            return *val;
+
+        throw std::out_of_range("json object has no such key");
     }
     
     json& operator[](std::size_t index)
@@ -680,10 +470,10 @@ public:
     }
 
     const json& operator[](std::size_t index) const {
-        return GetArray().at(index);
+        return at(index);
     }
 
-    json& operator[](const ObjectType::key_type& key)
+    json& operator[](std::string_view key)
     {
         if (IsNull())
             data.emplace<ObjectType>();
@@ -691,43 +481,43 @@ public:
         return GetObject()[key];
     }
 
-    json& operator[](const char* key)
-    {
-        if (IsNull())
-            data.emplace<ObjectType>();
-
-        return GetObject()[key];
+    json& operator[](const char* key) {
+        return (*this)[std::string_view(key)];
     }
 
-    const json& operator[](const ObjectType::key_type& key) const {
-        return GetObject().at(key);
+    const json& operator[](std::string_view key) const {
+        return at(key);
     }
 
     const json& operator[](const char* key) const {
-        return GetObject().at(key);
+        return at(key);
     }
-    
+
     ObjectType& GetObject() {
+        MakeOwned();
         return std::get<ObjectType>(data);
     }
 
-    const ObjectType& GetObject() const {
-        return std::get<ObjectType>(data);
-    }
+    ObjectView GetObject() const;
 
     ArrayType& GetArray() {
+        MakeOwned();
         return std::get<ArrayType>(data);
     }
 
-    const ArrayType& GetArray() const {
+    ArrayView GetArray() const
+    {
+        if (auto arr = std::get_if<ParsedArray>(&data))
+            return ArrayView(arr->elements, arr->count);
+
         return std::get<ArrayType>(data);
     }
 
-    StringType& GetString() {
-        return std::get<StringType>(data);
-    }
+    std::string_view GetString() const
+    {
+        if (auto str = std::get_if<ParsedString>(&data))
+            return *str;
 
-    const StringType& GetString() const {
         return std::get<StringType>(data);
     }
 
@@ -782,13 +572,12 @@ public:
     }
 
     template<class T>
-    T value(const ObjectType::key_type& key, T defaultValue) const
+    T value(std::string_view key, T defaultValue) const
     {
         T ret;
 
-        auto it = GetObject().find(key);
-        if (it != GetObject().end()) {
-            ret = it->second.get<T>();
+        if (auto val = FindValue(key)) {
+            ret = val->get<T>();
         }
         else {
             ret = std::move(defaultValue);
@@ -797,42 +586,20 @@ public:
         return ret;
     }
 
-    bool empty() const
-    {
-        if (IsObject())
-            return GetObject().empty();
-        else if (IsArray())
-            return GetArray().empty();
-        else if (IsString())
-            return GetString().empty();
-        else if (IsNull())
-            return true;
-        else // IsInteger() || IsFloat() || IsBoolean()
-            return false;
+    bool empty() const {
+        return size() == 0;
     }
 
-    std::size_t size() const
-    {
-        if (IsObject())
-            return GetObject().size();
-        else if (IsArray())
-            return GetArray().size();
-        else if (IsString())
-            return GetString().size();
-        else if (IsNull())
-            return 0;
-        else // IsInteger() || IsFloat() || IsBoolean()
-            return 1;
-    }
+    std::size_t size() const;
 
     void clear()
     {
         if (IsObject())
-            GetObject().clear();
+            data.emplace<ObjectType>();
         else if (IsArray())
-            GetArray().clear();
+            data.emplace<ArrayType>();
         else if (IsString())
-            GetString().clear();
+            data.emplace<StringType>();
         else if (IsInteger())
             GetInteger() = 0;
         else if (IsFloat())
@@ -898,14 +665,14 @@ public:
             return std::get<ArrayIter>(var);
         }
 
-        const ObjectType::key_type& key() const {
-            return GetObjectIter()->first;
+        std::string_view key() const {
+            return GetObjectIter()->key;
         }
 
         const json& value() const
         {
             if (IsObjectIter())
-                return GetObjectIter()->second;
+                return GetObjectIter()->value;
             else if (IsArrayIter())
                 return *GetArrayIter();
 
@@ -974,7 +741,7 @@ public:
         json& value()
         {
             if (this->IsObjectIter())
-                return this->GetObjectIter()->second;
+                return this->GetObjectIter()->value;
             else if (this->IsArrayIter())
                 return *this->GetArrayIter();
 
@@ -990,88 +757,284 @@ public:
         }
     };
 
-    using const_iterator = base_const_iterator<ObjectType::const_iterator, ArrayType::const_iterator>;
-    using iterator = base_iterator<ObjectType::iterator, ArrayType::iterator>;
+    using const_iterator = base_const_iterator<const JsonMember*, const json*>;
+    using iterator = base_iterator<JsonMember*, json*>;
 
-    iterator begin()
-    {
-        if(IsObject())
-            return { GetObject().begin() };
-        else if(IsArray())
-            return { GetArray().begin() };
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
 
-        return {};
-    }
+    const_iterator find(std::string_view key) const;
+    iterator find(std::string_view key);
 
-    iterator end()
-    {
-        if(IsObject())
-            return { GetObject().end() };
-        else if(IsArray())
-            return { GetArray().end() };
+    ObjectView items() const;
 
-        return {};
+    ObjectType& items() {
+        return GetObject();
     }
+};
 
-    const_iterator begin() const
-    {
-        if(IsObject())
-            return { GetObject().cbegin() };
-        else if(IsArray())
-            return { GetArray().cbegin() };
+// A member of a JSON object. The keys of parsed objects point into the
+// document's arena, and the keys of objects built in code into the object.
+struct JsonMember
+{
+    std::string_view key;
+    json value;
+};
 
-        return {};
-    }
+// json OBJECT
+const JsonMember* FindJsonMember(std::span<const JsonMember> members, std::string_view key)
+{
+    auto it = std::ranges::lower_bound(members, key, {}, &JsonMember::key);
 
-    const_iterator end() const
-    {
-        if(IsObject())
-            return { GetObject().cend() };
-        else if(IsArray())
-            return { GetArray().cend() };
+    if (it != members.end() && it->key != key)
+        it = members.end();
 
-        return {};
-    }
+    return members.data() + (it - members.begin());
+}
 
-    const_iterator find(const ObjectType::key_type& key) const
-    {
-        if (IsObject())
-            return { GetObject().find(key) };
-        
-        return {};
-    }
+JsonObject::JsonObject(const_iterator first, const_iterator last)
+{
+    // the range is already sorted
+    members.reserve(last - first);
 
-    iterator find(const ObjectType::key_type& key)
-    {
-        if (IsObject())
-            return { GetObject().find(key) };
+    for (auto it = first; it != last; ++it)
+        members.push_back({ keys.emplace_front(it->key), it->value });
+}
 
-        return {};
-    }
+JsonObject::JsonObject(const JsonObject& other)
+    : JsonObject(other.begin(), other.end()) {}
 
-    const ObjectType& items() const {
-        return GetObject();
-    }
+JsonObject& JsonObject::operator=(const JsonObject& other)
+{
+    JsonObject copy(other);
+    *this = std::move(copy);
+    return *this;
+}
 
-    ObjectType& items() {
-        return GetObject();
+JsonObject::iterator JsonObject::begin() {
+    return members.data();
+}
+
+JsonObject::iterator JsonObject::end() {
+    return members.data() + members.size();
+}
+
+JsonObject::const_iterator JsonObject::begin() const {
+    return members.data();
+}
+
+JsonObject::const_iterator JsonObject::end() const {
+    return members.data() + members.size();
+}
+
+std::size_t JsonObject::size() const {
+    return members.size();
+}
+
+bool JsonObject::empty() const {
+    return members.empty();
+}
+
+JsonObject::iterator JsonObject::find(std::string_view key) {
+    return const_cast<iterator>(std::as_const(*this).find(key));
+}
+
+JsonObject::const_iterator JsonObject::find(std::string_view key) const {
+    return FindJsonMember(members, key);
+}
+
+bool JsonObject::contains(std::string_view key) const {
+    return find(key) != end();
+}
+
+json& JsonObject::at(std::string_view key) {
+    return const_cast<json&>(std::as_const(*this).at(key));
+}
+
+const json& JsonObject::at(std::string_view key) const
+{
+    auto it = find(key);
+
+    if (it == end())
+        throw std::out_of_range("json object has no such key");
+
+    return it->value;
+}
+
+json& JsonObject::operator[](std::string_view key)
+{
+    auto it = std::ranges::lower_bound(members, key, {}, &JsonMember::key);
+
+    if (it == members.end() || it->key != key)
+        it = members.insert(it, JsonMember{ keys.emplace_front(key), json() });
+
+    return it->value;
+}
+
+void JsonObject::insert_or_assign(std::string_view key, json value) {
+    (*this)[key] = std::move(value);
+}
+
+void JsonObject::clear()
+{
+    members.clear();
+    keys.clear();
+}
+
+// json
+json json::parse(std::string_view text)
+{
+    JsonParser parser(text);
+    return parser.parse();
+}
+
+json::json(const json& other)
+    : data(other.data)
+{
+    // only the root of a parsed document keeps the arena alive
+    if (auto obj = std::get_if<ParsedObject>(&data); obj && !obj->arena)
+        MakeOwned();
+    else if (auto arr = std::get_if<ParsedArray>(&data); arr && !arr->arena)
+        MakeOwned();
+    else if (std::holds_alternative<ParsedString>(data))
+        MakeOwned();
+}
+
+json& json::operator=(const json& other)
+{
+    // 'other' may be part of this value, so it's copied before anything is replaced
+    json copy(other);
+    data = std::move(copy.data);
+    return *this;
+}
+
+void json::MakeOwned()
+{
+    const json& self = *this;
+
+    if (std::holds_alternative<ParsedObject>(data)) {
+        auto obj = self.GetObject();
+        data = ObjectType(obj.data(), obj.data() + obj.size());
     }
-};
+    else if (std::holds_alternative<ParsedArray>(data)) {
+        auto arr = self.GetArray();
+        data = ArrayType(arr.begin(), arr.end());
+    }
+    else if (std::holds_alternative<ParsedString>(data)) {
+        data = StringType(self.GetString());
+    }
+}
+
+const json* json::FindValue(std::string_view key) const
+{
+    auto members = GetObject();
+    auto member = FindJsonMember(members, key);
+    return member != members.data() + members.size() ? &member->value : nullptr;
+}
+
+json::ObjectView json::GetObject() const
+{
+    if (auto obj = std::get_if<ParsedObject>(&data))
+        return ObjectView(obj->members, obj->count);
+
+    auto& obj = std::get<ObjectType>(data);
+    return ObjectView(obj.begin(), obj.end());
+}
+
+json::ObjectView json::items() const {
+    return GetObject();
+}
+
+std::size_t json::size() const
+{
+    if (IsObject())
+        return GetObject().size();
+    else if (IsArray())
+        return GetArray().size();
+    else if (IsString())
+        return GetString().size();
+    else if (IsNull())
+        return 0;
+    else // IsInteger() || IsFloat() || IsBoolean()
+        return 1;
+}
+
+json::iterator json::begin()
+{
+    if(IsObject())
+        return { GetObject().begin() };
+    else if(IsArray())
+        return { GetArray().data() };
+
+    return {};
+}
+
+json::iterator json::end()
+{
+    if(IsObject())
+        return { GetObject().end() };
+    else if(IsArray())
+        return { GetArray().data() + GetArray().size() };
+
+    return {};
+}
+
+json::const_iterator json::begin() const
+{
+    if(IsObject())
+        return { GetObject().data() };
+    else if(IsArray())
+        return { GetArray().data() };
+
+    return {};
+}
+
+json::const_iterator json::end() const
+{
+    if(IsObject())
+        return { GetObject().data() + GetObject().size() };
+    else if(IsArray())
+        return { GetArray().data() + GetArray().size() };
+
+    return {};
+}
+
+json::const_iterator json::find(std::string_view key) const
+{
+    if (IsObject())
+        return { FindJsonMember(GetObject(), key) };
+    
+    return {};
+}
+
+json::iterator json::find(std::string_view key)
+{
+    if (IsObject())
+        return { GetObject().find(key) };
+
+    return {};
+}
 
 void to_json(json& obj, const json::ObjectType& val) {
     obj = json(val);
 }
 
-void from_json(const json& obj, json::ObjectType& val) {
-    val = obj.GetObject();
+void from_json(const json& obj, json::ObjectType& val)
+{
+    auto members = obj.GetObject();
+    val = json::ObjectType(members.data(), members.data() + members.size());
 }
 
 void to_json(json& obj, const json::ArrayType& val) {
     obj = json(val);
 }
 
-void from_json(const json& obj, json::ArrayType& val) {
-    val = obj.GetArray();
+void from_json(const json& obj, json::ArrayType& val)
+{
+    auto arr = obj.GetArray();
+    val.assign(arr.begin(), arr.end());
 }
 
 template<class T> requires std::is_constructible_v<typename json::StringType, T>
@@ -1136,7 +1099,7 @@ void to_json(json& obj, const std::forward_list<T, A>& cont)
 template<class T, class A>
 void from_json(const json& obj, std::forward_list<T, A>& cont)
 {
-    auto& arr = obj.GetArray();
+    auto arr = obj.GetArray();
     cont.clear();
 
     for (auto it = arr.rbegin(); it != arr.rend(); ++it) {
@@ -1159,7 +1122,7 @@ void to_json(json& obj, const std::list<T, A>& cont)
 template<class T, class A>
 void from_json(const json& obj, std::list<T, A>& cont)
 {
-    auto& arr = obj.GetArray();
+    auto arr = obj.GetArray();
     cont.clear();
 
     for(auto& val : arr) {
@@ -1182,7 +1145,7 @@ void to_json(json& obj, const std::array<T, N>& cont)
 template<class T, std::size_t N>
 void from_json(const json& obj, std::array<T, N>& cont)
 {
-    auto& arr = obj.GetArray();
+    auto arr = obj.GetArray();
     
     for(std::size_t i = 0; i != N; ++i) {
         cont[i] = arr[i].get<T>();
@@ -1203,7 +1166,7 @@ void to_json(json& obj, const std::vector<T, A>& cont)
 template<class T, class A>
 void from_json(const json& obj, std::vector<T, A>& cont)
 {
-    auto& arr = obj.GetArray();
+    auto arr = obj.GetArray();
     cont.clear();
 
     for(auto& val : arr) {
@@ -1235,17 +1198,17 @@ void to_json(json& obj, const std::unordered_map<K, T, H, E, A>& cont)
 template<class K, class T, class H, class E, class A> requires (std::is_constructible_v<K, typename json::StringType> || has_from_string<K>::value)
 void from_json(const json& obj, std::unordered_map<K, T, H, E, A>& cont)
 {
-    auto& objectValue = obj.GetObject();
+    auto objectValue = obj.GetObject();
     cont.clear();
 
     for(auto& [key, val] : objectValue)
     {
         if constexpr (std::is_constructible_v<K, typename json::StringType>) {
-            cont[key] = val.get<T>();
+            cont[K(json::StringType(key))] = val.get<T>();
         }
         else {
             K k;
-            from_string(key, k);
+            from_string(json::StringType(key), k);
             cont[k] = val.get<T>();
         }
     }
@@ -1258,7 +1221,7 @@ void to_json(json& obj, const std::map<K, T, C, A>& cont)
     auto& objectValue = ret.GetObject();
 
     for(auto& [key, value] : cont)
-        objectValue[json(key)] = json(value);
+        objectValue[json(key).GetString()] = json(value);
 
     obj = std::move(ret);
 }
@@ -1266,7 +1229,7 @@ void to_json(json& obj, const std::map<K, T, C, A>& cont)
 template<class K, class T, class C, class A>
 void from_json(const json& obj, std::map<K, T, C, A>& cont)
 {
-    auto& objectValue = obj.GetObject();
+    auto objectValue = obj.GetObject();
     cont.clear();
 
     for(auto& [key, val] : objectValue) {
@@ -1275,155 +1238,572 @@ void from_json(const json& obj, std::map<K, T, C, A>& cont)
 }
 
 // json PARSER
-JsonParser::JsonParser(const std::string& text)
-    : lexer(text){}
+JsonParser::JsonParser(std::string_view text)
+{
+    // room for the copy of the input, every array and object, and padding
+    std::size_t capacity = text.size() + ScanStructure(text) + (sizes.size() + 1) * alignof(JsonMember);
+    arena = spnew<JsonArena>(capacity);
+
+    std::string_view source = arena->CopyString(text);
+    beg = pos = source.data();
+    end = source.data() + source.size();
+}
 
 json JsonParser::parse()
 {
-    if (!NextToken())
+    SkipWhitespace();
+
+    if (pos == end)
         throw Exception("input is empty");
 
-    return ParseValue();
+    json ret = ParseValue();
+
+    SkipWhitespace();
+
+    if (pos != end)
+        Error("unexpected input after value");
+
+    if (auto obj = std::get_if<json::ParsedObject>(&ret.data))
+        obj->arena = arena;
+    else if (auto arr = std::get_if<json::ParsedArray>(&ret.data))
+        arr->arena = arena;
+    else if (auto str = std::get_if<json::ParsedString>(&ret.data))
+        ret.data = json::StringType(*str);
+
+    return ret;
+}
+
+void JsonParser::Error(std::string_view message) const
+{
+    std::size_t line = 1 + std::count(beg, pos, '\n');
+    std::size_t column = 1 + (pos - std::find(std::make_reverse_iterator(pos), std::make_reverse_iterator(beg), '\n').base());
+
+    throw Exception({ message, " at line ", line, ", column ", column });
 }
 
-bool JsonParser::NextToken(bool thrownOnEOF) {
-    token = std::move(lexer.GetNextToken());
-    return token.type != JsonTokenType::EndOfFile;
+static bool IsJsonWhitespace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
 }
 
-json JsonParser::ParseValue()
+void JsonParser::SkipWhitespace()
 {
-    switch (token.type)
+#if MW_JSON_SSE2
+    while (end - pos >= 16 && IsJsonWhitespace(*pos))
     {
-    case JsonTokenType::ObjectStart:
-        return ParseObject();
-    case JsonTokenType::ArrayStart:
-        return ParseArray();
-    case JsonTokenType::String:
-        return ParseString();
-    case JsonTokenType::Integer:
-        return ParseInteger();
-    case JsonTokenType::Float:
-        return ParseFloat();
-    case JsonTokenType::Boolean:
-        return ParseBoolean();
-    case JsonTokenType::Null:
-        return ParseNull();
-    case JsonTokenType::EndOfFile:
-        throw Exception("unexpected end of input");
-    default:
-        throw Exception("unexpected token");
+        __m128i chunk = _mm_loadu_si128((const __m128i*)pos);
+
+        __m128i ws = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+            _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+
+        auto mask = (unsigned)_mm_movemask_epi8(ws) ^ 0xFFFFu;
+
+        if (mask != 0) {
+            pos += std::countr_zero(mask);
+            break;
+        }
+
+        pos += 16;
     }
-}
+#endif
 
-json JsonParser::ParseString()
-{
-    Assert(token.type == JsonTokenType::String);
-    auto ret = json(token.GetString());
-    NextToken(false);
-    return ret;
+    while (pos != end && IsJsonWhitespace(*pos))
+        ++pos;
 }
 
-json JsonParser::ParseInteger()
+// Fills in 'sizes' and returns the number of bytes the arrays and objects
+// will need in the arena. Nothing is validated here, so the sizes only
+// match what ParseArray and ParseObject find if the input is well formed.
+std::size_t JsonParser::ScanStructure(std::string_view text)
 {
-    Assert(token.type == JsonTokenType::Integer);
-    auto ret = json(token.GetInteger());
-    NextToken(false);
-    return ret;
+    struct Scope
+    {
+        std::size_t index;
+        const char* open;
+        std::uint32_t commas;
+    };
+
+    std::vector<Scope> scopes;
+    std::size_t bytes = 0;
+    bool inString = false;
+    const char* escapedChar = nullptr;
+
+    auto close = [&](const char* p)
+    {
+        Scope scope = scopes.back();
+        scopes.pop_back();
+
+        // the scope is empty if nothing but whitespace follows the bracket
+        while (IsJsonWhitespace(p[-1]))
+            --p;
+
+        std::uint32_t size = (p - 1 == scope.open) ? 0 : scope.commas + 1;
+        sizes[scope.index] = size;
+        bytes += size * (*scope.open == '{' ? sizeof(JsonMember) : sizeof(json));
+    };
+
+    auto visit = [&](const char* p)
+    {
+        if (p == escapedChar)
+            return;
+
+        if (inString)
+        {
+            if (*p == '\\')
+                escapedChar = p + 1;
+            else if (*p == '\"')
+                inString = false;
+
+            return;
+        }
+
+        switch (*p)
+        {
+        case '\"':
+            inString = true;
+            break;
+        case '[':
+        case '{':
+            scopes.push_back({ sizes.size(), p, 0 });
+            sizes.push_back(0);
+            break;
+        case ']':
+        case '}':
+            if (!scopes.empty())
+                close(p);
+            break;
+        case ',':
+            if (!scopes.empty())
+                ++scopes.back().commas;
+            break;
+        }
+    };
+
+    const char* p = text.data();
+    const char* last = text.data() + text.size();
+
+#if MW_JSON_SSE2
+    for (; last - p >= 16; p += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)p);
+
+        // '[' and '{' differ only in bit 5, and so do ']' and '}'
+        __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+                _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+            _mm_or_si128(
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8(',')),
+                    _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"'))),
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))));
+
+        for (auto mask = (unsigned)_mm_movemask_epi8(special); mask != 0; mask &= mask - 1)
+            visit(p + std::countr_zero(mask));
+    }
+#endif
+
+    for (; p != last; ++p)
+        visit(p);
+
+    // unclosed scopes are an error that the parser reports later
+    while (!scopes.empty())
+        close(last);
+
+    return bytes;
 }
 
-json JsonParser::ParseFloat()
+std::size_t JsonParser::NextSize()
 {
-    Assert(token.type == JsonTokenType::Float);
-    auto ret = json(token.GetFloat());
-    NextToken(false);
-    return ret;
+    if (nextSize == sizes.size())
+        Error("unexpected input");
+
+    return sizes[nextSize++];
 }
 
-json JsonParser::ParseBoolean()
+void JsonParser::Expect(char c)
 {
-    Assert(token.type == JsonTokenType::Boolean);
-    auto ret = json(token.GetBoolean());
-    NextToken(false);
-    return ret;
+    SkipWhitespace();
+
+    if (pos == end)
+        Error("unexpected end of input");
+
+    if (*pos != c)
+        Error(std::string("expected '") + c + "'");
+
+    ++pos;
 }
 
-json JsonParser::ParseNull()
+json JsonParser::ParseValue()
 {
-    Assert(token.type == JsonTokenType::Null);
-    auto ret = json();
-    NextToken(false);
-    return ret;
+    SkipWhitespace();
+
+    if (pos == end)
+        Error("unexpected end of input");
+
+    switch (*pos)
+    {
+    case '{':
+        return ParseObject();
+    case '[':
+        return ParseArray();
+    case '\"':
+    {
+        json ret;
+        ret.data.emplace<json::ParsedString>(ParseString());
+        return ret;
+    }
+    case 't':
+    case 'f':
+    case 'n':
+        return ParseLiteral();
+    default:
+        if ((*pos >= '0' && *pos <= '9') || *pos == '-')
+            return ParseNumber();
+
+        Error("unexpected input");
+    }
 }
 
 json JsonParser::ParseObject()
 {
-    Assert(token.type == JsonTokenType::ObjectStart);
-    NextToken();
+    Assert(*pos == '{');
+    ++pos;
+
+    if (++depth > MaxDepth)
+        Error("maximum depth exceeded");
 
-    json::ObjectType values;
+    std::size_t capacity = NextSize();
+    JsonMember* members = arena->Allocate<JsonMember>(capacity);
+    std::size_t count = 0;
 
-    while (token.type != JsonTokenType::ObjectEnd)
+    SkipWhitespace();
+
+    if (pos != end && *pos == '}')
+    {
+        ++pos;
+    }
+    else
     {
-        if (token.type != JsonTokenType::String)
-            throw Exception("expected string");
+        while (true)
+        {
+            SkipWhitespace();
 
-        json key = ParseString();
+            if (pos == end || *pos != '\"')
+                Error("expected string");
 
-        if (token.type != JsonTokenType::Colon)
-            throw Exception("expected colon");
+            if (count == capacity)
+                Error("unexpected input");
 
-        NextToken();
+            std::string_view key = ParseString();
+            Expect(':');
+            ::new ((void*)(members + count++)) JsonMember{ key, ParseValue() };
 
-        values[key.GetString()] = ParseValue();
+            SkipWhitespace();
 
-        if (token.type == JsonTokenType::Comma)
-        {
-            NextToken();
+            if (pos == end)
+                Error("unexpected end of input");
+
+            if (*pos == ',') {
+                ++pos;
+                continue;
+            }
+
+            if (*pos != '}')
+                Error("expected '}'");
 
-            if (token.type == JsonTokenType::ObjectEnd)
-                throw Exception("expected a value");
+            ++pos;
+            break;
         }
-        else
+    }
+
+    --depth;
+
+    // Members are found with a binary search, so they're sorted by key.
+    // The sort is stable, and when a key is repeated the last one wins.
+    JsonMember* last = members + count;
+    auto byKey = [](const JsonMember& a, const JsonMember& b) { return a.key < b.key; };
+
+    if (!std::is_sorted(members, last, byKey))
+        std::stable_sort(members, last, byKey);
+
+    JsonMember* unique = members;
+
+    for (JsonMember* it = members; it != last; ++it)
+    {
+        if (it + 1 != last && it[1].key == it->key)
+            continue;
+
+        if (unique != it)
+            *unique = std::move(*it);
+
+        ++unique;
+    }
+
+    json ret;
+    ret.data = json::ParsedObject{ members, (std::size_t)(unique - members) };
+    return ret;
+}
+
+json JsonParser::ParseArray()
+{
+    Assert(*pos == '[');
+    ++pos;
+
+    if (++depth > MaxDepth)
+        Error("maximum depth exceeded");
+
+    std::size_t capacity = NextSize();
+    json* elements = arena->Allocate<json>(capacity);
+    std::size_t count = 0;
+
+    SkipWhitespace();
+
+    if (pos != end && *pos == ']')
+    {
+        ++pos;
+    }
+    else
+    {
+        while (true)
         {
-            if (token.type != JsonTokenType::ObjectEnd)
-                throw Exception("expected '}'");
+            if (count == capacity) {
+                SkipWhitespace();
+                Error(pos == end ? "unexpected end of input" : "unexpected input");
+            }
+
+            ::new ((void*)(elements + count++)) json(ParseValue());
+
+            SkipWhitespace();
+
+            if (pos == end)
+                Error("unexpected end of input");
+
+            if (*pos == ',') {
+                ++pos;
+                continue;
+            }
+
+            if (*pos != ']')
+                Error("expected ']'");
+
+            ++pos;
+            break;
         }
     }
 
-    NextToken();
+    --depth;
 
-    return json(std::move(values));
+    json ret;
+    ret.data = json::ParsedArray{ elements, count };
+    return ret;
 }
 
-json JsonParser::ParseArray()
+json JsonParser::ParseNumber()
+{
+    // Find the end of the number with JSON's grammar first, since from_chars
+    // also accepts things JSON doesn't, like inf, nan, "1." and "01".
+    auto isDigit = [&](const char* p) { return p != end && *p >= '0' && *p <= '9'; };
+    auto skipDigits = [&](const char* p) { while (isDigit(p)) ++p; return p; };
+
+    const char* p = pos;
+    bool isInteger = true;
+
+    if (*p == '-')
+        ++p;
+
+    if (!isDigit(p))
+        Error("invalid number");
+
+    p = (*p == '0') ? p + 1 : skipDigits(p);
+
+    if (p != end && *p == '.')
+    {
+        if (!isDigit(++p))
+            Error("invalid number");
+
+        p = skipDigits(p);
+        isInteger = false;
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+        ++p;
+        if (p != end && (*p == '+' || *p == '-'))
+            ++p;
+
+        if (!isDigit(p))
+            Error("invalid number");
+
+        p = skipDigits(p);
+        isInteger = false;
+    }
+
+    const char* first = pos;
+    pos = p;
+
+    if (isInteger)
+    {
+        std::int64_t integer;
+        auto ret = std::from_chars(first, p, integer);
+
+        if (ret.ec == std::errc())
+            return json(integer);
+    }
+
+    // integers that overflow int64 become floats
+    double floating;
+    auto ret = std::from_chars(first, p, floating);
+
+    if (ret.ec != std::errc() || !std::isfinite(floating))
+        Error("number out of range");
+
+    return json(floating);
+}
+
+json JsonParser::ParseLiteral()
 {
-    Assert(token.type == JsonTokenType::ArrayStart);
-    NextToken();
+    std::string_view rest(pos, end);
 
-    std::vector<json> values;
+    if (rest.starts_with("true")) {
+        pos += 4;
+        return json(true);
+    }
+    else if (rest.starts_with("false")) {
+        pos += 5;
+        return json(false);
+    }
+    else if (rest.starts_with("null")) {
+        pos += 4;
+        return json();
+    }
+
+    Error("unexpected input");
+}
+
+std::string_view JsonParser::ParseString()
+{
+    Assert(*pos == '\"');
+    ++pos;
+
+    const char* first = pos;
+    escaped.clear();
 
-    while (token.type != JsonTokenType::ArrayEnd)
+    while (true)
     {
-        values.push_back(ParseValue());
+        // find the next quote or escape
+        const char* run = pos;
 
-        if (token.type == JsonTokenType::Comma)
+#if MW_JSON_SSE2
+        while (end - pos >= 16)
         {
-            NextToken();
+            __m128i chunk = _mm_loadu_si128((const __m128i*)pos);
 
-            if (token.type == JsonTokenType::ArrayEnd)
-                throw Exception("expected a value");
+            __m128i special = _mm_or_si128(
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"')),
+                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+
+            auto mask = (unsigned)_mm_movemask_epi8(special);
+
+            if (mask != 0) {
+                pos += std::countr_zero(mask);
+                break;
+            }
+
+            pos += 16;
         }
-        else
+#endif
+
+        while (pos != end && *pos != '\"' && *pos != '\\')
+            ++pos;
+
+        if (pos == end)
+            Error("unexpected end of input");
+
+        // without escapes, the string is used where it is in the input
+        if (*pos == '\"' && run == first) {
+            ++pos;
+            return std::string_view(first, pos - 1);
+        }
+
+        escaped.append(run, pos);
+
+        if (*pos == '\"') {
+            ++pos;
+            return arena->CopyString(escaped);
+        }
+
+        ParseEscape(escaped);
+    }
+}
+
+void JsonParser::ParseEscape(std::string& str)
+{
+    Assert(*pos == '\\');
+    ++pos;
+
+    if (pos == end)
+        Error("unexpected end of input");
+
+    char c = *pos++;
+
+    switch (c)
+    {
+    case 'r': str.push_back('\r'); break;
+    case 'n': str.push_back('\n'); break;
+    case 't': str.push_back('\t'); break;
+    case 'b': str.push_back('\b'); break;
+    case 'f': str.push_back('\f'); break;
+    case 'u':
+    {
+        char32_t value = ParseHex4();
+
+        // characters outside the BMP are escaped as a surrogate pair
+        if (value >= 0xD800 && value <= 0xDBFF
+            && end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u')
         {
-            if (token.type != JsonTokenType::ArrayEnd)
-                throw Exception("expected ']'");
+            auto resume = pos;
+            pos += 2;
+            char32_t low = ParseHex4();
+
+            if (low >= 0xDC00 && low <= 0xDFFF)
+                value = 0x10000 + ((value - 0xD800) << 10) + (low - 0xDC00);
+            else
+                pos = resume;
         }
+
+        if (value >= 0xD800 && value <= 0xDFFF)
+            Error("invalid unicode escape sequence");
+
+        utf8::append(value, std::back_inserter(str));
+        break;
     }
+    default:
+        // includes '\"', '\\' and '/'
+        str.push_back(c);
+        break;
+    }
+}
+
+char32_t JsonParser::ParseHex4()
+{
+    if (end - pos < 4)
+        Error("unexpected end of input");
 
-    NextToken();
+    std::uint32_t value = 0;
+    auto ret = std::from_chars(pos, pos + 4, value, 16);
 
-    return json(std::move(values));
+    if (ret.ec != std::errc() || ret.ptr != pos + 4)
+        Error("invalid unicode escape sequence");
+
+    pos += 4;
+    return (char32_t)value;
 }
 
 // json PRINTER
@@ -1451,7 +1831,7 @@ std::string JsonPrinter::ToString(const json& value)
     return stream.str();
 }
 
-void JsonPrinter::WriteEscaped(std::ostream& stream, const std::string& val)
+void JsonPrinter::WriteEscaped(std::ostream& stream, std::string_view val)
 {
     stream << '\"';
 
@@ -1489,7 +1869,7 @@ void JsonPrinter::ToStream(std::ostream& stream, int indent, const json& value)
 
     case DataType::Object:
     {
-        auto& obj = value.GetObject();
+        auto obj = value.GetObject();
 
         stream << '{';
         if (pretty && !obj.empty()) stream << '\n';
@@ -1523,7 +1903,7 @@ void JsonPrinter::ToStream(std::ostream& stream, int indent, const json& value)
     {
         stream << '[';
 
-        auto& arr = value.GetArray();
+        auto arr = value.GetArray();
 
         if (pretty && !arr.empty()) stream << '\n';
 
@@ -1550,7 +1930,7 @@ void JsonPrinter::ToStream(std::ostream& stream, int indent, const json& value)
     }
     case DataType::String:
     {
-        auto& val = value.GetString();
+        auto val = value.GetString();
         WriteEscaped(stream, val);
         break;
     }
@@ -1564,6 +1944,12 @@ void JsonPrinter::ToStream(std::ostream& stream, int indent, const json& value)
     {
         auto floating = value.get<json::FloatType>();
 
+        // JSON has no inf or nan, and the parser rejects them
+        if (!std::isfinite(floating)) {
+            stream << "null";
+            break;
+        }
+
         constexpr int MaxDigits = 325;
         char chars[MaxDigits];
 
@@ -1571,8 +1957,9 @@ void JsonPrinter::ToStream(std::ostream& stream, int indent, const json& value)
             &chars[0], &chars[0] + MaxDigits,
             floating, std::chars_format::general);
 
+        // mark whole numbers as floats, unless they have an exponent
         std::string_view str(&chars[0], ret.ptr);
-        if(str.find('.') == std::string_view::npos)
+        if(str.find_first_of(".e") == std::string_view::npos)
         {
             auto p = ret.ptr;
             *p++ = '.';
@@ -0,0 +1,289 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Microwave.System.JsonWriter;
+import Microwave.System.Exception;
+import <MW/System/Debug.h>;
+import std;
+
+namespace mw {
+inline namespace system {
+
+JsonWriter::JsonWriter(Sink sink, int indent, std::size_t bufferSize)
+    : sink(std::move(sink)), indent(indent), buffer(std::max<std::size_t>(bufferSize, 64))
+{
+}
+
+void JsonWriter::Flush()
+{
+    if (used != 0)
+    {
+        sink(std::as_writable_bytes(std::span(buffer.data(), used)));
+        used = 0;
+    }
+}
+
+void JsonWriter::Put(char c)
+{
+    if (used == buffer.size())
+        Flush();
+
+    buffer[used++] = c;
+}
+
+void JsonWriter::Put(std::string_view str)
+{
+    while (!str.empty())
+    {
+        if (used == buffer.size())
+            Flush();
+
+        auto count = std::min(str.size(), buffer.size() - used);
+        std::copy_n(str.data(), count, buffer.data() + used);
+        used += count;
+        str.remove_prefix(count);
+    }
+}
+
+void JsonWriter::PutEscaped(std::string_view str)
+{
+    Put('\"');
+
+    auto run = str.begin();
+
+    for (auto it = str.begin(); it != str.end(); ++it)
+    {
+        const char* escape = nullptr;
+
+        switch (*it)
+        {
+        case '\"': escape = "\\\""; break;
+        case '\\': escape = "\\\\"; break;
+        case '\r': escape = "\\r"; break;
+        case '\n': escape = "\\n"; break;
+        case '\t': escape = "\\t"; break;
+        case '\b': escape = "\\b"; break;
+        case '\f': escape = "\\f"; break;
+        default: continue;
+        }
+
+        Put(std::string_view(run, it));
+        Put(escape);
+        run = it + 1;
+    }
+
+    Put(std::string_view(run, str.end()));
+    Put('\"');
+}
+
+void JsonWriter::PutIndent()
+{
+    if (indent >= 0)
+    {
+        Put('\n');
+
+        for (std::size_t i = 0; i < scopes.size() * indent; ++i)
+            Put(' ');
+    }
+}
+
+void JsonWriter::BeginValue()
+{
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+
+    if (scopes.empty())
+        return;
+
+    auto& scope = scopes.back();
+
+    if (scope.isObject)
+        throw Exception("expected a key");
+
+    if (scope.count++ != 0)
+        Put(',');
+
+    PutIndent();
+}
+
+JsonWriter& JsonWriter::Key(std::string_view key)
+{
+    if (scopes.empty() || !scopes.back().isObject || afterKey)
+        throw Exception("unexpected key");
+
+    auto& scope = scopes.back();
+
+    if (scope.count++ != 0)
+        Put(',');
+
+    PutIndent();
+    PutEscaped(key);
+    Put(indent >= 0 ? ": " : ":");
+    afterKey = true;
+
+    return *this;
+}
+
+JsonWriter& JsonWriter::BeginObject()
+{
+    BeginValue();
+    Put('{');
+    scopes.push_back({ true, 0 });
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndObject()
+{
+    if (scopes.empty() || !scopes.back().isObject || afterKey)
+        throw Exception("unexpected end of object");
+
+    bool empty = scopes.back().count == 0;
+    scopes.pop_back();
+
+    if (!empty)
+        PutIndent();
+
+    Put('}');
+    return *this;
+}
+
+JsonWriter& JsonWriter::BeginArray()
+{
+    BeginValue();
+    Put('[');
+    scopes.push_back({ false, 0 });
+    return *this;
+}
+
+JsonWriter& JsonWriter::EndArray()
+{
+    if (scopes.empty() || scopes.back().isObject)
+        throw Exception("unexpected end of array");
+
+    bool empty = scopes.back().count == 0;
+    scopes.pop_back();
+
+    if (!empty)
+        PutIndent();
+
+    Put(']');
+    return *this;
+}
+
+JsonWriter& JsonWriter::Null()
+{
+    BeginValue();
+    Put("null");
+    return *this;
+}
+
+JsonWriter& JsonWriter::Bool(bool value)
+{
+    BeginValue();
+    Put(value ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::Int(std::int64_t value)
+{
+    BeginValue();
+
+    char chars[24];
+    auto ret = std::to_chars(std::begin(chars), std::end(chars), value);
+    Put(std::string_view(chars, ret.ptr));
+
+    return *this;
+}
+
+template<class F>
+void JsonWriter::PutFloat(F value)
+{
+    // JSON has no inf or nan, and the parser rejects them
+    if (!std::isfinite(value)) {
+        Put("null");
+        return;
+    }
+
+    // shortest text that reads back as the same value
+    char chars[64];
+    auto ret = std::to_chars(std::begin(chars), std::end(chars) - 2, value);
+    std::string_view str(chars, ret.ptr);
+
+    // mark whole numbers as floats, unless they have an exponent
+    if (str.find_first_of(".e") == std::string_view::npos)
+    {
+        auto p = ret.ptr;
+        *p++ = '.';
+        *p++ = '0';
+        str = std::string_view(chars, p);
+    }
+
+    Put(str);
+}
+
+JsonWriter& JsonWriter::Float(double value)
+{
+    BeginValue();
+    PutFloat(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Float(float value)
+{
+    BeginValue();
+    PutFloat(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::String(std::string_view value)
+{
+    BeginValue();
+    PutEscaped(value);
+    return *this;
+}
+
+JsonWriter& JsonWriter::Value(const json& value)
+{
+    switch (value.GetType())
+    {
+    default:
+    case DataType::Null:
+        return Null();
+
+    case DataType::Object:
+        BeginObject();
+
+        for (auto& [key, val] : value.items()) {
+            Key(key);
+            Value(val);
+        }
+
+        return EndObject();
+
+    case DataType::Array:
+        BeginArray();
+
+        for (auto& elem : value)
+            Value(elem);
+
+        return EndArray();
+
+    case DataType::String:
+        return String(value.GetString());
+
+    case DataType::Integer:
+        return Int(value.get<json::IntegerType>());
+
+    case DataType::Float:
+        return Float(value.get<json::FloatType>());
+
+    case DataType::Boolean:
+        return Bool(value.get<json::BooleanType>());
+    }
+}
+
+} // system
+} // mw
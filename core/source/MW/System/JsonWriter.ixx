@@ -0,0 +1,165 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.System.JsonWriter;
+import Microwave.System.Json;
+import Microwave.System.Path;
+import Microwave.System.Pointers;
+import std;
+
+export namespace mw {
+inline namespace system {
+
+class JsonWriter;
+
+template<class T>
+concept JsonWritable = requires(JsonWriter& writer, const T& value) {
+    to_json(writer, value);
+};
+
+// Writes JSON as it goes, without building a json tree first. Output is
+// collected in a buffer and passed to the sink whenever it fills up, so
+// memory use doesn't depend on the size of the document.
+//
+// Values with a to_json(JsonWriter&, const T&) overload are streamed
+// through it. Containers and maps are streamed element by element, and
+// anything else is converted to json and written from that.
+//
+// The output matches json::dump with the same indent. Flush() must be
+// called once the document is complete.
+class JsonWriter
+{
+public:
+    using Sink = std::function<void(std::span<std::byte>)>;
+
+    // a negative indent writes compact output
+    JsonWriter(Sink sink, int indent = -1, std::size_t bufferSize = DefaultBufferSize);
+
+    // writes to anything with a Write(std::span<std::byte>) method, like a Stream
+    template<class S> requires requires(S& s, std::span<std::byte> data) { s.Write(data); }
+    JsonWriter(const gptr<S>& stream, int indent = -1, std::size_t bufferSize = DefaultBufferSize)
+        : JsonWriter([stream](std::span<std::byte> data) { stream->Write(data); }, indent, bufferSize) {}
+
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    static constexpr std::size_t DefaultBufferSize = 8192;
+
+    JsonWriter& BeginObject();
+    JsonWriter& EndObject();
+    JsonWriter& BeginArray();
+    JsonWriter& EndArray();
+    JsonWriter& Key(std::string_view key);
+
+    JsonWriter& Null();
+    JsonWriter& Bool(bool value);
+    JsonWriter& Int(std::int64_t value);
+    JsonWriter& Float(double value);
+    JsonWriter& Float(float value);
+    JsonWriter& String(std::string_view value);
+    JsonWriter& Value(const json& value);
+
+    template<class T>
+    JsonWriter& Write(const T& value);
+
+    template<class T>
+    JsonWriter& Property(std::string_view key, const T& value) {
+        Key(key);
+        return Write(value);
+    }
+
+    // passes anything left in the buffer to the sink
+    void Flush();
+
+private:
+    struct Scope
+    {
+        bool isObject = false;
+        std::size_t count = 0;
+    };
+
+    Sink sink;
+    int indent;
+    std::vector<char> buffer;
+    std::size_t used = 0;
+    std::vector<Scope> scopes;
+    bool afterKey = false;
+
+    void Put(char c);
+    void Put(std::string_view str);
+    void PutEscaped(std::string_view str);
+    void PutIndent();
+    void BeginValue();
+    template<class F> void PutFloat(F value);
+};
+
+template<class T>
+JsonWriter& JsonWriter::Write(const T& value)
+{
+    using S = std::remove_cvref_t<T>;
+
+    if constexpr (std::is_same_v<S, json>) {
+        return Value(value);
+    }
+    else if constexpr (std::is_same_v<S, bool>) {
+        return Bool(value);
+    }
+    else if constexpr (std::is_integral_v<S>) {
+        return Int((std::int64_t)value);
+    }
+    else if constexpr (std::is_floating_point_v<S>) {
+        return Float(value);
+    }
+    else if constexpr (std::is_convertible_v<const S&, std::string_view>) {
+        return String(value);
+    }
+    else if constexpr (JsonWritable<S>) {
+        to_json(*this, value);
+        return *this;
+    }
+    else if constexpr (requires { typename S::mapped_type; value.begin()->first; })
+    {
+        using K = typename S::key_type;
+        BeginObject();
+
+        for (auto& [key, val] : value)
+        {
+            if constexpr (std::is_convertible_v<const K&, std::string_view>) {
+                Key(key);
+            }
+            else if constexpr (std::is_constructible_v<std::string, K>) {
+                Key(std::string(key));
+            }
+            else {
+                std::string k;
+                to_string(k, key);
+                Key(k);
+            }
+
+            Write(val);
+        }
+
+        return EndObject();
+    }
+    else if constexpr (std::ranges::range<S>)
+    {
+        BeginArray();
+
+        for (auto& elem : value)
+            Write(elem);
+
+        return EndArray();
+    }
+    else {
+        return Value(json(value));
+    }
+}
+
+// paths are ranges of their components, so they need to be written explicitly
+void to_json(JsonWriter& writer, const path& p) {
+    writer.String(p.generic_string());
+}
+
+} // system
+} // mw
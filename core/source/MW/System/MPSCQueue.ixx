@@ -0,0 +1,81 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.System.MPSCQueue;
+import std;
+
+export namespace mw {
+inline namespace system {
+
+// Unbounded multi-producer/single-consumer FIFO (Vyukov's intrusive queue).
+// Push() is wait-free and may be called from any thread. Pop() and Empty()
+// may only be called from the single consumer thread. A producer that has
+// been preempted mid-push can make Pop() briefly report nothing while the
+// item is in flight, so producers should signal the consumer after Push().
+template<class T>
+class MPSCQueue
+{
+    struct Node
+    {
+        std::atomic<Node*> next = nullptr;
+        T value{};
+    };
+
+    alignas(64) std::atomic<Node*> tail;
+    alignas(64) Node* head;
+
+public:
+    MPSCQueue()
+    {
+        head = new Node();
+        tail.store(head, std::memory_order_relaxed);
+    }
+
+    ~MPSCQueue()
+    {
+        while (head)
+        {
+            Node* next = head->next.load(std::memory_order_relaxed);
+            delete head;
+            head = next;
+        }
+    }
+
+    MPSCQueue(const MPSCQueue&) = delete;
+    MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+    MPSCQueue(MPSCQueue&&) = delete;
+    MPSCQueue& operator=(MPSCQueue&&) = delete;
+
+    void Push(T value)
+    {
+        Node* node = new Node();
+        node->value = std::move(value);
+
+        Node* prev = tail.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_seq_cst);
+    }
+
+    bool Pop(T& value)
+    {
+        Node* next = head->next.load(std::memory_order_acquire);
+        if (!next)
+            return false;
+
+        // 'next' becomes the new stub node
+        value = std::move(next->value);
+        next->value = T{};
+
+        delete head;
+        head = next;
+        return true;
+    }
+
+    bool Empty() const {
+        return head->next.load(std::memory_order_seq_cst) == nullptr;
+    }
+};
+
+} // system
+} // mw
@@ -6,6 +6,7 @@ export module Microwave.System.Object;
 import Microwave.IO.Terminal;
 import Microwave.System.Exception;
 import Microwave.System.Json;
+import Microwave.System.JsonWriter;
 import Microwave.System.Pointers;
 import Microwave.System.Task;
 import Microwave.System.UUID;
@@ -20,6 +21,7 @@ inline namespace system {
 
 class Object;
 class ObjectLinker;
+class ObjectCloner;
 class Executor;
 class Type;
 
@@ -140,6 +142,7 @@ class ObjectLinker
     static bool AddObject(ObjectLinker* linker, const gptr<Object>& object);
 
     friend Object;
+    friend ObjectCloner;
     friend ILink;
 public:
 
@@ -164,6 +167,24 @@ public:
         const std::string& keyForUUID,
         const gptr<T>& ptr);
 
+    // the same, for WriteJson overrides
+    template<class T> requires std::is_base_of_v<Object, T>
+    static void SaveLink(
+        JsonWriter& writer,
+        std::string_view keyForUUID,
+        const gptr<T>& ptr);
+
+    template<class T> requires std::is_base_of_v<Object, T>
+    static void SaveAsset(
+        JsonWriter& writer,
+        const gptr<T>& ptr);
+
+    template<class T> requires std::is_base_of_v<Object, T>
+    static void SaveAsset(
+        JsonWriter& writer,
+        std::string_view keyForUUID,
+        const gptr<T>& ptr);
+
     template<class T> //requires std::is_base_of_v<Object, T>
     static bool RestoreLink(
         ObjectLinker* linker,
@@ -209,6 +230,16 @@ public:
         const json& obj,
         const std::string& keyOfUUID);
 
+    // Calls 'assign' with the asset once it's linked, for assignees that
+    // may move before then, like elements of a vector that can still grow.
+    template<class T>
+    static bool RestoreAssetWith(
+        ObjectLinker* linker,
+        const gptr<Object>& hostObject,
+        gfunction<void(const gptr<T>&)> assign,
+        const json& obj,
+        const std::string& keyOfUUID);
+
     static Task<void> LinkAsync(
         ObjectLinker* linker,
         const gptr<Executor>& executor);
@@ -297,6 +328,26 @@ public:
         obj["name"] = name;
     }
 
+    // Writes what ToJson would save, straight to 'writer'. Objects with
+    // large arrays or deep hierarchies override this to stream them
+    // instead of building a json first. Overrides write the braces of the
+    // object themselves, and have to be kept in step with ToJson.
+    virtual void WriteJson(JsonWriter& writer) const
+    {
+        json obj;
+        ToJson(obj);
+        writer.Value(obj);
+    }
+
+    // writes the members saved by Object::ToJson, for WriteJson overrides
+    void WriteObjectJson(JsonWriter& writer) const
+    {
+        auto type = Type::Find(this);
+        writer.Property("objectType", type ? type->name() : std::string("unknown"));
+        writer.Property("uuid", uuid);
+        writer.Property("name", name);
+    }
+
     virtual void FromJson(const json& obj, ObjectLinker* linker)
     {
         uuid = obj["uuid"];
@@ -304,6 +355,21 @@ public:
         ObjectLinker::AddObject(linker, self(this));
     }
 
+    // Returns a copy of this object made with ObjectCloner::Create, or
+    // null if this type can only be copied through ToJson and FromJson.
+    virtual gptr<Object> Clone(ObjectCloner& cloner) const {
+        return nullptr;
+    }
+
+    // Copies what ToJson would save from 'source'. Each class that
+    // overrides Clone declares its own CloneFrom for its exact type,
+    // which calls the one of its base class first.
+    void CloneFrom(const Object& source, ObjectCloner& cloner)
+    {
+        uuid = source.uuid;
+        name = source.name;
+    }
+
     //static void SaveToJson(const gptr<Object>& target, json& obj)
     //{
     //    auto type = Type::Find(target);
@@ -453,6 +519,64 @@ struct AssetLink : ILink
     }
 };
 
+template<class T>
+struct AssetCallbackLink : ILink
+{
+    gptr<Object> hostObject;
+    gfunction<void(const gptr<T>&)> assign;
+    UUID targetAssetID;
+
+    AssetCallbackLink(
+        const gptr<Object>& hostObject,
+        gfunction<void(const gptr<T>&)> assign,
+        const UUID& targetAssetID)
+        : hostObject(hostObject),
+          assign(std::move(assign)),
+          targetAssetID(targetAssetID)
+    {
+        Assert(hostObject);
+    }
+
+    virtual Task<void> LinkAsync(
+        ObjectLinker* linker,
+        const gptr<Executor>& executor) override
+    {
+        Assert(hostObject);
+        auto asset = co_await detail::GetAssetAsync(targetAssetID, executor);
+        assign(gpcast<T>(asset));
+        co_return;
+    }
+};
+
+// Copies object graphs for Instantiate. Objects that override Clone copy
+// their members directly and share the assets they reference. Anything
+// else is copied through ToJson and FromJson.
+//
+// Clones keep the UUIDs of the objects they were copied from, so links
+// within the graph are restored through an ObjectLinker once everything
+// has been cloned, the same way they are when loading from json.
+class ObjectCloner
+{
+    ObjectLinker linker;
+public:
+    // clones 'source' and everything it owns
+    gptr<Object> Clone(const gptr<Object>& source);
+
+    // Creates a T and copies 'source' into it with T::CloneFrom. Returns
+    // null if 'source' is a subclass of T that doesn't override Clone
+    // itself, so the subclass falls back to json.
+    template<class T> requires std::is_base_of_v<Object, T>
+    gptr<T> Create(const T* source);
+
+    // points 'assignee' at the clone of 'target' when Link is called,
+    // or leaves it empty if 'target' is not part of the cloned graph
+    template<class A, class T> requires std::is_base_of_v<Object, T>
+    void CloneLink(const gptr<Object>& hostObject, A& assignee, const gptr<T>& target);
+
+    // restores links once the whole graph has been cloned
+    void Link();
+};
+
 template<class T> requires std::is_base_of_v<Object, T>
 void ObjectLinker::SaveLink(
     json& obj,
@@ -479,6 +603,37 @@ void ObjectLinker::SaveAsset(
     obj[keyForUUID] = ptr ? json(ptr->GetUUID()) : json(nullptr);
 }
 
+template<class T> requires std::is_base_of_v<Object, T>
+void ObjectLinker::SaveLink(
+    JsonWriter& writer,
+    std::string_view keyForUUID,
+    const gptr<T>& ptr)
+{
+    writer.Key(keyForUUID);
+    SaveAsset(writer, ptr);
+}
+
+template<class T> requires std::is_base_of_v<Object, T>
+void ObjectLinker::SaveAsset(
+    JsonWriter& writer,
+    const gptr<T>& ptr)
+{
+    if (ptr)
+        writer.Write(ptr->GetUUID());
+    else
+        writer.Null();
+}
+
+template<class T> requires std::is_base_of_v<Object, T>
+void ObjectLinker::SaveAsset(
+    JsonWriter& writer,
+    std::string_view keyForUUID,
+    const gptr<T>& ptr)
+{
+    writer.Key(keyForUUID);
+    SaveAsset(writer, ptr);
+}
+
 template<class T>
 bool ObjectLinker::RestoreLink(
     ObjectLinker* linker,
@@ -590,16 +745,76 @@ bool ObjectLinker::RestoreAsset(
     return false;
 }
 
-template<class T = Object> requires std::is_base_of_v<Object, T>
-inline gptr<T> Instantiate(const gptr<Object>& object)
+template<class T>
+bool ObjectLinker::RestoreAssetWith(
+    ObjectLinker* linker,
+    const gptr<Object>& hostObject,
+    gfunction<void(const gptr<T>&)> assign,
+    const json& obj,
+    const std::string& keyOfUUID)
 {
+    if (!linker)
+        return false;
+
+    if (auto it = obj.find(keyOfUUID); it != obj.end() && !it->is_null())
+    {
+        UUID assetID = *it;
+
+        linker->links.emplace_back(
+            upnew<AssetCallbackLink<T>>(hostObject, std::move(assign), assetID)
+        );
+
+        return true;
+    }
+
+    return false;
+}
+
+gptr<Object> ObjectCloner::Clone(const gptr<Object>& source)
+{
+    if (!source)
+        return nullptr;
+
+    if (auto clone = source->Clone(*this))
+        return clone;
+
     json obj;
-    object->ToJson(obj);
+    source->ToJson(obj);
+    return Object::CreateFromJson(obj, &linker);
+}
 
-    ObjectLinker linker;
-    gptr<T> ret = Object::CreateFromJson<T>(obj, &linker);
-    // update IDs of all objects to new unique ones
-    if (ret) ObjectLinker::Link(&linker);
+template<class T> requires std::is_base_of_v<Object, T>
+gptr<T> ObjectCloner::Create(const T* source)
+{
+    if (typeid(*source) != typeid(T))
+        return nullptr;
+
+    auto clone = gpnew<T>();
+    clone->CloneFrom(*source, *this);
+    ObjectLinker::AddObject(&linker, clone);
+    return clone;
+}
+
+template<class A, class T> requires std::is_base_of_v<Object, T>
+void ObjectCloner::CloneLink(
+    const gptr<Object>& hostObject,
+    A& assignee,
+    const gptr<T>& target)
+{
+    if (target)
+        ObjectLinker::RestoreLink(&linker, hostObject, assignee, target->GetUUID());
+}
+
+void ObjectCloner::Link() {
+    ObjectLinker::Link(&linker);
+}
+
+template<class T = Object> requires std::is_base_of_v<Object, T>
+inline gptr<T> Instantiate(const gptr<Object>& object)
+{
+    ObjectCloner cloner;
+    gptr<T> ret = gpcast<T>(cloner.Clone(object));
+    if (ret) cloner.Link();
 
     return ret;
 }
@@ -15,7 +15,10 @@ export import Microwave.System.GC;
 export import Microwave.System.IAwaitable;
 export import Microwave.System.IAwaiter;
 export import Microwave.System.Exception;
+export import Microwave.System.JobSystem;
 export import Microwave.System.Json;
+export import Microwave.System.JsonWriter;
+export import Microwave.System.MPSCQueue;
 export import Microwave.System.Object;
 export import Microwave.System.Path;
 export import Microwave.System.Pointers;
@@ -26,3 +29,4 @@ export import Microwave.System.Task;
 export import Microwave.System.ThreadPool;
 export import Microwave.System.UUID;
 export import Microwave.System.Window;
+export import Microwave.System.WorkStealingDeque;
@@ -12,6 +12,18 @@ namespace detail {
 
 Task<void> GetDelayTask(std::chrono::milliseconds length)
 {
+    // use a dispatcher timer when possible, rather than tying up a worker
+    if (auto dispatcher = Dispatcher::GetCurrent())
+    {
+        auto awaitable = gpnew<Awaitable<void>>();
+
+        dispatcher->InvokeAsync(
+            [awaitable]{ awaitable->SetCompleted(); },
+            std::chrono::steady_clock::now() + length);
+
+        return Task<void>(awaitable);
+    }
+
     return ThreadPool::InvokeAsync([len = length]{
         std::this_thread::sleep_for(len);
     });
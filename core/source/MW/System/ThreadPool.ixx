@@ -3,7 +3,9 @@
 *--------------------------------------------------------------*/
 
 export module Microwave.System.ThreadPool;
-import Microwave.System.AsyncExecutor;
+import Microwave.System.Executor;
+import Microwave.System.JobSystem;
+import Microwave.System.Object;
 import Microwave.System.Pointers;
 import Microwave.System.Task;
 import std;
@@ -11,9 +13,22 @@ import std;
 export namespace mw {
 inline namespace system {
 
-class ThreadPool : public AsyncExecutor
+// Runs jobs as background jobs on the shared JobSystem, so they
+// can block on IO without stalling threads that help with ParallelFor
+class ThreadPool : public Executor
 {
+    inline static Type::Pin<ThreadPool> pin;
+
+protected:
+    virtual void Execute(const gfunction<void()>& job) override {
+        JobSystem::GetInstance().ScheduleBackground(job);
+    }
+
 public:
+    ThreadPool() {
+        SetName("ThreadPool");
+    }
+
     template<class Fun, class T = std::invoke_result_t<Fun>>
     static Task<T> InvokeAsync(Fun&& fun) {
         return GetInstance()->Invoke(std::forward<Fun>(fun));
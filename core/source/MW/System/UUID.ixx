@@ -15,18 +15,22 @@ class UUID
         return (std::uint64_t)std::chrono::system_clock::now().time_since_epoch().count();
     }
 
+    // files are imported concurrently, and each import creates objects
     inline static std::mt19937_64 generator{ GetSeed() };
+    inline static std::mutex generatorLock;
 
     std::array<std::uint8_t, 16> data = {};
 
 public:
     static void SetRandomSeed(std::uint64_t seed) {
+        std::lock_guard lock(generatorLock);
         generator.seed(seed);
     }
 
     static UUID New()
     {
         UUID ret;
+        std::unique_lock lock(generatorLock);
 
         int i = 0;
         std::uint64_t val = generator();
@@ -40,6 +44,8 @@ public:
             *it = (std::uint8_t)((val >> (i * 8)) & 0xFF);
         }
 
+        lock.unlock();
+
         // set variant to 0b10xxxxxx
         ret.data[8] &= 0xBF;
         ret.data[8] |= 0x80;
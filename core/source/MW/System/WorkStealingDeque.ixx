@@ -0,0 +1,144 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Microwave.System.WorkStealingDeque;
+import std;
+
+export namespace mw {
+inline namespace system {
+
+// Chase-Lev work-stealing deque of pointers (Le et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models", 2013). The owning thread
+// pushes and pops at the bottom, while any thread may steal from the top.
+// Buffers that are outgrown are kept alive until the deque is destroyed,
+// since a concurrent thief may still be reading from them.
+template<class T>
+class WorkStealingDeque
+{
+    struct Buffer
+    {
+        std::int64_t capacity;
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<T*>[]> items;
+
+        Buffer(std::int64_t capacity)
+            : capacity(capacity), mask(capacity - 1), items(new std::atomic<T*>[capacity]) {}
+
+        T* Get(std::int64_t index) const {
+            return items[index & mask].load(std::memory_order_relaxed);
+        }
+
+        void Put(std::int64_t index, T* item) {
+            items[index & mask].store(item, std::memory_order_relaxed);
+        }
+    };
+
+    alignas(64) std::atomic<std::int64_t> top = 0;
+    alignas(64) std::atomic<std::int64_t> bottom = 0;
+    std::atomic<Buffer*> buffer;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+
+public:
+    WorkStealingDeque(std::int64_t capacity = 1024)
+    {
+        buffers.push_back(std::make_unique<Buffer>(std::bit_ceil((std::uint64_t)capacity)));
+        buffer.store(buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    WorkStealingDeque(WorkStealingDeque&&) = delete;
+    WorkStealingDeque& operator=(WorkStealingDeque&&) = delete;
+
+    // owner only
+    void Push(T* item)
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        Buffer* buf = buffer.load(std::memory_order_relaxed);
+
+        if (b - t > buf->capacity - 1)
+            buf = Grow(buf, t, b);
+
+        buf->Put(b, item);
+        bottom.store(b + 1, std::memory_order_release);
+    }
+
+    // owner only
+    T* Pop()
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* buf = buffer.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        T* item = nullptr;
+
+        if (t <= b)
+        {
+            item = buf->Get(b);
+
+            if (t == b)
+            {
+                // last item - race thieves for it
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    item = nullptr;
+
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+    }
+
+    // any thread
+    T* Steal()
+    {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+
+        if (t < b)
+        {
+            Buffer* buf = buffer.load(std::memory_order_acquire);
+            T* item = buf->Get(t);
+
+            if (top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return item;
+        }
+
+        return nullptr;
+    }
+
+    // approximate when called from a thread other than the owner
+    bool Empty() const
+    {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        return b <= t;
+    }
+
+private:
+    Buffer* Grow(Buffer* buf, std::int64_t t, std::int64_t b)
+    {
+        auto bigger = std::make_unique<Buffer>(buf->capacity * 2);
+
+        for (std::int64_t i = t; i < b; ++i)
+            bigger->Put(i, buf->Get(i));
+
+        Buffer* ret = bigger.get();
+        buffers.push_back(std::move(bigger));
+        buffer.store(ret, std::memory_order_release);
+        return ret;
+    }
+};
+
+} // system
+} // mw
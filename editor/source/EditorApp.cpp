@@ -63,6 +63,7 @@ public:
 
             bool forceImport = false;
             auto assetDatabase = gpnew<AssetDatabase>(assetLibrary);
+            assetDatabase->SetImportOptions(GetArgs());
             assetDatabase->Refresh(forceImport);
             assetDatabase.reset();
 
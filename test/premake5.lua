@@ -18,6 +18,14 @@ project "Test"
 
     files {
         "source/BatteryMeter.ixx",
+        "source/Benchmark.cpp",
+        "source/Benchmark.ixx",
+        "source/BenchmarkAnimation.cpp",
+        "source/BenchmarkData.cpp",
+        "source/BenchmarkGraphics.cpp",
+        "source/BenchmarkPhysics.cpp",
+        "source/BenchmarkScene.cpp",
+        "source/BenchmarkSystem.cpp",
         "source/BigDoors.ixx",
         "source/CameraController.ixx",
         "source/Coin.cpp",
@@ -0,0 +1,119 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module;
+#include <MW/System/Internal/Platform.h>
+
+#if PLATFORM_WINDOWS
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <Windows.h>
+#  include <psapi.h>
+#else
+#  include <sys/resource.h>
+#endif
+
+module Test.Benchmark;
+import Microwave;
+import <algorithm>;
+import <cmath>;
+import <format>;
+import <vector>;
+
+using namespace mw;
+
+namespace Test {
+
+struct Benchmark
+{
+    std::string name;
+    std::function<void()> run;
+};
+
+static std::vector<Benchmark>& benchmarks()
+{
+    static std::vector<Benchmark> container;
+    return container;
+}
+
+BenchmarkRegistration::BenchmarkRegistration(std::string name, std::function<void()> run) {
+    benchmarks().push_back({ std::move(name), std::move(run) });
+}
+
+bool RunBenchmarks(std::span<const std::string> args)
+{
+    auto it = std::find(args.begin(), args.end(), "--benchmark");
+    if (it == args.end())
+        return false;
+
+    std::string filter;
+    if (++it != args.end() && !it->starts_with("--"))
+        filter = *it;
+
+    auto& all = benchmarks();
+    std::sort(all.begin(), all.end(),
+        [](const Benchmark& a, const Benchmark& b) { return a.name < b.name; });
+
+    for (auto& benchmark : all)
+    {
+        if (benchmark.name.find(filter) == std::string::npos)
+            continue;
+
+        writeln(benchmark.name);
+
+        try {
+            benchmark.run();
+        }
+        catch (const std::exception& ex) {
+            writeln("    failed: ", ex.what());
+        }
+    }
+
+    return true;
+}
+
+HeadlessGraphics::HeadlessGraphics()
+    : previous(GraphicsContext::GetCurrent())
+    , graphics(gpnew<GraphicsContext>(GraphicsDriverType::None))
+{
+    GraphicsContext::SetCurrent(graphics);
+    graphics->SetRenderTarget(gpnew<RenderTexture>(IVec2(1280, 720)));
+}
+
+HeadlessGraphics::~HeadlessGraphics() {
+    GraphicsContext::SetCurrent(previous);
+}
+
+std::size_t GetPeakMemoryUsage()
+{
+#if PLATFORM_WINDOWS
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+  #if PLATFORM_MACOS || PLATFORM_IOS
+    return (std::size_t)usage.ru_maxrss;        // bytes
+  #else
+    return (std::size_t)usage.ru_maxrss * 1024; // kilobytes
+  #endif
+#endif
+}
+
+void Report(std::string_view label, double value, std::string_view unit)
+{
+    // small values, like errors, need more than two decimals to show up
+    if (value != 0 && std::abs(value) < 0.1)
+        writeln(std::format("    {:<40} {:>12.6f} {}", label, value, unit));
+    else
+        writeln(std::format("    {:<40} {:>12.2f} {}", label, value, unit));
+}
+
+} // Test
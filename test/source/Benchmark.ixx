@@ -0,0 +1,114 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+export module Test.Benchmark;
+import Microwave;
+import <chrono>;
+import <functional>;
+import <span>;
+import <string>;
+import <string_view>;
+
+using namespace mw;
+
+export namespace Test {
+
+// Adds a benchmark to the ones '--benchmark' runs. Instances are declared
+// at namespace scope next to the benchmark, so every one is registered
+// before the app starts.
+class BenchmarkRegistration
+{
+public:
+    BenchmarkRegistration(std::string name, std::function<void()> run);
+};
+
+// Runs the benchmarks selected by '--benchmark [name]' in 'args', which
+// are all of them, or those whose name contains 'name'. Returns false if
+// 'args' doesn't ask for any.
+bool RunBenchmarks(std::span<const std::string> args);
+
+// prints one result of the running benchmark
+void Report(std::string_view label, double value, std::string_view unit);
+
+// Flat colored shader with the matrices SceneRenderer and MeshRenderer
+// set, and a 'uColor' material property.
+inline constexpr const char* ColorShaderSource = R"(
+#pragma vertex VSMain
+#pragma fragment PSMain
+struct appdata
+{
+	float3 pos : POSITION;
+	float3 nor : NORMAL;
+};
+
+struct v2p
+{
+	half4 pos : POSITION;
+	half3 nor : NORMAL;
+};
+
+uniform float4x4 uMtxMVP;
+uniform float4x4 uMtxNormal;
+
+v2p VSMain(appdata input)
+{
+	v2p output;
+	output.pos = mul(uMtxMVP, float4(input.pos, 1.0));
+	output.nor = mul(uMtxNormal, float4(input.nor, 1.0)).rgb;
+	return output;
+}
+
+uniform float4 uColor;
+
+half4 PSMain(v2p input) : COLOR0
+{
+	return uColor;
+}
+)";
+
+// Makes a null graphics context current for as long as it exists, so that
+// rendering can be measured without a GPU.
+class HeadlessGraphics
+{
+    gptr<GraphicsContext> previous;
+public:
+    gptr<GraphicsContext> graphics;
+
+    HeadlessGraphics();
+    ~HeadlessGraphics();
+};
+
+// Peak resident memory of the process in bytes, or 0 if it's unavailable.
+// It never goes down, so a benchmark can only see what raises it.
+std::size_t GetPeakMemoryUsage();
+
+// seconds taken by a single call to 'fun'
+template<class F>
+double Time(F&& fun)
+{
+    auto start = std::chrono::steady_clock::now();
+    fun();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Calls 'fun' once to warm up, then until 'minSeconds' have passed, and
+// returns the average seconds per call.
+template<class F>
+double Measure(F&& fun, double minSeconds = 0.25)
+{
+    fun();
+
+    int calls = 0;
+    double total = 0;
+
+    while (total < minSeconds)
+    {
+        total += Time(fun);
+        ++calls;
+    }
+
+    return total / calls;
+}
+
+} // Test
@@ -0,0 +1,257 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Test.Benchmark;
+import Microwave;
+import <algorithm>;
+import <cmath>;
+import <format>;
+import <memory>;
+import <string>;
+import <thread>;
+import <vector>;
+
+using namespace mw;
+
+namespace Test {
+
+constexpr int BoneCount = 64;
+constexpr float ClipLength = 2.0f;
+constexpr float KeyRate = 30.0f;
+
+// Path of bone 'i' below the character's root. Bones form a binary tree,
+// so paths are about as deep as a humanoid's.
+static std::string GetBonePath(int i) {
+    return i == 0 ? "b0" : GetBonePath((i - 1) / 2) + "/b" + std::to_string(i);
+}
+
+// A clip with densely baked keys on every bone, the way the FBX converter
+// writes them. Scale never changes, and positions move slightly.
+static gptr<AnimationClip> CreateBakedClip()
+{
+    auto clip = gpnew<AnimationClip>();
+    clip->SetWrapMode(AnimationWrapMode::Loop);
+
+    int keyCount = (int)(ClipLength * KeyRate) + 1;
+
+    for (int b = 0; b < BoneCount; ++b)
+    {
+        auto track = gpnew<AnimationTrack>();
+
+        for (int k = 0; k < keyCount; ++k)
+        {
+            float time = k / KeyRate;
+            float phase = time * 3.14159265f + b * 0.1f;
+
+            Keyframe key;
+            key.time = time;
+            key.value.position = Vec3(0, 1, 0) + Vec3(std::sin(phase), 0, std::cos(phase)) * 0.01f;
+            key.value.rotation = Quat(std::sin(phase) * 30.0f, std::cos(phase) * 20.0f, 0);
+            key.value.scale = Vec3(1, 1, 1);
+            track->frames.push_back(key);
+        }
+
+        clip->AddTrack(GetBonePath(b), track);
+    }
+
+    return clip;
+}
+
+// a root node with an Animator playing 'clip', over a BoneCount bone skeleton
+static gptr<Node> CreateCharacter(const gptr<AnimationClip>& clip)
+{
+    auto root = gpnew<Node>();
+    std::vector<gptr<Node>> bones;
+
+    for (int b = 0; b < BoneCount; ++b)
+    {
+        auto parent = b == 0 ? root : bones[(b - 1) / 2];
+        auto bone = parent->AddChild();
+        bone->SetName("b" + std::to_string(b));
+        bones.push_back(bone);
+    }
+
+    root->AddComponent<Animator>()->AddClip(clip, "walk");
+    return root;
+}
+
+// Samples 300 characters with 64 animated bones each, one frame at a time
+// at 60Hz, so keyframe cursors see forward playback, and applies the poses.
+static void BenchmarkAnimator()
+{
+    constexpr int CharacterCount = 300;
+
+    auto character = CreateCharacter(CreateBakedClip());
+
+    gvector<gptr<Animator>> animators;
+    for (int i = 0; i < CharacterCount; ++i)
+    {
+        auto animator = Instantiate<Node>(character)->GetComponent<Animator>();
+        animator->Play("walk");
+        animators.push_back(animator);
+    }
+
+    float time = 0;
+
+    double frame = Measure([&] {
+        time = std::fmod(time + 1.0f / 60.0f, ClipLength);
+
+        for (auto& animator : animators)
+        {
+            animator->GetAnimationState("walk").time = time;
+            animator->Sample();
+        }
+    });
+
+    Report("frame", frame * 1000, "ms");
+    Report("sampled and applied", CharacterCount * BoneCount / frame / 1000, "bones per ms");
+}
+
+static BenchmarkRegistration animatorBenchmark("animator", &BenchmarkAnimator);
+
+// Compresses copies of the baked clip at the default tolerance and at ten
+// times that, and reports the size, max error and sampling cost of each.
+static void BenchmarkAnimationCompression()
+{
+    auto clip = CreateBakedClip();
+
+    auto sampleAll = [](const gptr<AnimationClip>& source)
+    {
+        Transform pose;
+        for (float time = 0; time < ClipLength; time += 1.0f / 60.0f)
+        {
+            for (auto& [path, track] : source->GetTracks())
+                pose = track->Evaluate(time);
+        }
+    };
+
+    double bakedSample = Measure([&] { sampleAll(clip); });
+
+    AnimationTolerance defaultTolerance;
+    AnimationTolerance looseTolerance;
+    looseTolerance.position *= 10;
+    looseTolerance.rotation *= 10;
+    looseTolerance.scale *= 10;
+
+    std::pair<const char*, AnimationTolerance> settings[] = {
+        { "default tolerance", defaultTolerance },
+        { "10x tolerance", looseTolerance },
+    };
+
+    for (auto& [name, tolerance] : settings)
+    {
+        auto compressed = gpnew<AnimationClip>();
+        AnimationCompressionStats stats;
+
+        for (auto& [path, track] : clip->GetTracks())
+        {
+            auto copy = gpnew<AnimationTrack>(*track);
+            stats += copy->Compress(tolerance);
+            compressed->AddTrack(path, copy);
+        }
+
+        double sample = Measure([&] { sampleAll(compressed); });
+
+        writeln("  ", name);
+        Report("original size", stats.originalSize / 1024.0, "KB");
+        Report("compressed size", stats.compressedSize / 1024.0, "KB");
+        Report("compression ratio", (double)stats.originalSize / stats.compressedSize, "x");
+        Report("max position error", stats.maxPositionError, "");
+        Report("max rotation error", stats.maxRotationError, "radians");
+        Report("max scale error", stats.maxScaleError, "");
+        Report("sampling time vs baked", sample / bakedSample * 100, "%");
+    }
+}
+
+static BenchmarkRegistration compressionBenchmark("animation compression", &BenchmarkAnimationCompression);
+
+// a 65k vertex grid skinned to BoneCount bones along its length, with two
+// non-zero influences per vertex, like most of a character's surface
+static gptr<Mesh> CreateSkinnedMesh(SkinType skinType)
+{
+    constexpr int Side = 256;
+
+    auto mesh = gpnew<Mesh>();
+    mesh->skinType = skinType;
+
+    for (int y = 0; y < Side; ++y)
+    {
+        for (int x = 0; x < Side; ++x)
+        {
+            float along = (float)y / (Side - 1) * (BoneCount - 1);
+            int bone = std::min((int)along, BoneCount - 2);
+            float blend = along - bone;
+
+            mesh->vertices.push_back(Vec3((float)x, (float)y, 0));
+            mesh->normals.push_back(Vec3(0, 0, -1));
+            mesh->boneIndices.push_back(IVec4(bone, bone + 1, 0, 0));
+            mesh->boneWeights.push_back(Vec4(1 - blend, blend, 0, 0));
+        }
+    }
+
+    mesh->bones.resize(BoneCount);
+    return mesh;
+}
+
+// Skins a 65k vertex mesh with linear and dual quaternion blending, on the
+// calling thread and on 2, 3... threads up to one per core, splitting the
+// vertices into chunks the way MeshRenderer does.
+static void BenchmarkSkinning()
+{
+    constexpr std::size_t ChunkSize = 8192;
+
+    std::vector<Mat4> matrices;
+    std::vector<DualQuatBone> dualQuats;
+
+    for (int b = 0; b < BoneCount; ++b)
+    {
+        auto matrix = Mat4::Rotation(0, 0, b * 2.0f) * Mat4::Translation(0, 0, b * 0.1f);
+        matrices.push_back(matrix);
+        dualQuats.push_back(DualQuatBone(matrix));
+    }
+
+    auto linearMesh = CreateSkinnedMesh(SkinType::Linear);
+    auto dualQuatMesh = CreateSkinnedMesh(SkinType::DualQuaternion);
+
+    std::size_t vertexCount = linearMesh->vertices.size();
+    std::vector<Vec3> positions(vertexCount);
+    std::vector<Vec3> normals(vertexCount);
+
+    int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+
+    for (int threads = 1; threads <= maxThreads; ++threads)
+    {
+        // the calling thread helps out while it waits, so it counts as one
+        std::unique_ptr<JobSystem> jobs;
+        if (threads > 1)
+            jobs = std::make_unique<JobSystem>(threads - 1);
+
+        auto skin = [&](auto&& kernel)
+        {
+            if (!jobs)
+                kernel(0, vertexCount);
+            else
+                jobs->ParallelFor(vertexCount, ChunkSize, kernel);
+        };
+
+        double linear = Measure([&] {
+            skin([&](std::size_t first, std::size_t last) {
+                SkinLinear(*linearMesh, matrices, first, last, positions, normals);
+            });
+        });
+
+        double dualQuat = Measure([&] {
+            skin([&](std::size_t first, std::size_t last) {
+                SkinDualQuaternion(*dualQuatMesh, dualQuats, first, last, positions, normals);
+            });
+        });
+
+        Report(std::format("linear, {} threads", threads), vertexCount / linear / 1000, "vertices per ms");
+        Report(std::format("dual quaternion, {} threads", threads), vertexCount / dualQuat / 1000, "vertices per ms");
+    }
+}
+
+static BenchmarkRegistration skinningBenchmark("skinning", &BenchmarkSkinning);
+
+} // Test
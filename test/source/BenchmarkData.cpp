@@ -0,0 +1,268 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Test.Benchmark;
+import Microwave;
+import <algorithm>;
+import <cmath>;
+import <filesystem>;
+import <format>;
+import <string>;
+import <thread>;
+import <vector>;
+
+using namespace mw;
+
+namespace Test {
+
+// where benchmarks write the files they load back
+static std::filesystem::path GetScratchDir()
+{
+    auto dir = std::filesystem::temp_directory_path() / "microwave-benchmark";
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+// a flat grid of side * side vertices, the size of a large imported mesh
+static gptr<Mesh> CreateGridMesh(int side)
+{
+    auto mesh = gpnew<Mesh>();
+    mesh->SetName("Grid");
+
+    for (int y = 0; y < side; ++y)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            float u = (float)x / (side - 1);
+            float v = (float)y / (side - 1);
+            mesh->vertices.push_back(Vec3(u * 100.0f, std::sin(u * 20.0f) * std::cos(v * 20.0f), v * 100.0f));
+            mesh->normals.push_back(Vec3(0, 1, 0));
+            mesh->texcoords.push_back(Vec2(u, v));
+        }
+    }
+
+    MeshElement element;
+
+    for (int y = 0; y < side - 1; ++y)
+    {
+        for (int x = 0; x < side - 1; ++x)
+        {
+            int i = y * side + x;
+            element.indices.insert(element.indices.end(), { i, i + side, i + 1, i + 1, i + side, i + side + 1 });
+        }
+    }
+
+    mesh->elements.push_back(std::move(element));
+    mesh->RecalcBounds();
+
+    return mesh;
+}
+
+// Saves a 262k vertex mesh as a JSON and a binary artifact, then loads each
+// back the way ObjectLoader does, including creating its buffers.
+static void BenchmarkArtifacts()
+{
+    HeadlessGraphics headless;
+
+    auto mesh = CreateGridMesh(512);
+    auto dir = GetScratchDir();
+    auto jsonPath = dir / "grid.json";
+    auto binaryPath = dir / "grid.bin";
+
+    {
+        JsonWriter writer(File::Open(jsonPath, OpenMode::Out | OpenMode::Binary), 2);
+        mesh->WriteJson(writer);
+        writer.Flush();
+    }
+
+    {
+        BinaryArtifactWriter writer;
+        mesh->WriteArtifact(writer);
+        writer.Save(binaryPath);
+    }
+
+    double jsonLoad = Measure([&] {
+        ObjectLinker linker;
+        auto val = json::parse(File::ReadAllText(jsonPath));
+        auto obj = Object::CreateFromJson(val, &linker);
+    });
+
+    double binaryLoad = Measure([&] {
+        ObjectLinker linker;
+        auto artifact = gpnew<BinaryArtifact>(binaryPath);
+        auto loaded = gpnew<Mesh>();
+        loaded->ReadArtifact(*artifact, &linker);
+        artifact->Close();
+    });
+
+    Report("JSON artifact size", std::filesystem::file_size(jsonPath) / 1048576.0, "MB");
+    Report("binary artifact size", std::filesystem::file_size(binaryPath) / 1048576.0, "MB");
+    Report("JSON artifact load", jsonLoad * 1000, "ms");
+    Report("binary artifact load", binaryLoad * 1000, "ms");
+}
+
+static BenchmarkRegistration artifactBenchmark("artifacts", &BenchmarkArtifacts);
+
+// Force-imports a copy of the test app's sources with 1, 2, 4... import
+// jobs, up to one per core, and with the shared JobSystem. Each Refresh
+// also prints the time spent per importer.
+static void BenchmarkImport()
+{
+    auto rootDir = GetScratchDir() / "import";
+    auto sourceDir = App::Get()->GetAssetLibrary()->GetRootDir() / "source";
+
+    std::filesystem::remove_all(rootDir);
+    std::filesystem::create_directories(rootDir / "source");
+    std::filesystem::copy(sourceDir.c_str(), rootDir / "source",
+        std::filesystem::copy_options::recursive);
+
+    int fileCount = 0;
+    for (auto& entry : std::filesystem::recursive_directory_iterator(rootDir / "source"))
+    {
+        if (entry.is_regular_file() && entry.path().extension() != ".meta")
+            ++fileCount;
+    }
+
+    int maxJobs = std::max(1, (int)std::thread::hardware_concurrency());
+
+    std::vector<int> jobCounts;
+    for (int count = 1; count < maxJobs; count *= 2)
+        jobCounts.push_back(count);
+    jobCounts.push_back(maxJobs);
+    jobCounts.push_back(0);
+
+    Report("source files", (double)fileCount, "");
+
+    double sequential = 0;
+
+    for (int jobs : jobCounts)
+    {
+        auto assetDatabase = gpnew<AssetDatabase>(gpnew<AssetLibrary>(rootDir));
+        assetDatabase->SetImportJobs(jobs);
+
+        double seconds = Time([&] { assetDatabase->Refresh(true); });
+
+        if (jobs == 1)
+            sequential = seconds;
+
+        auto label = jobs ? std::format("{} jobs", jobs) : std::string("shared JobSystem");
+        Report(label, seconds * 1000, "ms");
+        Report(label + " speedup", sequential / seconds, "x");
+    }
+
+    std::filesystem::remove_all(rootDir);
+}
+
+static BenchmarkRegistration importBenchmark("import", &BenchmarkImport);
+
+// Parses every JSON artifact the test app's assets were imported to, and
+// the JSON of a 262k vertex mesh, which is mostly numbers.
+static void BenchmarkJsonParse()
+{
+    std::vector<std::string> artifacts;
+    std::size_t artifactBytes = 0;
+
+    auto dataDir = App::Get()->GetAssetLibrary()->GetDataDir();
+
+    for (auto& entry : std::filesystem::directory_iterator(dataDir.c_str()))
+    {
+        if (!entry.is_regular_file() || BinaryArtifact::IsBinaryArtifact(entry.path()))
+            continue;
+
+        auto text = File::ReadAllText(entry.path());
+        auto start = text.find_first_not_of(" \t\r\n");
+
+        if (start != std::string::npos && (text[start] == '{' || text[start] == '['))
+        {
+            artifactBytes += text.size();
+            artifacts.push_back(std::move(text));
+        }
+    }
+
+    json meshJson;
+    CreateGridMesh(512)->ToJson(meshJson);
+    auto meshText = meshJson.dump();
+
+    double artifactParse = Measure([&] {
+        for (auto& text : artifacts)
+            json::parse(text);
+    });
+
+    double meshParse = Measure([&] {
+        json::parse(meshText);
+    });
+
+    Report("JSON artifacts", (double)artifacts.size(), "files");
+    Report("JSON artifacts", artifactBytes / 1048576.0, "MB");
+    Report("JSON artifact parse", artifactBytes / artifactParse / 1048576.0, "MB/s");
+    Report("mesh JSON", meshText.size() / 1048576.0, "MB");
+    Report("mesh JSON parse", meshText.size() / meshParse / 1048576.0, "MB/s");
+}
+
+static BenchmarkRegistration jsonParseBenchmark("json parse", &BenchmarkJsonParse);
+
+// Saves a 20k node level, with a renderer on every node, along with a 262k
+// vertex mesh, by building json and dumping it, and by streaming it through
+// JsonWriter. Peak memory only rises, so streaming is measured first.
+static void BenchmarkJsonWrite()
+{
+    constexpr int NodeCount = 20000;
+
+    auto mesh = CreateGridMesh(512);
+    auto level = gpnew<Node>();
+
+    for (int i = 0; i < NodeCount; ++i)
+    {
+        auto node = level->AddChild();
+        node->SetName("Node" + std::to_string(i));
+        node->SetLocalPosition((float)i, 0, 0);
+        node->AddComponent<MeshRenderer>()->mesh = mesh;
+    }
+
+    auto dir = GetScratchDir();
+    auto levelPath = dir / "level.json";
+    auto meshPath = dir / "mesh.json";
+
+    auto writeStreamed = [&](int indent)
+    {
+        JsonWriter levelWriter(File::Open(levelPath, OpenMode::Out | OpenMode::Binary), indent);
+        level->WriteJson(levelWriter);
+        levelWriter.Flush();
+
+        JsonWriter meshWriter(File::Open(meshPath, OpenMode::Out | OpenMode::Binary), indent);
+        mesh->WriteJson(meshWriter);
+        meshWriter.Flush();
+    };
+
+    auto writeDom = [&]
+    {
+        json levelJson;
+        level->ToJson(levelJson);
+        File::WriteAllText(levelPath, levelJson.dump(2));
+
+        json meshJson;
+        mesh->ToJson(meshJson);
+        File::WriteAllText(meshPath, meshJson.dump(2));
+    };
+
+    auto basePeak = GetPeakMemoryUsage();
+    writeStreamed(2);
+    auto streamedPeak = GetPeakMemoryUsage();
+    writeDom();
+    auto domPeak = GetPeakMemoryUsage();
+
+    double dom = Measure(writeDom);
+    double streamed = Measure([&] { writeStreamed(2); });
+    double compact = Measure([&] { writeStreamed(-1); });
+
+    Report("json tree + dump(2)", dom * 1000, "ms");
+    Report("JsonWriter, indent 2", streamed * 1000, "ms");
+    Report("JsonWriter, compact", compact * 1000, "ms");
+    Report("peak memory growth, JsonWriter", (streamedPeak - basePeak) / 1048576.0, "MB");
+    Report("peak memory growth, json tree", (domPeak - basePeak) / 1048576.0, "MB");
+}
+
+static BenchmarkRegistration jsonWriteBenchmark("json write", &BenchmarkJsonWrite);
+
+} // Test
@@ -0,0 +1,437 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Test.Benchmark;
+import Microwave;
+import <cmath>;
+import <filesystem>;
+import <format>;
+import <limits>;
+import <string>;
+import <string_view>;
+import <utility>;
+import <vector>;
+
+using namespace mw;
+
+namespace Test {
+
+// Per-draw cost of setting a draw's uniforms: by names built at runtime,
+// which hashes each one like the old string-keyed lookups did, by
+// constant names hashed at compile time, and by IDs resolved up front.
+// Applying a material with a per-draw property block is measured too.
+static void BenchmarkUniforms()
+{
+    constexpr int DrawCount = 100000;
+
+    HeadlessGraphics headless;
+
+    auto shader = gpnew<Shader>(ColorShaderSource);
+    shader->Bind();
+
+    auto material = gpnew<Material>();
+    material->shader = shader;
+    material->SetUniform("uColor", Color::White());
+
+    auto extra = gpnew<MaterialPropertyBlock>();
+    extra->SetUniform(UniformNames::MtxNormal, Mat4::Identity());
+
+    std::string mvpName = "uMtxMVP";
+    std::string normalName = "uMtxNormal";
+    std::string colorName = "uColor";
+
+    Mat4 mtx = Mat4::Identity();
+    Color color = Color::White();
+
+    double byString = Measure([&] {
+        for (int i = 0; i < DrawCount; ++i)
+        {
+            shader->SetUniform(mvpName, mtx);
+            shader->SetUniform(normalName, mtx);
+            shader->SetUniform(colorName, color);
+        }
+    });
+
+    double byName = Measure([&] {
+        for (int i = 0; i < DrawCount; ++i)
+        {
+            shader->SetUniform(UniformNames::MtxMVP, mtx);
+            shader->SetUniform(UniformNames::MtxNormal, mtx);
+            shader->SetUniform("uColor", color);
+        }
+    });
+
+    int idMVP = shader->GetUniformID(UniformNames::MtxMVP);
+    int idNormal = shader->GetUniformID(UniformNames::MtxNormal);
+    int idColor = shader->GetUniformID("uColor");
+
+    double byID = Measure([&] {
+        for (int i = 0; i < DrawCount; ++i)
+        {
+            shader->SetUniform(idMVP, mtx);
+            shader->SetUniform(idNormal, mtx);
+            shader->SetUniform(idColor, color);
+        }
+    });
+
+    double materialApply = Measure([&] {
+        for (int i = 0; i < DrawCount; ++i)
+            material->SetActive(extra.get());
+    });
+
+    Report("3 uniforms by runtime name", byString / DrawCount * 1e9, "ns per draw");
+    Report("3 uniforms by constant name", byName / DrawCount * 1e9, "ns per draw");
+    Report("3 uniforms by ID", byID / DrawCount * 1e9, "ns per draw");
+    Report("material with property block", materialApply / DrawCount * 1e9, "ns per draw");
+}
+
+static BenchmarkRegistration uniformBenchmark("uniforms", &BenchmarkUniforms);
+
+// Scalar versions of the math kernels, written the way Microwave.Math
+// falls back to without a vector unit, as a baseline.
+namespace Scalar {
+
+static Mat4 Multiply(const Mat4& a, const Mat4& b)
+{
+    const float* pa = &a.m11;
+    const float* pb = &b.m11;
+
+    Mat4 ret;
+    float* out = &ret.m11;
+
+    for (int r = 0; r < 4; ++r)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            out[r * 4 + c] =
+                pa[r * 4 + 0] * pb[0 * 4 + c] + pa[r * 4 + 1] * pb[1 * 4 + c] +
+                pa[r * 4 + 2] * pb[2 * 4 + c] + pa[r * 4 + 3] * pb[3 * 4 + c];
+        }
+    }
+
+    return ret;
+}
+
+static Mat4 Inverse(const Mat4& a)
+{
+    Mat4 adj;
+
+    adj.m11 = a.m22 * a.m33 * a.m44 - a.m22 * a.m34 * a.m43 - a.m32 * a.m23 * a.m44 + a.m32 * a.m24 * a.m43 + a.m42 * a.m23 * a.m34 - a.m42 * a.m24 * a.m33;
+    adj.m21 = -a.m21 * a.m33 * a.m44 + a.m21 * a.m34 * a.m43 + a.m31 * a.m23 * a.m44 - a.m31 * a.m24 * a.m43 - a.m41 * a.m23 * a.m34 + a.m41 * a.m24 * a.m33;
+    adj.m31 = a.m21 * a.m32 * a.m44 - a.m21 * a.m34 * a.m42 - a.m31 * a.m22 * a.m44 + a.m31 * a.m24 * a.m42 + a.m41 * a.m22 * a.m34 - a.m41 * a.m24 * a.m32;
+    adj.m41 = -a.m21 * a.m32 * a.m43 + a.m21 * a.m33 * a.m42 + a.m31 * a.m22 * a.m43 - a.m31 * a.m23 * a.m42 - a.m41 * a.m22 * a.m33 + a.m41 * a.m23 * a.m32;
+    adj.m12 = -a.m12 * a.m33 * a.m44 + a.m12 * a.m34 * a.m43 + a.m32 * a.m13 * a.m44 - a.m32 * a.m14 * a.m43 - a.m42 * a.m13 * a.m34 + a.m42 * a.m14 * a.m33;
+    adj.m22 = a.m11 * a.m33 * a.m44 - a.m11 * a.m34 * a.m43 - a.m31 * a.m13 * a.m44 + a.m31 * a.m14 * a.m43 + a.m41 * a.m13 * a.m34 - a.m41 * a.m14 * a.m33;
+    adj.m32 = -a.m11 * a.m32 * a.m44 + a.m11 * a.m34 * a.m42 + a.m31 * a.m12 * a.m44 - a.m31 * a.m14 * a.m42 - a.m41 * a.m12 * a.m34 + a.m41 * a.m14 * a.m32;
+    adj.m42 = a.m11 * a.m32 * a.m43 - a.m11 * a.m33 * a.m42 - a.m31 * a.m12 * a.m43 + a.m31 * a.m13 * a.m42 + a.m41 * a.m12 * a.m33 - a.m41 * a.m13 * a.m32;
+    adj.m13 = a.m12 * a.m23 * a.m44 - a.m12 * a.m24 * a.m43 - a.m22 * a.m13 * a.m44 + a.m22 * a.m14 * a.m43 + a.m42 * a.m13 * a.m24 - a.m42 * a.m14 * a.m23;
+    adj.m23 = -a.m11 * a.m23 * a.m44 + a.m11 * a.m24 * a.m43 + a.m21 * a.m13 * a.m44 - a.m21 * a.m14 * a.m43 - a.m41 * a.m13 * a.m24 + a.m41 * a.m14 * a.m23;
+    adj.m33 = a.m11 * a.m22 * a.m44 - a.m11 * a.m24 * a.m42 - a.m21 * a.m12 * a.m44 + a.m21 * a.m14 * a.m42 + a.m41 * a.m12 * a.m24 - a.m41 * a.m14 * a.m22;
+    adj.m43 = -a.m11 * a.m22 * a.m43 + a.m11 * a.m23 * a.m42 + a.m21 * a.m12 * a.m43 - a.m21 * a.m13 * a.m42 - a.m41 * a.m12 * a.m23 + a.m41 * a.m13 * a.m22;
+    adj.m14 = -a.m12 * a.m23 * a.m34 + a.m12 * a.m24 * a.m33 + a.m22 * a.m13 * a.m34 - a.m22 * a.m14 * a.m33 - a.m32 * a.m13 * a.m24 + a.m32 * a.m14 * a.m23;
+    adj.m24 = a.m11 * a.m23 * a.m34 - a.m11 * a.m24 * a.m33 - a.m21 * a.m13 * a.m34 + a.m21 * a.m14 * a.m33 + a.m31 * a.m13 * a.m24 - a.m31 * a.m14 * a.m23;
+    adj.m34 = -a.m11 * a.m22 * a.m34 + a.m11 * a.m24 * a.m32 + a.m21 * a.m12 * a.m34 - a.m21 * a.m14 * a.m32 - a.m31 * a.m12 * a.m24 + a.m31 * a.m14 * a.m22;
+    adj.m44 = a.m11 * a.m22 * a.m33 - a.m11 * a.m23 * a.m32 - a.m21 * a.m12 * a.m33 + a.m21 * a.m13 * a.m32 + a.m31 * a.m12 * a.m23 - a.m31 * a.m13 * a.m22;
+
+    float det = a.m11 * adj.m11 + a.m12 * adj.m21 + a.m13 * adj.m31 + a.m14 * adj.m41;
+    if (!(std::abs(det) > 0))
+        return a;
+
+    float inv = 1.0f / det;
+    float* p = &adj.m11;
+
+    for (int i = 0; i < 16; ++i)
+        p[i] *= inv;
+
+    return adj;
+}
+
+static Vec3 TransformPoint(const Mat4& m, const Vec3& p)
+{
+    return Vec3(
+        p.x * m.m11 + p.y * m.m21 + p.z * m.m31 + m.m41,
+        p.x * m.m12 + p.y * m.m22 + p.z * m.m32 + m.m42,
+        p.x * m.m13 + p.y * m.m23 + p.z * m.m33 + m.m43);
+}
+
+static Vec3 TransformVector(const Mat4& m, const Vec3& v)
+{
+    return Vec3(
+        v.x * m.m11 + v.y * m.m21 + v.z * m.m31,
+        v.x * m.m12 + v.y * m.m22 + v.z * m.m32,
+        v.x * m.m13 + v.y * m.m23 + v.z * m.m33);
+}
+
+static AABox TransformBox(const Mat4& m, const AABox& box)
+{
+    auto& e = box.extents;
+
+    AABox ret;
+    ret.center = TransformPoint(m, box.center);
+    ret.extents = Vec3(
+        std::abs(e.x * m.m11) + std::abs(e.y * m.m21) + std::abs(e.z * m.m31),
+        std::abs(e.x * m.m12) + std::abs(e.y * m.m22) + std::abs(e.z * m.m32),
+        std::abs(e.x * m.m13) + std::abs(e.y * m.m23) + std::abs(e.z * m.m33));
+    return ret;
+}
+
+static Quat Multiply(const Quat& a, const Quat& b)
+{
+    return Quat(
+        a.v.z * b.v.y - a.v.y * b.v.z + a.v.x * b.w + a.w * b.v.x,
+        a.v.x * b.v.z - a.v.z * b.v.x + a.v.y * b.w + a.w * b.v.y,
+        a.v.y * b.v.x - a.v.x * b.v.y + a.v.z * b.w + a.w * b.v.z,
+        a.w * b.w - a.v * b.v);
+}
+
+static Vec3 Rotate(const Vec3& v, const Quat& q)
+{
+    Vec3 uv = q.v.Cross(v);
+    Vec3 uuv = q.v.Cross(uv);
+    return v + uv * (2.0f * q.w) + uuv * 2.0f;
+}
+
+static Quat Slerp(const Quat& a, const Quat& b, float t)
+{
+    float dot = a.Dot(b);
+    float sign = dot < 0 ? -1.0f : 1.0f;
+    dot *= sign;
+
+    float ta = 1 - t;
+    float tb = t;
+
+    if (dot <= (1.0f - std::numeric_limits<float>::epsilon()))
+    {
+        float angle = std::acos(dot);
+        float invSinAngle = 1.0f / std::sin(angle);
+        ta = std::sin((1.0f - t) * angle) * invSinAngle;
+        tb = std::sin(t * angle) * invSinAngle;
+    }
+
+    tb *= sign;
+    return Quat(a.v * ta + b.v * tb, a.w * ta + b.w * tb);
+}
+
+} // Scalar
+
+// Runs each Math kernel and batch function over 64k elements, next to the
+// scalar code it replaced, and reports millions of operations per second.
+static void BenchmarkMath()
+{
+    constexpr std::size_t Count = 65536;
+
+    std::vector<Mat4> matrices(Count);
+    std::vector<Mat4> matrixResults(Count);
+    std::vector<Vec3> points(Count);
+    std::vector<Vec3> pointResults(Count);
+    std::vector<AABox> boxes(Count);
+    std::vector<AABox> boxResults(Count);
+    std::vector<Quat> rotations(Count);
+    std::vector<Quat> rotationResults(Count);
+
+    for (std::size_t i = 0; i < Count; ++i)
+    {
+        float f = (float)i;
+        matrices[i] = Mat4::Rotation(f, f * 0.5f, f * 0.25f) * Mat4::Translation(f, -f, f * 2.0f);
+        points[i] = Vec3(f, f * 0.5f, -f);
+        boxes[i] = AABox(points[i], Vec3(1, 2, 3));
+        rotations[i] = Quat(f, f * 0.5f, f * 0.25f);
+    }
+
+    Mat4 m = Mat4::Rotation(30, 45, 60) * Mat4::Translation(1, 2, 3);
+    Quat q = Quat(30, 45, 60);
+
+    auto compare = [](std::string_view name, double kernel, double scalar)
+    {
+        Report(name, Count / kernel / 1e6, "M per second");
+        Report(std::format("{}, scalar", name), Count / scalar / 1e6, "M per second");
+        Report(std::format("{}, speedup", name), scalar / kernel, "x");
+    };
+
+    compare("Mat4 * Mat4",
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) matrixResults[i] = matrices[i] * m; }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) matrixResults[i] = Scalar::Multiply(matrices[i], m); }));
+
+    compare("Mat4::Inverse",
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) matrixResults[i] = matrices[i].Inverse(); }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) matrixResults[i] = Scalar::Inverse(matrices[i]); }));
+
+    compare("Quat * Quat",
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) rotationResults[i] = rotations[i] * q; }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) rotationResults[i] = Scalar::Multiply(rotations[i], q); }));
+
+    compare("Vec3 * Quat",
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) pointResults[i] = points[i] * rotations[i]; }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) pointResults[i] = Scalar::Rotate(points[i], rotations[i]); }));
+
+    compare("Quat::Slerp",
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) rotationResults[i] = Quat::Slerp(rotations[i], q, 0.3f); }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) rotationResults[i] = Scalar::Slerp(rotations[i], q, 0.3f); }));
+
+    compare("AABox::Transform",
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) boxResults[i] = boxes[i].Transform(m); }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) boxResults[i] = Scalar::TransformBox(m, boxes[i]); }));
+
+    compare("TransformPoints",
+        Measure([&] { TransformPoints(m, points, pointResults); }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) pointResults[i] = Scalar::TransformPoint(m, points[i]); }));
+
+    compare("TransformVectors",
+        Measure([&] { TransformVectors(m, points, pointResults); }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) pointResults[i] = Scalar::TransformVector(m, points[i]); }));
+
+    compare("MultiplyMatrices",
+        Measure([&] { MultiplyMatrices(matrices, m, matrixResults); }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) matrixResults[i] = Scalar::Multiply(matrices[i], m); }));
+
+    compare("TransformBoxes",
+        Measure([&] { TransformBoxes(m, boxes, boxResults); }),
+        Measure([&] { for (std::size_t i = 0; i < Count; ++i) boxResults[i] = Scalar::TransformBox(m, boxes[i]); }));
+}
+
+static BenchmarkRegistration mathBenchmark("math", &BenchmarkMath);
+
+// a 4K image with a gradient in every channel
+static Image CreateTestImage(PixelDataFormat format)
+{
+    Image image(format, IVec2(3840, 2160));
+    auto data = image.GetData();
+
+    if (format == PixelDataFormat::RGBAFloat)
+    {
+        auto values = std::span((float*)data.data(), data.size() / sizeof(float));
+        for (std::size_t i = 0; i < values.size(); ++i)
+            values[i] = (i % 1021) / 1020.0f;
+    }
+    else
+    {
+        for (std::size_t i = 0; i < data.size(); ++i)
+            data[i] = (std::byte)(i * 31);
+    }
+
+    return image;
+}
+
+// Converts a 4K image between every pair of pixel formats, with Clone,
+// which splits large images across the JobSystem, and with ConvertPixels
+// on one thread. Then the sRGB and premultiplied alpha variants.
+static void BenchmarkPixels()
+{
+    std::pair<PixelDataFormat, const char*> formats[] = {
+        { PixelDataFormat::Alpha8, "Alpha8" },
+        { PixelDataFormat::RGB24, "RGB24" },
+        { PixelDataFormat::RGBA32, "RGBA32" },
+        { PixelDataFormat::RGBAFloat, "RGBAFloat" },
+    };
+
+    auto rgba32 = CreateTestImage(PixelDataFormat::RGBA32);
+    auto size = rgba32.GetSize();
+    double megapixels = size.x * size.y / 1e6;
+
+    for (auto& [srcFormat, srcName] : formats)
+    {
+        auto src = CreateTestImage(srcFormat);
+
+        for (auto& [dstFormat, dstName] : formats)
+        {
+            Image dst(dstFormat, size);
+
+            double clone = Measure([&] {
+                src.Clone(dstFormat);
+            });
+
+            double rows = Measure([&] {
+                Image::ConvertPixels(
+                    src.GetData().data(), srcFormat,
+                    dst.GetData().data(), dstFormat,
+                    (std::size_t)size.x * size.y);
+            });
+
+            Report(std::format("{} -> {}", srcName, dstName), megapixels / clone, "MPix/s");
+            Report(std::format("{} -> {}, one thread", srcName, dstName), megapixels / rows, "MPix/s");
+        }
+    }
+
+    auto rgbaFloat = CreateTestImage(PixelDataFormat::RGBAFloat);
+
+    std::pair<PixelConversion, const char*> conversions[] = {
+        { PixelConversion::SRGBToLinear, "sRGB to linear" },
+        { PixelConversion::PremultiplyAlpha, "premultiply" },
+        { PixelConversion::LinearToSRGB, "linear to sRGB" },
+    };
+
+    for (auto& [conversion, name] : conversions)
+    {
+        double bytes = Measure([&] { rgba32.Clone(PixelDataFormat::RGBA32, conversion); });
+        double floats = Measure([&] { rgbaFloat.Clone(PixelDataFormat::RGBA32, conversion); });
+
+        Report(std::format("RGBA32 -> RGBA32, {}", name), megapixels / bytes, "MPix/s");
+        Report(std::format("RGBAFloat -> RGBA32, {}", name), megapixels / floats, "MPix/s");
+    }
+
+    double flip = Measure([&] { rgba32.FlipVertically(); });
+    Report("RGBA32 vertical flip", megapixels / flip, "MPix/s");
+}
+
+static BenchmarkRegistration pixelBenchmark("pixels", &BenchmarkPixels);
+
+// Builds every texture in the test app's sources the way TextureImporter
+// does, uncompressed and for both compression targets. Sizes are compared
+// with what loading the source used to upload: full RGBA32 images, with
+// mips the GPU generated.
+static void BenchmarkTextures()
+{
+    auto sourceDir = App::Get()->GetAssetLibrary()->GetRootDir() / "source";
+
+    std::vector<Image> images;
+    std::size_t sourceBytes = 0;
+    double megapixels = 0;
+
+    for (auto& entry : std::filesystem::recursive_directory_iterator(sourceDir.c_str()))
+    {
+        auto ext = entry.path().extension().string();
+        if (ext != ".png" && ext != ".jpg" && ext != ".tga")
+            continue;
+
+        images.emplace_back(entry.path());
+        sourceBytes += entry.file_size();
+
+        auto size = images.back().GetSize();
+        megapixels += size.x * size.y / 1e6;
+    }
+
+    // a full mip chain adds a third to the top level
+    double uploadedBytes = megapixels * 1e6 * 4 * 4 / 3;
+
+    Report("textures", (double)images.size(), "");
+    Report("source files", sourceBytes / 1048576.0, "MB");
+    Report("RGBA32 with GPU mips", uploadedBytes / 1048576.0, "MB");
+
+    std::pair<const char*, TextureBuildSettings> builds[] = {
+        { "uncompressed", { .compress = false } },
+        { "BC", { .target = TextureCompressionTarget::BC } },
+        { "ETC2", { .target = TextureCompressionTarget::ETC2 } },
+    };
+
+    for (auto& [name, settings] : builds)
+    {
+        double seconds = 0;
+        std::size_t builtBytes = 0;
+
+        for (auto& image : images)
+        {
+            TextureData data;
+            seconds += Time([&] { data = TextureData::Build(image, settings); });
+            builtBytes += data.GetByteCount();
+        }
+
+        Report(std::format("{} build", name), megapixels / seconds, "MPix/s");
+        Report(std::format("{} size", name), builtBytes / 1048576.0, "MB");
+        Report(std::format("{} size reduction", name), uploadedBytes / builtBytes, "x");
+    }
+}
+
+static BenchmarkRegistration textureBenchmark("textures", &BenchmarkTextures);
+
+} // Test
@@ -0,0 +1,475 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Test.Benchmark;
+import Microwave;
+import <cmath>;
+import <algorithm>;
+import <format>;
+import <optional>;
+import <random>;
+import <utility>;
+import <vector>;
+
+using namespace mw;
+
+namespace Test {
+
+// a node with a rigid body, which the caller adds colliders to
+static gptr<Node> AddBody(const gptr<Scene>& scene, const Vec3& position, BodyType bodyType)
+{
+    auto node = scene->GetRootNode()->AddChild();
+    node->SetPosition(position);
+
+    auto body = node->AddComponent<RigidBody>();
+    body->SetBodyType(bodyType);
+
+    return node;
+}
+
+// a static box the size of 'extents' * 2, whose top is at y = 0
+static gptr<Node> AddGround(const gptr<Scene>& scene, const Vec3& extents)
+{
+    auto ground = AddBody(scene, Vec3(0, -extents.y, 0), BodyType::Static);
+    ground->AddComponent<BoxCollider>()->SetExtents(extents);
+    return ground;
+}
+
+// Runs the scene's first update, which builds the shapes of its bodies,
+// and returns the seconds it took apart from stepping the simulation.
+static double LoadPhysicsScene(const gptr<Scene>& scene)
+{
+    double seconds = Time([&] { scene->Update(); });
+    return seconds - scene->GetPhysics()->GetStats().stepTime;
+}
+
+// Steps the simulation 'steps' times, one step at a time, and returns the
+// average PhysicsStats::stepTime.
+static double StepPhysicsScene(const gptr<Scene>& scene, int steps)
+{
+    auto physics = scene->GetPhysics();
+    float stepTime = 1.0f / physics->GetSettings().stepRate;
+
+    double total = 0;
+
+    for (int i = 0; i < steps; ++i)
+    {
+        physics->StepSimulation(stepTime);
+        total += physics->GetStats().stepTime;
+    }
+
+    return total / steps;
+}
+
+// the surface of a lumpy rock with a radius around 0.5, in direction 'dir'
+static Vec3 GetRockPoint(const Vec3& dir)
+{
+    float bumps = std::sin(dir.x * 7.0f) * std::cos(dir.z * 5.0f) + std::sin(dir.y * 6.0f);
+    return dir * (0.5f + bumps * 0.05f);
+}
+
+// a rock with rings * segments vertices, the size of a detailed scanned prop
+static gptr<Mesh> CreateRockMesh(int rings, int segments)
+{
+    auto mesh = gpnew<Mesh>();
+    mesh->SetName("Rock");
+
+    for (int r = 0; r < rings; ++r)
+    {
+        float polar = Pi * (r + 0.5f) / rings;
+
+        for (int s = 0; s < segments; ++s)
+        {
+            float azimuth = TwoPi * s / segments;
+            Vec3 dir(std::sin(polar) * std::cos(azimuth), std::cos(polar), std::sin(polar) * std::sin(azimuth));
+            mesh->vertices.push_back(GetRockPoint(dir));
+        }
+    }
+
+    MeshElement element;
+
+    for (int r = 0; r < rings - 1; ++r)
+    {
+        for (int s = 0; s < segments; ++s)
+        {
+            int i = r * segments + s;
+            int j = r * segments + (s + 1) % segments;
+            element.indices.insert(element.indices.end(), { i, i + segments, j, j, i + segments, j + segments });
+        }
+    }
+
+    mesh->elements.push_back(std::move(element));
+    mesh->RecalcBounds();
+
+    return mesh;
+}
+
+// Points of the rock in 'count' directions spread evenly over a sphere,
+// which is what ModelImporter bakes into Mesh::collisionHull.
+static std::vector<Vec3> CreateRockHull(int count)
+{
+    std::vector<Vec3> hull;
+    float goldenAngle = Pi * (3.0f - std::sqrt(5.0f));
+
+    for (int i = 0; i < count; ++i)
+    {
+        float y = 1.0f - 2.0f * (i + 0.5f) / count;
+        float radius = std::sqrt(1.0f - y * y);
+        float angle = goldenAngle * i;
+        hull.push_back(GetRockPoint(Vec3(std::cos(angle) * radius, y, std::sin(angle) * radius)));
+    }
+
+    return hull;
+}
+
+// a static grid of side * side vertices, to collide with as triangles
+static gptr<Mesh> CreateTerrainMesh(int side, float size)
+{
+    auto mesh = gpnew<Mesh>();
+    mesh->SetName("Terrain");
+
+    for (int z = 0; z < side; ++z)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            float u = (float)x / (side - 1) - 0.5f;
+            float v = (float)z / (side - 1) - 0.5f;
+            float height = std::sin(u * 40.0f) * std::cos(v * 40.0f) * 0.25f;
+            mesh->vertices.push_back(Vec3(u * size, height, v * size));
+        }
+    }
+
+    MeshElement element;
+
+    for (int z = 0; z < side - 1; ++z)
+    {
+        for (int x = 0; x < side - 1; ++x)
+        {
+            int i = z * side + x;
+            element.indices.insert(element.indices.end(), { i, i + side, i + 1, i + 1, i + side, i + side + 1 });
+        }
+    }
+
+    mesh->elements.push_back(std::move(element));
+    mesh->RecalcBounds();
+
+    return mesh;
+}
+
+// Loads 400 rocks with 20k vertex mesh colliders and drops them on the
+// ground. Each rock used to build a hull over every vertex of its own
+// mesh, which is measured by giving each one its own copy with a full
+// hull. Shared meshes are measured with the hull reduced at load, and
+// baked like ModelImporter does. Last, the rocks drop on a 130k triangle
+// concave terrain, whose tree is built at load, like any mesh that wasn't
+// imported from a model.
+static void BenchmarkCollisionShapes()
+{
+    constexpr int RockCount = 400;
+    constexpr int RowLength = 20;
+    constexpr int Steps = 120;
+
+    auto rockMesh = CreateRockMesh(100, 200);
+
+    auto bakedMesh = gpnew<Mesh>();
+    bakedMesh->vertices = rockMesh->vertices;
+    bakedMesh->elements = rockMesh->elements;
+    bakedMesh->collisionHull = CreateRockHull(64);
+    bakedMesh->RecalcBounds();
+
+    Report("rock vertices", (double)rockMesh->vertices.size(), "");
+
+    enum class Shapes { FullHulls, ReducedAtLoad, Baked, Terrain };
+
+    std::pair<const char*, Shapes> cases[] = {
+        { "per-collider full hulls", Shapes::FullHulls },
+        { "shared hull reduced at load", Shapes::ReducedAtLoad },
+        { "shared baked hull", Shapes::Baked },
+        { "baked hull on concave terrain", Shapes::Terrain },
+    };
+
+    for (auto& [name, shapes] : cases)
+    {
+        auto scene = gpnew<Scene>();
+
+        if (shapes == Shapes::Terrain)
+        {
+            auto collider = AddBody(scene, Vec3(0, 0, 0), BodyType::Static)->AddComponent<MeshCollider>();
+            collider->SetMesh(CreateTerrainMesh(256, 60.0f));
+            collider->SetConvex(false);
+        }
+        else
+        {
+            AddGround(scene, Vec3(30, 1, 30));
+        }
+
+        for (int i = 0; i < RockCount; ++i)
+        {
+            int x = i % RowLength;
+            int z = i / RowLength;
+
+            auto node = AddBody(scene, Vec3(x * 1.2f - 12, 1, z * 1.2f - 12), BodyType::Dynamic);
+            auto collider = node->AddComponent<MeshCollider>();
+
+            if (shapes == Shapes::FullHulls)
+            {
+                // the hull is all that's used, so the vertices aren't copied
+                auto mesh = gpnew<Mesh>();
+                mesh->collisionHull = rockMesh->vertices;
+                collider->SetMesh(mesh);
+            }
+            else if (shapes == Shapes::ReducedAtLoad)
+            {
+                collider->SetMesh(rockMesh);
+            }
+            else
+            {
+                collider->SetMesh(bakedMesh);
+            }
+        }
+
+        double load = LoadPhysicsScene(scene);
+        double step = StepPhysicsScene(scene, Steps);
+
+        Report(std::format("{} load", name), load * 1000, "ms");
+        Report(std::format("{} step", name), step * 1000, "ms");
+    }
+}
+
+static BenchmarkRegistration collisionShapeBenchmark("collision shapes", &BenchmarkCollisionShapes);
+
+// Casts 10k rays a frame down into the test level, from random points
+// above it in random directions, one at a time and as a batch split
+// across the JobSystem's workers.
+static void BenchmarkRaycast()
+{
+    constexpr int RayCount = 10000;
+
+    auto scene = gpnew<Scene>();
+    auto levelModel = App::Get()->GetAssetLibrary()->GetAsset<Node>("Models/Level01.fbx");
+    if (!levelModel)
+        throw Exception("Models/Level01.fbx is not imported");
+
+    scene->GetRootNode()->AddChild(Instantiate<Node>(levelModel));
+    LoadPhysicsScene(scene);
+
+    auto bodies = scene->GetRootNode()->FindChildren(
+        [](const gptr<Node>& node) { return node->GetComponent<RigidBody>() != nullptr; });
+
+    if (bodies.empty())
+        throw Exception("the test level has no rigid bodies");
+
+    Vec3 boundsMin = bodies[0]->GetPosition();
+    Vec3 boundsMax = boundsMin;
+
+    for (auto& body : bodies)
+    {
+        auto pos = body->GetPosition();
+        boundsMin = Vec3(std::min(boundsMin.x, pos.x), std::min(boundsMin.y, pos.y), std::min(boundsMin.z, pos.z));
+        boundsMax = Vec3(std::max(boundsMax.x, pos.x), std::max(boundsMax.y, pos.y), std::max(boundsMax.z, pos.z));
+    }
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<RaycastQuery> queries(RayCount);
+
+    for (auto& query : queries)
+    {
+        Vec3 origin(
+            boundsMin.x + (boundsMax.x - boundsMin.x) * unit(random),
+            boundsMax.y + 10.0f,
+            boundsMin.z + (boundsMax.z - boundsMin.z) * unit(random));
+
+        Vec3 dir(unit(random) - 0.5f, -1.0f, unit(random) - 0.5f);
+        query.ray = Ray(origin, dir.Normalized());
+    }
+
+    auto physics = scene->GetPhysics();
+    std::vector<std::optional<RaycastHit>> hits(RayCount);
+
+    double serial = Measure([&] {
+        for (int i = 0; i < RayCount; ++i)
+            hits[i] = physics->Raycast(queries[i].ray, queries[i].maxDistance, queries[i].layers);
+    });
+
+    double batched = Measure([&] {
+        physics->Raycast(queries, hits);
+    });
+
+    auto hitCount = std::count_if(hits.begin(), hits.end(),
+        [](const std::optional<RaycastHit>& hit) { return hit.has_value(); });
+
+    Report("bodies", (double)physics->GetBodyCount(), "");
+    Report("rays hit", 100.0 * hitCount / RayCount, "%");
+    Report("one at a time", serial * 1000, "ms per frame");
+    Report("one at a time", RayCount / serial / 1000, "rays per ms");
+    Report("batched", batched * 1000, "ms per frame");
+    Report("batched", RayCount / batched / 1000, "rays per ms");
+    Report("batched speedup", serial / batched, "x");
+}
+
+static BenchmarkRegistration raycastBenchmark("raycast", &BenchmarkRaycast);
+
+// 'count' unit boxes in layers of 50 x 50 just above the ground, with 'layers' on their nodes
+static void AddBoxes(const gptr<Scene>& scene, int count, LayerMask layers = LayerMask::Default)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        int x = i % 50;
+        int z = i / 50 % 50;
+        int y = i / 2500;
+
+        auto node = AddBody(scene, Vec3(x * 1.5f - 37, 1 + y * 1.2f, z * 1.5f - 37), BodyType::Dynamic);
+        node->AddComponent<BoxCollider>()->SetExtents(Vec3(0.5f, 0.5f, 0.5f));
+        node->SetLayerMask(layers);
+    }
+}
+
+// Drops 5000 boxes on the ground and steps them 120 times, single threaded
+// and on the JobSystem, reporting the steps per second each manages.
+static void BenchmarkPhysicsStep()
+{
+    constexpr int BoxCount = 5000;
+    constexpr int Steps = 120;
+
+    auto defaultSettings = PhysicsWorld::GetDefaultSettings();
+
+    for (bool multithreaded : { false, true })
+    {
+        // a scene's world is created with the default settings
+        auto settings = defaultSettings;
+        settings.multithreaded = multithreaded;
+        PhysicsWorld::SetDefaultSettings(settings);
+
+        auto scene = gpnew<Scene>();
+        PhysicsWorld::SetDefaultSettings(defaultSettings);
+
+        AddGround(scene, Vec3(200, 1, 200));
+        AddBoxes(scene, BoxCount);
+        LoadPhysicsScene(scene);
+
+        double step = StepPhysicsScene(scene, Steps);
+        auto name = multithreaded ? "multithreaded" : "single threaded";
+
+        Report(name, 1.0 / step, "steps/s");
+        Report(std::format("{} moved bodies", name), (double)scene->GetPhysics()->GetStats().movedBodies, "");
+    }
+}
+
+static BenchmarkRegistration physicsStepBenchmark("physics step", &BenchmarkPhysicsStep);
+
+// Piles 5000 overlapping debris boxes on the ground and steps them for a
+// second, with debris colliding with itself, and with debris-vs-debris
+// turned off in the layer matrix. The first world then turns it off too,
+// to show pairs dropping without bodies being re-added.
+static void BenchmarkLayerFilter()
+{
+    constexpr int BoxCount = 5000;
+    constexpr int Steps = 60;
+    constexpr auto Debris = (LayerMask)(1u << 2);
+
+    for (bool debrisCollides : { true, false })
+    {
+        auto scene = gpnew<Scene>();
+        auto physics = scene->GetPhysics();
+        physics->SetLayerCollision(Debris, Debris, debrisCollides);
+
+        AddGround(scene, Vec3(200, 1, 200));
+
+        for (int i = 0; i < BoxCount; ++i)
+        {
+            int x = i % 25;
+            int z = i / 25 % 25;
+            int y = i / 625;
+
+            auto node = AddBody(scene, Vec3(x * 0.9f - 11, 0.5f + y * 0.9f, z * 0.9f - 11), BodyType::Dynamic);
+            node->AddComponent<BoxCollider>()->SetExtents(Vec3(0.5f, 0.5f, 0.5f));
+            node->SetLayerMask(Debris);
+        }
+
+        LoadPhysicsScene(scene);
+        double step = StepPhysicsScene(scene, Steps);
+
+        auto name = debrisCollides ? "debris-vs-debris on" : "debris-vs-debris off";
+        auto stats = physics->GetStats();
+
+        Report(std::format("{} pairs", name), (double)stats.pairs, "");
+        Report(std::format("{} manifolds", name), (double)stats.manifolds, "");
+        Report(std::format("{} step", name), step * 1000, "ms");
+
+        if (debrisCollides)
+        {
+            physics->SetLayerCollision(Debris, Debris, false);
+            StepPhysicsScene(scene, 1);
+
+            Report("turned off in place, pairs", (double)physics->GetStats().pairs, "");
+        }
+    }
+}
+
+static BenchmarkRegistration layerFilterBenchmark("layer filter", &BenchmarkLayerFilter);
+
+// counts the collision events its body receives
+class CollisionCounter : public Script
+                       , public ICollisionEvents
+{
+public:
+    int events = 0;
+
+    virtual void OnCollisionStart(const Collision& collision) override { ++events; }
+    virtual void OnCollisionUpdate(const Collision& collision) override { ++events; }
+    virtual void OnCollisionStop(const Collision& collision) override { ++events; }
+};
+
+// Settles 2000 boxes on the ground, for 2000 resting contacts, then steps
+// them with no collision handlers, and with a handler on every body. Time
+// outside of PhysicsStats::stepTime is spent tracking and delivering events.
+static void BenchmarkCollisionEvents()
+{
+    constexpr int BoxCount = 2000;
+    constexpr int SettleSteps = 180;
+    constexpr int Steps = 120;
+
+    for (bool handlers : { false, true })
+    {
+        auto scene = gpnew<Scene>();
+        auto physics = scene->GetPhysics();
+
+        AddGround(scene, Vec3(200, 1, 200));
+        AddBoxes(scene, BoxCount);
+
+        if (handlers)
+        {
+            for (auto& node : scene->GetRootNode()->GetChildren())
+                node->AddComponent<CollisionCounter>();
+        }
+
+        LoadPhysicsScene(scene);
+        StepPhysicsScene(scene, SettleSteps);
+
+        float stepTime = 1.0f / physics->GetSettings().stepRate;
+        double total = 0;
+        double stepping = 0;
+        int events = 0;
+
+        for (int i = 0; i < Steps; ++i)
+        {
+            total += Time([&] { physics->StepSimulation(stepTime); });
+            stepping += physics->GetStats().stepTime;
+            events += physics->GetStats().collisionEvents;
+        }
+
+        auto name = handlers ? "handlers on every body" : "no handlers";
+
+        Report(std::format("{} manifolds", name), (double)physics->GetStats().manifolds, "");
+        Report(std::format("{} events", name), (double)events / Steps, "per step");
+        Report(std::format("{} step", name), stepping / Steps * 1e6, "us");
+        Report(std::format("{} collision tracking", name), (total - stepping) / Steps * 1e6, "us");
+    }
+}
+
+static BenchmarkRegistration collisionEventBenchmark("collision events", &BenchmarkCollisionEvents);
+
+} // Test
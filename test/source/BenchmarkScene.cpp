@@ -0,0 +1,278 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Test.Benchmark;
+import Microwave;
+import <array>;
+import <cmath>;
+import <span>;
+import <vector>;
+
+using namespace mw;
+
+namespace Test {
+
+static gptr<Mesh> CreateCubeMesh()
+{
+    auto mesh = gpnew<Mesh>();
+
+    for (int i = 0; i < 8; ++i)
+    {
+        Vec3 corner((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+        mesh->vertices.push_back(corner * 0.5f);
+        mesh->normals.push_back(corner.Normalized());
+    }
+
+    MeshElement element;
+    element.indices = {
+        0, 2, 1, 1, 2, 3,  4, 5, 6, 5, 7, 6,
+        0, 1, 4, 1, 5, 4,  2, 6, 3, 3, 6, 7,
+        0, 4, 2, 2, 4, 6,  1, 3, 5, 3, 7, 5
+    };
+
+    mesh->elements.push_back(std::move(element));
+    mesh->RecalcBounds();
+    mesh->UpdateBuffers();
+
+    return mesh;
+}
+
+// A camera at (0, 0, -cameraDistance) looking down +Z at a square grid of
+// 'boxCount' boxes in the XY plane, 'spacing' apart. Boxes cycle through
+// 'materialCount' materials, which cycle through 'shaderCount' shaders, so
+// neighbouring boxes never share state unless the renderer sorts them.
+static gptr<Scene> CreateBoxScene(
+    int boxCount, int shaderCount, int materialCount, float spacing, float cameraDistance)
+{
+    auto scene = gpnew<Scene>();
+    auto root = scene->GetRootNode();
+
+    auto cameraNode = root->AddChild();
+    cameraNode->SetPosition(0, 0, -cameraDistance);
+    auto camera = cameraNode->AddComponent<Camera>();
+    camera->SetMode(CameraViewMode::Perspective);
+    camera->SetFarPlane(cameraDistance * 2);
+
+    gvector<gptr<Shader>> shaders;
+    for (int i = 0; i < shaderCount; ++i)
+        shaders.push_back(gpnew<Shader>(ColorShaderSource));
+
+    gvector<gptr<Material>> materials;
+    for (int i = 0; i < materialCount; ++i)
+    {
+        auto material = gpnew<Material>();
+        material->shader = shaders[i % shaderCount];
+        material->SetUniform("uColor", Color((float)i / materialCount, 0.5f, 0.5f, 1.0f));
+        materials.push_back(material);
+    }
+
+    auto mesh = CreateCubeMesh();
+    int side = (int)std::ceil(std::sqrt((float)boxCount));
+    float offset = (side - 1) * spacing * 0.5f;
+
+    for (int i = 0; i < boxCount; ++i)
+    {
+        auto node = root->AddChild();
+        node->SetPosition((i % side) * spacing - offset, (i / side) * spacing - offset, 0);
+
+        auto renderer = node->AddComponent<MeshRenderer>();
+        renderer->mesh = mesh;
+        renderer->materials.push_back(materials[i % materialCount]);
+    }
+
+    return scene;
+}
+
+// Renders 10k boxes that alternate between 4 shaders and 32 materials into
+// a null context, and reports the driver work each frame submits. Applied
+// versus redundant changes show what the state cache skips.
+static void BenchmarkRender()
+{
+    HeadlessGraphics headless;
+    auto& graphics = headless.graphics;
+
+    auto scene = CreateBoxScene(10000, 4, 32, 2.0f, 250.0f);
+    auto renderer = gpnew<SceneRenderer>();
+
+    double frame = Measure([&] {
+        graphics->ResetStats();
+        renderer->Render(scene);
+    });
+
+    auto& stats = graphics->GetStats();
+
+    Report("frame", frame * 1000, "ms");
+    Report("draw calls", stats.drawCalls, "per frame");
+    Report("shader changes", stats.shaderChanges, "per frame");
+    Report("buffer changes", stats.bufferChanges, "per frame");
+    Report("texture changes", stats.textureChanges, "per frame");
+    Report("render state changes", stats.stateChanges, "per frame");
+    Report("redundant changes skipped", stats.redundantChanges, "per frame");
+}
+
+static BenchmarkRegistration renderBenchmark("render", &BenchmarkRender);
+
+// Culls 50k boxes, about a third of which are in view. The single box
+// tests compare the old 8-corner test against the center/extents one on
+// one thread; the frame figures come from the renderer's parallel pass.
+static void BenchmarkCulling()
+{
+    constexpr int BoxCount = 50000;
+
+    HeadlessGraphics headless;
+
+    auto scene = CreateBoxScene(BoxCount, 1, 1, 3.0f, 300.0f);
+    auto root = scene->GetRootNode();
+    auto camera = root->GetChild(0)->GetComponent<Camera>();
+
+    std::vector<AABox> bounds;
+    for (int i = 1; i <= BoxCount; ++i)
+        bounds.push_back(root->GetChild(i)->GetComponent<MeshRenderer>()->GetBounds());
+
+    int visible = 0;
+
+    double corners = Measure([&] {
+        visible = 0;
+        for (auto& box : bounds)
+        {
+            std::array<Vec3, 8> verts;
+            box.GetCorners(verts);
+            visible += camera->CanSee(std::span<Vec3>(verts));
+        }
+    });
+
+    double extents = Measure([&] {
+        visible = 0;
+        for (auto& box : bounds)
+            visible += camera->CanSee(box);
+    });
+
+    auto renderer = gpnew<SceneRenderer>();
+    double cullTime = 0;
+    int frames = 0;
+
+    double frame = Measure([&] {
+        renderer->Render(scene);
+        cullTime += renderer->GetStats().cullTime;
+        ++frames;
+    });
+
+    auto& stats = renderer->GetStats();
+
+    Report("visible boxes", visible, "");
+    Report("8 corner test", BoxCount / corners / 1000, "culls per ms");
+    Report("center/extents test", BoxCount / extents / 1000, "culls per ms");
+    Report("renderer cull pass", stats.renderables * frames / cullTime / 1000, "culls per ms");
+    Report("frame", frame * 1000, "ms");
+}
+
+static BenchmarkRegistration cullingBenchmark("culling", &BenchmarkCulling);
+
+// Spawns a 500+ node prefab made of copies of the BigDoors model, whose
+// renderers reference imported meshes and materials. Native cloning is
+// compared with the json round trip Instantiate used to do.
+static void BenchmarkInstantiate()
+{
+    auto assetLibrary = App::Get()->GetAssetLibrary();
+    auto model = assetLibrary->GetAsset<Node>("Models/BigDoors.fbx");
+    if (!model)
+        throw Exception("Models/BigDoors.fbx is not imported");
+
+    auto countNodes = [](const gptr<Node>& root)
+    {
+        gvector<gptr<Node>> nodes;
+        root->FindChildren(nodes, [](const gptr<Node>&) { return true; });
+        return nodes.size() + 1;
+    };
+
+    auto prefab = gpnew<Node>();
+    while (countNodes(prefab) < 500)
+        prefab->AddChild(Instantiate<Node>(model));
+
+    double native = Measure([&] {
+        Instantiate<Node>(prefab);
+    });
+
+    double viaJson = Measure([&] {
+        json obj;
+        prefab->ToJson(obj);
+
+        ObjectLinker linker;
+        auto copy = Object::CreateFromJson<Node>(obj, &linker);
+        ObjectLinker::Link(&linker);
+    });
+
+    Report("prefab nodes", (double)countNodes(prefab), "");
+    Report("native clone", 1 / native, "spawns per second");
+    Report("json round trip", 1 / viaJson, "spawns per second");
+}
+
+static BenchmarkRegistration instantiateBenchmark("instantiate", &BenchmarkInstantiate);
+
+// Builds a 100k-node 8-ary tree and animates the root's children every
+// frame, which dirties the whole tree. Resolving each node's matrix from
+// its getter walks up through the dirty parents the way the old recursive
+// path did; the batched pass resolves them all in order in one sweep.
+static void BenchmarkTransforms()
+{
+    constexpr std::size_t NodeCount = 100000;
+    constexpr std::size_t Branching = 8;
+
+    auto& store = TransformStore::GetInstance();
+
+    gvector<gptr<Node>> nodes;
+    nodes.reserve(NodeCount);
+    nodes.push_back(gpnew<Node>());
+
+    for (std::size_t i = 1; i < NodeCount; ++i)
+    {
+        auto child = nodes[(i - 1) / Branching]->AddChild();
+        child->SetLocalPosition(1.0f, 0.0f, 0.0f);
+        nodes.push_back(child);
+    }
+
+    float angle = 0;
+
+    auto animate = [&]
+    {
+        angle += 0.01f;
+
+        for (std::size_t i = 1; i <= Branching; ++i)
+            nodes[i]->SetLocalRotation(Quat(0, angle, 0));
+    };
+
+    Mat4 sum;
+
+    double lazy = Measure([&] {
+        animate();
+        for (auto& node : nodes)
+            sum = node->GetLocalToWorldMatrix();
+    });
+
+    double serial = Measure([&] {
+        animate();
+        store.UpdateWorldTransforms(false);
+        for (auto& node : nodes)
+            sum = node->GetLocalToWorldMatrix();
+    });
+
+    double parallel = Measure([&] {
+        animate();
+        store.UpdateWorldTransforms(true);
+        for (auto& node : nodes)
+            sum = node->GetLocalToWorldMatrix();
+    });
+
+    auto stats = store.GetStats();
+
+    Report("lazy per-node resolve", lazy * 1000, "ms per frame");
+    Report("batched pass", serial * 1000, "ms per frame");
+    Report("batched pass, parallel", parallel * 1000, "ms per frame");
+    Report("transforms updated per pass", (double)stats.updated, "");
+    Report("live transforms", (double)stats.slots, "");
+}
+
+static BenchmarkRegistration transformBenchmark("transforms", &BenchmarkTransforms);
+
+} // Test
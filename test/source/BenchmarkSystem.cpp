@@ -0,0 +1,95 @@
+/*--------------------------------------------------------------*
+*  Copyright (c) 2022 Nicolas Jinchereau. All rights reserved.  *
+*--------------------------------------------------------------*/
+
+module Test.Benchmark;
+import Microwave;
+import <algorithm>;
+import <chrono>;
+import <format>;
+import <thread>;
+import <vector>;
+
+using namespace mw;
+
+namespace Test {
+
+// Posts timers spread over the next hour, cancels every other one, then
+// runs a burst of immediate actions through Run().
+static void BenchmarkDispatcher()
+{
+    constexpr int TimerCount = 200000;
+    constexpr int ActionCount = 200000;
+
+    auto dispatcher = gpnew<Dispatcher>();
+    auto now = std::chrono::steady_clock::now();
+
+    gvector<gptr<DispatchAction>> timers;
+    timers.reserve(TimerCount);
+
+    double postTime = Time([&] {
+        for (int i = 0; i < TimerCount; ++i)
+            timers.push_back(dispatcher->InvokeAsync([] {}, now + std::chrono::hours(1) + std::chrono::microseconds(i)));
+    });
+
+    double cancelTime = Time([&] {
+        for (int i = 0; i < TimerCount; i += 2)
+            dispatcher->Cancel(timers[i]);
+    });
+
+    int invoked = 0;
+
+    double runTime = Time([&] {
+        for (int i = 0; i < ActionCount; ++i)
+            dispatcher->InvokeAsync([&] { ++invoked; });
+
+        dispatcher->InvokeAsync([&] { dispatcher->Quit(); });
+        dispatcher->Run();
+    });
+
+    Report("timer posts", TimerCount / postTime / 1000, "per ms");
+    Report("timer cancels", TimerCount / 2 / cancelTime / 1000, "per ms");
+    Report("immediate actions posted and run", invoked / runTime / 1000, "per ms");
+}
+
+static BenchmarkRegistration dispatcherBenchmark("dispatcher", &BenchmarkDispatcher);
+
+// Runs a ParallelFor with one tiny job per index on 1, 2, 4... workers, up
+// to one per core, and reports how many jobs each configuration gets through.
+static void BenchmarkJobSystem()
+{
+    constexpr std::size_t JobCount = 100000;
+
+    int maxWorkers = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+
+    std::vector<int> workerCounts;
+    for (int count = 1; count < maxWorkers; count *= 2)
+        workerCounts.push_back(count);
+    workerCounts.push_back(maxWorkers);
+
+    for (int workerCount : workerCounts)
+    {
+        JobSystem jobs(workerCount);
+        std::vector<std::uint32_t> values(JobCount);
+
+        auto before = jobs.GetStats();
+
+        double seconds = Measure([&] {
+            jobs.ParallelFor(JobCount, 1, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i)
+                    values[i] = (std::uint32_t)i * 2654435761u;
+            });
+        });
+
+        auto after = jobs.GetStats();
+        auto executed = after.executed - before.executed;
+        auto stolen = after.stolen - before.stolen;
+
+        Report(std::format("{} workers", workerCount), JobCount / seconds / 1000, "jobs per ms");
+        Report(std::format("{} workers stolen", workerCount), 100.0 * stolen / std::max<std::uint64_t>(executed, 1), "%");
+    }
+}
+
+static BenchmarkRegistration jobSystemBenchmark("jobs", &BenchmarkJobSystem);
+
+} // Test
@@ -3,6 +3,7 @@
 *--------------------------------------------------------------*/
 
 import Microwave;
+import Test.Benchmark;
 import Test.Game;
 import <iostream>;
 import <memory>;
@@ -51,9 +52,17 @@ public:
 
             bool forceImport = false;
             auto assetDatabase = gpnew<AssetDatabase>(assetLibrary);
+            assetDatabase->SetImportOptions(GetArgs());
             assetDatabase->Refresh(forceImport);
             assetDatabase.reset();
 
+            // '--benchmark [name]' measures the engine and quits instead of starting the game
+            if (RunBenchmarks(GetArgs()))
+            {
+                Dispatcher::GetCurrent()->InvokeAsync([] { Dispatcher::GetCurrent()->Quit(); });
+                return;
+            }
+
             // set up scene
             scene = gpnew<Scene>();
             scene->GetRootNode()->AddChild()->AddComponent<Game>();
@@ -30,7 +30,8 @@ function configure_project_common()
             "_CRT_SECURE_NO_WARNINGS",
             "_CRT_SECURE_NO_DEPRECATE",
             "_SCL_SECURE_NO_WARNINGS",
-            "NO_OPENGL3"
+            "NO_OPENGL3",
+            "BT_THREADSAFE=1"
         }
 
     filter "configurations:Debug"
@@ -17,7 +17,6 @@ project "graph-collector"
         "src/gc/gc.h",
         "src/gc/detail/compressed_pair.h",
         "src/gc/detail/functor.h",
-        "src/gc/detail/intrusive_list.h",
         "src/gc/detail/vector.h"
     }
 
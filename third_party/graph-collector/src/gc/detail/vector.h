@@ -335,7 +335,7 @@ public:
 
     void pop_back() {
         assert(!empty());
-        std::destroy_at(mLast--);
+        std::destroy_at(--mLast);
     }
 
     void clear() {
@@ -346,7 +346,7 @@ public:
     void swap(vector& right) {
         std::swap(mFirst, right.mFirst);
         std::swap(mLast, right.mLast);
-        std::swap(mEnd, right.MEnd);
+        std::swap(mEnd, right.mEnd);
     }
 
     void resize(size_t newSize) {
@@ -525,7 +525,7 @@ public:
     }
 
     const T& at(size_t pos) const {
-        return const_cast<vector<T>>(this)->at(pos);
+        return const_cast<vector<T>*>(this)->at(pos);
     }
 
     T& operator[](size_t pos) {
@@ -533,7 +533,7 @@ public:
     }
 
     const T& operator[](size_t pos) const {
-        return const_cast<vector<T>>(this)->at(pos);
+        return const_cast<vector<T>*>(this)->at(pos);
     }
 
     T& front() {
@@ -542,7 +542,7 @@ public:
     }
 
     const T& front() const {
-        return const_cast<vector<T>>(this)->front();
+        return const_cast<vector<T>*>(this)->front();
     }
 
     T& back() {
@@ -551,7 +551,7 @@ public:
     }
 
     const T& back() const {
-        return const_cast<vector<T>>(this)->back();
+        return const_cast<vector<T>*>(this)->back();
     }
 
 private:
@@ -614,6 +614,9 @@ private:
             }
 
             std::destroy(mFirst, mLast);
+        }
+
+        if (mFirst) {
             dealloc(mFirst);
         }
 
@@ -17,13 +17,101 @@ graph* graph::That::operator->() {
 
 graph::That graph::that;
 
+struct free_cell
+{
+    free_cell* next;
+};
+
+// Only the thread using the owner shard allocates from a slab, and returns
+// cells to 'freeCells'. Other threads push the cells they free onto
+// 'remoteCells', which the owner takes back when it runs out of free cells.
+struct slab_header
+{
+    pointer_shard* owner;
+    slab_header* prev; // in the owner's list of available or full slabs
+    slab_header* next;
+    free_cell* freeCells;
+    std::atomic<free_cell*> remoteCells;
+    uint32_t usedCells; // allocated cells, including those in 'remoteCells'
+    uint32_t sizeClass;
+    bool full;
+};
+
+struct pointer_shard
+{
+    std::mutex lock;
+    // Attached pointers are kept in arrays rather than linked through the
+    // pointers themselves, so the snapshot can load their values independently
+    // of each other instead of chasing a list through memory.
+    detail::vector<graph_ptr<void>*> pointers;
+    detail::vector<raw_graph_ptr<void>*> rawPointers;
+    bool inUse = false;
+
+    // objects adopted or retired while the graph was tracing
+    detail::vector<std::byte*> shaded;
+
+    // Slabs of each size class that still have free cells, starting with the
+    // one being allocated from, and slabs that had none left when last used.
+    // Only touched by the thread using the shard.
+    slab_header* slabs[graph::size_class_count] = {};
+    slab_header* fullSlabs[graph::size_class_count] = {};
+    std::atomic<ptrdiff_t> liveCells[graph::size_class_count] = {};
+};
+
+// The calling thread's shard. Kept in a trivially destructible thread_local,
+// so that it can still be read from the destructors of other thread_locals
+// after 'shard_owner' has released it.
+static thread_local pointer_shard* localShardPtr = nullptr;
+static thread_local bool localShardReleased = false;
+
+// Returns the calling thread's shard to the graph when the thread exits.
+// The shard itself is never freed, since pointers attached to it may outlive
+// the thread, so it's handed to the next thread that needs one instead.
+struct shard_owner
+{
+    bool owns = false;
+
+    ~shard_owner()
+    {
+        if (localShardPtr) {
+            graph::that->release_shard(localShardPtr);
+            localShardPtr = nullptr;
+        }
+
+        localShardReleased = true;
+    }
+};
+
+static thread_local shard_owner localShard;
+
+graph::shard_ref::shard_ref()
+    : shard(local_shard()), borrowed(!shard)
+{
+    if (borrowed)
+        shard = that->acquire_shard();
+}
+
+graph::shard_ref::~shard_ref()
+{
+    if (borrowed)
+        that->release_shard(shard);
+}
+
+graph::pointer_lock::pointer_lock()
+{
+    shard->lock.lock();
+}
+
+graph::pointer_lock::~pointer_lock() {
+    shard->lock.unlock();
+}
+
 graph::graph()
 {
-    ranges.reserve(100'000);
+    shards.reserve(64);
     rngs.reserve(100'000);
     info.reserve(100'000);
-    scan.reserve(100'000);
-    keep.reserve(100'000);
+    work.reserve(100'000);
 }
 
 graph::~graph()
@@ -31,240 +119,984 @@ graph::~graph()
     // orphan attached pointers
     // leak uncollected cycles
     // leak raw memory
+    // leak shards
+}
+
+pointer_shard* graph::acquire_shard()
+{
+    std::lock_guard lk(shardLock);
+
+    for (auto s : shards)
+    {
+        if (!s->inUse) {
+            s->inUse = true;
+            return s;
+        }
+    }
+
+    auto s = new pointer_shard();
+    s->inUse = true;
+    shards.push_back(s);
+    return s;
+}
+
+void graph::release_shard(pointer_shard* shard)
+{
+    trim_slabs(shard);
+
+    std::lock_guard lk(shardLock);
+    shard->inUse = false;
+}
+
+// Returns null once the thread has released its shard on exit.
+pointer_shard* graph::local_shard()
+{
+    if (!localShardPtr && !localShardReleased)
+    {
+        localShardPtr = that->acquire_shard();
+        localShard.owns = true; // registers the destructor that releases it
+    }
+
+    return localShardPtr;
+}
+
+// Removes a pointer from its shard by moving the last one into its slot.
+template<class P>
+void graph::unlink(detail::vector<P*>& pointers, P* gp)
+{
+    P* last = pointers.back();
+    pointers[gp->slot] = last;
+    last->slot = gp->slot;
+    pointers.pop_back();
 }
 
-void graph::attach(graph_ptr<void>* gp)
+void graph::attach(graph_ptr<void>* gp, bool adopted)
 {
-    std::lock_guard lk(graphLock);
-    pointers.push_back(const_cast<graph_ptr<void>*>(gp));
+    shard_ref s;
+    std::lock_guard lk(s->lock);
+    gp->shard = s.get();
+    gp->slot = (uint32_t)s->pointers.size();
+    s->pointers.push_back(gp);
+
+    if (adopted && that->tracing && gp->ptr)
+        s->shaded.push_back(static_cast<std::byte*>(gp->ptr.get()));
 }
 
 void graph::detach(graph_ptr<void>* gp)
 {
-    std::lock_guard lk(graphLock);
-    pointers.remove(const_cast<graph_ptr<void>*>(gp));
+    // may be a different shard than the calling thread's
+    // if the pointer was attached on another thread
+    pointer_shard* s = gp->shard;
+    std::lock_guard lk(s->lock);
+    unlink(s->pointers, gp);
+}
+
+// Called before an object created by 'make' is destroyed. Its pointers may be
+// in a pending snapshot, so it's recorded as reachable, which keeps the sweep
+// from moving values out of them while or after its destructor runs.
+void graph::retire(void* p)
+{
+    shard_ref s;
+    std::lock_guard lk(s->lock);
+
+    if (tracing)
+        s->shaded.push_back(static_cast<std::byte*>(p));
 }
 
 void graph::attach(raw_graph_ptr<void>* gp)
 {
-    std::lock_guard lk(graphLock);
-    rawPointers.push_back(const_cast<raw_graph_ptr<void>*>(gp));
+    shard_ref s;
+    std::lock_guard lk(s->lock);
+    gp->shard = s.get();
+    gp->slot = (uint32_t)s->rawPointers.size();
+    s->rawPointers.push_back(gp);
 }
 
 void graph::detach(raw_graph_ptr<void>* gp)
 {
-    std::lock_guard lk(graphLock);
-    rawPointers.remove(const_cast<raw_graph_ptr<void>*>(gp));
+    pointer_shard* s = gp->shard;
+    std::lock_guard lk(s->lock);
+    unlink(s->rawPointers, gp);
 }
 
-void graph::add_range(void* p, size_t size)
+range_stripe& graph::stripe_for(void* p)
 {
-    std::lock_guard lk(graphLock);
+    // fibonacci hashing spreads neighbouring allocations across stripes
+    uint64_t h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p)) * 0x9E3779B97F4A7C15ull;
+    return that->rangeStripes[h >> (64 - range_stripe_bits)];
+}
 
+void graph::add_range(void* p, size_t size, uint32_t cellSize)
+{
     std::byte* bp = static_cast<std::byte*>(p);
 
-    auto it = std::upper_bound(ranges.begin(), ranges.end(), bp,
-        [](std::byte* p, const memory_range& r) { return p < r.begin; });
-
-    ranges.insert(it, memory_range{ bp, bp + size });
+    range_stripe& stripe = stripe_for(p);
+    std::lock_guard lk(stripe.lock);
+    stripe.ranges.emplace(bp, range_entry{ bp + size, cellSize });
 }
 
 void graph::remove_range(void* p)
 {
-    std::lock_guard lk(graphLock);
+    range_stripe& stripe = stripe_for(p);
+    std::lock_guard lk(stripe.lock);
+    
+    [[maybe_unused]] size_t erased = stripe.ranges.erase(static_cast<std::byte*>(p));
+    assert(erased == 1);
+}
+
+int graph::size_class_for(size_t size, size_t align)
+{
+    if (align > cell_alignment)
+        return -1;
+
+    for (int i = 0; i != (int)size_class_count; ++i)
+    {
+        if (size <= size_class_cells[i])
+            return i;
+    }
+
+    return -1;
+}
+
+void* graph::allocate_block(size_t size, size_t align, bool pooled)
+{
+    int sizeClass = pooled ? size_class_for(size, align) : -1;
+
+    if (sizeClass < 0)
+    {
+        void* p = ::operator new(size, std::align_val_t(align));
+        that->add_range(p, size);
+        return p;
+    }
+
+    shard_ref shard;
+
+    void* p = that->allocate_cell(shard.get(), sizeClass);
+    shard->liveCells[sizeClass].fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+void graph::deallocate_block(void* p, size_t size, size_t align, bool pooled)
+{
+    int sizeClass = pooled ? size_class_for(size, align) : -1;
+
+    if (sizeClass < 0)
+    {
+        that->remove_range(p);
+        ::operator delete(p, std::align_val_t(align));
+        return;
+    }
+
+    // Cells go back to the slab they came from, so memory freed by one thread
+    // isn't stranded in another thread's free list, and empty slabs can be
+    // released. Nothing here needs a shard, since the calling thread may have
+    // already released its own on exit.
+    slab_header* slab = slab_of(p);
+    slab->owner->liveCells[sizeClass].fetch_sub(1, std::memory_order_relaxed);
+
+    if (slab->owner == localShardPtr)
+    {
+        that->release_cell(localShardPtr, slab, p);
+        return;
+    }
+
+    auto cell = static_cast<free_cell*>(p);
+    cell->next = slab->remoteCells.load(std::memory_order_relaxed);
+
+    while (!slab->remoteCells.compare_exchange_weak(
+        cell->next, cell, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+static void push_slab(slab_header*& list, slab_header* slab)
+{
+    // insert behind the first slab, which is the one being allocated from
+    slab_header* prev = list;
+    slab_header* next = list ? list->next : nullptr;
+
+    slab->prev = prev;
+    slab->next = next;
+
+    if (next)
+        next->prev = slab;
+
+    if (prev)
+        prev->next = slab;
+    else
+        list = slab;
+}
+
+static void remove_slab(slab_header*& list, slab_header* slab)
+{
+    if (slab->prev)
+        slab->prev->next = slab->next;
+    else
+        list = slab->next;
+
+    if (slab->next)
+        slab->next->prev = slab->prev;
+
+    slab->prev = nullptr;
+    slab->next = nullptr;
+}
+
+// Moves the cells freed by other threads back to the slab's own free list.
+static void take_remote_cells(slab_header* slab)
+{
+    free_cell* cells = slab->remoteCells.exchange(nullptr, std::memory_order_acquire);
+
+    while (cells)
+    {
+        free_cell* cell = cells;
+        cells = cell->next;
+        cell->next = slab->freeCells;
+        slab->freeCells = cell;
+        --slab->usedCells;
+    }
+}
+
+slab_header* graph::slab_of(void* p) {
+    return reinterpret_cast<slab_header*>(reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(slab_size - 1));
+}
+
+size_t graph::slab_header_size() {
+    return (sizeof(slab_header) + cell_alignment - 1) & ~(cell_alignment - 1);
+}
+
+void* graph::allocate_cell(pointer_shard* shard, int sizeClass)
+{
+    slab_header*& available = shard->slabs[sizeClass];
+
+    for (;;)
+    {
+        if (!available)
+        {
+            // take back exhausted slabs that had cells freed
+            // by other threads before creating a new one
+            slab_header*& full = shard->fullSlabs[sizeClass];
+
+            for (slab_header* slab = full; slab; )
+            {
+                slab_header* next = slab->next;
+
+                if (slab->remoteCells.load(std::memory_order_relaxed))
+                {
+                    remove_slab(full, slab);
+                    push_slab(available, slab);
+                    slab->full = false;
+                }
+
+                slab = next;
+            }
+
+            if (!available)
+                push_slab(available, create_slab(shard, sizeClass));
+        }
+
+        slab_header* slab = available;
+
+        if (!slab->freeCells)
+            take_remote_cells(slab);
+
+        if (free_cell* cell = slab->freeCells)
+        {
+            slab->freeCells = cell->next;
+            ++slab->usedCells;
+            return cell;
+        }
+
+        remove_slab(available, slab);
+        push_slab(shard->fullSlabs[sizeClass], slab);
+        slab->full = true;
+    }
+}
+
+void graph::release_cell(pointer_shard* shard, slab_header* slab, void* p)
+{
+    auto cell = static_cast<free_cell*>(p);
+    cell->next = slab->freeCells;
+    slab->freeCells = cell;
+    --slab->usedCells;
+
+    slab_header*& available = shard->slabs[slab->sizeClass];
+
+    if (slab->full)
+    {
+        remove_slab(shard->fullSlabs[slab->sizeClass], slab);
+        push_slab(available, slab);
+        slab->full = false;
+    }
+
+    // the slab being allocated from is kept, so that a size class doesn't
+    // create and release a slab each time a single object comes and goes
+    if (slab->usedCells == 0 && slab != available)
+    {
+        remove_slab(available, slab);
+        release_slab(slab);
+    }
+}
+
+slab_header* graph::create_slab(pointer_shard* shard, int sizeClass)
+{
+    uint32_t cellSize = size_class_cells[sizeClass];
+    size_t cellCount = (slab_size - slab_header_size()) / cellSize;
+
+    std::byte* mem = static_cast<std::byte*>(
+        ::operator new(slab_size, std::align_val_t(slab_alignment)));
+
+    slab_header* slab = std::construct_at(reinterpret_cast<slab_header*>(mem));
+    slab->owner = shard;
+    slab->sizeClass = (uint32_t)sizeClass;
+
+    std::byte* cells = mem + slab_header_size();
+    add_range(cells, cellCount * cellSize, cellSize);
+    slabCounts[sizeClass].fetch_add(1, std::memory_order_relaxed);
+
+    // link in reverse so cells are handed out in address order
+    for (size_t i = cellCount; i-- != 0; )
+    {
+        auto cell = reinterpret_cast<free_cell*>(cells + i * cellSize);
+        cell->next = slab->freeCells;
+        slab->freeCells = cell;
+    }
+
+    return slab;
+}
+
+void graph::release_slab(slab_header* slab)
+{
+    remove_range(reinterpret_cast<std::byte*>(slab) + slab_header_size());
+    slabCounts[slab->sizeClass].fetch_sub(1, std::memory_order_relaxed);
+
+    std::destroy_at(slab);
+    ::operator delete(slab, std::align_val_t(slab_alignment));
+}
+
+// Shards that no thread is using only have their slabs trimmed when they're
+// released, so cells other threads free afterwards are reclaimed from here.
+void graph::trim_released_shards()
+{
+    detail::vector<pointer_shard*> released;
+
+    {
+        std::lock_guard lk(shardLock);
+
+        for (auto s : shards)
+        {
+            if (!s->inUse) {
+                s->inUse = true;
+                released.push_back(s);
+            }
+        }
+    }
 
-    auto it = find_range_iterator(p);
-    assert(it != ranges.end());
-    ranges.erase(it);
+    for (auto s : released)
+        release_shard(s);
+}
+
+// Releases every empty slab of a shard whose thread is done with it. Slabs that
+// still have objects in them are kept, and are taken back by the next thread
+// to use the shard once other threads have freed their cells.
+void graph::trim_slabs(pointer_shard* shard)
+{
+    for (size_t i = 0; i != size_class_count; ++i)
+    {
+        for (slab_header** list : { &shard->slabs[i], &shard->fullSlabs[i] })
+        {
+            for (slab_header* slab = *list; slab; )
+            {
+                slab_header* next = slab->next;
+                take_remote_cells(slab);
+
+                if (slab->usedCells == 0)
+                {
+                    remove_slab(*list, slab);
+                    release_slab(slab);
+                }
+
+                slab = next;
+            }
+        }
+    }
+}
+
+void graph::use_slab_pools(bool enable) {
+    that->slabPoolsEnabled = enable;
 }
 
 garbage graph::collect() {
-    return that->collect_impl();
+    return that->collect_impl(steady_clock::duration::max());
 }
 
-garbage graph::collect_impl()
+garbage graph::collect(steady_clock::duration budget) {
+    return that->collect_impl(budget);
+}
+
+bool graph::collection_pending() {
+    return that->collectionPhase != phase::idle;
+}
+
+garbage graph::collect_impl(steady_clock::duration budget)
 {
     if (that->collecting.exchange(true)) {
         printf("collection already in progress\n");
         return garbage();
     }
 
-    auto start = std::chrono::steady_clock::now();
+    auto now = steady_clock::now();
 
-    size_t managedPointerCount = 0;
-    
+    auto deadline = budget < steady_clock::time_point::max() - now ?
+        now + budget : steady_clock::time_point::max();
+
+    if (collectionPhase == phase::idle)
+    {
+        trim_released_shards();
+        collectionStart = now;
+        collectionSteps = 0;
+        take_snapshot();
+        start_phase(phase::sort_ranges);
+    }
+
+    ++collectionSteps;
+
+    garbage ret;
+
+    if (!step(deadline, ret))
     {
-        std::scoped_lock lk(pointerLock, graphLock);
+        collecting = false;
+        return garbage();
+    }
+
+    collectionPhase = phase::idle;
+    collecting = false;
+
+    auto dur = steady_clock::now() - collectionStart;
+    float seconds = duration_cast<duration<float>>(dur).count();
+    printf("Collected %d objects in %f seconds (%d steps)\n",
+        (int)ret.size(), seconds, collectionSteps);
+
+    return ret;
+}
+
+void graph::start_phase(phase p)
+{
+    collectionPhase = p;
+    progress = 0;
+}
 
-        size_t totalPointers = pointers.size() + rawPointers.size();
-        info.reserve(totalPointers);
-        scan.reserve(totalPointers);
-        keep.reserve(totalPointers);
+// Sorts 'data' by an address, one byte of the key per pass, starting with the
+// least significant. Bytes that are the same for every element are skipped,
+// which usually leaves only a few passes for heap addresses. The sort can be
+// interrupted between blocks of elements and resumed from 'state'.
+template<class T, class Key>
+static bool radix_sort(detail::vector<T>& data, detail::vector<T>& temp,
+    radix_sort_state& state, Key key, steady_clock::time_point deadline)
+{
+    constexpr size_t elementsPerDeadlineCheck = 4096;
+    constexpr int digits = sizeof(uintptr_t);
 
-        rngs.reserve(ranges.size());
-        for(auto& r : ranges)
-            rngs.push_back({ r.begin, r.end, false, false });
+    size_t count = data.size();
 
-        for (auto& gp : pointers)
+    if (state.digit < 0)
+    {
+        while (state.position < count)
         {
-            if (gp)
+            size_t end = std::min(count, state.position + elementsPerDeadlineCheck);
+
+            for (T* e = data.data() + state.position; state.position != end; ++state.position, ++e)
             {
-                auto it_r = find_range_iterator(gp.get());
-                size_t idx_r = static_cast<size_t>(it_r - ranges.begin());
+                uintptr_t k = key(*e);
 
-                scan_info si;
-                si.gp = &gp;
-                si.range = &rngs[idx_r];
-                si.range->managed = true;
+                for (int d = 0; d != digits; ++d)
+                    ++state.counts[d][(k >> (d * 8)) & 0xFF];
+            }
 
-                uint32_t idx = (uint32_t)info.size();
-                info.push_back(si);
+            if (state.position != count && steady_clock::now() >= deadline)
+                return false;
+        }
 
-                if (bool isRoot = !find_range(si.gp))
-                    keep.push_back(idx);
-                else
-                    scan.push_back(idx);
+        temp.resize(count);
+        state.digit = 0;
+        state.position = 0;
+    }
 
-                ++managedPointerCount;
+    while (state.digit < digits)
+    {
+        size_t* offsets = state.counts[state.digit];
+
+        if (state.position == 0)
+        {
+            // every key has the same value for this byte
+            if (std::find(offsets, offsets + 256, count) != offsets + 256)
+            {
+                ++state.digit;
+                continue;
             }
+
+            size_t offset = 0;
+
+            for (int i = 0; i != 256; ++i)
+                offset += std::exchange(offsets[i], offset);
         }
 
-        for (auto& rgp : rawPointers)
+        int shift = state.digit * 8;
+
+        while (state.position < count)
         {
-            auto it_r = find_range_iterator(rgp.ptr);
-            if (it_r != ranges.end())
-            {
-                size_t idx_r = static_cast<size_t>(it_r - ranges.begin());
+            size_t end = std::min(count, state.position + elementsPerDeadlineCheck);
+
+            for (T* e = data.data() + state.position; state.position != end; ++state.position, ++e)
+                temp.data()[offsets[(key(*e) >> shift) & 0xFF]++] = *e;
 
-                scan_info si;
-                si.gp = &rgp;
-                si.range = &rngs[idx_r];
-                si.range->managed = false;
+            if (state.position != count && steady_clock::now() >= deadline)
+                return false;
+        }
 
-                uint32_t idx = (uint32_t)info.size();
-                info.push_back(si);
+        data.swap(temp);
+        state.position = 0;
+        ++state.digit;
+    }
 
-                if (bool isRoot = !find_range(si.gp))
-                    keep.push_back(idx);
-                else
-                    scan.push_back(idx);
-            }
+    return true;
+}
+
+// Calls 'fun' for each index from 'progress' up to 'count', checking the
+// deadline every 'itemsPerDeadlineCheck' items.
+template<class Fun>
+static bool for_each_until(size_t& progress, size_t count,
+    size_t itemsPerDeadlineCheck, steady_clock::time_point deadline, Fun&& fun)
+{
+    while (progress < count)
+    {
+        size_t end = std::min(count, progress + itemsPerDeadlineCheck);
+
+        for (; progress != end; ++progress)
+            fun(progress);
+
+        if (progress != count && steady_clock::now() >= deadline)
+            return false;
+    }
+
+    return true;
+}
+
+bool graph::step(steady_clock::time_point deadline, garbage& ret)
+{
+    auto rangeKey = [](const range_info& r) { return reinterpret_cast<uintptr_t>(r.begin); };
+    auto pointerKey = [](const scan_info& si) { return reinterpret_cast<uintptr_t>(si.location); };
+
+    for (;;)
+    {
+        switch (collectionPhase)
+        {
+        case phase::sort_ranges:
+            if (!radix_sort(rngs, rngsTemp, sortState, rangeKey, deadline))
+                return false;
+
+            start_phase(phase::number_cells);
+            break;
+
+        case phase::number_cells:
+            if (!number_cells(deadline))
+                return false;
+
+            start_phase(phase::resolve);
+            break;
+
+        case phase::resolve:
+            if (!resolve(deadline))
+                return false;
+
+            sortState = {};
+            start_phase(phase::sort_pointers);
+            break;
+
+        case phase::sort_pointers:
+            // sort pointers by their own address so that the pointers
+            // contained in a range can be found with a binary search
+            if (!radix_sort(info, infoTemp, sortState, pointerKey, deadline))
+                return false;
+
+            rangeCursor = 0;
+            start_phase(phase::locate);
+            break;
+
+        case phase::locate:
+            if (!locate(deadline))
+                return false;
+
+            start_phase(phase::mark);
+            break;
+
+        case phase::mark:
+            if (!mark(deadline))
+                return false;
+
+            start_phase(phase::scan);
+            break;
+
+        case phase::scan:
+            if (!scan(deadline))
+                return false;
+
+            ret = sweep();
+            return true;
+
+        case phase::idle:
+            return true;
         }
-    } // scoped_lock
+    }
+}
 
-    detail::vector<std::shared_ptr<void>> unreachable;
-    unreachable.reserve(managedPointerCount);
+void graph::take_snapshot()
+{
+    // Stop the world by draining every shard. Mutators only ever hold their
+    // own shard's lock, so once all of them are held no pointer can change.
+    // Only copy what's needed to trace the graph while mutators are stopped.
+    // Sorting and resolving pointers to ranges happen after the locks are
+    // released, against the copied ranges, so new allocations can't affect them.
+    std::lock_guard shardsLock(shardLock);
+
+    for (auto s : shards)
+        s->lock.lock();
+
+    for (auto& stripe : rangeStripes)
+        stripe.lock.lock();
+
+    managedPointerCount = 0;
 
-    for (size_t i = 0; i != keep.size(); ++i)
+    size_t rangeCount = 0;
+    size_t pointerCount = 0;
+
+    for (auto& stripe : rangeStripes)
+        rangeCount += stripe.ranges.size();
+
+    for (auto s : shards)
+        pointerCount += s->pointers.size() + s->rawPointers.size();
+
+    rngs.reserve(rangeCount);
+    info.reserve(pointerCount);
+
+    for (auto& stripe : rangeStripes)
     {
-        scan_info& parent = info[keep[i]];
+        for (auto& [begin, entry] : stripe.ranges)
+            rngs.push_back({ { begin, entry.end }, entry.cellSize, 0 });
+    }
+
+    for (auto s : shards)
+    {
+        for (auto gp : s->pointers)
+        {
+            if (*gp)
+            {
+                info.push_back({
+                    reinterpret_cast<std::byte*>(gp),
+                    static_cast<std::byte*>(gp->get()),
+                    no_range, no_range, true });
+
+                ++managedPointerCount;
+            }
+        }
+
+        for (auto rgp : s->rawPointers)
+        {
+            if (*rgp)
+            {
+                info.push_back({
+                    reinterpret_cast<std::byte*>(rgp),
+                    static_cast<std::byte*>(rgp->get()),
+                    no_range, no_range, false });
+            }
+        }
+
+        s->shaded.clear();
+    }
+
+    sortState = {};
+    tracing = true;
+
+    for (auto& stripe : rangeStripes)
+        stripe.lock.unlock();
+
+    for (auto s : shards)
+        s->lock.unlock();
+}
+
+bool graph::number_cells(steady_clock::time_point deadline)
+{
+    constexpr size_t rangesPerDeadlineCheck = 4096;
+
+    if (progress == 0)
+        cellCount = 0;
+
+    bool done = for_each_until(progress, rngs.size(), rangesPerDeadlineCheck, deadline,
+        [this](size_t i)
+        {
+            range_info& r = rngs[i];
+            r.firstCell = cellCount;
+            cellCount += r.cellSize ? (uint32_t)((r.end - r.begin) / r.cellSize) : 1;
+        });
 
-        if(parent.range->scanned)
-            continue;
+    if (done)
+        marks.resize(cellCount, false);
 
-        for(auto it = scan.begin(); it != scan.end(); )
+    return done;
+}
+
+bool graph::resolve(steady_clock::time_point deadline)
+{
+    constexpr size_t pointersPerDeadlineCheck = 1024;
+
+    return for_each_until(progress, info.size(), pointersPerDeadlineCheck, deadline,
+        [this](size_t i) { info[i].target = find_snapshot_cell(info[i].address); });
+}
+
+bool graph::locate(steady_clock::time_point deadline)
+{
+    constexpr size_t pointersPerDeadlineCheck = 4096;
+
+    // ranges are sorted and disjoint, so a single merge pass finds
+    // the range each pointer lives in. Pointers outside of all ranges
+    // are roots, and whatever they point to is reachable.
+    if (progress == 0)
+        work.reserve(marks.size());
+
+    return for_each_until(progress, info.size(), pointersPerDeadlineCheck, deadline,
+        [this](size_t i)
         {
-            auto idx = *it;
+            scan_info& si = info[i];
 
-            std::byte* bp = static_cast<std::byte*>(info[idx].gp);
+            while (rangeCursor < rngs.size() && rngs[rangeCursor].end <= si.location)
+                ++rangeCursor;
 
-            if (bp >= parent.range->begin && bp < parent.range->end)
+            if (rangeCursor < rngs.size() && si.location >= rngs[rangeCursor].begin)
             {
-                keep.push_back(idx);
-                *it = scan.back();
-                scan.pop_back();
+                si.owner = cell_in_range(rngs[rangeCursor], si.location);
             }
-            else
+            else if (si.target != no_range && !marks[si.target])
+            {
+                marks[si.target] = true;
+                work.push_back(si.target);
+            }
+        });
+}
+
+bool graph::mark(steady_clock::time_point deadline)
+{
+    constexpr size_t cellsPerDeadlineCheck = 64;
+
+    size_t traced = 0;
+
+    while (!work.empty())
+    {
+        if (++traced % cellsPerDeadlineCheck == 0 && steady_clock::now() >= deadline)
+            return false;
+
+        memory_range parent = cell_bounds(work.back());
+        work.pop_back();
+
+        auto it = std::lower_bound(info.begin(), info.end(), parent.begin,
+            [](const scan_info& si, std::byte* p) { return si.location < p; });
+
+        for (; it != info.end() && it->location < parent.end; ++it)
+        {
+            if (it->target != no_range && !marks[it->target])
             {
-                ++it;
+                marks[it->target] = true;
+                work.push_back(it->target);
             }
         }
+    }
+
+    return true;
+}
 
-        parent.range->scanned = true;
+bool graph::scan(steady_clock::time_point deadline)
+{
+    constexpr size_t pointersPerDeadlineCheck = 4096;
+
+    if (progress == 0)
+        candidates.reserve(managedPointerCount);
+
+    return for_each_until(progress, info.size(), pointersPerDeadlineCheck, deadline,
+        [this](size_t i)
+        {
+            const scan_info& si = info[i];
+
+            if (si.managed && si.owner != no_range && !marks[si.owner])
+                candidates.push_back((uint32_t)i);
+        });
+}
+
+garbage graph::sweep()
+{
+    // Unreachable objects can only become reachable again through a new
+    // graph_ptr that doesn't come from an existing one, and the memory of a
+    // pointer found in the snapshot is only released after its object was
+    // retired. Both are recorded in the shards while tracing, so with the world
+    // stopped again, whatever they reference is marked before taking the garbage.
+    // Recorded objects that weren't in the snapshot don't have pointers in it,
+    // so this usually only traces the few that were retired during collection.
+    std::lock_guard shardsLock(shardLock);
+
+    for (auto s : shards)
+        s->lock.lock();
+
+    for (auto s : shards)
+    {
+        for (std::byte* p : s->shaded)
+        {
+            uint32_t cell = find_snapshot_cell(p);
+
+            if (cell != no_range && !marks[cell])
+            {
+                marks[cell] = true;
+                work.push_back(cell);
+            }
+        }
+
+        s->shaded.clear();
     }
 
-    for (auto& idx : scan)
+    mark(steady_clock::time_point::max());
+
+    detail::vector<std::shared_ptr<void>> unreachable;
+    unreachable.reserve(candidates.size());
+
+    for (uint32_t i : candidates)
     {
-        scan_info& si = info[idx];
+        const scan_info& si = info[i];
 
-        if (si.range->managed)
+        if (!marks[si.owner])
         {
-            auto mptr = static_cast<graph_ptr<void>*>(si.gp);
+            auto mptr = reinterpret_cast<graph_ptr<void>*>(si.location);
             unreachable.push_back(std::move(mptr->ptr));
         }
     }
 
+    tracing = false;
+
+    for (auto s : shards)
+        s->lock.unlock();
+
     rngs.clear();
+    rngsTemp.clear();
     info.clear();
-    scan.clear();
-    keep.clear();
+    infoTemp.clear();
+    marks.clear();
+    work.clear();
+    candidates.clear();
 
-    collecting = false;
+    return garbage(std::move(unreachable));
+}
 
-    size_t objCount = unreachable.size();
+// Ranges are half-open, so a pointer to the end of an allocation doesn't
+// keep it alive. Containers that hold one also hold one to the beginning.
+uint32_t graph::find_snapshot_cell(std::byte* bp) const
+{
+    if (!rngs.empty() && bp >= rngs.front().begin && bp < rngs.back().end)
+    {
+        auto it = std::upper_bound(rngs.begin(), rngs.end(), bp,
+            [](std::byte* p, const range_info& r) { return p < r.begin; });
 
-    auto dur = std::chrono::steady_clock::now() - start;
-    float seconds = std::chrono::duration_cast<std::chrono::duration<float>>(dur).count();
-    printf("Collected %d objects in %f seconds\n", (int)objCount, seconds);
+        if (it != rngs.begin())
+        {
+            --it;
 
-    return garbage(std::move(unreachable));
+            if (bp < it->end)
+                return cell_in_range(*it, bp);
+        }
+    }
+
+    return no_range;
 }
 
-int graph::allocated_objects()
+uint32_t graph::cell_in_range(const range_info& r, std::byte* bp) const
 {
-    std::lock_guard lk(that->graphLock);
-    return (int)that->ranges.size();
+    if (!r.cellSize)
+        return r.firstCell;
+
+    return r.firstCell + (uint32_t)((size_t)(bp - r.begin) / r.cellSize);
 }
 
-size_t graph::allocated_bytes()
+memory_range graph::cell_bounds(uint32_t cell) const
 {
-    std::lock_guard lk(that->graphLock);
-    
-    size_t total = 0;
-    
-    for (auto& range : that->ranges)
-        total += (range.end - range.begin);
+    auto it = std::upper_bound(rngs.begin(), rngs.end(), cell,
+        [](uint32_t c, const range_info& r) { return c < r.firstCell; });
 
-    return total;
+    const range_info& r = *--it;
+
+    if (!r.cellSize)
+        return { r.begin, r.end };
+
+    std::byte* begin = r.begin + (size_t)(cell - r.firstCell) * r.cellSize;
+    return { begin, begin + r.cellSize };
 }
 
-std::optional<memory_range> graph::find_range(void* internalPtr)
+int graph::allocated_objects()
 {
-    std::optional<memory_range> ret;
+    size_t total = 0;
 
-    auto it = find_range_iterator(internalPtr);
-    if (it != ranges.end())
-        ret = *it;
+    for (auto& stripe : that->rangeStripes)
+    {
+        std::lock_guard lk(stripe.lock);
 
-    return ret;
+        for (auto& [begin, entry] : stripe.ranges)
+        {
+            if (!entry.cellSize)
+                ++total;
+        }
+    }
+
+    for (auto& sc : size_classes())
+        total += sc.allocated_objects;
+
+    return (int)total;
 }
 
-detail::vector<memory_range>::iterator graph::find_range_iterator(void* internalPtr)
+size_t graph::allocated_bytes()
 {
-    if (internalPtr && !ranges.empty())
+    size_t total = 0;
+    
+    for (auto& stripe : that->rangeStripes)
     {
-        std::byte* bp = static_cast<std::byte*>(internalPtr);
+        std::lock_guard lk(stripe.lock);
 
-        std::byte* allBegin = ranges.front().begin;
-        std::byte* allEnd = ranges.back().end;
-
-        if (bp >= allBegin && bp <= allEnd)
+        for (auto& [begin, entry] : stripe.ranges)
         {
-            auto it = std::upper_bound(ranges.begin(), ranges.end(), bp,
-                [](std::byte* p, const memory_range& r) { return p < r.begin; });
+            if (!entry.cellSize)
+                total += (entry.end - begin);
+        }
+    }
 
-            if (it != ranges.begin())
-            {
-                --it;
+    for (auto& sc : size_classes())
+        total += sc.allocated_bytes;
 
-                if (bp >= it->begin && bp <= it->end) {
-                    return it;
-                }
-            }
-        }
+    return total;
+}
+
+std::vector<size_class_stats> graph::size_classes()
+{
+    std::vector<size_class_stats> ret(size_class_count);
+
+    std::lock_guard lk(that->shardLock);
+
+    for (size_t i = 0; i != size_class_count; ++i)
+    {
+        ptrdiff_t live = 0;
+
+        for (auto s : that->shards)
+            live += s->liveCells[i].load(std::memory_order_relaxed);
+
+        size_class_stats& sc = ret[i];
+        sc.cell_size = size_class_cells[i];
+        sc.allocated_objects = (size_t)live;
+        sc.allocated_bytes = (size_t)live * size_class_cells[i];
+        sc.reserved_bytes = that->slabCounts[i].load(std::memory_order_relaxed) * slab_size;
     }
 
-    return ranges.end();
+    return ret;
 }
 
 } // gc
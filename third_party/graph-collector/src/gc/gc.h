@@ -4,6 +4,7 @@
 
 #pragma once
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <compare>
@@ -23,7 +24,6 @@
 #include <utility>
 #include <vector>
 #include <gc/detail/functor.h>
-#include <gc/detail/intrusive_list.h>
 #include <gc/detail/vector.h>
 
 namespace gc {
@@ -37,22 +37,66 @@ class weak_graph_ptr;
 template<class T>
 class raw_graph_ptr;
 
+template<class T>
+class block_allocator;
+
 struct memory_range
 {
     std::byte* begin{};
     std::byte* end{};
 };
 
+// A registered range is either a single allocation, or a slab divided
+// into cells of 'cellSize' bytes that are each traced as separate objects.
 struct range_info : memory_range
 {
-    bool managed{};
-    bool scanned{};
+    uint32_t cellSize{};  // zero for a single allocation
+    uint32_t firstCell{}; // index of the range's first cell in the snapshot
+};
+
+struct range_entry
+{
+    std::byte* end{};
+    uint32_t cellSize{};
+};
+
+// allocation statistics for one of the slab size classes
+struct size_class_stats
+{
+    size_t cell_size{};
+    size_t allocated_objects{};
+    size_t allocated_bytes{};
+    size_t reserved_bytes{}; // memory held by the class's slabs
+};
+
+// per-thread registry of attached pointers
+struct pointer_shard;
+
+// bookkeeping at the start of each slab
+struct slab_header;
+
+// registry of memory ranges, partitioned by address
+struct range_stripe
+{
+    std::mutex lock;
+    std::unordered_map<std::byte*, range_entry> ranges; // keyed by begin
+};
+
+// progress of a radix sort that is spread over several collection steps
+struct radix_sort_state
+{
+    size_t counts[sizeof(uintptr_t)][256]{}; // histogram of each key byte
+    size_t position{};
+    int digit = -1; // key byte being scattered, or -1 while counting
 };
 
 struct scan_info
 {
-    void* gp;
-    range_info* range;
+    std::byte* location; // address of the pointer itself
+    std::byte* address;  // address the pointer refers to
+    uint32_t target;     // index of the cell 'address' falls in
+    uint32_t owner;      // index of the cell 'location' falls in
+    bool managed;        // graph_ptr (true) or raw_graph_ptr (false)
 };
 
 class garbage
@@ -72,6 +116,14 @@ public:
 
     garbage(garbage&&) = default;
     garbage& operator=(garbage&&) = default;
+
+    size_t size() const {
+        return unreachable_objects.size();
+    }
+
+    bool empty() const {
+        return unreachable_objects.empty();
+    }
 };
 
 class graph
@@ -88,19 +140,95 @@ class graph
     template <class U>
     friend class allocator;
 
-    std::recursive_mutex graphLock;
-    std::shared_mutex pointerLock;
-    detail::intrusive_list<graph_ptr<void>> pointers;
-    detail::intrusive_list<raw_graph_ptr<void>> rawPointers;
-    detail::vector<memory_range> ranges;
+    template <class U>
+    friend class block_allocator;
+
+    friend struct pointer_shard;
+    friend struct shard_owner;
+
+    // The calling thread's shard. A thread that already released its shard on
+    // exit, but still creates or destroys objects from the destructors of other
+    // thread_locals, borrows one for the duration of each operation instead.
+    class shard_ref
+    {
+        pointer_shard* shard;
+        bool borrowed;
+    public:
+        shard_ref();
+        ~shard_ref();
+
+        shard_ref(const shard_ref&) = delete;
+        shard_ref& operator=(const shard_ref&) = delete;
+
+        pointer_shard* get() const { return shard; }
+        pointer_shard* operator->() const { return shard; }
+    };
+
+    // Held by a thread for the duration of any change to a pointer's value.
+    // Only locks the calling thread's shard, so mutators don't contend with
+    // each other, while the collector can stop the world by locking every shard.
+    class pointer_lock
+    {
+        shard_ref shard;
+    public:
+        pointer_lock();
+        ~pointer_lock();
+
+        pointer_lock(const pointer_lock&) = delete;
+        pointer_lock& operator=(const pointer_lock&) = delete;
+    };
+
+    static constexpr size_t range_stripe_bits = 6;
+    static constexpr size_t range_stripe_count = size_t(1) << range_stripe_bits;
+
+    std::mutex shardLock;
+    detail::vector<pointer_shard*> shards;
+    range_stripe rangeStripes[range_stripe_count];
+
+    // Objects created by 'make' are carved out of slabs of fixed size cells.
+    // Each slab belongs to a shard, is registered as a single range, and is
+    // released once all of its cells are free. Slabs are aligned to their size,
+    // so the slab of a cell is found by masking the cell's address.
+    static constexpr size_t slab_size = 64 * 1024;
+    static constexpr size_t slab_alignment = slab_size;
+    static constexpr size_t cell_alignment = 16;
+    static constexpr size_t size_class_count = 14;
+    static constexpr uint32_t size_class_cells[size_class_count] = {
+        32, 48, 64, 80, 96, 128, 160, 192, 256, 320, 384, 512, 768, 1024
+    };
+
+    std::atomic<bool> slabPoolsEnabled = true;
+    std::atomic<size_t> slabCounts[size_class_count] = {};
+
+    // Every phase after the snapshot can be interrupted by the deadline and
+    // resumed by a later call, with 'progress' tracking how far it got.
+    enum class phase { idle, sort_ranges, number_cells, resolve, sort_pointers, locate, mark, scan };
+
+    static constexpr uint32_t no_range = UINT32_MAX;
 
     std::chrono::steady_clock::time_point collectionStart;
     detail::vector<range_info> rngs;
+    detail::vector<range_info> rngsTemp;
     detail::vector<scan_info> info;
-    detail::vector<uint32_t> scan;
-    detail::vector<uint32_t> keep;
+    detail::vector<scan_info> infoTemp;
+    detail::vector<bool> marks;
+    detail::vector<uint32_t> work;
+    detail::vector<uint32_t> candidates; // managed pointers in unmarked cells
+    radix_sort_state sortState;
+    size_t managedPointerCount = 0;
+    size_t progress = 0;
+    size_t rangeCursor = 0;
+    uint32_t cellCount = 0;
+    phase collectionPhase = phase::idle;
+    int collectionSteps = 0;
     std::atomic<bool> collecting = false;
 
+    // Set from the snapshot until the garbage is taken, and only changed while
+    // every shard is locked. While set, objects that are adopted by a new
+    // graph_ptr (weak_graph_ptr::lock, graph_object::self, make) or destroyed
+    // are recorded in the shard, and treated as reachable before sweeping.
+    bool tracing = false;
+
     graph();
     ~graph();
 
@@ -128,31 +256,112 @@ public:
     // to the caller so they can destroy them where appropriate
     [[nodiscard]] static garbage collect();
 
+    // perform at most 'budget' worth of collection work, starting a new
+    // collection or resuming one left unfinished by a previous call.
+    // The returned garbage is empty until the final step completes.
+    [[nodiscard]] static garbage collect(std::chrono::steady_clock::duration budget);
+
+    // true if a budgeted collection has been started but not finished
+    static bool collection_pending();
+
     // get total number of objects owned by this graph
     static int allocated_objects();
     
     // get total bytes allocated by this graph
     static size_t allocated_bytes();
 
+    // get allocation statistics for each of the slab size classes
+    static std::vector<size_class_stats> size_classes();
+
+    // Enable or disable allocation of objects created by 'make' from slab pools.
+    // When disabled, each object gets its own heap allocation. Objects are always
+    // returned to the allocator they came from, so this can be changed at any time.
+    static void use_slab_pools(bool enable);
+
 private:
-    void attach(graph_ptr<void>* gp);
+    void attach(graph_ptr<void>* gp, bool adopted = false);
     void detach(graph_ptr<void>* gp);
+    void retire(void* p);
+
+    template<class P>
+    static void unlink(detail::vector<P*>& pointers, P* gp);
     
     void attach(raw_graph_ptr<void>* gp);
     void detach(raw_graph_ptr<void>* gp);
 
-    void add_range(void* p, size_t size);
+    void add_range(void* p, size_t size, uint32_t cellSize = 0);
     void remove_range(void* p);
 
-    std::optional<memory_range> find_range(void* internalPtr);
-    detail::vector<memory_range>::iterator find_range_iterator(void* internalPtr);
-
-    garbage collect_impl();
+    static void* allocate_block(size_t size, size_t align, bool pooled);
+    static void deallocate_block(void* p, size_t size, size_t align, bool pooled);
+    static int size_class_for(size_t size, size_t align);
+    void* allocate_cell(pointer_shard* shard, int sizeClass);
+    void release_cell(pointer_shard* shard, slab_header* slab, void* p);
+    slab_header* create_slab(pointer_shard* shard, int sizeClass);
+    void release_slab(slab_header* slab);
+    void trim_slabs(pointer_shard* shard);
+    void trim_released_shards();
+    static slab_header* slab_of(void* p);
+    static size_t slab_header_size();
+
+    static range_stripe& stripe_for(void* p);
+
+    pointer_shard* acquire_shard();
+    void release_shard(pointer_shard* shard);
+    static pointer_shard* local_shard();
+
+    garbage collect_impl(std::chrono::steady_clock::duration budget);
+    bool step(std::chrono::steady_clock::time_point deadline, garbage& ret);
+    void start_phase(phase p);
+    void take_snapshot();
+    bool number_cells(std::chrono::steady_clock::time_point deadline);
+    bool resolve(std::chrono::steady_clock::time_point deadline);
+    bool locate(std::chrono::steady_clock::time_point deadline);
+    bool mark(std::chrono::steady_clock::time_point deadline);
+    bool scan(std::chrono::steady_clock::time_point deadline);
+    garbage sweep();
+    uint32_t find_snapshot_cell(std::byte* bp) const;
+    uint32_t cell_in_range(const range_info& r, std::byte* bp) const;
+    memory_range cell_bounds(uint32_t cell) const;
 };
 
 template<class T>
 concept graph_object_subclass = std::is_base_of_v<typename T::graph_object_type, T>;
 
+// Allocates the storage of objects created by 'graph::make', including the
+// shared_ptr control block. The choice of pool is captured at allocation time,
+// and shared_ptr keeps a copy of the allocator to release the storage with.
+template<class T>
+class block_allocator
+{
+    template<class U>
+    friend class block_allocator;
+
+    bool pooled{};
+public:
+    using value_type = T;
+
+    explicit block_allocator(bool pooled)
+        : pooled(pooled) {}
+
+    template<class U>
+    block_allocator(const block_allocator<U>& that)
+        : pooled(that.pooled) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(graph::allocate_block(sizeof(T) * n, alignof(T), pooled));
+    }
+
+    void deallocate(T* p, size_t n) {
+        graph::deallocate_block(p, sizeof(T) * n, alignof(T), pooled);
+    }
+
+    template<class U>
+    bool operator==(const block_allocator<U>& that) const {
+        return pooled == that.pooled;
+    }
+};
+
 template<class T, typename... Args> requires (!std::is_array_v<T>)
 inline graph_ptr<T> graph::make(Args&&... args)
 {
@@ -161,16 +370,17 @@ inline graph_ptr<T> graph::make(Args&&... args)
         union { T storage; };
 
         graph_ptr_storage(Args&&... args) {
-            graph::that->add_range(static_cast<void*>(&storage), sizeof(T));
             std::construct_at(&storage, std::forward<Args>(args)...);
         }
         ~graph_ptr_storage() {
+            that->retire(&storage);
             std::destroy_at(&storage);
-            graph::that->remove_range(static_cast<void*>(&storage));
         }
     };
 
-    std::shared_ptr<graph_ptr_storage> gps = std::make_shared<graph_ptr_storage>(std::forward<Args>(args)...);
+    block_allocator<graph_ptr_storage> alloc(that->slabPoolsEnabled.load(std::memory_order_relaxed));
+
+    std::shared_ptr<graph_ptr_storage> gps = std::allocate_shared<graph_ptr_storage>(alloc, std::forward<Args>(args)...);
     T* p = &gps->storage;
     std::shared_ptr<T> sp = { std::move(gps), p };
 
@@ -205,7 +415,7 @@ inline void graph::deallocate(const raw_graph_ptr<T>& gp)
 }
 
 template<class T>
-class graph_ptr final : public detail::intrusive_list_node
+class graph_ptr final
 {
 public:
     friend graph;
@@ -223,16 +433,34 @@ public:
     friend class graph_object;
 private:
     std::shared_ptr<T> ptr;
+    pointer_shard* shard = nullptr;
+    uint32_t slot = 0; // index in the shard's pointer array
 
     void attach() { graph::that->attach((graph_ptr<void>*)this); }
+    void adopt() { graph::that->attach((graph_ptr<void>*)this, true); }
     void detach() { graph::that->detach((graph_ptr<void>*)this); }
 
+    // Replace the pointer's value, then release the previous value after the
+    // lock is released, since destroying it may detach pointers in other shards.
+    template<class SP>
+    void assign(SP&& value)
+    {
+        std::shared_ptr<T> prev;
+        {
+            graph::pointer_lock lk;
+            prev = std::forward<SP>(value);
+            ptr.swap(prev);
+        }
+    }
+
+    // Used when the value doesn't come from another graph_ptr, so a pending
+    // collection may not have seen it as reachable.
     graph_ptr(std::shared_ptr<T>&& ptr)
-        : ptr(std::move(ptr)) { attach(); }
+        : ptr(std::move(ptr)) { adopt(); }
 
     template<class U>
     graph_ptr(std::shared_ptr<U>&& sp, T* p)
-        : ptr(std::move(sp), p) { attach(); }
+        : ptr(std::move(sp), p) { adopt(); }
 public:
     using element_type = std::remove_extent_t<T>;
 
@@ -246,7 +474,7 @@ public:
     template<class U>
     graph_ptr(graph_ptr<U>&& that, T* p) {
         attach();
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = { std::move(that.ptr), p };
     }
 
@@ -259,46 +487,42 @@ public:
 
     graph_ptr(graph_ptr&& that) {
         attach();
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = std::move(that.ptr);
     }
 
     template<class U> requires std::is_convertible_v<U*, element_type*>
     graph_ptr(graph_ptr<U>&& that) {
         attach();
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = std::move(that.ptr);
     }
 
     template<class U> requires std::is_convertible_v<U*, element_type*>
     explicit graph_ptr(const weak_graph_ptr<U>& that)
-        : ptr(that.ptr) { attach(); }
+        : ptr(that.ptr) { adopt(); }
 
     ~graph_ptr() { detach(); }
 
     graph_ptr& operator=(const graph_ptr& that) {
-        std::shared_lock lk(graph::that->pointerLock);
-        ptr = that.ptr;
+        assign(that.ptr);
         return *this;
     }
 
     template<class U>
     graph_ptr& operator=(const graph_ptr<U>& that) {
-        std::shared_lock lk(graph::that->pointerLock);
-        ptr = that.ptr;
+        assign(that.ptr);
         return *this;
     }
 
     graph_ptr& operator=(graph_ptr&& that) {
-        std::shared_lock lk(graph::that->pointerLock);
-        ptr = std::move(that.ptr);
+        assign(std::move(that.ptr));
         return *this;
     }
 
     template<class U>
     graph_ptr& operator=(graph_ptr<U>&& that) {
-        std::shared_lock lk(graph::that->pointerLock);
-        ptr = std::move(that.ptr);
+        assign(std::move(that.ptr));
         return *this;
     }
 
@@ -308,13 +532,12 @@ public:
     }
 
     void swap(graph_ptr& that) {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr.swap(that.ptr);
     }
 
     void reset() {
-        std::shared_lock lk(graph::that->pointerLock);
-        ptr.reset();
+        assign(std::shared_ptr<T>());
     }
 
     T* get() const {
@@ -520,7 +743,7 @@ class graph_object
 {
     friend class graph;
 
-    template<class T>
+    template<class U>
     friend class allocator;
 
     template<class U>
@@ -549,7 +772,7 @@ public:
 };
 
 template<class T>
-class raw_graph_ptr final : public detail::intrusive_list_node
+class raw_graph_ptr final
 {
 public:
     using P = std::remove_extent_t<T>;
@@ -574,6 +797,8 @@ public:
     using reference = U&;
 private:
     P* ptr = nullptr;
+    pointer_shard* shard = nullptr;
+    uint32_t slot = 0;
 
     void attach() { graph::that->attach((raw_graph_ptr<void>*)this); }
     void detach() { graph::that->detach((raw_graph_ptr<void>*)this); }
@@ -594,7 +819,7 @@ public:
     raw_graph_ptr(raw_graph_ptr&& that)
     {
         attach();
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = that.ptr;
         that.ptr = nullptr;
     }
@@ -603,7 +828,7 @@ public:
     raw_graph_ptr(raw_graph_ptr<U>&& that)
     {
         attach();
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = that.ptr;
         that.ptr = nullptr;
     }
@@ -611,20 +836,20 @@ public:
     ~raw_graph_ptr() { detach(); }
 
     raw_graph_ptr& operator=(const raw_graph_ptr& that) {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = that.ptr;
         return *this;
     }
 
     template<class U>
     raw_graph_ptr& operator=(const raw_graph_ptr<U>& that) {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = that.ptr;
         return *this;
     }
 
     raw_graph_ptr& operator=(raw_graph_ptr&& that) {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = that.ptr;
         that.ptr = nullptr;
         return *this;
@@ -632,7 +857,7 @@ public:
 
     template<class U>
     raw_graph_ptr& operator=(raw_graph_ptr<U>&& that) {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = that.ptr;
         that.ptr = nullptr;
         return *this;
@@ -644,12 +869,12 @@ public:
     }
 
     void swap(raw_graph_ptr& that) {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         std::swap(ptr, that.ptr);
     }
 
     void reset() {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr = nullptr;
     }
 
@@ -676,19 +901,19 @@ public:
     }
 
     raw_graph_ptr& operator+=(ptrdiff_t offset) {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr += offset;
         return *this;
     }
 
     raw_graph_ptr& operator-=(ptrdiff_t offset) {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ptr -= offset;
         return *this;
     }
 
     raw_graph_ptr& operator++() {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         ++ptr;
         return *this;
     }
@@ -700,7 +925,7 @@ public:
     }
 
     raw_graph_ptr& operator--() {
-        std::shared_lock lk(graph::that->pointerLock);
+        graph::pointer_lock lk;
         --ptr;
         return *this;
     }
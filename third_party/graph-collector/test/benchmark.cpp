@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <gc/gc.h>
+
+using namespace std::chrono;
+
+namespace {
+
+struct BenchNode
+{
+    gc::graph_ptr<BenchNode> next;
+    gc::vector<gc::graph_ptr<BenchNode>> children;
+};
+
+// stand-ins for the objects a frame typically creates and releases
+struct SmallObject { gc::graph_ptr<BenchNode> owner; int state; };
+struct MediumObject { gc::graph_ptr<BenchNode> owner; float values[12]; };
+struct LargeObject { gc::graph_ptr<BenchNode> owner; float matrix[16]; float extra[24]; };
+
+// Builds a reachable tree of 'count / 2' nodes under 'root', and
+// 'count / 4' unreachable two-node cycles for the collector to find.
+void BuildScene(const gc::graph_ptr<BenchNode>& root, int count)
+{
+    int reachable = count / 2;
+    size_t fanout = 8;
+
+    gc::vector<gc::graph_ptr<BenchNode>> level;
+    level.push_back(root);
+
+    int created = 0;
+    size_t parent = 0;
+
+    while (created < reachable)
+    {
+        auto node = gc::graph::make<BenchNode>();
+        level[parent]->children.push_back(node);
+        level.push_back(node);
+        ++created;
+
+        if (level[parent]->children.size() == fanout)
+            ++parent;
+    }
+
+    for (int i = 0; i < count / 4; ++i)
+    {
+        auto a = gc::graph::make<BenchNode>();
+        auto b = gc::graph::make<BenchNode>();
+        a->next = b;
+        b->next = a;
+    }
+}
+
+double ToMilliseconds(steady_clock::duration d) {
+    return duration_cast<duration<double, std::milli>>(d).count();
+}
+
+// The pointer churn of a typical update loop: allocate a few objects,
+// then copy, move and release pointers to them many times over.
+void ChurnPointers(int iterations)
+{
+    for (int i = 0; i < iterations; ++i)
+    {
+        auto a = gc::graph::make<BenchNode>();
+        auto b = gc::graph::make<BenchNode>();
+        a->next = b;
+
+        for (int j = 0; j < 32; ++j)
+        {
+            gc::graph_ptr<BenchNode> copy = a;
+            gc::graph_ptr<BenchNode> moved = std::move(copy);
+            moved = b;
+            moved.reset();
+        }
+    }
+}
+
+} // namespace
+
+void RunAllocationBenchmark()
+{
+    constexpr int frames = 200;
+    constexpr int objectsPerFrame = 3'000;
+
+    printf("\n%10s %14s %14s %14s\n", "pool", "frame (ms)", "collect (ms)", "objects");
+
+    for (bool pooled : { false, true })
+    {
+        gc::graph::use_slab_pools(pooled);
+
+        auto root = gc::graph::make<BenchNode>();
+
+        gc::vector<gc::graph_ptr<SmallObject>> small;
+        gc::vector<gc::graph_ptr<MediumObject>> medium;
+        gc::vector<gc::graph_ptr<LargeObject>> large;
+
+        auto start = steady_clock::now();
+
+        for (int f = 0; f < frames; ++f)
+        {
+            for (int i = 0; i < objectsPerFrame / 3; ++i)
+            {
+                small.push_back(gc::graph::make<SmallObject>());
+                medium.push_back(gc::graph::make<MediumObject>());
+                large.push_back(gc::graph::make<LargeObject>());
+            }
+
+            small.clear();
+            medium.clear();
+            large.clear();
+        }
+
+        double frameTime = ToMilliseconds(steady_clock::now() - start) / frames;
+
+        // keep a frame's worth of objects alive to measure collection
+        for (int i = 0; i < objectsPerFrame * 10; ++i)
+            large.push_back(gc::graph::make<LargeObject>());
+
+        start = steady_clock::now();
+        (void)gc::graph::collect();
+        double collectTime = ToMilliseconds(steady_clock::now() - start);
+
+        int objects = gc::graph::allocated_objects();
+
+        printf("%10s %14.3f %14.3f %14d\n", pooled ? "slab" : "malloc", frameTime, collectTime, objects);
+
+        if (pooled)
+        {
+            printf("\n%10s %14s %14s %14s\n", "cell size", "objects", "bytes", "reserved");
+
+            for (auto& sc : gc::graph::size_classes())
+            {
+                if (sc.reserved_bytes) {
+                    printf("%10zu %14zu %14zu %14zu\n", sc.cell_size,
+                        sc.allocated_objects, sc.allocated_bytes, sc.reserved_bytes);
+                }
+            }
+        }
+    }
+
+    gc::graph::use_slab_pools(true);
+}
+
+void RunRegistrationBenchmark()
+{
+    constexpr int iterations = 20'000;
+
+    int maxThreads = std::max(4, (int)std::thread::hardware_concurrency());
+
+    printf("\n%10s %14s %16s\n", "threads", "time (ms)", "pointer ops/ms");
+
+    for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+
+        std::atomic<bool> go = false;
+
+        for (int i = 0; i < threadCount; ++i)
+        {
+            threads.emplace_back([&go]{
+                while (!go) std::this_thread::yield();
+                ChurnPointers(iterations);
+            });
+        }
+
+        auto start = steady_clock::now();
+        go = true;
+
+        for (auto& t : threads)
+            t.join();
+
+        double ms = ToMilliseconds(steady_clock::now() - start);
+
+        // 2 allocations, 1 member assignment, and 4 operations per inner iteration
+        double ops = (double)threadCount * iterations * (3 + 32 * 4);
+
+        printf("%10d %14.3f %16.0f\n", threadCount, ms, ops / ms);
+    }
+}
+
+void RunCollectionBenchmark()
+{
+    printf("\n%10s %12s %12s %10s %14s\n",
+        "objects", "full (ms)", "budgeted", "steps", "max step (ms)");
+
+    for (int count : { 1'000, 10'000, 50'000, 100'000, 200'000 })
+    {
+        auto root = gc::graph::make<BenchNode>();
+        BuildScene(root, count);
+
+        auto start = steady_clock::now();
+        gc::garbage g = gc::graph::collect();
+        auto fullTime = steady_clock::now() - start;
+        g = {};
+
+        root = gc::graph::make<BenchNode>();
+        BuildScene(root, count);
+
+        int steps = 0;
+        steady_clock::duration totalTime{};
+        steady_clock::duration maxStep{};
+
+        do
+        {
+            start = steady_clock::now();
+            g = gc::graph::collect(milliseconds(1));
+            auto stepTime = steady_clock::now() - start;
+
+            totalTime += stepTime;
+            maxStep = std::max(maxStep, stepTime);
+            ++steps;
+        }
+        while (gc::graph::collection_pending());
+
+        g = {};
+        root.reset();
+
+        printf("%10d %12.3f %12.3f %10d %14.3f\n", count,
+            ToMilliseconds(fullTime), ToMilliseconds(totalTime),
+            steps, ToMilliseconds(maxStep));
+    }
+
+    (void)gc::graph::collect();
+}
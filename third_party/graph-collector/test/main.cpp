@@ -10,6 +10,7 @@
 #include <list>
 #include <unordered_map>
 #include <unordered_set>
+#include <optional>
 #include <queue>
 #include <gc/gc.h>
 
@@ -98,8 +99,50 @@ public:
     }
 };
 
+void RunCollectionBenchmark();
+void RunRegistrationBenchmark();
+void RunAllocationBenchmark();
+
 std::atomic<bool> run = true;
 
+// An unreachable cycle locked through a weak pointer while a collection is
+// pending has to come out of it intact, since it's reachable again.
+void TestLockDuringCollection()
+{
+    // enough pointers that no phase of the collection fits in a zero budget
+    gc::vector<gc::graph_ptr<int>> filler;
+    for (int i = 0; i != 20'000; ++i)
+        filler.push_back(gc::graph::make<int>(i));
+
+    gc::weak_graph_ptr<Test> weak;
+    {
+        gc::graph_ptr<Test> testA = gc::graph::make<Test>();
+        gc::graph_ptr<Test> testB = gc::graph::make<Test>();
+        testA->otherTest = testB;
+        testB->otherTest = testA;
+        weak = testA;
+    }
+
+    gc::garbage g = gc::graph::collect(std::chrono::nanoseconds(0));
+    assert(gc::graph::collection_pending());
+
+    gc::graph_ptr<Test> locked = weak.lock();
+    assert(locked);
+
+    while (gc::graph::collection_pending())
+        g = gc::graph::collect(std::chrono::milliseconds(1));
+
+    assert(locked->otherTest);
+    assert(locked->otherTest->otherTest == locked);
+    assert(locked->objects.size() == 3);
+
+    locked.reset();
+    filler.clear();
+    g = {};
+    (void)gc::graph::collect();
+    assert(weak.expired());
+}
+
 void DoTest(int id)
 {
     while (run)
@@ -146,8 +189,53 @@ void DoTest(int id)
     }
 }
 
+// Cleared after the thread's shard was released on exit, since
+// it's constructed before the thread first registers a pointer.
+thread_local std::optional<gc::graph_ptr<Test>> threadCache;
+
+size_t ReservedBytes()
+{
+    size_t total = 0;
+    for (auto& sc : gc::graph::size_classes())
+        total += sc.reserved_bytes;
+    return total;
+}
+
+// Objects created on a thread that has exited are freed back to the slabs
+// they came from, and those slabs are released once they're empty.
+void TestFreeAfterThreadExit()
+{
+    size_t reserved = ReservedBytes();
+
+    std::vector<gc::graph_ptr<Test>> objects;
+
+    std::thread([&]{
+        threadCache.emplace();
+        for (int i = 0; i != 2'000; ++i)
+            objects.push_back(gc::graph::make<Test>());
+        *threadCache = gc::graph::make<Test>();
+    }).join();
+
+    assert(ReservedBytes() > reserved);
+
+    objects.clear();
+    (void)gc::graph::collect();
+    assert(ReservedBytes() <= reserved);
+}
+
 int main(int argc, char* argv[])
 {
+    if (argc > 1 && std::string(argv[1]) == "--benchmark")
+    {
+        RunCollectionBenchmark();
+        RunRegistrationBenchmark();
+        RunAllocationBenchmark();
+        return 0;
+    }
+
+    TestLockDuringCollection();
+    TestFreeAfterThreadExit();
+
     std::vector<std::thread> tests;
     int numThreads = 4;
 